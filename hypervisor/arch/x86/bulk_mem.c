@@ -0,0 +1,633 @@
+/*
+ * Copyright (C) 2019 Intel Corporation. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <types.h>
+#include <rtl.h>
+#include <page.h>
+#include <board.h>
+#include <cpu.h>
+#include <cpuid.h>
+#include <cpufeatures.h>
+#include <cpu_caps.h>
+#include <logmsg.h>
+#include <bulk_mem.h>
+
+/**
+ * @defgroup hwmgmt_bulk_mem hwmgmt.bulk-mem
+ * @ingroup hwmgmt
+ * @brief Implementation of the copy and clear of multi-MByte memory regions with SIMD streaming stores.
+ *
+ * The hypervisor is built without SSE, and memcpy_s and memset use REP MOVSB and REP STOSB, which are fast enough for
+ * small regions. Regions of guest RAM being loaded, scrubbed or snapshotted are copied or cleared through this module
+ * instead, which uses the widest SIMD registers the physical platform supports and non-temporal stores that do not
+ * pollute the caches.
+ *
+ * The SIMD registers hold the state of the guest running on the physical CPU, so the state components used are saved
+ * with XSAVE before the kernel runs and restored with XRSTOR after it, with XCR0 temporarily enabling them.
+ *
+ * Usage Remarks: Init module uses this module to select the kernels once the CPU capabilities are known, and the
+ * vp-base modules use it to load, scrub and snapshot guest RAM.
+ *
+ * Dependency Justification: this module uses hwmgmt.cpu_caps to fetch hardware capabilities and hwmgmt.cpu to access
+ * XCR0.
+ *
+ * External APIs:
+ *  - init_bulk_mem()      This function selects the kernels from the capabilities of the physical platform.
+ *  - bulk_copy()          This function copies a memory region.
+ *  - bulk_clear()         This function clears a memory region.
+ *  - get_bulk_kernel()    This function returns the name of the kernels selected.
+ *
+ * Internal functions that are wrappers of inline assembly required by the coding guideline:
+ *  - asm_xsave()          Wrapper of inline assembly to save state components with XSAVE.
+ *  - asm_xrstor()         Wrapper of inline assembly to restore state components with XRSTOR.
+ *  - copy_avx2()          Wrapper of inline assembly to copy 256-byte blocks with AVX2 registers.
+ *  - clear_avx2()         Wrapper of inline assembly to clear 256-byte blocks with AVX2 registers.
+ *  - copy_avx512()        Wrapper of inline assembly to copy 256-byte blocks with AVX-512 registers.
+ *  - clear_avx512()       Wrapper of inline assembly to clear 256-byte blocks with AVX-512 registers.
+ *
+ * @{
+ */
+
+/**
+ * @file
+ * @brief This file implements the external APIs of the hwmgmt.bulk-mem module.
+ *
+ * Helper functions include: run_simd_kernel.
+ */
+
+#define BULK_KERNEL_ERMS	0U	/**< REP MOVSB for copies and MOVNTI for clears */
+#define BULK_KERNEL_AVX2	1U	/**< 32-byte VMOVNTDQ */
+#define BULK_KERNEL_AVX512	2U	/**< 64-byte VMOVNTDQ */
+
+/**
+ * @brief Number of bytes a SIMD kernel copies or clears per iteration.
+ */
+#define BULK_BLOCK_SIZE		256UL
+
+/**
+ * @brief Alignment of the destination a SIMD kernel requires, which is the size of the widest register used.
+ */
+#define BULK_ALIGN		64UL
+
+/**
+ * @brief Size below which a region is copied or cleared without a SIMD kernel, as saving and restoring the state
+ * components would not pay off.
+ */
+#define BULK_MIN_SIZE		(16UL * PAGE_SIZE)
+
+/**
+ * @brief XCR0 state components used by the AVX2 kernels.
+ */
+#define BULK_XCR0_AVX2		(XCR0_SSE | XCR0_AVX)
+
+/**
+ * @brief XCR0 state components used by the AVX-512 kernels, which shall be enabled together.
+ */
+#define BULK_XCR0_AVX512	(XCR0_SSE | XCR0_AVX | XCR0_OPMASK | XCR0_ZMM_HI256 | XCR0_HI16_ZMM)
+
+/**
+ * @brief The kernels selected by init_bulk_mem, one of BULK_KERNEL_ERMS, BULK_KERNEL_AVX2 and BULK_KERNEL_AVX512.
+ */
+static uint32_t bulk_kernel = BULK_KERNEL_ERMS;
+
+/**
+ * @brief XCR0 state components used by the kernels selected, 0 for BULK_KERNEL_ERMS.
+ */
+static uint64_t bulk_xcr0;
+
+/**
+ * @brief Per physical CPU XSAVE areas holding the guest state components while a SIMD kernel runs.
+ *
+ * They are used in the standard format, whose XSAVE header is left zeroed apart from XSTATE_BV as XRSTOR requires.
+ */
+static uint8_t bulk_xsave_areas[MAX_PCPU_NUM][XSAVE_STATE_AREA_SIZE] __aligned(64);
+
+/**
+ * @brief Save the given state components to an XSAVE area.
+ *
+ * @param[out] area Pointer to the XSAVE area.
+ * @param[in] mask The state components to be saved.
+ *
+ * @return None
+ *
+ * @pre area != NULL
+ * @pre area is 64-byte aligned.
+ * @pre The state components in \a mask are enabled in XCR0.
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ * @threadsafety When \a area is different among parallel invocation
+ */
+static inline void asm_xsave(uint8_t *area, uint64_t mask)
+{
+	/** Execute xsave in order to save the state components in mask to the area.
+	 *  - Input operands: RDI holds area, EDX:EAX holds mask
+	 *  - Output operands: None
+	 *  - Clobbers: memory */
+	asm volatile("xsave (%0)" : : "D"(area), "d"((uint32_t)(mask >> 32U)), "a"((uint32_t)mask) : "memory");
+}
+
+/**
+ * @brief Restore the given state components from an XSAVE area.
+ *
+ * @param[in] area Pointer to the XSAVE area.
+ * @param[in] mask The state components to be restored.
+ *
+ * @return None
+ *
+ * @pre area != NULL
+ * @pre area holds the state components in \a mask saved by asm_xsave.
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+static inline void asm_xrstor(const uint8_t *area, uint64_t mask)
+{
+	/** Execute xrstor in order to restore the state components in mask from the area.
+	 *  - Input operands: RDI holds area, EDX:EAX holds mask
+	 *  - Output operands: None
+	 *  - Clobbers: memory */
+	asm volatile("xrstor (%0)" : : "D"(area), "d"((uint32_t)(mask >> 32U)), "a"((uint32_t)mask) : "memory");
+}
+
+/**
+ * @brief Copy 256-byte blocks with AVX2 registers and non-temporal stores.
+ *
+ * @param[out] d Destination address.
+ * @param[in] s Source address.
+ * @param[in] n Number of bytes to be copied.
+ *
+ * @return None
+ *
+ * @pre \a d is 32-byte aligned.
+ * @pre n != 0 and n is a multiple of BULK_BLOCK_SIZE.
+ * @pre The AVX state is enabled in XCR0 and YMM0-YMM7 are saved.
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ * @threadsafety When the intersection of any virtual address range [\a d , \a d + \a n ) set on different physical
+ * processor is null set.
+ */
+static inline void copy_avx2(void *d, const void *s, size_t n)
+{
+	/** Execute vmovdqu and vmovntdq eight times per iteration until n bytes are copied, then sfence in order to
+	 *  make the non-temporal stores globally visible.
+	 *  - Input operands: None
+	 *  - Output operands: RDI holds d, RSI holds s and RCX holds n, all updated by the loop
+	 *  - Clobbers: cc, memory */
+	asm volatile("1: vmovdqu (%%rsi), %%ymm0\n\t"
+		     "vmovdqu 32(%%rsi), %%ymm1\n\t"
+		     "vmovdqu 64(%%rsi), %%ymm2\n\t"
+		     "vmovdqu 96(%%rsi), %%ymm3\n\t"
+		     "vmovdqu 128(%%rsi), %%ymm4\n\t"
+		     "vmovdqu 160(%%rsi), %%ymm5\n\t"
+		     "vmovdqu 192(%%rsi), %%ymm6\n\t"
+		     "vmovdqu 224(%%rsi), %%ymm7\n\t"
+		     "vmovntdq %%ymm0, (%%rdi)\n\t"
+		     "vmovntdq %%ymm1, 32(%%rdi)\n\t"
+		     "vmovntdq %%ymm2, 64(%%rdi)\n\t"
+		     "vmovntdq %%ymm3, 96(%%rdi)\n\t"
+		     "vmovntdq %%ymm4, 128(%%rdi)\n\t"
+		     "vmovntdq %%ymm5, 160(%%rdi)\n\t"
+		     "vmovntdq %%ymm6, 192(%%rdi)\n\t"
+		     "vmovntdq %%ymm7, 224(%%rdi)\n\t"
+		     "add $256, %%rsi\n\t"
+		     "add $256, %%rdi\n\t"
+		     "sub $256, %%rcx\n\t"
+		     "jnz 1b\n\t"
+		     "sfence"
+		     : "+D"(d), "+S"(s), "+c"(n)
+		     :
+		     : "cc", "memory");
+}
+
+/**
+ * @brief Clear 256-byte blocks with AVX2 registers and non-temporal stores.
+ *
+ * @param[out] d Destination address.
+ * @param[in] n Number of bytes to be cleared.
+ *
+ * @return None
+ *
+ * @pre \a d is 32-byte aligned.
+ * @pre n != 0 and n is a multiple of BULK_BLOCK_SIZE.
+ * @pre The AVX state is enabled in XCR0 and YMM0 is saved.
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ * @threadsafety When the intersection of any virtual address range [\a d , \a d + \a n ) set on different physical
+ * processor is null set.
+ */
+static inline void clear_avx2(void *d, size_t n)
+{
+	/** Execute vpxor once, and vmovntdq eight times per iteration until n bytes are cleared, then sfence in order
+	 *  to make the non-temporal stores globally visible.
+	 *  - Input operands: None
+	 *  - Output operands: RDI holds d and RCX holds n, both updated by the loop
+	 *  - Clobbers: cc, memory */
+	asm volatile("vpxor %%ymm0, %%ymm0, %%ymm0\n\t"
+		     "1: vmovntdq %%ymm0, (%%rdi)\n\t"
+		     "vmovntdq %%ymm0, 32(%%rdi)\n\t"
+		     "vmovntdq %%ymm0, 64(%%rdi)\n\t"
+		     "vmovntdq %%ymm0, 96(%%rdi)\n\t"
+		     "vmovntdq %%ymm0, 128(%%rdi)\n\t"
+		     "vmovntdq %%ymm0, 160(%%rdi)\n\t"
+		     "vmovntdq %%ymm0, 192(%%rdi)\n\t"
+		     "vmovntdq %%ymm0, 224(%%rdi)\n\t"
+		     "add $256, %%rdi\n\t"
+		     "sub $256, %%rcx\n\t"
+		     "jnz 1b\n\t"
+		     "sfence"
+		     : "+D"(d), "+c"(n)
+		     :
+		     : "cc", "memory");
+}
+
+/**
+ * @brief Copy 256-byte blocks with AVX-512 registers and non-temporal stores.
+ *
+ * @param[out] d Destination address.
+ * @param[in] s Source address.
+ * @param[in] n Number of bytes to be copied.
+ *
+ * @return None
+ *
+ * @pre \a d is 64-byte aligned.
+ * @pre n != 0 and n is a multiple of BULK_BLOCK_SIZE.
+ * @pre The AVX-512 states are enabled in XCR0 and ZMM0-ZMM3 are saved.
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ * @threadsafety When the intersection of any virtual address range [\a d , \a d + \a n ) set on different physical
+ * processor is null set.
+ */
+static inline void copy_avx512(void *d, const void *s, size_t n)
+{
+	/** Execute vmovdqu64 and vmovntdq four times per iteration until n bytes are copied, then sfence in order to
+	 *  make the non-temporal stores globally visible.
+	 *  - Input operands: None
+	 *  - Output operands: RDI holds d, RSI holds s and RCX holds n, all updated by the loop
+	 *  - Clobbers: cc, memory */
+	asm volatile("1: vmovdqu64 (%%rsi), %%zmm0\n\t"
+		     "vmovdqu64 64(%%rsi), %%zmm1\n\t"
+		     "vmovdqu64 128(%%rsi), %%zmm2\n\t"
+		     "vmovdqu64 192(%%rsi), %%zmm3\n\t"
+		     "vmovntdq %%zmm0, (%%rdi)\n\t"
+		     "vmovntdq %%zmm1, 64(%%rdi)\n\t"
+		     "vmovntdq %%zmm2, 128(%%rdi)\n\t"
+		     "vmovntdq %%zmm3, 192(%%rdi)\n\t"
+		     "add $256, %%rsi\n\t"
+		     "add $256, %%rdi\n\t"
+		     "sub $256, %%rcx\n\t"
+		     "jnz 1b\n\t"
+		     "sfence"
+		     : "+D"(d), "+S"(s), "+c"(n)
+		     :
+		     : "cc", "memory");
+}
+
+/**
+ * @brief Clear 256-byte blocks with AVX-512 registers and non-temporal stores.
+ *
+ * @param[out] d Destination address.
+ * @param[in] n Number of bytes to be cleared.
+ *
+ * @return None
+ *
+ * @pre \a d is 64-byte aligned.
+ * @pre n != 0 and n is a multiple of BULK_BLOCK_SIZE.
+ * @pre The AVX-512 states are enabled in XCR0 and ZMM0 is saved.
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ * @threadsafety When the intersection of any virtual address range [\a d , \a d + \a n ) set on different physical
+ * processor is null set.
+ */
+static inline void clear_avx512(void *d, size_t n)
+{
+	/** Execute vpxord once, and vmovntdq four times per iteration until n bytes are cleared, then sfence in order
+	 *  to make the non-temporal stores globally visible.
+	 *  - Input operands: None
+	 *  - Output operands: RDI holds d and RCX holds n, both updated by the loop
+	 *  - Clobbers: cc, memory */
+	asm volatile("vpxord %%zmm0, %%zmm0, %%zmm0\n\t"
+		     "1: vmovntdq %%zmm0, (%%rdi)\n\t"
+		     "vmovntdq %%zmm0, 64(%%rdi)\n\t"
+		     "vmovntdq %%zmm0, 128(%%rdi)\n\t"
+		     "vmovntdq %%zmm0, 192(%%rdi)\n\t"
+		     "add $256, %%rdi\n\t"
+		     "sub $256, %%rcx\n\t"
+		     "jnz 1b\n\t"
+		     "sfence"
+		     : "+D"(d), "+c"(n)
+		     :
+		     : "cc", "memory");
+}
+
+/**
+ * @brief Select the kernels used by bulk_copy and bulk_clear.
+ *
+ * The AVX-512 kernels are selected if the physical platform supports AVX-512 Foundation instructions and XCR0 can
+ * enable all the AVX-512 state components, the AVX2 kernels are selected if it supports AVX2 instructions, and REP
+ * MOVSB and MOVNTI are used otherwise.
+ *
+ * @return None
+ *
+ * @pre N/A
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_ROOT
+ *
+ * @remark It is called by init_pcpu_post on the BSP, after the CPU capabilities are initialized.
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Unspecified
+ */
+void init_bulk_mem(void)
+{
+	/** Declare the following local variables of type uint32_t.
+	 *  - xcr0_low representing the lower 32 bits of the XCR0 bits the processor supports, not initialized.
+	 *  - unused representing the unused outputs of cpuid_subleaf, not initialized. */
+	uint32_t xcr0_low, unused;
+
+	/** Call cpuid_subleaf with the following parameters, in order to get the XCR0 bits the processor supports in
+	 *  xcr0_low.
+	 *  - CPUID_XSAVE_FEATURES
+	 *  - 0
+	 *  - &xcr0_low
+	 *  - &unused
+	 *  - &unused
+	 *  - &unused */
+	cpuid_subleaf(CPUID_XSAVE_FEATURES, 0U, &xcr0_low, &unused, &unused, &unused);
+
+	/** If the processor supports AVX-512 Foundation instructions and all the AVX-512 state components */
+	if (pcpu_has_cap(X86_FEATURE_AVX512F) && (((uint64_t)xcr0_low & BULK_XCR0_AVX512) == BULK_XCR0_AVX512)) {
+		/** Set bulk_kernel to BULK_KERNEL_AVX512 and bulk_xcr0 to BULK_XCR0_AVX512 */
+		bulk_kernel = BULK_KERNEL_AVX512;
+		bulk_xcr0 = BULK_XCR0_AVX512;
+	/** If the processor supports AVX and AVX2 instructions */
+	} else if (pcpu_has_cap(X86_FEATURE_AVX) && pcpu_has_cap(X86_FEATURE_AVX2)) {
+		/** Set bulk_kernel to BULK_KERNEL_AVX2 and bulk_xcr0 to BULK_XCR0_AVX2 */
+		bulk_kernel = BULK_KERNEL_AVX2;
+		bulk_xcr0 = BULK_XCR0_AVX2;
+	} else {
+		/** Set bulk_kernel to BULK_KERNEL_ERMS and bulk_xcr0 to 0 */
+		bulk_kernel = BULK_KERNEL_ERMS;
+		bulk_xcr0 = 0UL;
+	}
+
+	/** Logging the following information with a log level of LOG_INFO.
+	 *  - the return value of get_bulk_kernel() */
+	pr_info("Bulk memory kernel: %s", get_bulk_kernel());
+}
+
+/**
+ * @brief Get the name of the kernels used by bulk_copy and bulk_clear.
+ *
+ * @return "avx512", "avx2" or "erms".
+ *
+ * @pre N/A
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_ROOT, HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+const char *get_bulk_kernel(void)
+{
+	/** Declare the following local variables of type 'const char *'.
+	 *  - name representing the name of the kernels, initialized as "erms". */
+	const char *name = "erms";
+
+	/** If bulk_kernel is BULK_KERNEL_AVX512 */
+	if (bulk_kernel == BULK_KERNEL_AVX512) {
+		/** Set name to "avx512" */
+		name = "avx512";
+	/** If bulk_kernel is BULK_KERNEL_AVX2 */
+	} else if (bulk_kernel == BULK_KERNEL_AVX2) {
+		/** Set name to "avx2" */
+		name = "avx2";
+	} else {
+		/* REP MOVSB and MOVNTI */
+	}
+
+	/** Return name */
+	return name;
+}
+
+/**
+ * @brief Run the SIMD kernel selected on 256-byte blocks, with the guest state components saved around it.
+ *
+ * @param[out] d Destination address.
+ * @param[in] s Source address, or NULL to clear the destination.
+ * @param[in] n Number of bytes to be copied or cleared.
+ *
+ * @return None
+ *
+ * @pre \a d is BULK_ALIGN aligned.
+ * @pre n != 0 and n is a multiple of BULK_BLOCK_SIZE.
+ * @pre bulk_kernel != BULK_KERNEL_ERMS
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_ROOT, HV_OPERATIONAL
+ *
+ * @remark It is an internal function called by bulk_copy and bulk_clear.
+ *
+ * @reentrancy Unspecified
+ * @threadsafety When the intersection of any virtual address range [\a d , \a d + \a n ) set on different physical
+ * processor is null set.
+ */
+static void run_simd_kernel(void *d, const void *s, size_t n)
+{
+	/** Declare the following local variables of type 'uint8_t *'.
+	 *  - area representing the XSAVE area of the current physical CPU, initialized as
+	 *    bulk_xsave_areas[get_pcpu_id()]. */
+	uint8_t *area = bulk_xsave_areas[get_pcpu_id()];
+	/** Declare the following local variables of type uint64_t.
+	 *  - xcr0 representing the XCR0 of the guest, initialized as read_xcr(0). */
+	uint64_t xcr0 = read_xcr(0);
+
+	/** Call write_xcr with the following parameters, in order to enable the state components used by the kernel.
+	 *  - 0
+	 *  - xcr0 | bulk_xcr0 */
+	write_xcr(0, xcr0 | bulk_xcr0);
+	/** Call asm_xsave with the following parameters, in order to save the guest values of those components.
+	 *  - area
+	 *  - bulk_xcr0 */
+	asm_xsave(area, bulk_xcr0);
+
+	/** If bulk_kernel is BULK_KERNEL_AVX512 and s is not NULL */
+	if ((bulk_kernel == BULK_KERNEL_AVX512) && (s != NULL)) {
+		/** Call copy_avx512 with the following parameters, in order to copy the blocks.
+		 *  - d
+		 *  - s
+		 *  - n */
+		copy_avx512(d, s, n);
+	/** If bulk_kernel is BULK_KERNEL_AVX512 */
+	} else if (bulk_kernel == BULK_KERNEL_AVX512) {
+		/** Call clear_avx512 with the following parameters, in order to clear the blocks.
+		 *  - d
+		 *  - n */
+		clear_avx512(d, n);
+	/** If s is not NULL */
+	} else if (s != NULL) {
+		/** Call copy_avx2 with the following parameters, in order to copy the blocks.
+		 *  - d
+		 *  - s
+		 *  - n */
+		copy_avx2(d, s, n);
+	} else {
+		/** Call clear_avx2 with the following parameters, in order to clear the blocks.
+		 *  - d
+		 *  - n */
+		clear_avx2(d, n);
+	}
+
+	/** Call asm_xrstor with the following parameters, in order to restore the guest values of the components.
+	 *  - area
+	 *  - bulk_xcr0 */
+	asm_xrstor(area, bulk_xcr0);
+	/** Call write_xcr with the following parameters, in order to restore the XCR0 of the guest.
+	 *  - 0
+	 *  - xcr0 */
+	write_xcr(0, xcr0);
+}
+
+/**
+ * @brief Copy a multi-MByte memory region.
+ *
+ * The part of the region that starts at a BULK_ALIGN aligned destination and spans whole BULK_BLOCK_SIZE blocks is
+ * copied by the SIMD kernel selected with non-temporal stores, and the rest by memcpy_s. Regions smaller than
+ * BULK_MIN_SIZE are copied by memcpy_s only.
+ *
+ * @param[out] d Destination address.
+ * @param[in] s Source address.
+ * @param[in] n Number of bytes to be copied.
+ *
+ * @return None
+ *
+ * @pre d != NULL
+ * @pre s != NULL
+ * @pre The host physical address ranges [hva2hpa(\a s ), hva2hpa(\a s + \a n )) and [hva2hpa(\a d ),
+ * hva2hpa(\a d + \a n )) do not overlap.
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_ROOT, HV_OPERATIONAL
+ *
+ * @remark It shall not be called before init_pcpu_xsave on the current physical CPU.
+ *
+ * @reentrancy Unspecified
+ * @threadsafety When the intersection of any virtual address range [\a d , \a d + \a n ) set on different physical
+ * processor is null set.
+ */
+void bulk_copy(void *d, const void *s, size_t n)
+{
+	/** Declare the following local variables of type uint64_t.
+	 *  - head representing the number of bytes before the first aligned block, initialized as the distance from
+	 *    d to the next BULK_ALIGN boundary.
+	 *  - body representing the number of bytes in whole blocks, initialized as 0. */
+	uint64_t head = (BULK_ALIGN - ((uint64_t)d & (BULK_ALIGN - 1UL))) & (BULK_ALIGN - 1UL);
+	uint64_t body = 0UL;
+
+	/** If a SIMD kernel is selected and n is not less than BULK_MIN_SIZE */
+	if ((bulk_kernel != BULK_KERNEL_ERMS) && (n >= BULK_MIN_SIZE)) {
+		/** Set body to the number of bytes in whole blocks after head */
+		body = (n - head) & ~(BULK_BLOCK_SIZE - 1UL);
+		/** Call memcpy_s in order to copy the head */
+		(void)memcpy_s(d, head, s, head);
+		/** Call run_simd_kernel in order to copy the blocks */
+		run_simd_kernel((uint8_t *)d + head, (const uint8_t *)s + head, body);
+		/** Call memcpy_s in order to copy the tail */
+		(void)memcpy_s((uint8_t *)d + head + body, n - head - body, (const uint8_t *)s + head + body,
+			n - head - body);
+	} else {
+		/** Call memcpy_s in order to copy the whole region */
+		(void)memcpy_s(d, n, s, n);
+	}
+}
+
+/**
+ * @brief Clear a multi-MByte memory region.
+ *
+ * The part of the region that starts at a BULK_ALIGN aligned address and spans whole BULK_BLOCK_SIZE blocks is
+ * cleared with non-temporal stores, by the SIMD kernel selected or by memclr_nt if there is none, and the rest by
+ * memset. Regions smaller than BULK_MIN_SIZE are cleared by memset only.
+ *
+ * @param[out] d Start address of the region.
+ * @param[in] n Number of bytes to be cleared.
+ *
+ * @return None
+ *
+ * @pre d != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_ROOT, HV_OPERATIONAL
+ *
+ * @remark It shall not be called before init_pcpu_xsave on the current physical CPU.
+ *
+ * @reentrancy Unspecified
+ * @threadsafety When the intersection of any virtual address range [\a d , \a d + \a n ) set on different physical
+ * processor is null set.
+ */
+void bulk_clear(void *d, size_t n)
+{
+	/** Declare the following local variables of type uint64_t.
+	 *  - head representing the number of bytes before the first aligned block, initialized as the distance from
+	 *    d to the next BULK_ALIGN boundary.
+	 *  - body representing the number of bytes in whole blocks, initialized as 0. */
+	uint64_t head = (BULK_ALIGN - ((uint64_t)d & (BULK_ALIGN - 1UL))) & (BULK_ALIGN - 1UL);
+	uint64_t body = 0UL;
+
+	/** If n is not less than BULK_MIN_SIZE */
+	if (n >= BULK_MIN_SIZE) {
+		/** Set body to the number of bytes in whole blocks after head */
+		body = (n - head) & ~(BULK_BLOCK_SIZE - 1UL);
+		/** Call memset in order to clear the head */
+		(void)memset(d, 0U, head);
+		/** If a SIMD kernel is selected */
+		if (bulk_kernel != BULK_KERNEL_ERMS) {
+			/** Call run_simd_kernel in order to clear the blocks */
+			run_simd_kernel((uint8_t *)d + head, NULL, body);
+		} else {
+			/** Call memclr_nt in order to clear the blocks */
+			memclr_nt((uint8_t *)d + head, body);
+		}
+		/** Call memset in order to clear the tail */
+		(void)memset((uint8_t *)d + head + body, 0U, n - head - body);
+	} else {
+		/** Call memset in order to clear the whole region */
+		(void)memset(d, 0U, n);
+	}
+}
+
+/**
+ * @}
+ */
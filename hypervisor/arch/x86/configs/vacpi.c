@@ -20,7 +20,9 @@
  * @brief This file implements a function to build ACPI tables for a VM.
  *
  * This file defines a local ACPI template, which includes some default information of a ACPI table.
- * The APCI table can be used by the guest Linux. Also this file offers a API:
+ * The APCI table can be used by the guest Linux. The MCFG table advertises the virtual ECAM window emulated by vPCI,
+ * so that the guest accesses the PCI configuration space with a single MMIO access instead of a pair of port IO
+ * accesses. Also this file offers a API:
  *
  * - build_vacpi: called by prepare_vm
  *
@@ -41,8 +43,8 @@ static struct acpi_table_info acpi_table_template[CONFIG_MAX_VM_NUM] = {
 		},
 		/** Extended System Description Table  ('XSDT') */
 		.xsdt = {
-			/**< Currently XSDT table only pointers to 1 ACPI table entry (MADT) */
-			.header.length = sizeof(struct acpi_table_header) + sizeof(uint64_t),
+			/**< Currently XSDT table pointers to 2 ACPI table entries (MADT and MCFG) */
+			.header.length = sizeof(struct acpi_table_header) + (2U * sizeof(uint64_t)),
 				/**< Length of table in bytes, including this header */
 			.header.revision = 0x1U,  /**< ACPI Specification minor version number */
 			.header.oem_revision = 0x1U, /**< OEM revision number */
@@ -53,6 +55,7 @@ static struct acpi_table_info acpi_table_template[CONFIG_MAX_VM_NUM] = {
 			.header.asl_compiler_id = ACPI_ASL_COMPILER_ID, /**< ASL compiler vendor ID */
 
 			.table_offset_entry[0] = ACPI_MADT_ADDR, /**< Array of pointers to ACPI tables */
+			.table_offset_entry[1] = ACPI_MCFG_ADDR, /**< Array of pointers to ACPI tables */
 		},
 		/** Multipile ACPI Description Table  ('APIC') */
 		.madt = {
@@ -75,6 +78,25 @@ static struct acpi_table_info acpi_table_template[CONFIG_MAX_VM_NUM] = {
 				.lapic_flags = 0x1U, /**< LAPIC flag: Processor Enabled=1 */
 			}
 		},
+		/** PCI Express Memory Mapped Configuration Table  ('MCFG') */
+		.mcfg = {
+			.header.length = sizeof(struct acpi_table_mcfg) + sizeof(struct acpi_mcfg_allocation),
+				/**< Length of table in bytes, including this header */
+			.header.revision = 0x1U, /**< ACPI Specification minor version number */
+			.header.oem_revision = 0x1U, /**< OEM revision number */
+			.header.asl_compiler_revision = ACPI_ASL_COMPILER_VERSION, /**< ASL compiler version */
+			.header.signature = ACPI_SIG_MCFG, /**< table signature */
+			.header.oem_id = ACPI_OEM_ID, /**< OEM identification */
+			.header.oem_table_id = "VIRTNUC7", /**< OEM table identification */
+			.header.asl_compiler_id = ACPI_ASL_COMPILER_ID, /**< ASL compiler vendor ID */
+		},
+		/** The virtual ECAM window emulated by vPCI */
+		.mcfg_entry = {
+			.address = VPCI_ECAM_BASE, /**< Base address of the virtual ECAM window */
+			.pci_segment = 0U, /**< PCI segment group 0 */
+			.start_bus_number = 0U, /**< First bus decoded by the window */
+			.end_bus_number = VPCI_ECAM_BUS_END, /**< Last bus decoded by the window */
+		},
 	}
 };
 
@@ -162,6 +184,10 @@ void build_vacpi(struct acrn_vm *vm)
 	 *  - lapic representing a pointer to LAPIC table, not initialized.
 	 */
 	struct acpi_madt_local_apic *lapic;
+	/** Declare the following local variables of type 'struct acpi_table_mcfg *'.
+	 *  - mcfg representing a pointer to MCFG table, not initialized.
+	 */
+	struct acpi_table_mcfg *mcfg;
 	/** Declare the following local variables of type uint16_t.
 	 *  - i representing a index used in a loop, not initialized.
 	 */
@@ -169,6 +195,11 @@ void build_vacpi(struct acrn_vm *vm)
 
 	/** Set rsdp to &acpi_table_template[vm->vm_id].rsdp */
 	rsdp = &acpi_table_template[vm->vm_id].rsdp;
+	/** Set rsdp->checksum to 0, as the template is rebuilt each time the VM is (re)started and the checksum
+	 *  fields are covered by the sums below */
+	rsdp->checksum = 0U;
+	/** Set rsdp->extended_checksum to 0 */
+	rsdp->extended_checksum = 0U;
 	/** Set rsdp->checksum to the return value of calculate_checksum8(rsdp, ACPI_RSDP_CHECKSUM_LENGTH) */
 	rsdp->checksum = calculate_checksum8(rsdp, ACPI_RSDP_CHECKSUM_LENGTH);
 	/** Set rsdp->extended_checksum to the return value of calculate_checksum8(rsdp, ACPI_RSDP_XCHECKSUM_LENGTH) */
@@ -184,6 +215,8 @@ void build_vacpi(struct acrn_vm *vm)
 
 	/** Set xsdt to &acpi_table_template[vm->vm_id].xsdt */
 	xsdt = &acpi_table_template[vm->vm_id].xsdt;
+	/** Set xsdt->header.checksum to 0 */
+	xsdt->header.checksum = 0U;
 	/** Set xsdt->header.checksum to the return value of calculate_checksum8(xsdt, xsdt->header.length) */
 	xsdt->header.checksum = calculate_checksum8(xsdt, xsdt->header.length);
 	/** Call copy_to_gpa with the following parameters, in order to copy the XSDT table to guest fixed memory
@@ -210,6 +243,8 @@ void build_vacpi(struct acrn_vm *vm)
 	/** Set madt->header.length to the total MADT table length */
 	madt->header.length = sizeof(struct acpi_table_madt) + (sizeof(struct acpi_madt_local_apic) *
 		(size_t)vm->hw.created_vcpus);
+	/** Set madt->header.checksum to 0 */
+	madt->header.checksum = 0U;
 	/** Set madt->header.checksum to the return value of calculate_checksum8(madt, madt->header.length) */
 	madt->header.checksum = calculate_checksum8(madt, madt->header.length);
 
@@ -221,6 +256,21 @@ void build_vacpi(struct acrn_vm *vm)
 	 *  - madt->header.length
 	 */
 	copy_to_gpa(vm, madt, ACPI_MADT_ADDR, madt->header.length);
+
+	/** Set mcfg to &acpi_table_template[vm->vm_id].mcfg */
+	mcfg = &acpi_table_template[vm->vm_id].mcfg;
+	/** Set mcfg->header.checksum to 0 */
+	mcfg->header.checksum = 0U;
+	/** Set mcfg->header.checksum to the return value of calculate_checksum8(mcfg, mcfg->header.length) */
+	mcfg->header.checksum = calculate_checksum8(mcfg, mcfg->header.length);
+	/** Call copy_to_gpa with the following parameters, in order to copy MCFG table and its ECAM window
+	 *  allocation to guest fixed memory space which is for ACPI table.
+	 *  - vm
+	 *  - mcfg
+	 *  - ACPI_MCFG_ADDR
+	 *  - mcfg->header.length
+	 */
+	copy_to_gpa(vm, mcfg, ACPI_MCFG_ADDR, mcfg->header.length);
 }
 
 /**
@@ -25,6 +25,7 @@
 #include <ld_sym.h>
 #include <logmsg.h>
 #include <uart16550.h>
+#include <bulk_mem.h>
 
 /**
  * @defgroup hwmgmt hwmgmt
@@ -291,8 +292,8 @@
  * - init_pcpu_pre: Perform the physical CPU's early stage initialization.
  * - init_pcpu_post: Perform the physical CPU's late stage initialization.
  * - get_pcpu_id_from_lapic_id(lapic_id): Get physical CPU id whose local APIC id is equal to \a lapic_id
- * - start_pcpu(pcpu_id): Start the physical CPU whose CPU id is \a pcpu_id.
- * - start_pcpus: Start all cpus if the bit is set in mask except itself
+ * - start_pcpu(pcpu_id): Send the INIT-SIPI sequence to the physical CPU whose CPU id is \a pcpu_id.
+ * - start_pcpus: Start all cpus if the bit is set in mask except itself and wait for all of them at once
  * - make_pcpu_offline: Submit a request to offline the target CPU.
  * - need_offline: Test and clear the NEED_OFFLINE bit of the given CPU.
  * - is_any_pcpu_active: If there is any physical CPU still active.
@@ -301,8 +302,6 @@
  * - cpu_dead: Put the current physical CPU in halt state.
  * - set_current_pcpu_id: Write current physical CPU ID to MSR_IA32_TSC_AUX.
  * - print_hv_banner: Print the boot message.
- * - asm_monitor: Set up a linear address range to be monitored by hardware and activate the monitor.
- * - asm_mwait: Enter an implementation-dependent optimized state.
  * - wait_sync_change(sync, wake_sync): Wait until \a *sync is equal to \a wake_sync.
  * - init_pcpu_xsave: Initialize physical CPU XSAVE features.
  */
@@ -612,6 +611,9 @@ void init_pcpu_post(uint16_t pcpu_id)
 
 	/** If pcpu_id is equal to BOOT_CPU_ID. */
 	if (pcpu_id == BOOT_CPU_ID) {
+		/** Call init_bulk_mem in order to select the kernels copying and clearing multi-MByte memory regions. */
+		init_bulk_mem();
+
 		/* Print Hypervisor Banner */
 		/** Call print_hv_banner in order to print the boot message. */
 		print_hv_banner();
@@ -748,82 +750,36 @@ static uint16_t get_pcpu_id_from_lapic_id(uint32_t lapic_id)
 /**
  * @brief Start the physical CPU whose CPU id is \a pcpu_id.
  *
+ * The INIT-SIPI sequence is sent without waiting for the physical CPU to come up, so that the caller can start several
+ * physical CPUs back to back and wait for all of them at once.
+ *
  * @param[in]    pcpu_id The CPU id of the CPU that will be started.
  *
- * @return Whether the physical CPU is start successful, where the physical CPU's id is \a pcpu_id.
+ * @return None
  *
  * @mode HV_SUBMODE_INIT_PRE_SMP, HV_SUBMODE_INIT_POST_SMP
  *
+ * @remark The stack of the physical CPU shall have been prepared by write_trampoline_stack_sym.
+ *
  * @reentrancy Unspecified
  * @threadsafety When \a pcpu_id is different among parallel invocation.
  */
-static bool start_pcpu(uint16_t pcpu_id)
+static void start_pcpu(uint16_t pcpu_id)
 {
-	/** Declare the following local variables of type uint32_t.
-	 *  - timeout representing the milliseconds to be waited until status of the CPU enter to PCPU_STATE_RUNNING
-	 *    mode, the time unit is millisecond, not initialized. */
-	uint32_t timeout;
-	/** Declare the following local variables of type bool.
-	 *  - status representing whether the physical CPU is start successful, initialized as true, where the physical
-	 *    CPU's id is \a pcpu_id, initialized as true. */
-	bool status = true;
-
-	/* Update the stack for pcpu */
-	/** Call stac in order to set the AC flag bit in the EFLAGS register and make the supervisor-mode data have
-	 *  rights to access the user-mode pages even if the SMAP bit is set in the CR4 register. */
-	stac();
-	/** Call write_trampoline_stack_sym with the following parameters, in order to set up the stack for AP.
-	 *  - pcpu_id */
-	write_trampoline_stack_sym(pcpu_id);
-	/** Call clac in order to clear the AC bit in the EFLAGS register and make the supervisor-mode data do not
-	 *  have rights to access the user-mode pages */
-	clac();
-
 	/** Call send_startup_ipi with the following parameters, in order to send a INIT-SIPI sequence to target
 	 *  logical processor whose CPU id is \a pcpu_id.
 	 *  - INTR_CPU_STARTUP_USE_DEST
 	 *  - pcpu_id
 	 *  - startup_paddr */
 	send_startup_ipi(INTR_CPU_STARTUP_USE_DEST, pcpu_id, startup_paddr);
-
-	/* Wait until the pcpu with pcpu_id is running and set the active bitmap or
-	 * configured time-out has expired
-	 */
-	/** Set timeout to the value calculated by multiplying CPU_UP_TIMEOUT by 1000. */
-	timeout = CPU_UP_TIMEOUT * 1000U;
-	/** Until any of the following conditions hold:
-	 *  - per_cpu_data[pcpu_id].boot_state is equal to PCPU_STATE_RUNNING
-	 *  - timeout is equal to 0. */
-	while ((per_cpu_data[pcpu_id].boot_state != PCPU_STATE_RUNNING) && (timeout != 0U)) {
-		/** Call udelay with the following parameters, in order to delay 10us.
-		 *  - 10 */
-		udelay(10U);
-
-		/** Decrement timeout by 10. */
-		timeout -= 10U;
-	}
-
-	/** If per_cpu_data[pcpu_id].boot_state isn't equal to PCPU_STATE_RUNNING. */
-	if (per_cpu_data[pcpu_id].boot_state != PCPU_STATE_RUNNING) {
-		/** Logging the following information with a log level of LOG_FATAL.
-		 *  - pcpu_id */
-		pr_fatal("Secondary CPU%hu failed to come up", pcpu_id);
-		/** Call pcpu_set_current_state with the following parameters, in order to
-		 *  set the state of the CPU (whose ID is \a pcpu_id) to PCPU_STATE_RUNNING
-		 *  - pcpu_id
-		 *  - PCPU_STATE_DEAD */
-		pcpu_set_current_state(pcpu_id, PCPU_STATE_DEAD);
-		/** Set status to false. */
-		status = false;
-	}
-
-	/** Return status. */
-	return status;
 }
 
 /**
  * @brief Start all cpus if the bit is set in mask except itself.
  *
+ * The stacks of all the physical CPUs are prepared first and the INIT-SIPI sequences are then sent back to back. A
+ * single wait of CPU_UP_TIMEOUT covers the whole \a mask, and the time each physical CPU takes to come up is reported.
+ *
  * @param[in] mask Bits mask of cpus which should be started.
  *
  * @return Whether all mask of cpus is started successfully.
@@ -855,9 +811,22 @@ bool start_pcpus(uint64_t mask)
 	/** Declare the following local variables of type uint16_t.
 	 *  - pcpu_id representing current physical CPU ID, initialized as get_pcpu_id(). */
 	uint16_t pcpu_id = get_pcpu_id();
+	/** Declare the following local variables of type uint16_t.
+	 *  - slot_idx representing the next free slot of the AP stack table, initialized as 0. */
+	uint16_t slot_idx = 0U;
+	/** Declare the following local variables of type uint64_t.
+	 *  - expected_start_mask representing bits mask of cpus which should be started, initialized as mask
+	 *    without the current physical CPU. */
+	uint64_t expected_start_mask = mask & ~(1UL << pcpu_id);
 	/** Declare the following local variables of type uint64_t.
-	 *  - expected_start_mask representing bits mask of cpus which should be started, initialized as mask. */
-	uint64_t expected_start_mask = mask;
+	 *  - pending_mask representing bits mask of cpus which are started but not yet running, not initialized.
+	 *  - start_tsc representing the TSC value when the first INIT-SIPI sequence is sent, not initialized.
+	 *  - elapsed_us representing the microseconds elapsed since start_tsc, not initialized. */
+	uint64_t pending_mask, start_tsc, elapsed_us;
+	/** Declare the following local variables of type uint32_t.
+	 *  - timeout representing the microseconds to be waited until all the physical CPUs in \a mask enter
+	 *    PCPU_STATE_RUNNING, initialized as CPU_UP_TIMEOUT * 1000. */
+	uint32_t timeout = CPU_UP_TIMEOUT * 1000U;
 	/** Declare the following local variables of type bool.
 	 *  - status representing whether all CPUs specified in \a mask are started successfully, initialized as
 	 *    true. */
@@ -869,40 +838,109 @@ bool start_pcpus(uint64_t mask)
 
 	/** Set pcpu_sync to 1. */
 	pcpu_sync = 1UL;
+
+	/* Prepare the stacks of all the APs before any of them runs the trampoline code. The slots are packed densely
+	 * since the trampoline code stops looking up at the first empty slot. */
+	/** For each i ranging from 0 to 'get_pcpu_nums() - 1' [with a step of 1] */
+	for (i = 0U; i < get_pcpu_nums(); i++) {
+		/** If the (i+1)-th bit of expected_start_mask is set */
+		if ((expected_start_mask & (1UL << i)) != 0UL) {
+			/** Call write_trampoline_stack_sym with the following parameters, in order to set up the stack
+			 *  for AP in the next free slot.
+			 *  - slot_idx
+			 *  - i */
+			write_trampoline_stack_sym(slot_idx, i);
+			/** Increment slot_idx by 1. */
+			slot_idx++;
+		}
+	}
 	/** Call cpu_write_memory_barrier with the following parameters, in order to synchronize all write and read
 	 *  accesses to memory. */
 	cpu_write_memory_barrier();
 
-	/** Set i to ffs64(expected_start_mask). */
-	i = ffs64(expected_start_mask);
+	/** Set start_tsc to the return value of rdtsc(). */
+	start_tsc = rdtsc();
+	/** Set pending_mask to expected_start_mask. */
+	pending_mask = expected_start_mask;
+	/** Set i to ffs64(pending_mask). */
+	i = ffs64(pending_mask);
 	/** Until i is equal to INVALID_BIT_INDEX. */
 	while (i != INVALID_BIT_INDEX) {
 		/** Call bitmap_clear_nolock with the following parameters, in order to clear the (i+1)-th bit in the
-		 *  expected_start_mask.
+		 *  pending_mask.
 		 *  - i
-		 *  - &expected_start_mask */
-		bitmap_clear_nolock(i, &expected_start_mask);
-
-		/** If pcpu_id is equal to i. */
-		if (pcpu_id == i) {
-			/** Set i to the return value of 'ffs64(expected_start_mask)'. */
-			i = ffs64(expected_start_mask);
-			/** Continue to next iteration */
-			continue; /* Avoid start itself */
-		}
+		 *  - &pending_mask */
+		bitmap_clear_nolock(i, &pending_mask);
+		/** Call start_pcpu with the following parameters, in order to send the INIT-SIPI sequence to the
+		 *  physical CPU whose CPU id is i.
+		 *  - i */
+		start_pcpu(i);
+		/** Set i to ffs64(pending_mask). */
+		i = ffs64(pending_mask);
+	}
 
-		/** If the return value of start_pcpu(i) is false, indicating that the start-up of the physical
-		 *  CPU (CPU ID is i) is failed. */
-		if (start_pcpu(i) == false) {
-			/** Set status to false */
-			status = false;
-			/** Terminate the loop */
-			break;
+	/* Wait until all the started pcpus are running or the configured time-out has expired */
+	/** Set pending_mask to expected_start_mask. */
+	pending_mask = expected_start_mask;
+	/** Until any of the following conditions hold:
+	 *  - pending_mask is equal to 0
+	 *  - timeout is equal to 0. */
+	while ((pending_mask != 0UL) && (timeout != 0U)) {
+		/** Set i to ffs64(pending_mask). */
+		i = ffs64(pending_mask);
+		/** If per_cpu_data[i].boot_state is equal to PCPU_STATE_RUNNING. */
+		if (per_cpu_data[i].boot_state == PCPU_STATE_RUNNING) {
+			/** Set elapsed_us to the value calculated by dividing '(rdtsc() - start_tsc) * 1000' by
+			 *  get_tsc_khz(). */
+			elapsed_us = ((rdtsc() - start_tsc) * 1000UL) / get_tsc_khz();
+			/** Logging the following information with a log level of LOG_INFO.
+			 *  - i
+			 *  - elapsed_us */
+			pr_info("Secondary CPU%hu came up in %lu us", i, elapsed_us);
+			/** Call bitmap_clear_nolock with the following parameters, in order to clear the (i+1)-th bit
+			 *  in the pending_mask.
+			 *  - i
+			 *  - &pending_mask */
+			bitmap_clear_nolock(i, &pending_mask);
+		} else {
+			/** Call udelay with the following parameters, in order to delay 10us.
+			 *  - 10 */
+			udelay(10U);
+			/** Decrement timeout by 10. */
+			timeout -= 10U;
 		}
-		/** Set i to ffs64(expected_start_mask). */
-		i = ffs64(expected_start_mask);
 	}
 
+	/** Set i to ffs64(pending_mask). */
+	i = ffs64(pending_mask);
+	/** Until i is equal to INVALID_BIT_INDEX. */
+	while (i != INVALID_BIT_INDEX) {
+		/** Call bitmap_clear_nolock with the following parameters, in order to clear the (i+1)-th bit in the
+		 *  pending_mask.
+		 *  - i
+		 *  - &pending_mask */
+		bitmap_clear_nolock(i, &pending_mask);
+		/** Logging the following information with a log level of LOG_FATAL.
+		 *  - i */
+		pr_fatal("Secondary CPU%hu failed to come up", i);
+		/** Call pcpu_set_current_state with the following parameters, in order to
+		 *  set the state of the CPU (whose ID is i) to PCPU_STATE_DEAD
+		 *  - i
+		 *  - PCPU_STATE_DEAD */
+		pcpu_set_current_state(i, PCPU_STATE_DEAD);
+		/** Set status to false. */
+		status = false;
+		/** Set i to ffs64(pending_mask). */
+		i = ffs64(pending_mask);
+	}
+
+	/** Set elapsed_us to the value calculated by dividing '(rdtsc() - start_tsc) * 1000' by get_tsc_khz(). */
+	elapsed_us = ((rdtsc() - start_tsc) * 1000UL) / get_tsc_khz();
+	/** Logging the following information with a log level of LOG_INFO.
+	 *  - expected_start_mask
+	 *  - elapsed_us */
+	pr_info("Secondary CPUs 0x%lx started in %lu us", expected_start_mask, elapsed_us);
+
 	/* Trigger event to allow secondary CPUs to continue */
 	/** Set pcpu_sync to 0. */
 	pcpu_sync = 0UL;
@@ -1173,55 +1211,6 @@ static void print_hv_banner(void)
 	pr_info(boot_msg);
 }
 
-/**
- * @brief Set up a linear address range to be monitored by hardware and activate the monitor.
- *
- * @param[in]    addr The start address to be monitored.
- * @param[in]    ecx Optional extensions of MONITOR instruction.
- * @param[in]    edx Optional hints of MONITOR instruction.
- *
- * @return None
- *
- * @mode HV_SUBMODE_INIT_POST_SMP
- *
- * @reentrancy Unspecified
- * @threadsafety Yes
- */
-static inline void asm_monitor(volatile const uint64_t *addr, uint64_t ecx, uint64_t edx)
-{
-	/** Execute monitor in order to set up a linear address range to be monitored by hardware and activate the
-	 *  monitor.
-	 *  - Input operands: RAX holds addr, RCX holds ecx, RDX holds edx
-	 *  - Output operands: None
-	 *  - Clobbers: None */
-	asm volatile("monitor\n" : : "a"(addr), "c"(ecx), "d"(edx));
-}
-
-/**
- * @brief Enter an implementation-dependent optimized state.
- *
- * Make processor to stop instruction execution and enter an implementation-dependent optimized state until occurrence
- * of a class of events.
- *
- * @param[in]    eax A value contain hints such as the preferred optimized state the processor should enter.
- * @param[in]    ecx Optional extensions for the MWAIT instruction.
- *
- * @return None
- *
- * @mode HV_SUBMODE_INIT_POST_SMP
- *
- * @reentrancy Unspecified
- * @threadsafety Yes
- */
-static inline void asm_mwait(uint64_t eax, uint64_t ecx)
-{
-	/** Execute mwait in order to enter an implementation-dependent optimized state.
-	 *  - Input operands: RAX holds eax, RCX holds ecx.
-	 *  - Output operands: None
-	 *  - Clobbers:None */
-	asm volatile("mwait\n" : : "a"(eax), "c"(ecx));
-}
-
 /**
  * @brief Wait until \a *sync is equal to \a wake_sync.
  *
@@ -44,6 +44,7 @@
  *
  * This file also implements following helper functions to help realize the features of the external APIs.
  * - calculate_logical_dest_mask
+ * - ptirq_irte_index
  * - ptirq_build_physical_msi
  * - remove_msix_remapping
  */
@@ -118,6 +119,38 @@ static uint32_t calculate_logical_dest_mask(uint64_t pdmask)
 	return dest_mask;
 }
 
+/**
+ * @brief Compute the interrupt remapping entry index of one MSI or MSI-X vector of a passthrough device.
+ *
+ * Each vector of each passthrough device owns one entry: bits 3:0 of the index are \a entry_nr,
+ * bits 9:4 are the low 6 bits of \a virt_bdf and the upper bits are the VM ID.
+ *
+ * @param[in] vm A pointer to the virtual machine owning the device.
+ * @param[in] virt_bdf The virtual BDF associated with the specified passthrough device.
+ * @param[in] entry_nr The entry ID of the vector.
+ *
+ * @return The index of the interrupt remapping entry, which is smaller than CONFIG_MAX_IR_ENTRIES.
+ *
+ * @pre vm != NULL
+ * @pre entry_nr < CONFIG_MAX_MSIX_TABLE_NUM
+ * @pre (virt_bdf & FFH) < 3FH
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark N/A
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+static inline uint16_t ptirq_irte_index(const struct acrn_vm *vm, uint16_t virt_bdf, uint32_t entry_nr)
+{
+	/** Return ((vm->vm_id << 10H) | ((virt_bdf & 3FH) << 4H) | entry_nr) & (CONFIG_MAX_IR_ENTRIES - 1H) */
+	return (uint16_t)((((uint32_t)vm->vm_id << 10U) | (((uint32_t)virt_bdf & 0x3FU) << 4U) | entry_nr) &
+		(CONFIG_MAX_IR_ENTRIES - 1U));
+}
+
 /**
  * @brief This function is for building the physical MSI remapping for a given virtual machine's
  *        passthrough device.
@@ -127,11 +160,13 @@ static uint32_t calculate_logical_dest_mask(uint64_t pdmask)
  * @param[in] virt_bdf The virtual BDF associated with the specified passthrough device.
  * @param[in] phys_bdf The physical BDF associated with the specified passthrough device.
  * @param[in] vector The interrupt vector.
+ * @param[in] entry_nr The entry ID of the vector in the MSI-X table, 0 for MSI.
  *
  * @return None
  *
  * @pre vm != NULL
  * @pre info != NULL
+ * @pre entry_nr < CONFIG_MAX_MSIX_TABLE_NUM
  * @pre (virt_bdf & FFH) < 3FH
  *
  * @post N/A
@@ -144,7 +179,8 @@ static uint32_t calculate_logical_dest_mask(uint64_t pdmask)
  * @threadsafety When \a phys_bdf is different among parallel invocation.
  */
 static void ptirq_build_physical_msi(
-	struct acrn_vm *vm, struct ptirq_msi_info *info, uint16_t virt_bdf, uint16_t phys_bdf, uint32_t vector)
+	struct acrn_vm *vm, struct ptirq_msi_info *info, uint16_t virt_bdf, uint16_t phys_bdf, uint32_t vector,
+	uint16_t entry_nr)
 {
 	/** Declare the following local variable of type uint64_t
 	 *  - vdmask representing the mask of the MSI target vCPU, not initialized.
@@ -230,9 +266,8 @@ static void ptirq_build_physical_msi(
 
 	/** Set intr_src.src.msi.value to be phys_bdf */
 	intr_src.src.msi.value = phys_bdf;
-	/** Set low 6-bits of 'index' to be low 6-bits of 'virt_bdf' and
-	 *  set high 10-bits of 'index' to be low 10-bits of 'vm->vm_id' */
-	index = ((virt_bdf & 0x3FU) | (uint16_t)(vm->vm_id << 0x6U)) & 0xFFU;
+	/** Set 'index' to the return value of ptirq_irte_index(vm, virt_bdf, (uint32_t)entry_nr) */
+	index = ptirq_irte_index(vm, virt_bdf, (uint32_t)entry_nr);
 	/** Call dmar_assign_irte with the following parameters, in order to
 	 *  assign an interrupt remapping entry to the given interrupt request source.
 	 *  - intr_src
@@ -286,7 +321,7 @@ static void ptirq_build_physical_msi(
  * @return None
  *
  * @pre vm != NULL
- * @pre entry_nr == 0
+ * @pre entry_nr < CONFIG_MAX_MSIX_TABLE_NUM
  * @pre (virt_bdf & FFH) < 3FH
  *
  * @post N/A
@@ -310,9 +345,8 @@ static void remove_msix_remapping(const struct acrn_vm *vm, uint16_t virt_bdf, u
 
 	/** Set the intr_src.src.msi.value to be 0H */
 	intr_src.src.msi.value = 0U;
-	/** Set low 6-bits of 'index' to low 6-bits of 'virt_bdf' and set high
-	 *  10-bits of 'index' to low 10-bits of 'vm->vm_id' */
-	index = ((virt_bdf & 0x3FU) | (uint16_t)(vm->vm_id << 0x6U)) & 0xFFU;
+	/** Set 'index' to the return value of ptirq_irte_index(vm, virt_bdf, entry_nr) */
+	index = ptirq_irte_index(vm, virt_bdf, entry_nr);
 	/** Call dmar_free_irte with the following parameters, in order to
 	 *  free the interrupt remapping entry associated with the given 'index'.
 	 *  - intr_src
@@ -344,7 +378,7 @@ static void remove_msix_remapping(const struct acrn_vm *vm, uint16_t virt_bdf, u
  * @return None
  *
  * @pre vm != NULL
- * @pre entry_nr == 0
+ * @pre entry_nr < CONFIG_MAX_MSIX_TABLE_NUM
  * @pre info != NULL
  * @pre (virt_bdf & FFH) < 3FH
  *
@@ -369,8 +403,9 @@ void ptirq_msix_remap(
 	 *  - virt_bdf
 	 *  - phys_bdf
 	 *  - (uint32_t)info->vmsi_data.bits.vector
+	 *  - entry_nr
 	 */
-	ptirq_build_physical_msi(vm, info, virt_bdf, phys_bdf, (uint32_t)info->vmsi_data.bits.vector);
+	ptirq_build_physical_msi(vm, info, virt_bdf, phys_bdf, (uint32_t)info->vmsi_data.bits.vector, entry_nr);
 
 	/** Logging the following information with a log level of ACRN_DBG_IRQ.
 	 *  - vm->vm_id
@@ -395,7 +430,7 @@ void ptirq_msix_remap(
  * @return None
  *
  * @pre vm != NULL
- * @pre vector_count == 1
+ * @pre vector_count <= CONFIG_MAX_MSIX_TABLE_NUM
  *
  * @post N/A
  *
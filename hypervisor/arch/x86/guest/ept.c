@@ -12,6 +12,7 @@
 #include <logmsg.h>
 #include <trace.h>
 #include <virq.h>
+#include <vtd.h>
 
 /**
  * @addtogroup vp-base_guest-mem
@@ -27,7 +28,12 @@
  * In addition, it defines a function to walk through EPT and a helper function used
  * by another file in vp-base.guest_mem.
  *
- * Helper function includes: get_ept_entry.
+ * It also implements a function to grant the execute permission to guest memory in 2-MByte granularity, and
+ * functions to harvest and to clear the accessed and dirty flags of the EPT of a VM that has them enabled, and to mark
+ * the pages the hypervisor writes as dirty. A function to invalidate the cached translations of a region synchronously
+ * is provided for the EPT memory operations.
+ *
+ * Helper function includes: get_ept_entry, harvest_ad_leaf, clear_dirty_leaf.
  */
 
 /**
@@ -35,6 +41,21 @@
  */
 #define ACRN_DBG_EPT 6U
 
+/**
+ * @brief Numbers of bytes found accessed and dirty by a harvest of EPT accessed and dirty flags.
+ *
+ * An instance is provided by each call of ept_harvest_ad and passed to harvest_ad_leaf through the EPT walk.
+ *
+ * @consistency N/A
+ * @alignment N/A
+ *
+ * @remark N/A
+ */
+struct harvest_ad_ctx {
+	uint64_t accessed_bytes; /**< Number of bytes found accessed */
+	uint64_t dirty_bytes; /**< Number of bytes found dirty */
+};
+
 /**
  * @brief A helper function to retrieve the corresponding \a vm's EPT structure.
  *
@@ -259,6 +280,13 @@ void ept_modify_mr(
 	 *  - &vm->ept_lock
 	 */
 	spinlock_release(&vm->ept_lock);
+	/** Call iommu_invalidate_range with the following parameters, in order to invalidate the IOTLB entries of the
+	 *  VM's IOMMU domain that cache the range, since the EPT is also its second-level translation table.
+	 *  - vm->iommu
+	 *  - gpa
+	 *  - size
+	 */
+	iommu_invalidate_range(vm->iommu, gpa, size);
 
 	/** For each vcpu in the online vCPUs of vm, using i as the loop counter. */
 	foreach_vcpu(i, vm, vcpu) {
@@ -331,6 +359,259 @@ void ept_del_mr(struct acrn_vm *vm, uint64_t *pml4_page, uint64_t gpa, uint64_t
 	 */
 	mmu_modify_or_del(pml4_page, gpa, size, 0UL, 0UL, &vm->arch_vm.ept_mem_ops, MR_DEL);
 
+	/** Call spinlock_release with the following parameter, in order to release the spinlock for protecting EPT
+	 *  manipulations.
+	 *  - &vm->ept_lock
+	 */
+	spinlock_release(&vm->ept_lock);
+	/** Call iommu_invalidate_range with the following parameters, in order to invalidate the IOTLB entries of the
+	 *  VM's IOMMU domain that cache the range, since the EPT is also its second-level translation table.
+	 *  - vm->iommu
+	 *  - gpa
+	 *  - size
+	 */
+	iommu_invalidate_range(vm->iommu, gpa, size);
+
+	/** For each vcpu in the online vCPUs of vm, using i as the loop counter. */
+	foreach_vcpu(i, vm, vcpu) {
+		/** Call vcpu_make_request with following parameters in order to notify the vCPU to flush its TLB.
+		 *  - vcpu
+		 *  - ACRN_REQUEST_EPT_FLUSH
+		 */
+		vcpu_make_request(vcpu, ACRN_REQUEST_EPT_FLUSH);
+	}
+}
+
+/**
+ * @brief Invalidate the cached translations of a guest memory region and wait until no vCPU can use them anymore.
+ *
+ * Unlike the flushes requested by ept_modify_mr and ept_del_mr, which a vCPU conducts at its next VM entry, the
+ * invalidation is complete when this function returns. The IOTLB entries and paging-structure caches of the VM's
+ * IOMMU domain covering the region are invalidated synchronously, an EPT flush is requested to every vCPU of the VM,
+ * and then this function waits until each vCPU has either conducted the flush or left VMX non-root operation, as it
+ * conducts the flush before its next VM entry in the latter case.
+ *
+ * @param[in] vm Pointer to the VM whose cached translations are invalidated.
+ * @param[in] gpa The start guest physical address of the region.
+ * @param[in] size The size of the region.
+ *
+ * @return None
+ *
+ * @pre vm != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_PRE_SMP, HV_SUBMODE_INIT_POST_SMP, HV_SUBMODE_INIT_ROOT, HV_OPERATIONAL
+ *
+ * @remark It is called by the EPT memory operations when a paging structure is left unreferenced by a merge, so that
+ *	   the paging structure is not rewritten while it is still cached. It may be called with vm->ept_lock held, as
+ *	   no vCPU needs the lock to conduct the flush.
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+void ept_flush_sync(struct acrn_vm *vm, uint64_t gpa, uint64_t size)
+{
+	/** Declare the following local variables of type struct acrn_vcpu *.
+	 *  - vcpu representing an online vCPU of the given VM, not initialized. */
+	struct acrn_vcpu *vcpu;
+	/** Declare the following local variables of type uint16_t.
+	 *  - i representing the loop counter as vCPU index, not initialized. */
+	uint16_t i;
+
+	/** Call iommu_invalidate_range with the following parameters, in order to invalidate the IOTLB entries and
+	 *  paging-structure caches of the VM's IOMMU domain that cache the region, which completes before it returns.
+	 *  - vm->iommu
+	 *  - gpa
+	 *  - size
+	 */
+	iommu_invalidate_range(vm->iommu, gpa, size);
+
+	/** For each vcpu in the online vCPUs of vm, using i as the loop counter. */
+	foreach_vcpu(i, vm, vcpu) {
+		/** Call vcpu_make_request with following parameters in order to notify the vCPU to flush its TLB.
+		 *  - vcpu
+		 *  - ACRN_REQUEST_EPT_FLUSH
+		 */
+		vcpu_make_request(vcpu, ACRN_REQUEST_EPT_FLUSH);
+	}
+	/** Call cpu_write_memory_barrier, in order to order the requests above before the checks of
+	 *  vcpu->in_non_root below */
+	cpu_write_memory_barrier();
+
+	/** For each vcpu in the online vCPUs of vm, using i as the loop counter. */
+	foreach_vcpu(i, vm, vcpu) {
+		/** Until the vCPU is out of VMX non-root operation or has conducted the flush */
+		while (vcpu->in_non_root && bitmap_test(ACRN_REQUEST_EPT_FLUSH, &vcpu->arch.pending_req)) {
+			/** Call asm_pause without any parameters, in order to improve processor performance in this
+			 *  spin-wait loop. */
+			asm_pause();
+		}
+	}
+}
+
+/**
+ * @brief Grant the execute permission to all cachable 4-KByte pages mapped by an EPT page table.
+ *
+ * It is supposed to be called internally by 'ept_grant_exe_right' with the VM's EPT lock held.
+ *
+ * @param[inout] pt_page Pointer to the EPT page table whose PTEs are updated.
+ * @param[in] mem_ops Pointer to the EPT memory operations of the VM owning \a pt_page.
+ *
+ * @return None
+ *
+ * @pre pt_page != NULL
+ * @pre mem_ops != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL, HV_SUBMODE_INIT_ROOT
+ *
+ * @remark N/A
+ *
+ * @reentrancy Unspecified
+ * @threadsafety When \a pt_page is different among parallel invocation.
+ */
+static void ept_grant_exe_pt(uint64_t *pt_page, const struct memory_ops *mem_ops)
+{
+	/** Declare the following local variables of type uint64_t.
+	 *  - i representing the index of the PTE being checked, not initialized. */
+	uint64_t i;
+
+	/** For each 'i' ranging from 0 to 'PTRS_PER_PTE - 1' [with a step of 1] */
+	for (i = 0UL; i < PTRS_PER_PTE; i++) {
+		/** Declare the following local variables of type uint64_t *.
+		 *  - pte representing the 'i'-th PTE in \a pt_page, initialized as 'pt_page + i'. */
+		uint64_t *pte = pt_page + i;
+
+		/** If the PTE is present, maps a write-back page and is not executable yet */
+		if ((mem_ops->pgentry_present(*pte) != 0UL) && ((*pte & EPT_MT_MASK) == EPT_WB) &&
+			((*pte & EPT_EXE) == 0UL)) {
+			/** Call set_pgentry with the following parameters, in order to set the execute access
+			 *  bit of the PTE.
+			 *  - pte
+			 *  - *pte | EPT_EXE
+			 *  - mem_ops
+			 */
+			set_pgentry(pte, *pte | EPT_EXE, mem_ops);
+		}
+	}
+}
+
+/**
+ * @brief Grant the execute permission to a guest memory region in 2-MByte granularity.
+ *
+ * On platforms vulnerable to the page size change MCE issue, large pages in the EPT are mapped without the execute
+ * permission, and any instruction fetch from them triggers an EPT violation. This function widens the specified
+ * region to 2-MByte boundaries and, for each 2-MByte region that is cachable:
+ * - If it is mapped by a non-executable large page, the large page is split once so that all of the resulting
+ *   4-KByte pages become executable.
+ * - If it is already mapped by 4-KByte pages, all present write-back PTEs of the page table become executable.
+ *
+ * Executable large pages are left untouched. A single EPT flush is requested on all vCPUs of the VM at the end,
+ * instead of one per 4-KByte page.
+ *
+ * It is supposed to be called by 'ept_violation_vmexit_handler' on an instruction fetch violation and by the
+ * loader to pre-grant the execute permission on the guest kernel image.
+ *
+ * @param[in] vm Pointer to the VM whose EPT is updated.
+ * @param[in] gpa The start guest physical address of the region.
+ * @param[in] size The size of the region.
+ *
+ * @return None
+ *
+ * @pre vm != NULL
+ * @pre size > 0
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL, HV_SUBMODE_INIT_ROOT
+ *
+ * @remark N/A
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+void ept_grant_exe_right(struct acrn_vm *vm, uint64_t gpa, uint64_t size)
+{
+	/** Declare the following local variables of type uint64_t *.
+	 *  - pml4_page representing the PML4 page of the VM's EPT, initialized as vm->arch_vm.nworld_eptp. */
+	uint64_t *pml4_page = (uint64_t *)vm->arch_vm.nworld_eptp;
+	/** Declare the following local variables of type const struct memory_ops *.
+	 *  - mem_ops representing the operations for the EPT, initialized as &vm->arch_vm.ept_mem_ops. */
+	const struct memory_ops *mem_ops = &vm->arch_vm.ept_mem_ops;
+	/** Declare the following local variables of type uint64_t.
+	 *  - addr representing the guest physical address being handled, initialized as 'gpa & PAGE_MASK'.
+	 *  - end representing the end of the region (exclusive), initialized as 'gpa + size'.
+	 *  - pg_size representing the size of the page mapping 'addr', not initialized. */
+	uint64_t addr = gpa & PAGE_MASK, end = gpa + size, pg_size;
+	/** Declare the following local variables of type const uint64_t *.
+	 *  - pgentry representing the EPT entry mapping 'addr', not initialized. */
+	const uint64_t *pgentry;
+	/** Declare the following local variables of type struct acrn_vcpu *.
+	 *  - vcpu representing an online vCPU of the given VM, not initialized. */
+	struct acrn_vcpu *vcpu;
+	/** Declare the following local variables of type uint16_t.
+	 *  - i representing the loop counter as vCPU index, not initialized. */
+	uint16_t i;
+
+	/** Logging the following information with a log level of ACRN_DBG_EPT.
+	 * - __func__
+	 * - vm->vm_id
+	 * - gpa
+	 * - size
+	 */
+	dev_dbg(ACRN_DBG_EPT, "%s,vm[%d] gpa 0x%lx size 0x%lx\n", __func__, vm->vm_id, gpa, size);
+
+	/** Call spinlock_obtain with the following parameter, in order to acquire the spinlock for protecting EPT
+	 *  manipulations.
+	 *  - &vm->ept_lock
+	 */
+	spinlock_obtain(&vm->ept_lock);
+
+	/** Until 'addr' is equal to or larger than 'end' */
+	while (addr < end) {
+		/** Call lookup_address with the following parameters and set pgentry to its return value, in order to
+		 *  get the EPT entry mapping 'addr'.
+		 *  - pml4_page
+		 *  - addr
+		 *  - &pg_size
+		 *  - mem_ops
+		 */
+		pgentry = lookup_address(pml4_page, addr, &pg_size, mem_ops);
+
+		/** If 'addr' is mapped to write-back memory */
+		if ((pgentry != NULL) && ((*pgentry & EPT_MT_MASK) == EPT_WB)) {
+			/** If 'addr' is mapped by a 4-KByte page */
+			if (pg_size == PTE_SIZE) {
+				/** Call ept_grant_exe_pt with the following parameters, in order to make all pages
+				 *  in the page table containing 'pgentry' executable.
+				 *  - the page-aligned address of pgentry
+				 *  - mem_ops
+				 */
+				ept_grant_exe_pt((uint64_t *)((uint64_t)pgentry & PAGE_MASK), mem_ops);
+			/** If 'addr' is mapped by a large page without the execute permission */
+			} else if ((*pgentry & EPT_EXE) == 0UL) {
+				/** Call mmu_modify_or_del with following parameters in order to split the large page,
+				 *  which recovers the execute permission of all resulting 4-KByte pages.
+				 *  - pml4_page
+				 *  - addr
+				 *  - PAGE_SIZE
+				 *  - EPT_EXE
+				 *  - 0
+				 *  - mem_ops
+				 *  - MR_MODIFY
+				 */
+				mmu_modify_or_del(pml4_page, addr, PAGE_SIZE, EPT_EXE, 0UL, mem_ops, MR_MODIFY);
+			} else {
+				/* The large page is already executable, nothing to do */
+			}
+		}
+
+		/** Set 'addr' to the start of the next 2-MByte region */
+		addr = (addr & PDE_MASK) + PDE_SIZE;
+	}
+
 	/** Call spinlock_release with the following parameter, in order to release the spinlock for protecting EPT
 	 *  manipulations.
 	 *  - &vm->ept_lock
@@ -354,6 +635,7 @@ void ept_del_mr(struct acrn_vm *vm, uint64_t *pml4_page, uint64_t gpa, uint64_t
  *
  * @param[in] pge The pointer that points to a leaf page entry.
  * @param[in] size The size of guest memory region.
+ * @param[in] data The context of the walk, which is not used.
  *
  * @return None
  *
@@ -369,7 +651,7 @@ void ept_del_mr(struct acrn_vm *vm, uint64_t *pml4_page, uint64_t gpa, uint64_t
  * @reentrancy Unspecified
  * @threadsafety Yes
  */
-void ept_flush_leaf_page(uint64_t *pge, uint64_t size)
+void ept_flush_leaf_page(uint64_t *pge, uint64_t size, __unused void *data)
 {
 	/** Declare the following local variables of type uint64_t.
 	 *  - hpa representing the corresponding start host physical memory address
@@ -409,6 +691,7 @@ void ept_flush_leaf_page(uint64_t *pge, uint64_t size)
  *
  * @param[in] vm Pointer to the VM whose EPT is walked through.
  * @param[in] cb The callback for each EPT entry.
+ * @param[inout] data The context passed to each call of \a cb, which may be NULL.
  *
  * @return None
  *
@@ -424,7 +707,7 @@ void ept_flush_leaf_page(uint64_t *pge, uint64_t size)
  * @reentrancy Unspecified
  * @threadsafety Yes
  */
-void walk_ept_table(struct acrn_vm *vm, pge_handler cb)
+void walk_ept_table(struct acrn_vm *vm, pge_handler cb, void *data)
 {
 	/** Declare the following local variable of type uint64_t *.
 	 *  - pml4_page representing the PML4 page of the EPT of the given VM, initialized as the return value of
@@ -440,8 +723,298 @@ void walk_ept_table(struct acrn_vm *vm, pge_handler cb)
 	 *  - pml4_page
 	 *  - mem_ops
 	 *  - cb
+	 *  - data
+	 */
+	walk_page_table(pml4_page, mem_ops, cb, data);
+}
+
+/**
+ * @brief Test and clear the accessed and dirty flags of a leaf EPT entry.
+ *
+ * The size of the page the entry maps is added to the accessed bytes of the harvest if the page is accessed, and to
+ * its dirty bytes as well if the page is dirty. The flags are cleared with locked instructions, as the processor
+ * may set them at the same time. The software dirty bit is set before the dirty flag is cleared, so that the next VM
+ * checkpoint still copies the page.
+ *
+ * @param[inout] pge Pointer to the leaf EPT entry.
+ * @param[in] size The size of the page the entry maps.
+ * @param[inout] data Pointer to the struct harvest_ad_ctx of the harvest.
+ *
+ * @return None
+ *
+ * @pre pge != NULL
+ * @pre data != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal function called by walk_page_table from ept_harvest_ad.
+ *
+ * @reentrancy Unspecified
+ * @threadsafety When \a data is different among parallel invocation
+ */
+static void harvest_ad_leaf(uint64_t *pge, uint64_t size, void *data)
+{
+	/** Declare the following local variables of type struct harvest_ad_ctx *.
+	 *  - ctx representing the context of the harvest, initialized as \a data. */
+	struct harvest_ad_ctx *ctx = (struct harvest_ad_ctx *)data;
+
+	/** If the dirty flag of the entry is set */
+	if (bitmap_test(EPT_DIRTY_POS, pge)) {
+		/** Call bitmap_set_lock with the following parameters, in order to keep the page dirty for the next
+		 *  VM checkpoint.
+		 *  - EPT_SOFT_DIRTY_POS
+		 *  - pge
+		 */
+		bitmap_set_lock(EPT_SOFT_DIRTY_POS, pge);
+		/** Call bitmap_clear_lock with the following parameters, in order to clear the dirty flag.
+		 *  - EPT_DIRTY_POS
+		 *  - pge
+		 */
+		bitmap_clear_lock(EPT_DIRTY_POS, pge);
+		/** Increment ctx->dirty_bytes by size */
+		ctx->dirty_bytes += size;
+	}
+	/** If the accessed flag of the entry is set, clearing it */
+	if (bitmap_test_and_clear_lock(EPT_ACCESSED_POS, pge)) {
+		/** Increment ctx->accessed_bytes by size */
+		ctx->accessed_bytes += size;
+	}
+}
+
+/**
+ * @brief Harvest the EPT accessed and dirty flags of a VM.
+ *
+ * This function sums up the sizes of the pages of the VM accessed and written since the previous harvest, and clears
+ * their accessed and dirty flags. The vCPUs of the VM are requested to flush their cached EPT translations, so that
+ * the processor sets the flags again on the next access to each page. The pages are counted at the granularity they
+ * are mapped with, so that a 2-MByte page accessed at one byte counts as 2 MBytes.
+ *
+ * @param[in] vm Pointer to the VM whose EPT accessed and dirty flags are harvested.
+ * @param[out] accessed Pointer to the number of bytes accessed since the previous harvest.
+ * @param[out] dirty Pointer to the number of bytes written since the previous harvest.
+ *
+ * @return None
+ *
+ * @pre vm != NULL
+ * @pre accessed != NULL
+ * @pre dirty != NULL
+ * @pre vm->arch_vm.ept_ad == true
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark N/A
+ *
+ * @reentrancy Unspecified
+ * @threadsafety When \a vm is different among parallel invocation
+ */
+void ept_harvest_ad(struct acrn_vm *vm, uint64_t *accessed, uint64_t *dirty)
+{
+	/** Declare the following local variables of type uint16_t.
+	 *  - i representing the loop counter for vCPUs, not initialized. */
+	uint16_t i;
+	/** Declare the following local variables of type struct acrn_vcpu *.
+	 *  - vcpu representing a pointer to a vCPU of the VM, not initialized. */
+	struct acrn_vcpu *vcpu;
+	/** Declare the following local variables of type struct harvest_ad_ctx.
+	 *  - ctx representing the numbers of bytes found accessed and dirty, initialized as all 0s. */
+	struct harvest_ad_ctx ctx = { 0UL, 0UL };
+
+	/** Call spinlock_obtain with the following parameter, in order to keep the EPT from being changed while it is
+	 *  walked through.
+	 *  - &vm->ept_lock
+	 */
+	spinlock_obtain(&vm->ept_lock);
+	/** Call walk_ept_table with the following parameters, in order to harvest the flags of each leaf entry.
+	 *  - vm
+	 *  - harvest_ad_leaf
+	 *  - &ctx
+	 */
+	walk_ept_table(vm, harvest_ad_leaf, &ctx);
+	/** Call spinlock_release with the following parameter, in order to allow the EPT to be changed.
+	 *  - &vm->ept_lock
+	 */
+	spinlock_release(&vm->ept_lock);
+
+	/** For each vcpu in the online vCPUs of vm, using i as the loop counter. */
+	foreach_vcpu(i, vm, vcpu) {
+		/** Call vcpu_make_request with following parameters in order to notify the vCPU to flush its TLB.
+		 *  - vcpu
+		 *  - ACRN_REQUEST_EPT_FLUSH
+		 */
+		vcpu_make_request(vcpu, ACRN_REQUEST_EPT_FLUSH);
+	}
+
+	/** Set *accessed to ctx.accessed_bytes */
+	*accessed = ctx.accessed_bytes;
+	/** Set *dirty to ctx.dirty_bytes */
+	*dirty = ctx.dirty_bytes;
+}
+
+/**
+ * @brief Clear the dirty flag and the software dirty bit of a leaf EPT entry.
+ *
+ * @param[inout] pge Pointer to the leaf EPT entry.
+ * @param[in] size The size of the page the entry maps.
+ * @param[in] data The context of the walk, which is not used.
+ *
+ * @return None
+ *
+ * @pre pge != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal function called by walk_page_table from ept_clear_dirty.
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+static void clear_dirty_leaf(uint64_t *pge, __unused uint64_t size, __unused void *data)
+{
+	/** Call bitmap_clear_lock with the following parameters, in order to clear the software dirty bit.
+	 *  - EPT_SOFT_DIRTY_POS
+	 *  - pge
+	 */
+	bitmap_clear_lock(EPT_SOFT_DIRTY_POS, pge);
+	/** Call bitmap_clear_lock with the following parameters, in order to clear the dirty flag.
+	 *  - EPT_DIRTY_POS
+	 *  - pge
+	 */
+	bitmap_clear_lock(EPT_DIRTY_POS, pge);
+}
+
+/**
+ * @brief Mark all the pages of a VM as clean.
+ *
+ * This function clears the dirty flag and the software dirty bit of every leaf EPT entry of the VM, so that the pages
+ * found dirty later on are the ones written since. The vCPUs of the VM are requested to flush their cached EPT
+ * translations, so that the processor sets the dirty flag again on the next write to each page.
+ *
+ * @param[in] vm Pointer to the VM whose pages are marked as clean.
+ *
+ * @return None
+ *
+ * @pre vm != NULL
+ * @pre vm->arch_vm.ept_ad == true
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is called once the guest RAM of the VM is in sync with its snapshot, while none of its vCPUs runs in
+ * the guest.
+ *
+ * @reentrancy Unspecified
+ * @threadsafety When \a vm is different among parallel invocation
+ */
+void ept_clear_dirty(struct acrn_vm *vm)
+{
+	/** Declare the following local variables of type uint16_t.
+	 *  - i representing the loop counter for vCPUs, not initialized. */
+	uint16_t i;
+	/** Declare the following local variables of type struct acrn_vcpu *.
+	 *  - vcpu representing a pointer to a vCPU of the VM, not initialized. */
+	struct acrn_vcpu *vcpu;
+
+	/** Call spinlock_obtain with the following parameter, in order to keep the EPT from being changed while it is
+	 *  walked through.
+	 *  - &vm->ept_lock
 	 */
-	walk_page_table(pml4_page, mem_ops, cb);
+	spinlock_obtain(&vm->ept_lock);
+	/** Call walk_ept_table with the following parameters, in order to clear the dirty state of each leaf entry.
+	 *  - vm
+	 *  - clear_dirty_leaf
+	 *  - NULL
+	 */
+	walk_ept_table(vm, clear_dirty_leaf, NULL);
+	/** Call spinlock_release with the following parameter, in order to allow the EPT to be changed.
+	 *  - &vm->ept_lock
+	 */
+	spinlock_release(&vm->ept_lock);
+
+	/** For each vcpu in the online vCPUs of vm, using i as the loop counter. */
+	foreach_vcpu(i, vm, vcpu) {
+		/** Call vcpu_make_request with following parameters in order to notify the vCPU to flush its TLB.
+		 *  - vcpu
+		 *  - ACRN_REQUEST_EPT_FLUSH
+		 */
+		vcpu_make_request(vcpu, ACRN_REQUEST_EPT_FLUSH);
+	}
+}
+
+/**
+ * @brief Mark the pages of a VM covering a guest physical range as dirty.
+ *
+ * The processor only sets the EPT dirty flag on guest writes. This function sets the software dirty bit of the leaf EPT
+ * entries mapping the given range, so that the pages the hypervisor writes on behalf of the guest are copied by the
+ * next VM checkpoint and restore as well. Nothing is done if EPT accessed and dirty flags are not enabled for the VM.
+ *
+ * @param[in] vm Pointer to the VM whose pages are written.
+ * @param[in] gpa The guest physical address of the range.
+ * @param[in] size The size of the range in bytes.
+ *
+ * @return None
+ *
+ * @pre vm != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_INIT, HV_OPERATIONAL
+ *
+ * @remark It is called by local_copy_gpa after writing guest memory.
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+void ept_set_soft_dirty(struct acrn_vm *vm, uint64_t gpa, uint64_t size)
+{
+	/** Declare the following local variables of type uint64_t.
+	 *  - addr representing the address being marked, initialized as gpa.
+	 *  - end representing the end of the range (exclusive), initialized as gpa + size.
+	 *  - pg_size representing the size of the page mapping addr, not initialized. */
+	uint64_t addr = gpa, end = gpa + size, pg_size;
+	/** Declare the following local variables of type const uint64_t *.
+	 *  - pgentry representing the EPT entry mapping addr, not initialized. */
+	const uint64_t *pgentry;
+
+	/** If EPT accessed and dirty flags are enabled for the VM */
+	if (vm->arch_vm.ept_ad) {
+		/** Call spinlock_obtain with the following parameter, in order to keep the EPT from being changed while
+		 *  it is looked up.
+		 *  - &vm->ept_lock
+		 */
+		spinlock_obtain(&vm->ept_lock);
+		/** Until addr is equal to or larger than end */
+		while (addr < end) {
+			/** Set pgentry to the return value of lookup_address((uint64_t *)vm->arch_vm.nworld_eptp, addr,
+			 *  &pg_size, &vm->arch_vm.ept_mem_ops) */
+			pgentry = lookup_address((uint64_t *)vm->arch_vm.nworld_eptp, addr, &pg_size,
+				&vm->arch_vm.ept_mem_ops);
+			/** If addr is mapped */
+			if (pgentry != NULL) {
+				/** Call bitmap_set_lock with the following parameters, in order to mark the page as
+				 *  dirty, the processor setting the dirty flag at the same time possibly.
+				 *  - EPT_SOFT_DIRTY_POS
+				 *  - (uint64_t *)pgentry
+				 */
+				bitmap_set_lock(EPT_SOFT_DIRTY_POS, (uint64_t *)pgentry);
+			} else {
+				/** Set pg_size to PAGE_SIZE to skip the unmapped page */
+				pg_size = PAGE_SIZE;
+			}
+			/** Set addr to the start of the page following the one mapping addr */
+			addr = (addr & ~(pg_size - 1UL)) + pg_size;
+		}
+		/** Call spinlock_release with the following parameter, in order to allow the EPT to be changed.
+		 *  - &vm->ept_lock
+		 */
+		spinlock_release(&vm->ept_lock);
+	}
 }
 
 /**
@@ -10,6 +10,8 @@
 #include <vm.h>
 #include <mmu.h>
 #include <ept.h>
+#include <vmx.h>
+#include <bulk_mem.h>
 #include <logmsg.h>
 
 /**
@@ -31,6 +33,7 @@
  * - 'vp-base.vcpu' depends on this module to initialize GDT register.
  * - 'vp-dm.vperipheral' depends on this module to map and unmap physical BAR for passthrough PCI devices.
  * - 'vp-dm.io_req' depends on this module to add executable access right to the specific memory region.
+ * - 'vp-dm.io_req' depends on this module to translate and access the guest buffers of string I/O instructions.
  * - 'vp-base.hv_main' depends on this module to flush page cache when wbinvd VMExit happens.
  *
  * Dependency:
@@ -44,6 +47,7 @@
  *   - Add, modify and delete page table entries.
  * - This module depends on 'vp-base.virq' to notify vCPU to flush its TLB.
  * - This module depends on 'hwmgmt.mmu' to flush cache for a given memory region.
+ * - This module depends on 'hwmgmt.bulk-mem' to copy large regions into guest memory.
  *
  * @{
  */
@@ -212,17 +216,28 @@ static inline uint32_t local_copy_gpa(
 			(void)memcpy_s(h_ptr, len, g_ptr, len);
 		/** If we want to copy from host memory into guest memory */
 		} else {
-			/** Call memcpy_s with following parameters in order to
-			 *  copy memory content from host memory into guest memory.
-			 *  - \a h_ptr
-			 *  - len
+			/** Call bulk_copy with following parameters in order to
+			 *  copy memory content from host memory into guest memory, with SIMD non-temporal stores if
+			 *  len is large as when a guest image is loaded.
 			 *  - g_ptr
+			 *  - \a h_ptr
 			 *  - len
 			 */
-			(void)memcpy_s(g_ptr, len, h_ptr, len);
+			bulk_copy(g_ptr, h_ptr, len);
 		}
 		/** Call clac to disallow explicit supervisor-mode accesses to user-mode pages */
 		clac();
+
+		/** If 'cp_from_vm' is false, meaning the guest memory has been written */
+		if (!cp_from_vm) {
+			/** Call ept_set_soft_dirty with the following parameters, in order to have the page written
+			 *  copied by the next checkpoint of the VM, as the processor does not set its EPT dirty flag.
+			 *  - \a vm
+			 *  - \a gpa
+			 *  - len
+			 */
+			ept_set_soft_dirty(vm, gpa, len);
+		}
 	}
 
 	/** Return the actual copy size in byte. */
@@ -437,6 +452,173 @@ uint64_t gpa2hpa(struct acrn_vm *vm, uint64_t gpa)
 	return local_gpa2hpa(vm, gpa, NULL);
 }
 
+/**
+ * @brief Translate guest linear memory address to guest physical memory address.
+ *
+ * The guest paging structures referenced by the guest CR3 of \a vcpu are walked in software, using the
+ * paging mode the vCPU currently runs in (no paging, 32-bit, PAE or 4-level paging). The access rights
+ * of each level are checked against a supervisor or user (CPL 3) data access, with CR0.WP honored for
+ * supervisor writes.
+ *
+ * @param[in] vcpu The pointer to the virtual CPU whose paging structures are used for the translation.
+ * @param[in] gva The guest linear memory address.
+ * @param[in] is_write Indicates whether the access to be performed at \a gva is a write.
+ * @param[out] gpa The pointer that returns the guest physical memory address mapping to \a gva.
+ * @param[out] err_code The pointer that returns the page fault error code to be injected if the translation fails.
+ *
+ * @return 0 if the translation succeeds, otherwise return -EFAULT.
+ *
+ * @pre vcpu != NULL
+ * @pre gpa != NULL
+ * @pre err_code != NULL
+ * @pre vcpu == get_running_vcpu(get_pcpu_id())
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark The accessed and dirty flags of the guest paging structures are not updated.
+ *
+ * @reentrancy Unspecified
+ * @threadsafety When \a vcpu is different among parallel invocations.
+ */
+int32_t gva2gpa(struct acrn_vcpu *vcpu, uint64_t gva, bool is_write, uint64_t *gpa, uint32_t *err_code)
+{
+	/** Declare the following local variables of type uint64_t.
+	 *  - entry representing the paging-structure entry being walked, initialized as 0.
+	 *  - base representing the guest physical address of the paging structure being walked, not initialized.
+	 *  - pfn_mask representing the mask of the address bits in a paging-structure entry, not initialized.
+	 *  - pg_mask representing the mask of the offset bits within the region mapped by an entry,
+	 *    not initialized. */
+	uint64_t entry = 0UL, base, pfn_mask, pg_mask;
+	/** Declare the following local variables of type uint32_t.
+	 *  - level representing the level of the paging structure being walked, not initialized.
+	 *  - shift representing the bit position of the index into the paging structure being walked,
+	 *    not initialized.
+	 *  - width representing the size in bytes of one paging-structure entry, not initialized.
+	 *  - index_bits representing the number of linear address bits indexing one paging structure,
+	 *    not initialized.
+	 *  - index representing the index of the entry within the paging structure being walked, not initialized. */
+	uint32_t level, shift, width, index_bits, index;
+	/** Declare the following local variables of type bool.
+	 *  - is_user representing whether the access is a user-mode access, initialized as true if the
+	 *    DPL of the guest SS (i.e. the CPL) is 3.
+	 *  - check_wp representing whether read-only pages are write-protected for the access, initialized as
+	 *    true if is_user is true or CR0.WP of the vCPU is set. */
+	bool is_user = ((exec_vmread32(VMX_GUEST_SS_ATTR) >> 5U) & 0x3U) == 3U;
+	bool check_wp = is_user || ((vcpu_get_cr0(vcpu) & CR0_WP) != 0UL);
+	/** Declare the following local variables of type bool.
+	 *  - is_pdpte representing whether the top-level paging structure is a PAE page-directory-pointer table,
+	 *    initialized as false. */
+	bool is_pdpte = false;
+	/** Declare the following local variables of type int32_t.
+	 *  - ret representing the return value, initialized as 0. */
+	int32_t ret = 0;
+
+	/** Set *err_code to PAGE_FAULT_WR_FLAG if is_write is true or 0 otherwise,
+	 *  merged with PAGE_FAULT_US_FLAG if is_user is true */
+	*err_code = (is_write ? PAGE_FAULT_WR_FLAG : 0U) | (is_user ? PAGE_FAULT_US_FLAG : 0U);
+
+	/** If paging is not enabled on the vCPU */
+	if (!is_paging_enabled(vcpu)) {
+		/** Set *gpa to gva as linear addresses are physical addresses */
+		*gpa = gva;
+	} else {
+		/** If the vCPU is in long mode, which uses 4-level paging */
+		if (is_long_mode(vcpu)) {
+			/** Set level to 4, width to 8 and index_bits to 9 */
+			level = 4U;
+			width = 8U;
+			index_bits = 9U;
+			/** Set pfn_mask to the address bits of a 64-bit paging-structure entry */
+			pfn_mask = MAXPHYADDR_MASK & PAGE_MASK;
+			/** Set base to the PML4 table address in the guest CR3 */
+			base = exec_vmread(VMX_GUEST_CR3) & pfn_mask;
+		/** If PAE is enabled on the vCPU */
+		} else if (is_pae(vcpu)) {
+			/** Set level to 3, width to 8 and index_bits to 9 */
+			level = 3U;
+			width = 8U;
+			index_bits = 9U;
+			/** Set is_pdpte to true */
+			is_pdpte = true;
+			/** Set pfn_mask to the address bits of a 64-bit paging-structure entry */
+			pfn_mask = MAXPHYADDR_MASK & PAGE_MASK;
+			/** Set base to the 32-byte aligned page-directory-pointer table address in the guest CR3 */
+			base = exec_vmread(VMX_GUEST_CR3) & 0xFFFFFFE0UL;
+		} else {
+			/** Set level to 2, width to 4 and index_bits to 10 for 32-bit paging */
+			level = 2U;
+			width = 4U;
+			index_bits = 10U;
+			/** Set pfn_mask to the address bits of a 32-bit paging-structure entry */
+			pfn_mask = 0xFFFFF000UL;
+			/** Set base to the page directory address in the guest CR3 */
+			base = exec_vmread(VMX_GUEST_CR3) & pfn_mask;
+		}
+		/** Set shift to the bit position of the index into the top-level paging structure */
+		shift = PAGE_SHIFT + (index_bits * (level - 1U));
+
+		/** Loop until a leaf entry is found or the walk fails */
+		while (true) {
+			/** Set index to the bits of gva indexing the paging structure at this level */
+			index = (uint32_t)(gva >> shift) & ((1U << index_bits) - 1U);
+			/** If the entry can not be read from guest memory by calling copy_from_gpa() with
+			 *  the following parameters:
+			 *  - vcpu->vm
+			 *  - &entry
+			 *  - base + (index * width)
+			 *  - width */
+			if (copy_from_gpa(vcpu->vm, &entry, base + ((uint64_t)index * width), width) != 0) {
+				/** Set ret to -EFAULT */
+				ret = -EFAULT;
+				/** Terminate the loop */
+				break;
+			}
+			/** If the entry is not present */
+			if ((entry & PAGE_PRESENT) == 0UL) {
+				/** Set ret to -EFAULT */
+				ret = -EFAULT;
+				/** Terminate the loop */
+				break;
+			}
+			/** If the entry is not a PAE page-directory-pointer-table entry, which has no access
+			 *  rights, and it denies the access */
+			if (!(is_pdpte && (level == 3U)) && ((is_write && check_wp && ((entry & PAGE_RW) == 0UL)) ||
+				(is_user && ((entry & PAGE_USER) == 0UL)))) {
+				/** Set PAGE_FAULT_P_FLAG in *err_code as this is a protection violation */
+				*err_code |= PAGE_FAULT_P_FLAG;
+				/** Set ret to -EFAULT */
+				ret = -EFAULT;
+				/** Terminate the loop */
+				break;
+			}
+
+			/** If the entry maps a page, i.e. the walk reaches the page table, or the entry is a
+			 *  PDE or 4-level paging PDPTE with PS set (a 4-MByte page also requires CR4.PSE with 32-bit paging) */
+			if ((level == 1U) || (((entry & PAGE_PS) != 0UL) &&
+				(((level == 2U) && ((width == 8U) || ((vcpu_get_cr4(vcpu) & CR4_PSE) != 0UL))) ||
+				((level == 3U) && !is_pdpte)))) {
+				/** Set pg_mask to the offset bits within the region mapped by the entry */
+				pg_mask = (1UL << shift) - 1UL;
+				/** Set *gpa to the frame address in the entry merged with the offset in gva */
+				*gpa = (entry & pfn_mask & ~pg_mask) | (gva & pg_mask);
+				/** Terminate the loop */
+				break;
+			}
+
+			/** Set base to the address of the next-level paging structure in the entry */
+			base = entry & pfn_mask;
+			/** Step to the next level */
+			level--;
+			shift -= index_bits;
+		}
+	}
+
+	/** Return ret */
+	return ret;
+}
+
 /**
  * @}
  */
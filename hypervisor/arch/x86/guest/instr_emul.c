@@ -0,0 +1,1024 @@
+/*
+ * Copyright (C) 2019 Intel Corporation. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <types.h>
+#include <errno.h>
+#include <rtl.h>
+#include <vcpu.h>
+#include <vm.h>
+#include <vmx.h>
+#include <virq.h>
+#include <io_req.h>
+#include <instr_emul.h>
+#include <guest_memory.h>
+#include <logmsg.h>
+
+/**
+ * @addtogroup vp-dm_io-req
+ *
+ * @{
+ */
+
+/**
+ * @file
+ * @brief This file implements the decoding and emulation of the guest instructions that access emulated
+ *	  MMIO ranges and cause EPT violations.
+ *
+ * The instruction at the guest RIP is fetched through the guest paging structures and decoded into a
+ * struct instr_emul_vie, which is kept in a per-vCPU cache indexed by guest RIP and CR3 so that a driver
+ * polling a register from the same instruction skips the page walk and the decoding. The memory operand
+ * is accessed through emulate_mmio() at the guest physical address reported by the EPT violation.
+ *
+ * External APIs:
+ * - emulate_mmio_instruction()
+ *
+ * Internal functions:
+ * - vie_size2mask()
+ * - vie_get_reg()
+ * - vie_set_reg()
+ * - vie_update_logic_flags()
+ * - vie_mmio_access()
+ * - vie_fetch()
+ * - vie_decode()
+ * - vie_cache_lookup()
+ * - vie_emulate_stos()
+ * - vie_execute()
+ */
+
+/**
+ * @brief Bit indicator for the carry flag in RFLAGS.
+ */
+#define VIE_RFLAGS_CF	(1UL << 0U)
+/**
+ * @brief Bit indicator for the parity flag in RFLAGS.
+ */
+#define VIE_RFLAGS_PF	(1UL << 2U)
+/**
+ * @brief Bit indicator for the zero flag in RFLAGS.
+ */
+#define VIE_RFLAGS_ZF	(1UL << 6U)
+/**
+ * @brief Bit indicator for the sign flag in RFLAGS.
+ */
+#define VIE_RFLAGS_SF	(1UL << 7U)
+/**
+ * @brief Bit indicator for the direction flag in RFLAGS.
+ */
+#define VIE_RFLAGS_DF	(1UL << 10U)
+/**
+ * @brief Bit indicator for the overflow flag in RFLAGS.
+ */
+#define VIE_RFLAGS_OF	(1UL << 11U)
+
+/**
+ * @brief Size of the zero-padded buffer an instruction is decoded from.
+ *
+ * The decoder reads at most 27 bytes (15 prefixes, 2 opcode bytes, ModR/M, SIB, 4-byte displacement and
+ * 4-byte immediate) before it checks the length, so reads past the fetched bytes only see the padding.
+ */
+#define VIE_DECODE_BUF_SIZE	32U
+
+/**
+ * @brief Return the mask of the low \a size bytes of a 64-bit value.
+ *
+ * @param[in] size The size in bytes, which is 1, 2, 4 or 8.
+ *
+ * @return The mask of the low \a size bytes.
+ *
+ * @pre size == 1 || size == 2 || size == 4 || size == 8
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+static inline uint64_t vie_size2mask(uint8_t size)
+{
+	/** Return all 1s if size is 8, otherwise (1 << (8 * size)) - 1 */
+	return (size == 8U) ? ~0UL : ((1UL << (8U * size)) - 1UL);
+}
+
+/**
+ * @brief Read the low \a size bytes of a general-purpose register operand of the guest.
+ *
+ * @param[in] vcpu The vCPU whose register is read.
+ * @param[in] reg The register encoded in the instruction, CPU_REG_RAX to CPU_REG_R15.
+ * @param[in] rex_present Whether the instruction has a REX prefix.
+ * @param[in] size The size of the operand in bytes.
+ *
+ * @return The value of the operand, with byte registers 4-7 read as AH, CH, DH and BH if \a rex_present is false.
+ *
+ * @pre vcpu != NULL
+ * @pre reg <= CPU_REG_R15
+ * @pre size == 1 || size == 2 || size == 4 || size == 8
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vcpu is different among parallel invocations.
+ */
+static uint64_t vie_get_reg(const struct acrn_vcpu *vcpu, uint32_t reg, bool rex_present, uint8_t size)
+{
+	/** Declare the following local variables of type uint64_t.
+	 *  - val representing the value of the operand, not initialized. */
+	uint64_t val;
+
+	/** If the operand is one of AH, CH, DH and BH */
+	if ((size == 1U) && !rex_present && (reg >= CPU_REG_RSP) && (reg <= CPU_REG_RDI)) {
+		/** Set val to bits 15:8 of the register reg - 4 */
+		val = (vcpu_get_gpreg(vcpu, reg - 4U) >> 8U) & 0xFFUL;
+	} else {
+		/** Set val to the low size bytes of the register reg */
+		val = vcpu_get_gpreg(vcpu, reg) & vie_size2mask(size);
+	}
+
+	/** Return val */
+	return val;
+}
+
+/**
+ * @brief Write the low \a size bytes of a general-purpose register operand of the guest.
+ *
+ * A 4-byte write zero-extends into the register and a 1-byte or 2-byte write keeps the other bits of the
+ * register, as for a MOV to the register.
+ *
+ * @param[inout] vcpu The vCPU whose register is written.
+ * @param[in] reg The register encoded in the instruction, CPU_REG_RAX to CPU_REG_R15.
+ * @param[in] rex_present Whether the instruction has a REX prefix.
+ * @param[in] size The size of the operand in bytes.
+ * @param[in] val The value to write.
+ *
+ * @return None
+ *
+ * @pre vcpu != NULL
+ * @pre reg <= CPU_REG_R15
+ * @pre size == 1 || size == 2 || size == 4 || size == 8
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vcpu is different among parallel invocations.
+ */
+static void vie_set_reg(struct acrn_vcpu *vcpu, uint32_t reg, bool rex_present, uint8_t size, uint64_t val)
+{
+	/** Declare the following local variables of type uint32_t.
+	 *  - target representing the register to be written, initialized as reg.
+	 *  - shift representing the bit position of the operand in the register, initialized as 0. */
+	uint32_t target = reg, shift = 0U;
+	/** Declare the following local variables of type uint64_t.
+	 *  - mask representing the bits of the register written, initialized as the mask of size bytes. */
+	uint64_t mask = vie_size2mask(size);
+
+	/** If the operand is one of AH, CH, DH and BH */
+	if ((size == 1U) && !rex_present && (reg >= CPU_REG_RSP) && (reg <= CPU_REG_RDI)) {
+		/** Set target to reg - 4 and shift to 8 */
+		target = reg - 4U;
+		shift = 8U;
+	}
+
+	/** If size is 4, which zero-extends */
+	if (size == 4U) {
+		/** Call vcpu_set_gpreg() to set the register target to the low 4 bytes of val */
+		vcpu_set_gpreg(vcpu, target, val & mask);
+	} else {
+		/** Call vcpu_set_gpreg() to merge the low size bytes of val at shift into the register target */
+		vcpu_set_gpreg(vcpu, target,
+			(vcpu_get_gpreg(vcpu, target) & ~(mask << shift)) | ((val & mask) << shift));
+	}
+}
+
+/**
+ * @brief Update the guest RFLAGS for the result of a logical operation (AND, OR, TEST).
+ *
+ * CF and OF are cleared, and PF, ZF and SF are set from the result. AF is undefined and left as is.
+ *
+ * @param[inout] vcpu The vCPU whose RFLAGS is updated.
+ * @param[in] result The result of the operation.
+ * @param[in] size The operand size in bytes.
+ *
+ * @return None
+ *
+ * @pre vcpu != NULL
+ * @pre size == 1 || size == 2 || size == 4 || size == 8
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vcpu is different among parallel invocations.
+ */
+static void vie_update_logic_flags(struct acrn_vcpu *vcpu, uint64_t result, uint8_t size)
+{
+	/** Declare the following local variables of type uint64_t.
+	 *  - rflags representing the guest RFLAGS with the status flags updated here cleared,
+	 *    initialized accordingly.
+	 *  - res representing the result truncated to size bytes, initialized accordingly. */
+	uint64_t rflags = vcpu_get_rflags(vcpu) & ~(VIE_RFLAGS_CF | VIE_RFLAGS_PF | VIE_RFLAGS_ZF |
+		VIE_RFLAGS_SF | VIE_RFLAGS_OF);
+	uint64_t res = result & vie_size2mask(size);
+	/** Declare the following local variables of type uint8_t.
+	 *  - parity representing the XOR of the bits in the low byte of res, initialized as the low byte of res. */
+	uint8_t parity = (uint8_t)res;
+
+	/** Fold parity down to its bit 0 */
+	parity ^= (uint8_t)(parity >> 4U);
+	parity ^= (uint8_t)(parity >> 2U);
+	parity ^= (uint8_t)(parity >> 1U);
+
+	/** If the low byte of res has an even number of 1s, set PF */
+	if ((parity & 1U) == 0U) {
+		rflags |= VIE_RFLAGS_PF;
+	}
+	/** If res is 0, set ZF */
+	if (res == 0UL) {
+		rflags |= VIE_RFLAGS_ZF;
+	}
+	/** If the most significant bit of res is 1, set SF */
+	if (((res >> ((8U * size) - 1U)) & 1UL) != 0UL) {
+		rflags |= VIE_RFLAGS_SF;
+	}
+
+	/** Call vcpu_set_rflags() with vcpu and rflags, in order to update the guest RFLAGS */
+	vcpu_set_rflags(vcpu, rflags);
+}
+
+/**
+ * @brief Access an emulated MMIO range through its registered handler.
+ *
+ * @param[inout] vcpu The vCPU performing the access.
+ * @param[in] gpa The guest physical address of the access.
+ * @param[in] size The size of the access in bytes.
+ * @param[in] direction REQUEST_READ or REQUEST_WRITE.
+ * @param[inout] val The value to write, or the value read.
+ *
+ * @return 0 if the access is emulated, otherwise the error returned by emulate_mmio().
+ *
+ * @pre vcpu != NULL
+ * @pre val != NULL
+ * @pre size == 1 || size == 2 || size == 4 || size == 8
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vcpu is different among parallel invocations.
+ */
+static int32_t vie_mmio_access(struct acrn_vcpu *vcpu, uint64_t gpa, uint8_t size, uint32_t direction, uint64_t *val)
+{
+	/** Declare the following local variables of type struct mmio_request *.
+	 *  - mmio_req representing the MMIO request of vcpu, initialized as &vcpu->req.reqs.mmio. */
+	struct mmio_request *mmio_req = &vcpu->req.reqs.mmio;
+	/** Declare the following local variables of type int32_t.
+	 *  - ret representing the return value, not initialized. */
+	int32_t ret;
+
+	/** Set the direction, address, size and value of mmio_req */
+	mmio_req->direction = direction;
+	mmio_req->address = gpa;
+	mmio_req->size = size;
+	mmio_req->value = (direction == REQUEST_WRITE) ? (*val & vie_size2mask(size)) : 0UL;
+
+	/** Call emulate_mmio() with vcpu and &vcpu->req and set ret to its return value */
+	ret = emulate_mmio(vcpu, &vcpu->req);
+	/** If the access is a read emulated successfully */
+	if ((ret == 0) && (direction == REQUEST_READ)) {
+		/** Set *val to the low size bytes of the value read */
+		*val = mmio_req->value & vie_size2mask(size);
+	}
+
+	/** Return ret */
+	return ret;
+}
+
+/**
+ * @brief Fetch the bytes of the instruction at the guest RIP.
+ *
+ * Up to VIE_INST_SIZE bytes are fetched. If the bytes cross a page boundary and the following page can not
+ * be translated, only the bytes in the first page are fetched and the page fault of the following page is
+ * returned through \a next_gva and \a next_err, to be injected if the instruction turns out to need them.
+ *
+ * @param[in] vcpu The vCPU whose instruction is fetched.
+ * @param[in] rip The guest RIP.
+ * @param[out] inst The buffer receiving the bytes.
+ * @param[out] inst_gpa The guest physical address of the first byte.
+ * @param[out] len_lo The number of bytes fetched from the page of the first byte.
+ * @param[out] len The number of bytes fetched.
+ * @param[out] next_gva The guest linear address of the following page.
+ * @param[out] next_err The page fault error code of the following page, 0 if it is translated.
+ *
+ * @return 0 if the first byte is fetched, otherwise -EFAULT with a page fault injected.
+ *
+ * @pre vcpu != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vcpu is different among parallel invocations.
+ */
+static int32_t vie_fetch(struct acrn_vcpu *vcpu, uint64_t rip, uint8_t *inst, uint64_t *inst_gpa,
+	uint32_t *len_lo, uint32_t *len, uint64_t *next_gva, uint32_t *next_err)
+{
+	/** Declare the following local variables of type uint64_t.
+	 *  - gva representing the guest linear address of the instruction, initialized as rip.
+	 *  - gpa_hi representing the guest physical address of the following page, not initialized. */
+	uint64_t gva = rip, gpa_hi;
+	/** Declare the following local variables of type uint32_t.
+	 *  - err_code representing the page fault error code of a failed translation, not initialized. */
+	uint32_t err_code;
+	/** Declare the following local variables of type int32_t.
+	 *  - ret representing the return value, not initialized. */
+	int32_t ret;
+
+	/** If the vCPU is not in 64-bit mode */
+	if (get_vcpu_mode(vcpu) != CPU_MODE_64BIT) {
+		/** Set gva to the CS base plus rip, truncated to 32 bits */
+		gva = (exec_vmread(VMX_GUEST_CS_BASE) + rip) & 0xFFFFFFFFUL;
+	}
+
+	/** Set *len_lo to the number of bytes from gva to the end of its page, at most VIE_INST_SIZE */
+	*len_lo = PAGE_SIZE - ((uint32_t)gva & (PAGE_SIZE - 1U));
+	*len_lo = (*len_lo > VIE_INST_SIZE) ? VIE_INST_SIZE : *len_lo;
+	/** Set *len to *len_lo and *next_err to 0 */
+	*len = *len_lo;
+	*next_err = 0U;
+	/** Set *next_gva to the guest linear address right after the first *len_lo bytes */
+	*next_gva = gva + *len_lo;
+
+	/** Call gva2gpa() to translate gva into *inst_gpa for a read access and set ret to its return value */
+	ret = gva2gpa(vcpu, gva, false, inst_gpa, &err_code);
+	/** If gva can not be translated or its bytes can not be read */
+	if ((ret != 0) || (copy_from_gpa(vcpu->vm, inst, *inst_gpa, *len_lo) != 0)) {
+		/** Call vcpu_inject_pf() with vcpu, gva and err_code, in order to report the fault to the guest */
+		vcpu_inject_pf(vcpu, gva, (ret != 0) ? err_code : 0U);
+		/** Set ret to -EFAULT */
+		ret = -EFAULT;
+	/** If the instruction may extend into the following page */
+	} else if (*len_lo < VIE_INST_SIZE) {
+		/** If the following page is translated and its bytes can be read */
+		if ((gva2gpa(vcpu, *next_gva, false, &gpa_hi, &err_code) == 0) &&
+			(copy_from_gpa(vcpu->vm, &inst[*len_lo], gpa_hi, VIE_INST_SIZE - *len_lo) == 0)) {
+			/** Set *len to VIE_INST_SIZE */
+			*len = VIE_INST_SIZE;
+		} else {
+			/** Set *next_err to err_code with the bit 31 set, which marks a pending fault */
+			*next_err = err_code | (1U << 31U);
+		}
+	} else {
+		/* the instruction is within the page of gva */
+	}
+
+	/** Return ret */
+	return ret;
+}
+
+/**
+ * @brief Decode an instruction accessing an emulated MMIO range.
+ *
+ * The prefixes 66H, 67H, F3H (REP), F0H (LOCK) and the segment overrides are accepted, the segment override
+ * being irrelevant as the accessed address is the guest physical address of the EPT violation. The
+ * ModR/M, SIB and displacement bytes are only parsed for the instruction length, as is the REX prefix
+ * apart from W (operand size) and R (register operand).
+ *
+ * @param[in] vcpu The vCPU executing the instruction.
+ * @param[in] inst The instruction bytes, padded with zeros up to VIE_DECODE_BUF_SIZE bytes.
+ * @param[in] avail The number of bytes in \a inst fetched from the guest.
+ * @param[out] vie The decoded instruction.
+ *
+ * @return 0 if the instruction is decoded, -ERANGE if it needs more than \a avail bytes, or -EINVAL if it is not
+ *	   supported.
+ *
+ * @pre vcpu != NULL
+ * @pre inst != NULL
+ * @pre vie != NULL
+ * @pre avail <= VIE_INST_SIZE
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vcpu is different among parallel invocations.
+ */
+static int32_t vie_decode(struct acrn_vcpu *vcpu, const uint8_t *inst, uint32_t avail, struct instr_emul_vie *vie)
+{
+	/** Declare the following local variables of type uint32_t.
+	 *  - pos representing the position of the byte being decoded, initialized as 0.
+	 *  - imm_size representing the size of the immediate in bytes, initialized as 0.
+	 *  - disp_size representing the size of the displacement in bytes, initialized as 0.
+	 *  - i representing the loop counter, not initialized. */
+	uint32_t pos = 0U, imm_size = 0U, disp_size = 0U, i;
+	/** Declare the following local variables of type uint8_t.
+	 *  - op representing the opcode byte, not initialized.
+	 *  - rex representing the REX prefix, initialized as 0.
+	 *  - modrm representing the ModR/M byte, not initialized.
+	 *  - def_size representing the default operand and address size in bytes, not initialized.
+	 *  - group_op representing the operation selected by the reg field of the ModR/M byte for the opcode
+	 *    groups 80H/81H/83H and F6H/F7H, initialized as 0xFF (no group). */
+	uint8_t op, rex = 0U, modrm, def_size, group_op = 0xFFU;
+	/** Declare the following local variables of type bool.
+	 *  - opsize_override representing whether the prefix 66H is present, initialized as false.
+	 *  - addrsize_override representing whether the prefix 67H is present, initialized as false.
+	 *  - byte_op representing whether the operands are bytes, initialized as false.
+	 *  - has_modrm representing whether the instruction has a ModR/M byte, initialized as true.
+	 *  - is_64bit representing whether the vCPU is in 64-bit mode, initialized accordingly. */
+	bool opsize_override = false, addrsize_override = false, byte_op = false, has_modrm = true;
+	bool is_64bit = (get_vcpu_mode(vcpu) == CPU_MODE_64BIT);
+	/** Declare the following local variables of type int32_t.
+	 *  - ret representing the return value, initialized as 0. */
+	int32_t ret = 0;
+
+	/** Call memset() to clear *vie */
+	(void)memset(vie, 0U, sizeof(struct instr_emul_vie));
+
+	/** Skip the legacy prefixes, recording 66H, 67H and F3H */
+	while (pos < avail) {
+		/** If inst[pos] is the operand-size override prefix */
+		if (inst[pos] == 0x66U) {
+			opsize_override = true;
+		/** If inst[pos] is the address-size override prefix */
+		} else if (inst[pos] == 0x67U) {
+			addrsize_override = true;
+		/** If inst[pos] is the REP prefix */
+		} else if (inst[pos] == 0xF3U) {
+			vie->rep = true;
+		/** If inst[pos] is LOCK or a segment override prefix, which do not change the emulation */
+		} else if ((inst[pos] == 0xF0U) || (inst[pos] == 0x26U) || (inst[pos] == 0x2EU) ||
+			(inst[pos] == 0x36U) || (inst[pos] == 0x3EU) || (inst[pos] == 0x64U) || (inst[pos] == 0x65U)) {
+			/* nothing to record */
+		} else {
+			/** Terminate the loop at the first byte which is not a prefix */
+			break;
+		}
+		/** Step to the next byte */
+		pos++;
+	}
+	/** If the vCPU is in 64-bit mode and inst[pos] is a REX prefix */
+	if (is_64bit && ((inst[pos] & 0xF0U) == 0x40U)) {
+		/** Set rex to inst[pos], vie->rex_present to true and step to the next byte */
+		rex = inst[pos];
+		vie->rex_present = true;
+		pos++;
+	}
+
+	/** If the vCPU is in 64-bit mode */
+	if (is_64bit) {
+		/** Set the address size to 4 with 67H or 8 otherwise */
+		vie->addrsize = addrsize_override ? 4U : 8U;
+		/** Set the operand size to 8 with REX.W, 2 with 66H or 4 otherwise */
+		vie->opsize = ((rex & 0x8U) != 0U) ? 8U : (opsize_override ? 2U : 4U);
+	} else {
+		/** Set def_size to 4 if the D bit of the guest CS attributes is set, or 2 otherwise */
+		def_size = ((exec_vmread32(VMX_GUEST_CS_ATTR) & (1U << 14U)) != 0U) ? 4U : 2U;
+		/** Set the address size and operand size to def_size, switched between 2 and 4 by 67H and 66H */
+		vie->addrsize = addrsize_override ? (6U - def_size) : def_size;
+		vie->opsize = opsize_override ? (6U - def_size) : def_size;
+	}
+
+	/** Set op to the opcode byte and step to the next byte */
+	op = inst[pos];
+	pos++;
+	/** If op is the two-byte opcode escape 0FH */
+	if (op == 0x0FU) {
+		/** Set op to the second opcode byte and step to the next byte */
+		op = inst[pos];
+		pos++;
+		/** Decode MOVZX (B6H, B7H) and MOVSX (BEH, BFH), whose memory operand is a byte for B6H/BEH
+		 *  and a word otherwise */
+		if ((op == 0xB6U) || (op == 0xB7U)) {
+			vie->op_type = VIE_OP_TYPE_MOVZX;
+			vie->mem_size = (op == 0xB6U) ? 1U : 2U;
+		} else if ((op == 0xBEU) || (op == 0xBFU)) {
+			vie->op_type = VIE_OP_TYPE_MOVSX;
+			vie->mem_size = (op == 0xBEU) ? 1U : 2U;
+		} else {
+			/** Set ret to -EINVAL for other two-byte opcodes */
+			ret = -EINVAL;
+		}
+	} else {
+		/** Decode the one-byte opcode, where bit 0 clear means byte operands for all supported ones
+		 *  except 83H */
+		switch (op) {
+		case 0x08U:
+		case 0x09U:
+			vie->op_type = VIE_OP_TYPE_OR_TO_MEM;
+			break;
+		case 0x0AU:
+		case 0x0BU:
+			vie->op_type = VIE_OP_TYPE_OR_FROM_MEM;
+			break;
+		case 0x20U:
+		case 0x21U:
+			vie->op_type = VIE_OP_TYPE_AND_TO_MEM;
+			break;
+		case 0x22U:
+		case 0x23U:
+			vie->op_type = VIE_OP_TYPE_AND_FROM_MEM;
+			break;
+		case 0x84U:
+		case 0x85U:
+			vie->op_type = VIE_OP_TYPE_TEST;
+			break;
+		case 0x88U:
+		case 0x89U:
+			vie->op_type = VIE_OP_TYPE_MOV_TO_MEM;
+			break;
+		case 0x8AU:
+		case 0x8BU:
+			vie->op_type = VIE_OP_TYPE_MOV_FROM_MEM;
+			break;
+		case 0xC6U:
+		case 0xC7U:
+			vie->op_type = VIE_OP_TYPE_MOV_IMM_TO_MEM;
+			group_op = 0U;
+			break;
+		case 0x80U:
+		case 0x81U:
+		case 0x83U:
+			/* OR (/1) or AND (/4) with an immediate, resolved after the ModR/M byte */
+			vie->op_type = VIE_OP_TYPE_OR_TO_MEM;
+			group_op = 0x14U;
+			break;
+		case 0xF6U:
+		case 0xF7U:
+			vie->op_type = VIE_OP_TYPE_TEST;
+			group_op = 0U;
+			break;
+		case 0xAAU:
+		case 0xABU:
+			vie->op_type = VIE_OP_TYPE_STOS;
+			has_modrm = false;
+			break;
+		default:
+			/** Set ret to -EINVAL for other opcodes */
+			ret = -EINVAL;
+			break;
+		}
+		/** Set byte_op to true if bit 0 of op is clear and op is not 83H */
+		byte_op = ((op & 0x1U) == 0U) && (op != 0x83U);
+		/** Set imm_size for the immediate forms: 1 for byte operands and 83H, otherwise 2 or 4 by operand size
+		 *  (a 64-bit operand takes a sign-extended 4-byte immediate) */
+		if (group_op != 0xFFU) {
+			if (byte_op || (op == 0x83U)) {
+				imm_size = 1U;
+			} else {
+				imm_size = (vie->opsize == 2U) ? 2U : 4U;
+			}
+			vie->has_imm = true;
+		}
+	}
+
+	/** If a byte operation, set the operand size to 1 */
+	if (byte_op) {
+		vie->opsize = 1U;
+	}
+	/** If the memory operand size is not set by MOVZX/MOVSX, set it to the operand size */
+	if (vie->mem_size == 0U) {
+		vie->mem_size = vie->opsize;
+	}
+
+	/** If the opcode is supported and has a ModR/M byte */
+	if ((ret == 0) && has_modrm) {
+		/** Set modrm to inst[pos] and step to the next byte */
+		modrm = inst[pos];
+		pos++;
+		/** Set vie->reg to the reg field of modrm extended by REX.R */
+		vie->reg = ((modrm >> 3U) & 0x7U) | (uint8_t)((rex & 0x4U) << 1U);
+
+		/** If mod is 3, which is a register operand and not a memory access */
+		if ((modrm >> 6U) == 3U) {
+			ret = -EINVAL;
+		/** If the address size is 2, which uses the 16-bit ModR/M forms */
+		} else if (vie->addrsize == 2U) {
+			/** Set disp_size to 2 for [disp16] and mod 2, 1 for mod 1, or 0 otherwise */
+			if ((((modrm >> 6U) == 0U) && ((modrm & 0x7U) == 6U)) || ((modrm >> 6U) == 2U)) {
+				disp_size = 2U;
+			} else {
+				disp_size = ((modrm >> 6U) == 1U) ? 1U : 0U;
+			}
+		} else {
+			/** Set disp_size to 1 for mod 1, 4 for mod 2, or 0 otherwise */
+			disp_size = ((modrm >> 6U) == 1U) ? 1U : (((modrm >> 6U) == 2U) ? 4U : 0U);
+			/** If rm is 4, a SIB byte follows, which needs a 4-byte displacement with mod 0 and base 5 */
+			if ((modrm & 0x7U) == 4U) {
+				if (((modrm >> 6U) == 0U) && ((inst[pos] & 0x7U) == 5U)) {
+					disp_size = 4U;
+				}
+				pos++;
+			/** If mod is 0 and rm is 5, which is [disp32] or [RIP + disp32] */
+			} else if (((modrm >> 6U) == 0U) && ((modrm & 0x7U) == 5U)) {
+				disp_size = 4U;
+			} else {
+				/* no SIB byte and no extra displacement */
+			}
+		}
+		/** Step over the displacement */
+		pos += disp_size;
+
+		/** If the opcode is a group opcode, resolve the operation by the reg field of modrm */
+		if ((ret == 0) && (group_op == 0x14U)) {
+			if (((modrm >> 3U) & 0x7U) == 1U) {
+				vie->op_type = VIE_OP_TYPE_OR_TO_MEM;
+			} else if (((modrm >> 3U) & 0x7U) == 4U) {
+				vie->op_type = VIE_OP_TYPE_AND_TO_MEM;
+			} else {
+				ret = -EINVAL;
+			}
+		} else if ((ret == 0) && (group_op == 0U) && (((modrm >> 3U) & 0x7U) != 0U)) {
+			ret = -EINVAL;
+		} else {
+			/* not a group opcode or a valid one */
+		}
+	}
+
+	/** If the instruction is supported so far */
+	if (ret == 0) {
+		/** Set vie->immediate to the little-endian immediate of imm_size bytes at pos */
+		for (i = 0U; i < imm_size; i++) {
+			vie->immediate |= (uint64_t)inst[pos + i] << (8U * i);
+		}
+		/** If imm_size is not 0, sign-extend the immediate to 64 bits */
+		if ((imm_size != 0U) && (imm_size < 8U) && ((inst[pos + imm_size - 1U] & 0x80U) != 0U)) {
+			vie->immediate |= ~vie_size2mask((uint8_t)imm_size);
+		}
+		/** Step over the immediate */
+		pos += imm_size;
+
+		/** If the instruction is longer than VIE_INST_SIZE bytes, which is not a valid instruction */
+		if (pos > VIE_INST_SIZE) {
+			ret = -EINVAL;
+		/** If the instruction extends past the fetched bytes */
+		} else if (pos > avail) {
+			ret = -ERANGE;
+		} else {
+			/** Set vie->inst_len to pos and copy the instruction bytes to vie->inst */
+			vie->inst_len = (uint8_t)pos;
+			(void)memcpy_s(vie->inst, VIE_INST_SIZE, inst, pos);
+		}
+	}
+
+	/** Return ret */
+	return ret;
+}
+
+/**
+ * @brief Look up the decode cache of a vCPU for the instruction at a guest RIP and CR3.
+ *
+ * A cached entry is only used if the guest memory it was fetched from still holds the same bytes.
+ *
+ * @param[in] vcpu The vCPU whose cache is looked up.
+ * @param[in] rip The guest RIP.
+ * @param[in] cr3 The guest CR3.
+ *
+ * @return The cached decoded instruction, or NULL if none is valid.
+ *
+ * @pre vcpu != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vcpu is different among parallel invocations.
+ */
+static const struct instr_emul_vie *vie_cache_lookup(struct acrn_vcpu *vcpu, uint64_t rip, uint64_t cr3)
+{
+	/** Declare the following local variables of type const struct instr_emul_vie *.
+	 *  - vie representing the cache entry for rip and cr3, initialized accordingly. */
+	const struct instr_emul_vie *vie =
+		&vcpu->inst_ctxt.cache[(rip ^ (cr3 >> PAGE_SHIFT)) & (VIE_CACHE_ENTRIES - 1U)];
+	/** Declare the following local variables of type uint8_t [VIE_INST_SIZE].
+	 *  - inst representing the bytes currently at the cached instruction address, not initialized. */
+	uint8_t inst[VIE_INST_SIZE];
+	/** Declare the following local variables of type uint32_t.
+	 *  - i representing the loop counter, not initialized. */
+	uint32_t i;
+	/** Declare the following local variables of type bool.
+	 *  - hit representing whether the entry is valid, initialized as true if it is decoded for rip and cr3. */
+	bool hit = (vie->op_type != VIE_OP_TYPE_NONE) && (vie->rip == rip) && (vie->cr3 == cr3);
+
+	/** If the entry is for rip and cr3 and the instruction bytes can be read again */
+	if (hit && (copy_from_gpa(vcpu->vm, inst, vie->inst_gpa, vie->inst_len) == 0)) {
+		/** For each byte of the instruction */
+		for (i = 0U; i < vie->inst_len; i++) {
+			/** If the byte has changed, the entry is stale */
+			if (inst[i] != vie->inst[i]) {
+				hit = false;
+				break;
+			}
+		}
+	} else {
+		/** Set hit to false */
+		hit = false;
+	}
+
+	/** Return vie if hit is true, otherwise NULL */
+	return hit ? vie : NULL;
+}
+
+/**
+ * @brief Emulate a STOS instruction, optionally REP prefixed, on an emulated MMIO range.
+ *
+ * One element is stored per EPT violation. RDI and, with REP, RCX are advanced and the instruction is
+ * re-executed while RCX is not 0, so that the following elements fault on their own addresses.
+ *
+ * @param[inout] vcpu The vCPU executing the instruction.
+ * @param[in] vie The decoded instruction.
+ * @param[in] gpa The guest physical address of the element.
+ *
+ * @return 0 if the instruction is emulated, otherwise the error of the MMIO access.
+ *
+ * @pre vcpu != NULL
+ * @pre vie != NULL
+ * @pre vie->op_type == VIE_OP_TYPE_STOS
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vcpu is different among parallel invocations.
+ */
+static int32_t vie_emulate_stos(struct acrn_vcpu *vcpu, const struct instr_emul_vie *vie, uint64_t gpa)
+{
+	/** Declare the following local variables of type uint64_t.
+	 *  - addr_mask representing the mask of the address size, initialized accordingly.
+	 *  - count representing the number of elements left, initialized as RCX masked with addr_mask with REP
+	 *    or 1 otherwise.
+	 *  - val representing the element, not initialized.
+	 *  - rdi representing RDI masked with addr_mask, not initialized. */
+	uint64_t addr_mask = vie_size2mask(vie->addrsize);
+	uint64_t count = vie->rep ? (vcpu_get_gpreg(vcpu, CPU_REG_RCX) & addr_mask) : 1UL;
+	uint64_t val, rdi;
+	/** Declare the following local variables of type int32_t.
+	 *  - ret representing the return value, initialized as 0. */
+	int32_t ret = 0;
+
+	/** If count is not 0 */
+	if (count != 0UL) {
+		/** Set val to the low mem_size bytes of RAX */
+		val = vcpu_get_gpreg(vcpu, CPU_REG_RAX);
+		/** Call vie_mmio_access() to write val to gpa and set ret to its return value */
+		ret = vie_mmio_access(vcpu, gpa, vie->mem_size, REQUEST_WRITE, &val);
+		/** If the element is written */
+		if (ret == 0) {
+			/** Set rdi to RDI advanced by mem_size, downwards if RFLAGS.DF is set */
+			rdi = vcpu_get_gpreg(vcpu, CPU_REG_RDI) & addr_mask;
+			rdi = ((vcpu_get_rflags(vcpu) & VIE_RFLAGS_DF) != 0UL) ? (rdi - vie->mem_size) :
+				(rdi + vie->mem_size);
+			/** Call vie_set_reg() to write rdi back to RDI in the address size */
+			vie_set_reg(vcpu, CPU_REG_RDI, true, vie->addrsize, rdi);
+			/** If the instruction is REP prefixed */
+			if (vie->rep) {
+				/** Call vie_set_reg() to write count - 1 back to RCX in the address size */
+				vie_set_reg(vcpu, CPU_REG_RCX, true, vie->addrsize, count - 1UL);
+				/** If elements remain, re-execute the instruction at next VM entry */
+				if (count > 1UL) {
+					vcpu_retain_rip(vcpu);
+				}
+			}
+		}
+	}
+
+	/** Return ret */
+	return ret;
+}
+
+/**
+ * @brief Emulate a decoded instruction on an emulated MMIO range.
+ *
+ * @param[inout] vcpu The vCPU executing the instruction.
+ * @param[in] vie The decoded instruction.
+ * @param[in] gpa The guest physical address of the memory operand.
+ *
+ * @return 0 if the instruction is emulated, otherwise the error of the MMIO access.
+ *
+ * @pre vcpu != NULL
+ * @pre vie != NULL
+ * @pre vie->op_type != VIE_OP_TYPE_NONE
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vcpu is different among parallel invocations.
+ */
+static int32_t vie_execute(struct acrn_vcpu *vcpu, const struct instr_emul_vie *vie, uint64_t gpa)
+{
+	/** Declare the following local variables of type uint64_t.
+	 *  - val representing the value of the memory operand, initialized as 0.
+	 *  - src representing the source operand, initialized as the immediate if the instruction has one,
+	 *    otherwise the register operand. */
+	uint64_t val = 0UL;
+	uint64_t src = vie->has_imm ? vie->immediate : vie_get_reg(vcpu, vie->reg, vie->rex_present,
+		vie->opsize);
+	/** Declare the following local variables of type int32_t.
+	 *  - ret representing the return value, initialized as 0. */
+	int32_t ret = 0;
+
+	/** Depending on vie->op_type */
+	switch (vie->op_type) {
+	case VIE_OP_TYPE_MOV_TO_MEM:
+	case VIE_OP_TYPE_MOV_IMM_TO_MEM:
+		/** Write src to the memory operand */
+		ret = vie_mmio_access(vcpu, gpa, vie->mem_size, REQUEST_WRITE, &src);
+		break;
+	case VIE_OP_TYPE_MOV_FROM_MEM:
+	case VIE_OP_TYPE_MOVZX:
+		/** Read the memory operand and write it zero-extended to the register operand */
+		ret = vie_mmio_access(vcpu, gpa, vie->mem_size, REQUEST_READ, &val);
+		if (ret == 0) {
+			vie_set_reg(vcpu, vie->reg, vie->rex_present, vie->opsize, val);
+		}
+		break;
+	case VIE_OP_TYPE_MOVSX:
+		/** Read the memory operand and write it sign-extended to the register operand */
+		ret = vie_mmio_access(vcpu, gpa, vie->mem_size, REQUEST_READ, &val);
+		if (ret == 0) {
+			if (((val >> ((8U * vie->mem_size) - 1U)) & 1UL) != 0UL) {
+				val |= ~vie_size2mask(vie->mem_size);
+			}
+			vie_set_reg(vcpu, vie->reg, vie->rex_present, vie->opsize, val);
+		}
+		break;
+	case VIE_OP_TYPE_STOS:
+		/** Call vie_emulate_stos() to emulate STOS */
+		ret = vie_emulate_stos(vcpu, vie, gpa);
+		break;
+	case VIE_OP_TYPE_AND_TO_MEM:
+	case VIE_OP_TYPE_OR_TO_MEM:
+		/** Read the memory operand, combine it with src, write the result back and update RFLAGS */
+		ret = vie_mmio_access(vcpu, gpa, vie->mem_size, REQUEST_READ, &val);
+		if (ret == 0) {
+			val = (vie->op_type == VIE_OP_TYPE_AND_TO_MEM) ? (val & src) : (val | src);
+			ret = vie_mmio_access(vcpu, gpa, vie->mem_size, REQUEST_WRITE, &val);
+			vie_update_logic_flags(vcpu, val, vie->opsize);
+		}
+		break;
+	case VIE_OP_TYPE_AND_FROM_MEM:
+	case VIE_OP_TYPE_OR_FROM_MEM:
+		/** Read the memory operand, combine it with the register operand into the register and update RFLAGS */
+		ret = vie_mmio_access(vcpu, gpa, vie->mem_size, REQUEST_READ, &val);
+		if (ret == 0) {
+			val = (vie->op_type == VIE_OP_TYPE_AND_FROM_MEM) ? (val & src) : (val | src);
+			vie_set_reg(vcpu, vie->reg, vie->rex_present, vie->opsize, val);
+			vie_update_logic_flags(vcpu, val, vie->opsize);
+		}
+		break;
+	case VIE_OP_TYPE_TEST:
+		/** Read the memory operand and update RFLAGS for its AND with src */
+		ret = vie_mmio_access(vcpu, gpa, vie->mem_size, REQUEST_READ, &val);
+		if (ret == 0) {
+			vie_update_logic_flags(vcpu, val & src, vie->opsize);
+		}
+		break;
+	default:
+		/** Set ret to -EINVAL for an instruction not decoded */
+		ret = -EINVAL;
+		break;
+	}
+
+	/** Return ret */
+	return ret;
+}
+
+/**
+ * @brief Decode and emulate the guest instruction that accesses an emulated MMIO range.
+ *
+ * The instruction at the guest RIP is taken from the decode cache of \a vcpu or fetched and decoded, then
+ * emulated with its memory operand at \a gpa, and the guest RIP is advanced past it.
+ *
+ * @param[inout] vcpu The vCPU whose instruction caused the EPT violation.
+ * @param[in] gpa The guest physical address of the EPT violation.
+ *
+ * @return 0 if the instruction is emulated or a page fault of its fetch is injected, -EINVAL if it can not be
+ *	   decoded or emulated.
+ *
+ * @pre vcpu != NULL
+ * @pre vcpu == get_running_vcpu(get_pcpu_id())
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vcpu is different among parallel invocations.
+ */
+int32_t emulate_mmio_instruction(struct acrn_vcpu *vcpu, uint64_t gpa)
+{
+	/** Declare the following local variables of type uint64_t.
+	 *  - rip representing the guest RIP, initialized accordingly.
+	 *  - cr3 representing the guest CR3, initialized accordingly.
+	 *  - inst_gpa representing the guest physical address of the fetched instruction, not initialized.
+	 *  - next_gva representing the guest linear address of the page following the instruction start,
+	 *    not initialized. */
+	uint64_t rip = vcpu_get_rip(vcpu), cr3 = exec_vmread(VMX_GUEST_CR3), inst_gpa, next_gva;
+	/** Declare the following local variables of type uint8_t [VIE_DECODE_BUF_SIZE].
+	 *  - inst representing the zero-padded instruction bytes, initialized as all 0s. */
+	uint8_t inst[VIE_DECODE_BUF_SIZE] = { 0U };
+	/** Declare the following local variables of type uint32_t.
+	 *  - len_lo representing the number of bytes fetched from the page of the instruction start, not initialized.
+	 *  - len representing the number of bytes fetched, not initialized.
+	 *  - next_err representing the pending page fault of the following page, not initialized. */
+	uint32_t len_lo, len, next_err;
+	/** Declare the following local variables of type const struct instr_emul_vie *.
+	 *  - vie representing the decoded instruction, initialized as the cache entry for rip and cr3. */
+	const struct instr_emul_vie *vie = vie_cache_lookup(vcpu, rip, cr3);
+	/** Declare the following local variables of type struct instr_emul_vie *.
+	 *  - slot representing the cache entry for rip and cr3, initialized accordingly. */
+	struct instr_emul_vie *slot = &vcpu->inst_ctxt.cache[(rip ^ (cr3 >> PAGE_SHIFT)) & (VIE_CACHE_ENTRIES - 1U)];
+	/** Declare the following local variables of type struct instr_emul_vie.
+	 *  - decoded representing an instruction decoded in this call, not initialized. */
+	struct instr_emul_vie decoded;
+	/** Declare the following local variables of type int32_t.
+	 *  - ret representing the return value, initialized as 0. */
+	int32_t ret = 0;
+
+	/** If the instruction is not in the decode cache */
+	if (vie == NULL) {
+		/** Call vie_fetch() to fetch the instruction bytes and set ret to its return value */
+		ret = vie_fetch(vcpu, rip, inst, &inst_gpa, &len_lo, &len, &next_gva, &next_err);
+		/** If the fetch succeeds */
+		if (ret == 0) {
+			/** Call vie_decode() to decode the bytes into decoded and set ret to its return value */
+			ret = vie_decode(vcpu, inst, len, &decoded);
+			/** If the instruction needs bytes of a following page which can not be translated */
+			if ((ret == -ERANGE) && (next_err != 0U)) {
+				/** Call vcpu_inject_pf() to report the fault of the following page to the guest */
+				vcpu_inject_pf(vcpu, next_gva, next_err & ~(1U << 31U));
+				/** Set ret to -EFAULT */
+				ret = -EFAULT;
+			/** If the instruction is decoded */
+			} else if (ret == 0) {
+				/** Set the RIP, CR3 and instruction address of decoded */
+				decoded.rip = rip;
+				decoded.cr3 = cr3;
+				decoded.inst_gpa = inst_gpa;
+				/** If the instruction is within one page, cache it for later exits at rip */
+				if (decoded.inst_len <= len_lo) {
+					*slot = decoded;
+				}
+				/** Set vie to &decoded */
+				vie = &decoded;
+			} else {
+				/** Logging the following information with a log level of LOG_ERROR.
+				 *  - rip
+				 *  - inst[0], inst[1] and inst[2] */
+				pr_err("%s: unsupported instruction at rip 0x%lx: %02x %02x %02x", __func__, rip,
+					inst[0], inst[1], inst[2]);
+				/** Set ret to -EINVAL */
+				ret = -EINVAL;
+			}
+		}
+	}
+
+	/** If the instruction is decoded */
+	if (vie != NULL) {
+		/** Set the instruction length of the exit to vie->inst_len, so that RIP is advanced past it */
+		vcpu->arch.inst_len = vie->inst_len;
+		/** Call vie_execute() to emulate the instruction at gpa and set ret to its return value */
+		ret = vie_execute(vcpu, vie, gpa);
+		/** If the emulation fails */
+		if (ret != 0) {
+			/** Set ret to -EINVAL */
+			ret = -EINVAL;
+		}
+	/** If a page fault of the fetch is injected, which is not an error of the emulation */
+	} else if (ret == -EFAULT) {
+		/** Set ret to 0 */
+		ret = 0;
+	} else {
+		/* the instruction can not be decoded */
+	}
+
+	/** Return ret */
+	return ret;
+}
+
+/**
+ * @}
+ */
@@ -1616,6 +1616,12 @@ void reset_vcpu(struct acrn_vcpu *vcpu)
 	 *  - 0: The value to be set to each byte of the specified memory block.
 	 *  - sizeof(struct run_context): The number of bytes to be set */
 	(void)memset((void *)(&vcpu->arch.context), 0U, sizeof(struct run_context));
+	/** Call memset() with the following parameters, in order to drop the decoded instructions of the
+	 *  previous run of the vCPU.
+	 *  - (void *)&vcpu->inst_ctxt: The address of the memory block to fill
+	 *  - 0: The value to be set to each byte of the specified memory block.
+	 *  - sizeof(struct instr_emul_ctxt): The number of bytes to be set */
+	(void)memset((void *)(&vcpu->inst_ctxt), 0U, sizeof(struct instr_emul_ctxt));
 
 	/** Call vcpu_vlapic() with vcpu as parameter in order to get address of the
 	 *  vlapic structure associated with the vcpu and set vlapic to its return value. */
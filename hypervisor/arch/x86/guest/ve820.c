@@ -9,6 +9,7 @@
 #include <vm.h>
 #include <reloc.h>
 #include <logmsg.h>
+#include <vpci.h>
 
 /**
  * @addtogroup vp-base_vm
@@ -27,7 +28,7 @@
  */
 
 #define ENTRY_HPA1		2U   /**< Index of the ve820 entry that presents the guest memory region below 4G */
-#define VE820_ENTRIES		3U   /**< Number of entries in a ve820 table. */
+#define VE820_ENTRIES		4U   /**< Number of entries in a ve820 table. */
 
 /** A static array for the ve820 tables for all VMs. */
 static struct e820_entry pre_vm_e820[CONFIG_MAX_VM_NUM][E820_MAX_ENTRIES];
@@ -49,6 +50,11 @@ static const struct e820_entry pre_ve820_template[E820_MAX_ENTRIES] = {
 		.length   = 0UL,                /**< this entry size: undefined and shall be filled in at runtime */
 		.type     = E820_TYPE_RAM       /**< this entry type: RAM */
 	},
+	{
+		.baseaddr = VPCI_ECAM_BASE,	/**< base address of the virtual ECAM window reported in the MCFG table */
+		.length   = VPCI_ECAM_SIZE,	/**< this entry size: 1MB per bus */
+		.type     = E820_TYPE_RESERVED  /**< this entry type: reserved */
+	},
 };
 
 /**
@@ -63,6 +69,8 @@ static const struct e820_entry pre_ve820_template[E820_MAX_ENTRIES] = {
  * - entry0: usable under 1MB
  * - entry1: reserved for ACPI Table from 0xf0000 to 0xfffff
  * - entry2: usable from 0x100000 up to the available RAM assigned to the VM
+ * - entry3: reserved for the virtual ECAM window from VPCI_ECAM_BASE, which guests such as Linux only use for PCI
+ *   configuration accesses if it is reserved in the E820 table
  *
  * @param[inout] vm Pointer to a structure representing the VM whose virtual E820 table is to be created
  *
@@ -17,6 +17,7 @@
 #include <trace.h>
 #include <logmsg.h>
 #include <vm_reset.h>
+#include <vm_snapshot.h>
 #include <console.h>
 
 /**
@@ -48,6 +49,7 @@
  * - This module depends on 'vp-base.hv_main' module to initialize the VMCS fields.
  * - This module depends on 'vp-base.vm' module to judge if the VM is safety VM.
  * - This module depends on 'vp-base.vm_reset' module to shutdown the corresponding VM.
+ * - This module depends on 'vp-base.vm' module to save or load the golden snapshot of the vCPU.
  * - This module depends on 'hwmgmt.mmu' module to invalidate cached EPT mappings.
  * - This module depends on 'hwmgmt.apic' module to initialize the LAPIC of the current physical CPU.
  * - This module depends on 'debug' module to set up timer for the console.
@@ -599,6 +601,26 @@ int32_t acrn_handle_pending_request(struct acrn_vcpu *vcpu)
 			init_lapic(get_pcpu_id());
 		}
 
+		/** If return value of bitmap_test_and_clear_lock(ACRN_REQUEST_SNAPSHOT_LOAD, pending_req_bits) is
+		 *  true */
+		if (bitmap_test_and_clear_lock(ACRN_REQUEST_SNAPSHOT_LOAD, pending_req_bits)) {
+			/** Call load_vcpu_snapshot() with the following parameters, in order
+			 *  to load the VMCS and LAPIC state of the vCPU from the golden snapshot of its VM.
+			 *  - vcpu
+			 */
+			load_vcpu_snapshot(vcpu);
+		}
+
+		/** If return value of bitmap_test_and_clear_lock(ACRN_REQUEST_SNAPSHOT_SAVE, pending_req_bits) is
+		 *  true */
+		if (bitmap_test_and_clear_lock(ACRN_REQUEST_SNAPSHOT_SAVE, pending_req_bits)) {
+			/** Call save_vcpu_snapshot() with the following parameters, in order
+			 *  to save the vCPU into the golden snapshot of its VM.
+			 *  - vcpu
+			 */
+			save_vcpu_snapshot(vcpu);
+		}
+
 		/** If return value of bitmap_test_and_clear_lock(ACRN_REQUEST_EPT_FLUSH, pending_req_bits)
 		 *  is true */
 		if (bitmap_test_and_clear_lock(ACRN_REQUEST_EPT_FLUSH, pending_req_bits)) {
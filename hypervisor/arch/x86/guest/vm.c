@@ -10,6 +10,8 @@
 #include <lapic.h>
 #include <vm.h>
 #include <vm_reset.h>
+#include <vm_snapshot.h>
+#include <vm_scrub.h>
 #include <bits.h>
 #include <e820.h>
 #include <multiboot.h>
@@ -19,6 +21,7 @@
 #include <console.h>
 #include <ptdev.h>
 #include <vmcs.h>
+#include <vmx.h>
 #include <pgtable.h>
 #include <mmu.h>
 #include <logmsg.h>
@@ -75,8 +78,8 @@
  * It also defines some helper functions to implement the features that are commonly used in this file.
  * In addition, it defines some decomposed functions to improve the readability of the code.
  *
- * Helper functions include: setup_io_bitmap, get_vm_bsp_pcpu_id, prepare_prelaunched_vm_memmap,
- * get_pcpu_bitmap.
+ * Helper functions include: setup_io_bitmap, get_vm_bsp_pcpu_id, get_vm_config_pcpu_bitmap,
+ * prepare_prelaunched_vm_memmap, get_pcpu_bitmap, is_region_overlapped.
  *
  * Decomposed functions include: create_vm, start_vm and prepare_vm.
  */
@@ -118,6 +121,113 @@ bool is_safety_vm(const struct acrn_vm *vm)
 	return (vm->vm_id == 0U);
 }
 
+/**
+ * @brief Check whether two host physical memory regions overlap.
+ *
+ * @param[in] hpa The start of the first region.
+ * @param[in] size The size of the first region in bytes.
+ * @param[in] base The start of the second region.
+ * @param[in] len The size of the second region in bytes.
+ *
+ * @return true if [hpa, hpa + size) and [base, base + len) overlap, otherwise false.
+ *
+ * @mode HV_SUBMODE_INIT_ROOT, HV_SUBMODE_INIT_POST_SMP
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+static inline bool is_region_overlapped(uint64_t hpa, uint64_t size, uint64_t base, uint64_t len)
+{
+	/** Return true if [hpa, hpa + size) and [base, base + len) overlap, otherwise false */
+	return (hpa < (base + len)) && (base < (hpa + size));
+}
+
+/**
+ * @brief Check whether a host physical memory region overlaps memory the hypervisor reserves for other uses.
+ *
+ * The reserved memory consists of the hypervisor image, the RAM of every VM, the golden snapshot memory of every VM,
+ * the region shared by every ivshmem device and the boot modules. The region being checked is not counted against
+ * itself, which depends on \a kind:
+ * - HOST_REGION_SNAPSHOT: the snapshot memory of the VM \a vm_id is skipped.
+ * - HOST_REGION_SHM: the shared regions equal to [hpa, hpa + size) are skipped, as ivshmem peers share them.
+ * - HOST_REGION_KERNEL_MODULE: the boot modules are skipped, the caller checking which VMs boot from the module.
+ *
+ * @param[in] hpa The host physical address where the region starts.
+ * @param[in] size The size of the region in bytes.
+ * @param[in] kind What the region is used for, HOST_REGION_SNAPSHOT, HOST_REGION_SHM or HOST_REGION_KERNEL_MODULE.
+ * @param[in] vm_id The ID of the VM the region is reserved for, only used if \a kind is HOST_REGION_SNAPSHOT.
+ *
+ * @return true if [hpa, hpa + size) overlaps any reserved memory, otherwise false.
+ *
+ * @pre size != 0
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_ROOT, HV_SUBMODE_INIT_POST_SMP
+ *
+ * @remark It is a public API called by the snapshot, ivshmem and guest image loading code to validate the
+ * configured regions.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+bool is_host_region_reserved(uint64_t hpa, uint64_t size, uint32_t kind, uint16_t vm_id)
+{
+	/** Declare the following local variables of type 'const struct acrn_vm_config *'.
+	 *  - vm_config representing the configuration data of the VM being checked, not initialized. */
+	const struct acrn_vm_config *vm_config;
+	/** Declare the following local variables of type 'const struct acrn_vm_pci_dev_config *'.
+	 *  - dev_config representing the configuration of the PCI device being checked, not initialized. */
+	const struct acrn_vm_pci_dev_config *dev_config;
+	/** Declare the following local variables of type uint16_t.
+	 *  - i representing the ID of the VM being checked, not initialized.
+	 *  - j representing the index of the PCI device being checked, not initialized. */
+	uint16_t i, j;
+	/** Declare the following local variables of type bool.
+	 *  - reserved representing the result, initialized as whether [hpa, hpa + size) overlaps the hypervisor
+	 *  image. */
+	bool reserved = is_region_overlapped(hpa, size, get_hv_image_base(), CONFIG_HV_RAM_SIZE);
+
+	/** For each i ranging from 0 to CONFIG_MAX_VM_NUM - 1 [with a step of 1], and while reserved is false */
+	for (i = 0U; (!reserved) && (i < CONFIG_MAX_VM_NUM); i++) {
+		/** Set vm_config to the return value of get_vm_config(i) */
+		vm_config = get_vm_config(i);
+		/** Set reserved to whether [hpa, hpa + size) overlaps the RAM of the VM being checked */
+		reserved = is_region_overlapped(hpa, size, vm_config->memory.start_hpa, vm_config->memory.size);
+		/** If reserved is false, the VM being checked reserves snapshot memory, and that memory is not the
+		 *  region being checked */
+		if ((!reserved) && (vm_config->memory.snapshot_hpa != 0UL) &&
+			((kind != HOST_REGION_SNAPSHOT) || (i != vm_id))) {
+			/** Set reserved to whether [hpa, hpa + size) overlaps that memory */
+			reserved = is_region_overlapped(hpa, size, vm_config->memory.snapshot_hpa,
+				vm_config->memory.size);
+		}
+		/** For each j ranging from 0 to vm_config->pci_dev_num - 1 [with a step of 1], and while reserved is
+		 *  false */
+		for (j = 0U; (!reserved) && (j < vm_config->pci_dev_num); j++) {
+			/** Set dev_config to &vm_config->pci_devs[j] */
+			dev_config = &vm_config->pci_devs[j];
+			/** If the device shares a region, and that region is not the region being checked */
+			if ((dev_config->shm_size != 0UL) && ((kind != HOST_REGION_SHM) ||
+				(dev_config->shm_hpa != hpa) || (dev_config->shm_size != size))) {
+				/** Set reserved to whether [hpa, hpa + size) overlaps the shared region */
+				reserved = is_region_overlapped(hpa, size, dev_config->shm_hpa, dev_config->shm_size);
+			}
+		}
+	}
+
+	/** If reserved is false and the region being checked is not a kernel module */
+	if ((!reserved) && (kind != HOST_REGION_KERNEL_MODULE)) {
+		/** Set reserved to the return value of is_boot_module_overlapped(hpa, size) */
+		reserved = is_boot_module_overlapped(hpa, size);
+	}
+
+	/** Return reserved */
+	return reserved;
+}
+
 /**
  * @brief Initialize the IO bitmap of the given VM.
  *
@@ -220,6 +330,47 @@ static inline uint16_t get_vm_bsp_pcpu_id(const struct acrn_vm_config *vm_config
 	return (cpu_id < get_pcpu_nums()) ? cpu_id : INVALID_CPU_ID;
 }
 
+/**
+ * @brief Get the bitmap of the physical CPUs assigned to a VM by its configuration.
+ *
+ * @param[in] vm_config The pointer to the VM configuration data which includes the vCPU affinity info.
+ *
+ * @return The bitmap of the physical CPUs any vCPU of the VM can run on.
+ *
+ * @pre vm_config != NULL
+ * @pre vm_config->vcpu_num <= MAX_VCPUS_PER_VM
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_ROOT
+ *
+ * @remark It is an internal function called by launch_vms.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+static uint64_t get_vm_config_pcpu_bitmap(const struct acrn_vm_config *vm_config)
+{
+	/** Declare the following local variables of type uint16_t.
+	 *  - i representing a loop counter used as index of vm_config->vcpu_affinity, not initialized.
+	 */
+	uint16_t i;
+	/** Declare the following local variables of type uint64_t.
+	 *  - bitmap representing the physical CPUs assigned to the VM, initialized as 0.
+	 */
+	uint64_t bitmap = 0UL;
+
+	/** For each i ranging from 0 to vm_config->vcpu_num - 1 [with a step of 1] */
+	for (i = 0U; i < vm_config->vcpu_num; i++) {
+		/** Bitwise OR bitmap by vm_config->vcpu_affinity[i] */
+		bitmap |= vm_config->vcpu_affinity[i];
+	}
+
+	/** Return bitmap */
+	return bitmap;
+}
+
 /**
  * @brief Setup EPT memory mapping for the given VM according to its e820 table.
  *
@@ -466,6 +617,10 @@ static int32_t create_vm(uint16_t vm_id, const struct acrn_vm_config *vm_config,
 	 *  - &vm->arch_vm.ept_mem_ops
 	 */
 	sanitize_pte((uint64_t *)vm->arch_vm.nworld_eptp, &vm->arch_vm.ept_mem_ops);
+	/** Set vm->arch_vm.ept_ad to true if GUEST_FLAG_EPT_AD is set in vm_config->guest_flags and the physical
+	 *  platform supports EPT accessed and dirty flags, or false otherwise */
+	vm->arch_vm.ept_ad = ((vm_config->guest_flags & GUEST_FLAG_EPT_AD) != 0UL) &&
+		((msr_read(MSR_IA32_VMX_EPT_VPID_CAP) & VMX_EPT_AD) != 0UL);
 
 	/** Call create_prelaunched_vm_e820 with the following parameters, in order to initialize the e820 table.
 	 *  - vm
@@ -495,6 +650,12 @@ static int32_t create_vm(uint16_t vm_id, const struct acrn_vm_config *vm_config,
 	 */
 	spinlock_init(&vm->vm_lock);
 
+	/** Call spinlock_init with the following parameter, in order to initialize the spinlock for protecting the
+	 *  MMIO handler entries.
+	 *  - &vm->emul_mmio_lock
+	 */
+	spinlock_init(&vm->emul_mmio_lock);
+
 	/** Call setup_io_bitmap with the following parameters, in order to setup IO bit-mask so the VM-exit occurs
 	 *  on selected IO ranges.
 	 *  - vm
@@ -513,6 +674,12 @@ static int32_t create_vm(uint16_t vm_id, const struct acrn_vm_config *vm_config,
 	 */
 	vrtc_init(vm);
 
+	/** Call init_vm_snapshot with the following parameters, in order to enable the golden snapshot of the VM if
+	 *  it is configured.
+	 *  - vm
+	 */
+	init_vm_snapshot(vm);
+
 	/** Call vpci_init with the following parameters, in order to initialize vPCI devices of the given VM.
 	 *  - vm
 	 */
@@ -550,7 +717,8 @@ static int32_t create_vm(uint16_t vm_id, const struct acrn_vm_config *vm_config,
  * @brief Shutdown the given VM and release its related resources
  *
  * This function is called to shutdown the given VM, and release its related resources. More specifically,
- * this function offlines all its virtual CPUs, release its EPT table and the vPCI devices.
+ * this function offlines all its virtual CPUs, scrubs its memory on all its physical CPUs before they go offline, and
+ * releases its EPT table and the vPCI devices.
  *
  * @param[inout] vm Pointer to a VM whose resources will be released.
  *
@@ -600,6 +768,13 @@ int32_t shutdown_vm(struct acrn_vm *vm)
 	 */
 	mask = get_pcpu_bitmap(vm);
 
+	/** Call post_vm_scrub with the following parameters, in order to have the memory of the VM scrubbed by its
+	 *  physical CPUs before they go offline.
+	 *  - vm
+	 *  - false
+	 */
+	post_vm_scrub(vm, false);
+
 	/** If this_pcpu_id is set in the 'mask' (a bitmap of physical CPU IDs), which means the current
 	 *  physical CPU is running the given VM. In this case only an offline flag shall be set as this
 	 *  physical CPU can only be offlined later.
@@ -637,6 +812,12 @@ int32_t shutdown_vm(struct acrn_vm *vm)
 		}
 	}
 
+	/** Call finish_vm_scrub with the following parameters, in order to scrub the memory of the VM along with its
+	 *  other physical CPUs.
+	 *  - vm
+	 */
+	finish_vm_scrub(vm);
+
 	/** Call wait_pcpus_offline with the following parameters, in order to wait for all the physical CPUs
 	 *  to be in the offline state, except current physical CPU.
 	 *  - mask
@@ -681,9 +862,9 @@ int32_t shutdown_vm(struct acrn_vm *vm)
  *
  * @post N/A
  *
- * @mode HV_SUBMODE_INIT_ROOT
+ * @mode HV_SUBMODE_INIT_ROOT, HV_OPERATIONAL
  *
- * @remark It is an internal function called by prepare_vm.
+ * @remark It is an internal function called by prepare_vm and restart_vm.
  *
  * @reentrancy Unspecified
  *
@@ -762,6 +943,153 @@ void pause_vm(struct acrn_vm *vm)
 	}
 }
 
+/**
+ * @brief Restart the given VM without releasing its resources
+ *
+ * This function is called to restart the given VM in place. Its physical CPUs stay in their idle threads and its EPT,
+ * IOMMU domain and vUART are kept as they are, as the VM configuration they are set up from never changes. The vCPUs
+ * and the vPCI devices are reset. If the VM has taken its golden snapshot, the VM is restored from the snapshot and all
+ * its vCPUs are kicked off. Otherwise the RAM of the VM is scrubbed, the guest OS image is loaded again and the virtual
+ * BP is kicked off.
+ *
+ * Without a golden snapshot, the guest kernel image can only be loaded again if it has been copied to its run-time
+ * location, as otherwise the guest has been running it in the memory it was originally saved in. This only happens
+ * when the bootloader placed the module in the RAM of the VM or GUEST_FLAG_KERNEL_IN_PLACE is set for the VM.
+ *
+ * @param[inout] vm Pointer to a VM which is to be restarted.
+ *
+ * @return A status to indicate whether the VM is restarted successfully.
+ *
+ * @retval 0 if the VM is restarted.
+ * @retval -EINVAL if the VM is not in PAUSED state.
+ * @retval -EACCES if the VM has no golden snapshot and its guest kernel image cannot be loaded again.
+ *
+ * @pre vm != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is a public API called by other modules. It shall be called on the physical CPU of the virtual BP of
+ * the VM with vm->vm_lock held.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vm is different among parallel invocation
+ */
+int32_t restart_vm(struct acrn_vm *vm)
+{
+	/** Declare the following local variables of type uint16_t.
+	 *  - i representing a loop counter used to as index to probe the vCPU of this VM, not initialized.
+	 */
+	uint16_t i;
+	/** Declare the following local variables of type 'struct acrn_vcpu *'.
+	 *  - vcpu representing a pointer to one vCPU data structure of this VM, initialized as NULL.
+	 */
+	struct acrn_vcpu *vcpu = NULL;
+	/** Declare the following local variables of type int32_t.
+	 *  - ret representing the status to be returned, initialized as 0.
+	 */
+	int32_t ret = 0;
+
+	/** If vm->state is not VM_PAUSED */
+	if (vm->state != VM_PAUSED) {
+		/** Set ret to -EINVAL */
+		ret = -EINVAL;
+	} else {
+		/** For each vcpu in the online vCPUs of the given VM, using i as the loop counter */
+		foreach_vcpu(i, vm, vcpu) {
+			/* The requests left from the previous run shall be dropped before reset_vcpu is called, as
+			 * reset_vcpu raises ACRN_REQUEST_LAPIC_RESET which the restarted vCPU shall handle. */
+			/** Set vcpu->arch.pending_req to 0 to drop the requests left from the previous run */
+			vcpu->arch.pending_req = 0UL;
+			/** Set vcpu->arch.idt_vectoring_info to 0 to drop the event left from the previous run */
+			vcpu->arch.idt_vectoring_info = 0U;
+			/** Call reset_vcpu with the following parameters, in order to put this vCPU back to its INIT
+			 *  state and request its vLAPIC to be reset.
+			 *  - vcpu
+			 */
+			reset_vcpu(vcpu);
+		}
+
+		/** Call vpci_reset with the following parameters, in order to stop the DMA of the passthrough devices
+		 *  before the RAM is reused and put the vPCI devices back to their configured state.
+		 *  - vm
+		 */
+		vpci_reset(vm);
+
+		/** If the return value of restore_vm_snapshot(vm) is true, which means the VM is restored from its golden
+		 *  snapshot */
+		if (restore_vm_snapshot(vm)) {
+			/** Set vm->state to VM_STARTED */
+			vm->state = VM_STARTED;
+			/** For each vcpu in the online vCPUs of the given VM, using i as the loop counter */
+			foreach_vcpu(i, vm, vcpu) {
+				/** Call launch_vcpu with the following parameters, in order to resume the vCPU at its
+				 *  saved state.
+				 *  - vcpu
+				 */
+				launch_vcpu(vcpu);
+			}
+
+			/** Logging the following information with a log level of LOG_ACRN.
+			 *  - vm->vm_id
+			 */
+			pr_acrnlog("Restore VM id: %x", vm->vm_id);
+		/** If vm->sw.kernel_info.kernel_in_place is true, which means the original guest kernel image is
+		 *  gone */
+		} else if (vm->sw.kernel_info.kernel_in_place) {
+			/** Logging the following information with a log level of LOG_ERROR.
+			 *  - vm->vm_id
+			 */
+			pr_err("VM %hu runs its kernel in place and cannot be restarted", vm->vm_id);
+			/** Set ret to -EACCES */
+			ret = -EACCES;
+		} else {
+			/** Call post_vm_scrub with the following parameters, in order to scrub the boot window of the
+			 *  VM and have the rest of its RAM scrubbed by its other physical CPUs meanwhile.
+			 *  - vm
+			 *  - true
+			 */
+			post_vm_scrub(vm, true);
+
+			/** If 'vm' is not a safety VM */
+			if (!is_safety_vm(vm)) {
+				/** Call build_vacpi with the following parameters, in order to rebuild the ACPI tables of
+				 *  the VM.
+				 *  - vm
+				 */
+				build_vacpi(vm);
+			}
+
+			/** Call direct_boot_sw_loader with the following parameters, in order to load the guest OS
+			 *  image and boot arguments again.
+			 *  - vm
+			 */
+			direct_boot_sw_loader(vm);
+
+			/** Call finish_vm_scrub with the following parameters, in order to wait for the RAM of the VM to
+			 *  be scrubbed before the VM runs.
+			 *  - vm
+			 */
+			finish_vm_scrub(vm);
+
+			/** Call start_vm with the following parameters, in order to launch the VM again.
+			 *  - vm
+			 */
+			start_vm(vm);
+
+			/** Logging the following information with a log level of LOG_ACRN.
+			 *  - vm->vm_id
+			 */
+			pr_acrnlog("Restart VM id: %x", vm->vm_id);
+		}
+	}
+
+	/** Return ret */
+	return ret;
+}
+
 /**
  * @brief Prepare a VM instance and launch it
  *
@@ -835,7 +1163,8 @@ void prepare_vm(uint16_t vm_id, const struct acrn_vm_config *vm_config)
  * @brief Launch all VMs which are configured in the VM configuration data
  *
  * This function is called to launch all VMs, which are configured in VM configuration data. This function will be
- * run on each physical CPU, but only when current CPU runs the VM's virtual BP will it create and launch the VM.
+ * run on each physical CPU, but only when current CPU runs the VM's virtual BP will it create and launch the VM. The
+ * other physical CPUs of the VM help to load its guest image meanwhile.
  *
  * @param[in] pcpu_id The ID of current running CPU
  *
@@ -883,6 +1212,21 @@ void launch_vms(uint16_t pcpu_id)
 			 *  - vm_config
 			 */
 			prepare_vm(vm_id, vm_config);
+			/** Call end_image_load with the following parameters, in order to release the other physical
+			 *  CPUs of the VM.
+			 *  - vm_id
+			 */
+			end_image_load(vm_id);
+		/** If bsp_id is valid and the current running physical CPU is assigned to the VM */
+		} else if ((bsp_id != INVALID_CPU_ID) &&
+			((get_vm_config_pcpu_bitmap(vm_config) & (1UL << pcpu_id)) != 0UL)) {
+			/** Call join_image_load with the following parameters, in order to help the VM's BP to load
+			 *  the guest image.
+			 *  - vm_id
+			 */
+			join_image_load(vm_id);
+		} else {
+			/* No action on the VMs the current physical CPU is not assigned to */
 		}
 	}
 }
@@ -959,6 +1303,77 @@ bool need_shutdown_vm(uint16_t pcpu_id)
 	return bitmap_test_and_clear_lock(NEED_SHUTDOWN_VM, &per_cpu(pcpu_flag, pcpu_id));
 }
 
+/**
+ * @brief Make a request to the given physical CPU to restart the VM it runs
+ *
+ * This function sets a flag of NEED_RESTART_VM on the physical CPU's flag. And if the physical CPU is not the current
+ * running CPU, send an IPI to it.
+ *
+ * @param[in] pcpu_id ID of the physical CPU which will restart the VM
+ *
+ * @return None
+ *
+ * @pre pcpu_id < MAX_PCPU_NUM
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is a public API called by other modules.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+void make_restart_vm_request(uint16_t pcpu_id)
+{
+	/** Call bitmap_set_lock with the following parameters, in order set the flag into the pcpu_flag field in
+	 *  the per-CPU region of the given physical CPU.
+	 *  - NEED_RESTART_VM
+	 *  - &per_cpu(pcpu_flag, pcpu_id)
+	 */
+	bitmap_set_lock(NEED_RESTART_VM, &per_cpu(pcpu_flag, pcpu_id));
+	/** If get_pcpu_id() is not pcpu_id, which means current running CPU is not the given physical CPU */
+	if (get_pcpu_id() != pcpu_id) {
+		/** Call send_single_init with the following parameters, in order to send IPI to the physical CPU.
+		 *  - pcpu_id
+		 */
+		send_single_init(pcpu_id);
+	}
+}
+
+/**
+ * @brief Check whether the physical CPU need to restart the VM it runs
+ *
+ * This function checks the flag in pcpu_flag of the CPU's private data. If the flag is set, then return true and
+ * clear it.
+ *
+ * @param[in] pcpu_id  ID of the physical CPU to be checked
+ *
+ * @return true If NEED_RESTART_VM is set in pcpu_flag of the physical CPU, or false otherwise
+ *
+ * @pre pcpu_id < MAX_PCPU_NUM
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is a public API called by other modules.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+bool need_restart_vm(uint16_t pcpu_id)
+{
+	/** Call bitmap_test_and_clear_lock with the following parameters, in order to check and clear the flag
+	 *  in the pcpu_flag field in the per-CPU region of the given physical CPU, and return its return value.
+	 *  - NEED_RESTART_VM
+	 *  - &per_cpu(pcpu_flag, pcpu_id)
+	 */
+	return bitmap_test_and_clear_lock(NEED_RESTART_VM, &per_cpu(pcpu_flag, pcpu_id));
+}
+
 /**
  * @}
  */
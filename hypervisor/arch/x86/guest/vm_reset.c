@@ -18,11 +18,13 @@
 
 /**
  * @file
- * @brief This file defines the APIs of requesting and handling VM shutdown.
+ * @brief This file defines the APIs of requesting and handling VM shutdown and restart.
  *
  * This file is decomposed into the following functions:
  *     fatal_error_shutdown_vm  -Do partial shutdown operation on the vm which vcpu belongs.
  *     shutdown_vm_from_idle    -Shutdown the vm that masked to be shutdown.
+ *     request_vm_restart       -Pause the vm and ask the physical cpu of its BP to restart it.
+ *     restart_vm_from_idle     -Restart the vm that masked to be restarted.
  */
 
 /**
@@ -123,6 +125,104 @@ void shutdown_vm_from_idle(uint16_t pcpu_id)
 	spinlock_release(&vm->vm_lock);
 }
 
+/**
+ * @brief  Pause the given vm and ask the physical cpu of its BP to restart it.
+ *
+ * @param[in]   vm The virtual machine to be restarted
+ *
+ * @return None
+ *
+ * @pre vm != NULL
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark This API can be called only after launch_vms has been called once on the processor.
+ *
+ * @reentrancy unspecified
+ * @threadsafety yes
+ */
+void request_vm_restart(struct acrn_vm *vm)
+{
+	/** Declare the following local variables of type uint16_t.
+	 *  - pcpu_id representing the physical cpu the BP of the vm runs on, initialized as
+	 *    pcpuid_from_vcpu(vcpu_from_vid(vm, BOOT_CPU_ID)). */
+	uint16_t pcpu_id = pcpuid_from_vcpu(vcpu_from_vid(vm, BOOT_CPU_ID));
+
+	/** Call spinlock_obtain with the following parameter, in order to acquire the spinlock for protecting
+	 *  simultaneous VM state transition requests
+	 *  - &vm->vm_lock
+	 */
+	spinlock_obtain(&vm->vm_lock);
+
+	/** Call pause_vm with the following parameters, in order to pause the virtual machine.
+	 *  - vm */
+	pause_vm(vm);
+
+	/** Call spinlock_release with the following parameter, in order to release the spinlock for protecting
+	 *  simultaneous VM state transition requests
+	 *  - &vm->vm_lock
+	 */
+	spinlock_release(&vm->vm_lock);
+
+	/** set the shutdown_vm_id field of per-CPU region of the cpu to the id of the virtual machine
+	 *  which will be restarted by hypervisor. */
+	per_cpu(shutdown_vm_id, pcpu_id) = vm->vm_id;
+	/** Call make_restart_vm_request with the following parameters, in order to send restart message to the
+	 *  physical cpu that the BP of the vm runs on.
+	 *  - pcpu_id */
+	make_restart_vm_request(pcpu_id);
+}
+
+/**
+ * @brief restart the vm that masked to be restarted
+ *
+ * The vm that masked to be restarted is the one whose vm id equals to the value of shutdown_vm_id field of the
+ * per-CPU region of physical cpu whose id is pcpu_id. If the vm cannot be restarted, it is shut down instead.
+ *
+ * @param[in]    pcpu_id The physical CPU ID whose per-CPU region records the ID of the VM to be restarted
+ *
+ * @return None
+ *
+ * @pre pcpu_id < MAX_PCPU_NUM
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark This API can be called only after launch_vms has been called once on the processor and
+ * the physical CPU id of this processor is the one the BP of the vm runs on.
+ *
+ * @reentrancy unspecified
+ * @threadsafety unspecified
+ */
+void restart_vm_from_idle(uint16_t pcpu_id)
+{
+	/** Declare the following local variables of type struct acrn_vm *.
+	 *  - vm representing the virtual machine whose VM ID equals to the value of shutdown_vm_id field of per-CPU
+	 *    region of physical cpu whose id is pcpu_id, initialized as
+	 *    get_vm_from_vmid(per_cpu(shutdown_vm_id, pcpu_id). */
+	struct acrn_vm *vm = get_vm_from_vmid(per_cpu(shutdown_vm_id, pcpu_id));
+
+	/** Call spinlock_obtain with the following parameter, in order to acquire the spinlock for protecting
+	 *  simultaneous VM state transition requests
+	 *  - &vm->vm_lock
+	 */
+	spinlock_obtain(&vm->vm_lock);
+
+	/** If vm->state is VM_PAUSED and the return value of restart_vm(vm) is not 0, indicating that the VM
+	 *  cannot be restarted. */
+	if ((vm->state == VM_PAUSED) && (restart_vm(vm) != 0)) {
+		/** Call shutdown_vm with the following parameters, in order to shutdown the virtual machine, and
+		 *  discard its return value because the return value of shutdown_vm is always 0.
+		 *  - vm */
+		(void)shutdown_vm(vm);
+	}
+
+	/** Call spinlock_release with the following parameter, in order to release the spinlock for protecting
+	 *  simultaneous VM state transition requests
+	 *  - &vm->vm_lock
+	 */
+	spinlock_release(&vm->vm_lock);
+}
+
 /**
  * @}
  */
@@ -0,0 +1,639 @@
+/*
+ * Copyright (C) 2019 Intel Corporation. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <vm.h>
+#include <per_cpu.h>
+#include <lapic.h>
+#include <pgtable.h>
+#include <mmu.h>
+#include <guest_memory.h>
+#include <atomic.h>
+#include <timer.h>
+#include <bulk_mem.h>
+#include <logmsg.h>
+#include <vm_scrub.h>
+
+/**
+ * @addtogroup vp-base_vm
+ *
+ * @{
+ */
+
+/**
+ * @file
+ * @brief This file implements scrubbing the memory of a VM on the physical CPUs it holds.
+ *
+ * The memory of a VM is cleared with non-temporal stores, in chunks of SCRUB_CHUNK_SIZE bytes that all the physical
+ * CPUs of the VM take in parallel. The physical CPU that posts the scrub calls post_vm_scrub, which kicks the other
+ * ones of the VM out of their idle loop into scrub_vm_from_idle, and finish_vm_scrub, which takes chunks along with
+ * them and returns once the whole memory is cleared.
+ *
+ * When the VM shuts down, its RAM and its golden snapshot are scrubbed before its physical CPUs go offline. When the
+ * VM is restarted, only the boot window, the part of the RAM the guest OS image and its boot data are loaded to, is
+ * scrubbed when the scrub is posted. The rest of the RAM is scrubbed by the other physical CPUs while the image is
+ * loaded again, and finish_vm_scrub is called before the virtual BP is kicked off. The memory the guest OS image and
+ * its boot arguments are originally saved in is not scrubbed, as it is needed to load them again, unless the guest has
+ * been running the kernel in it, in which case it is scrubbed at shutdown.
+ *
+ * Helper functions include: add_scrub_hole, scrub_hpa_range, scrub_chunks, get_boot_window_end,
+ * make_scrub_vm_request.
+ */
+
+/**
+ * @brief Size of the chunks the memory of a VM is split into to be shared by its physical CPUs.
+ */
+#define SCRUB_CHUNK_SIZE	MEM_2M
+
+#define SCRUB_RANGE_MAX		3U	/**< Maximum number of host physical ranges in a scrub */
+#define SCRUB_HOLE_MAX		3U	/**< Maximum number of host physical ranges left out of a scrub */
+
+#define SCRUB_IDLE		0UL	/**< No scrub is posted */
+#define SCRUB_POSTED		1UL	/**< A scrub is posted and its chunks can be taken */
+
+/**
+ * @brief Data structure of a memory scrub shared by the physical CPUs of a VM.
+ *
+ * All the fields but next_chunk, done_chunks, bytes and helpers are written by the physical CPU that posts the scrub
+ * before state becomes SCRUB_POSTED and are never changed after that.
+ *
+ * @consistency N/A
+ * @alignment 8
+ *
+ * @remark N/A
+ */
+struct vm_scrub_job {
+	uint64_t range_start[SCRUB_RANGE_MAX]; /**< Starting HPA of each range to scrub */
+	uint64_t range_end[SCRUB_RANGE_MAX]; /**< Ending HPA (exclusive) of each range to scrub */
+	uint64_t range_chunks[SCRUB_RANGE_MAX]; /**< Number of chunks of each range to scrub */
+	uint64_t hole_start[SCRUB_HOLE_MAX]; /**< Starting HPA of each range left out */
+	uint64_t hole_end[SCRUB_HOLE_MAX]; /**< Ending HPA (exclusive) of each range left out */
+	uint32_t hole_num; /**< Number of ranges left out */
+	uint64_t chunk_num; /**< Number of chunks of all the ranges to scrub */
+	uint64_t next_chunk; /**< Index of the next chunk to be taken */
+	uint64_t done_chunks; /**< Number of chunks already scrubbed */
+	uint64_t bytes; /**< Number of bytes already scrubbed */
+	uint64_t helpers; /**< Number of physical CPUs other than the posting one that took part in the scrub */
+	uint64_t start_tsc; /**< TSC value when the scrub is posted */
+	uint64_t state; /**< One of SCRUB_IDLE and SCRUB_POSTED */
+};
+
+/**
+ * @brief Memory scrubs indexed by VM ID.
+ */
+static struct vm_scrub_job vm_scrub_jobs[CONFIG_MAX_VM_NUM];
+
+/**
+ * @brief Leave the given host physical range out of a scrub.
+ *
+ * @param[inout] job Pointer to the scrub being posted.
+ * @param[in] start Starting HPA of the range, page aligned.
+ * @param[in] end Ending HPA (exclusive) of the range, page aligned.
+ *
+ * @return None
+ *
+ * @pre job != NULL
+ * @pre job->hole_num < SCRUB_HOLE_MAX
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal function called by post_vm_scrub.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a job is different among parallel invocation
+ */
+static void add_scrub_hole(struct vm_scrub_job *job, uint64_t start, uint64_t end)
+{
+	/** If start is less than end */
+	if (start < end) {
+		/** Set job->hole_start[job->hole_num] to start */
+		job->hole_start[job->hole_num] = start;
+		/** Set job->hole_end[job->hole_num] to end */
+		job->hole_end[job->hole_num] = end;
+		/** Increment job->hole_num by 1 */
+		job->hole_num++;
+	}
+}
+
+/**
+ * @brief Scrub the given host physical range except the parts left out of the scrub.
+ *
+ * @param[inout] job Pointer to the scrub the range belongs to.
+ * @param[in] start Starting HPA of the range, page aligned.
+ * @param[in] end Ending HPA (exclusive) of the range, page aligned.
+ *
+ * @return None
+ *
+ * @pre job != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal function called by scrub_chunks and post_vm_scrub.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When [\a start, \a end) is different among parallel invocation
+ */
+static void scrub_hpa_range(struct vm_scrub_job *job, uint64_t start, uint64_t end)
+{
+	/** Declare the following local variables of type uint64_t.
+	 *  - cur representing the HPA the scrub goes on from, initialized as start.
+	 *  - stop representing the HPA the current run of scrubbing stops at, not initialized.
+	 *  - resume representing the HPA the scrub resumes from after the current run, not initialized.
+	 */
+	uint64_t cur = start, stop, resume;
+	/** Declare the following local variables of type uint32_t.
+	 *  - i representing a loop counter used as index of the holes, not initialized.
+	 */
+	uint32_t i;
+
+	/** Until cur is not less than end */
+	while (cur < end) {
+		/** Set stop to end */
+		stop = end;
+		/** Set resume to end */
+		resume = end;
+		/** For each i ranging from 0 to job->hole_num - 1 [with a step of 1] */
+		for (i = 0U; i < job->hole_num; i++) {
+			/** If the hole i overlaps [cur, stop) */
+			if ((job->hole_end[i] > cur) && (job->hole_start[i] < stop)) {
+				/** Set stop to the larger value between job->hole_start[i] and cur */
+				stop = (job->hole_start[i] > cur) ? job->hole_start[i] : cur;
+				/** Set resume to job->hole_end[i] */
+				resume = job->hole_end[i];
+			}
+		}
+
+		/** If stop is larger than cur */
+		if (stop > cur) {
+			/** Call bulk_clear with the following parameters, in order to clear [cur, stop).
+			 *  - hpa2hva(cur)
+			 *  - stop - cur
+			 */
+			bulk_clear(hpa2hva(cur), stop - cur);
+			/** Call atomic_xadd64 with the following parameters, in order to account the bytes cleared.
+			 *  - &job->bytes
+			 *  - stop - cur
+			 */
+			(void)atomic_xadd64(&job->bytes, stop - cur);
+		}
+		/** Set cur to resume */
+		cur = resume;
+	}
+}
+
+/**
+ * @brief Scrub chunks of a posted scrub until none is left.
+ *
+ * @param[inout] job Pointer to the scrub whose chunks are to be scrubbed.
+ *
+ * @return None
+ *
+ * @pre job != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal function called by finish_vm_scrub and scrub_vm_from_idle.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+static void scrub_chunks(struct vm_scrub_job *job)
+{
+	/** Declare the following local variables of type uint64_t.
+	 *  - chunk representing the index of the chunk taken by the current physical CPU, initialized as the return
+	 *  value of atomic_xadd64(&job->next_chunk, 1).
+	 *  - index representing the index of the chunk in its range, not initialized.
+	 *  - start representing the starting HPA of the chunk, not initialized.
+	 */
+	uint64_t chunk = atomic_xadd64(&job->next_chunk, 1UL);
+	uint64_t index, start;
+	/** Declare the following local variables of type uint32_t.
+	 *  - r representing the index of the range the chunk belongs to, not initialized.
+	 */
+	uint32_t r;
+
+	/** Until chunk is not less than job->chunk_num */
+	while (chunk < job->chunk_num) {
+		/** Set r to 0 */
+		r = 0U;
+		/** Set index to chunk */
+		index = chunk;
+		/** Until index is less than job->range_chunks[r] */
+		while (index >= job->range_chunks[r]) {
+			/** Decrement index by job->range_chunks[r] */
+			index -= job->range_chunks[r];
+			/** Increment r by 1 */
+			r++;
+		}
+
+		/** Set start to job->range_start[r] + index * SCRUB_CHUNK_SIZE */
+		start = job->range_start[r] + (index * SCRUB_CHUNK_SIZE);
+		/** Call scrub_hpa_range with the following parameters, in order to scrub the chunk.
+		 *  - job
+		 *  - start
+		 *  - the smaller value between start + SCRUB_CHUNK_SIZE and job->range_end[r]
+		 */
+		scrub_hpa_range(job, start, ((job->range_end[r] - start) > SCRUB_CHUNK_SIZE) ?
+			(start + SCRUB_CHUNK_SIZE) : job->range_end[r]);
+		/** Call atomic_inc64 with the following parameters, in order to account the chunk as scrubbed.
+		 *  - &job->done_chunks
+		 */
+		atomic_inc64(&job->done_chunks);
+		/** Set chunk to the return value of atomic_xadd64(&job->next_chunk, 1) */
+		chunk = atomic_xadd64(&job->next_chunk, 1UL);
+	}
+}
+
+/**
+ * @brief Get the ending HPA of the boot window of the given VM.
+ *
+ * The boot window starts at the beginning of the RAM of the VM and covers the guest kernel image, the boot arguments,
+ * the zero page right after them and the GDT the guest starts with, which is the whole footprint of
+ * direct_boot_sw_loader in the guest RAM.
+ *
+ * @param[in] vm Pointer to the VM whose boot window is to be computed.
+ * @param[in] ram_end Ending HPA (exclusive) of the RAM of the VM.
+ *
+ * @return The ending HPA (exclusive) of the boot window, which is not larger than \a ram_end.
+ *
+ * @pre vm != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal function called by post_vm_scrub.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vm is different among parallel invocation
+ */
+static uint64_t get_boot_window_end(struct acrn_vm *vm, uint64_t ram_end)
+{
+	/** Declare the following local variables of type uint64_t.
+	 *  - kernel_end representing the ending GPA of the guest kernel image, initialized as
+	 *  vm->sw.kernel_info.kernel_load_addr + vm->sw.kernel_info.kernel_size.
+	 *  - bootargs_end representing the ending GPA of the zero page placed in the page after the boot arguments,
+	 *  initialized as vm->sw.bootargs_info.load_addr + 2 * MEM_4K.
+	 *  - gpa_end representing the ending GPA of the boot window, not initialized.
+	 *  - hpa_end representing the ending HPA of the boot window, not initialized.
+	 */
+	uint64_t kernel_end = vm->sw.kernel_info.kernel_load_addr + vm->sw.kernel_info.kernel_size;
+	uint64_t bootargs_end = vm->sw.bootargs_info.load_addr + (2UL * MEM_4K);
+	uint64_t gpa_end, hpa_end;
+
+	/** Set gpa_end to the larger value between kernel_end and bootargs_end, rounded up to a page boundary, plus
+	 *  one page for the GDT placed right after the kernel image and the boot arguments */
+	gpa_end = round_page_up((kernel_end > bootargs_end) ? kernel_end : bootargs_end) + PAGE_SIZE;
+	/** Set hpa_end to the HPA the last byte of the boot window is mapped to, plus 1 */
+	hpa_end = gpa2hpa(vm, gpa_end - 1UL) + 1UL;
+
+	/** Return the smaller value between hpa_end and ram_end */
+	return (hpa_end < ram_end) ? hpa_end : ram_end;
+}
+
+/**
+ * @brief Make a request to the given physical CPU to take part in scrubbing the memory of the given VM.
+ *
+ * @param[in] pcpu_id ID of the physical CPU which will take part in the scrub.
+ * @param[in] vm_id ID of the VM whose memory is scrubbed.
+ *
+ * @return None
+ *
+ * @pre pcpu_id < MAX_PCPU_NUM
+ * @pre pcpu_id != get_pcpu_id()
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal function called by post_vm_scrub.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+static void make_scrub_vm_request(uint16_t pcpu_id, uint16_t vm_id)
+{
+	/** Set the shutdown_vm_id field of per-CPU region of the physical CPU to vm_id */
+	per_cpu(shutdown_vm_id, pcpu_id) = vm_id;
+	/** Call bitmap_set_lock with the following parameters, in order set the flag into the pcpu_flag field in
+	 *  the per-CPU region of the given physical CPU.
+	 *  - NEED_SCRUB_VM
+	 *  - &per_cpu(pcpu_flag, pcpu_id)
+	 */
+	bitmap_set_lock(NEED_SCRUB_VM, &per_cpu(pcpu_flag, pcpu_id));
+	/** Call send_single_init with the following parameters, in order to send IPI to the physical CPU.
+	 *  - pcpu_id
+	 */
+	send_single_init(pcpu_id);
+}
+
+/**
+ * @brief Post a scrub of the memory of the given VM.
+ *
+ * The scrub covers the RAM of the VM and, when \a restart is false, the memory reserved for its golden snapshot. The
+ * memory the guest OS image and its boot arguments are originally saved in is left out, except the guest kernel image
+ * the guest runs in place, which is scrubbed along with the RAM when \a restart is false. The other physical CPUs of
+ * the VM are requested to take chunks of the scrub from their idle loop.
+ *
+ * When \a restart is true, the boot window of the VM is left out of the chunks and scrubbed on the current physical
+ * CPU before this function returns, except the pages the guest kernel image is copied to. The guest OS image can then
+ * be loaded again while the other physical CPUs scrub the rest of the RAM.
+ *
+ * @param[inout] vm Pointer to the VM whose memory is to be scrubbed.
+ * @param[in] restart Whether the VM is being restarted.
+ *
+ * @return None
+ *
+ * @pre vm != NULL
+ * @pre The vCPUs of the VM are paused.
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is called by shutdown_vm and restart_vm. finish_vm_scrub shall be called on the same physical CPU
+ * before the memory of the VM is used again.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vm is different among parallel invocation
+ */
+void post_vm_scrub(struct acrn_vm *vm, bool restart)
+{
+	/** Declare the following local variables of type 'const struct acrn_vm_config *'.
+	 *  - vm_config representing the configuration data of the VM, initialized as get_vm_config(vm->vm_id).
+	 */
+	const struct acrn_vm_config *vm_config = get_vm_config(vm->vm_id);
+	/** Declare the following local variables of type 'struct vm_scrub_job *'.
+	 *  - job representing the scrub of the VM, initialized as &vm_scrub_jobs[vm->vm_id].
+	 */
+	struct vm_scrub_job *job = &vm_scrub_jobs[vm->vm_id];
+	/** Declare the following local variables of type 'const struct sw_kernel_info *'.
+	 *  - sw_kernel representing the guest kernel image info of the VM, initialized as &(vm->sw.kernel_info).
+	 */
+	const struct sw_kernel_info *sw_kernel = &(vm->sw.kernel_info);
+	/** Declare the following local variables of type 'const struct sw_module_info *'.
+	 *  - bootargs_info representing the boot arguments info of the VM, initialized as &(vm->sw.bootargs_info).
+	 */
+	const struct sw_module_info *bootargs_info = &(vm->sw.bootargs_info);
+	/** Declare the following local variables of type uint64_t.
+	 *  - ram_end representing the ending HPA of the RAM of the VM, initialized as
+	 *  vm_config->memory.start_hpa + vm_config->memory.size.
+	 *  - boot_end representing the ending HPA of the boot window of the VM, initialized as
+	 *  vm_config->memory.start_hpa.
+	 *  - hpa representing an HPA a guest image is saved in or loaded to, not initialized.
+	 */
+	uint64_t ram_end = vm_config->memory.start_hpa + vm_config->memory.size;
+	uint64_t boot_end = vm_config->memory.start_hpa;
+	uint64_t hpa;
+	/** Declare the following local variables of type uint16_t.
+	 *  - i representing a loop counter used as index of the vCPUs of the VM, not initialized.
+	 */
+	uint16_t i;
+	/** Declare the following local variables of type 'struct acrn_vcpu *'.
+	 *  - vcpu representing a pointer to one vCPU of the VM, not initialized.
+	 */
+	struct acrn_vcpu *vcpu;
+
+	/** Set job->hole_num to 0 */
+	job->hole_num = 0U;
+	/** Set hpa to the HPA the guest kernel image is originally saved in */
+	hpa = hva2hpa(sw_kernel->kernel_src_addr);
+	/** If sw_kernel->kernel_in_place is false, which means the guest kernel image is still needed to load it again */
+	if (!sw_kernel->kernel_in_place) {
+		/** Call add_scrub_hole in order to leave out the pages the guest kernel image is originally saved in */
+		add_scrub_hole(job, round_page_down(hpa), round_page_up(hpa + sw_kernel->kernel_size));
+	}
+	/** If the boot arguments are not empty */
+	if (bootargs_info->size != 0U) {
+		/** Set hpa to the HPA the boot arguments are originally saved in */
+		hpa = hva2hpa(bootargs_info->src_addr);
+		/** Call add_scrub_hole in order to leave out the pages the boot arguments are originally saved in */
+		add_scrub_hole(job, round_page_down(hpa), round_page_up(hpa + bootargs_info->size));
+	}
+
+	/** If restart is true */
+	if (restart) {
+		/** Set boot_end to the return value of get_boot_window_end(vm, ram_end) */
+		boot_end = get_boot_window_end(vm, ram_end);
+		/** Set hpa to the HPA the guest kernel image is loaded to */
+		hpa = gpa2hpa(vm, sw_kernel->kernel_load_addr);
+		/** Call add_scrub_hole in order to leave out the pages the guest kernel image fully overwrites */
+		add_scrub_hole(job, round_page_up(hpa), round_page_down(hpa + sw_kernel->kernel_size));
+	}
+
+	/** Set job->range_start[0] and job->range_end[0] to the RAM of the VM after the boot window */
+	job->range_start[0] = boot_end;
+	job->range_end[0] = ram_end;
+	/** Set job->range_start[1], job->range_end[1], job->range_start[2] and job->range_end[2] to empty ranges */
+	job->range_start[1] = 0UL;
+	job->range_end[1] = 0UL;
+	job->range_start[2] = 0UL;
+	job->range_end[2] = 0UL;
+	/** If restart is false and the VM has memory reserved for its golden snapshot */
+	if (!restart && (vm_config->memory.snapshot_hpa != 0UL)) {
+		/** Set job->range_start[1] and job->range_end[1] to the memory reserved for the golden snapshot */
+		job->range_start[1] = vm_config->memory.snapshot_hpa;
+		job->range_end[1] = vm_config->memory.snapshot_hpa + vm_config->memory.size;
+	}
+	/** If restart is false, sw_kernel->kernel_in_place is true and the guest kernel image is originally saved outside
+	 *  the RAM of the VM, which means its module memory has been mapped into the VM */
+	if (!restart && sw_kernel->kernel_in_place && ((hpa < vm_config->memory.start_hpa) || (hpa >= ram_end))) {
+		/** Set job->range_start[2] and job->range_end[2] to the module pages the guest has been running the
+		 *  kernel in */
+		job->range_start[2] = hpa;
+		job->range_end[2] = hpa + ((uint64_t)sw_kernel->kernel_size & PAGE_MASK);
+	}
+	/** Set job->range_chunks[0], job->range_chunks[1] and job->range_chunks[2] to the number of SCRUB_CHUNK_SIZE
+	 *  sized chunks needed to cover each range */
+	job->range_chunks[0] = ((job->range_end[0] - job->range_start[0]) + SCRUB_CHUNK_SIZE - 1UL) / SCRUB_CHUNK_SIZE;
+	job->range_chunks[1] = ((job->range_end[1] - job->range_start[1]) + SCRUB_CHUNK_SIZE - 1UL) / SCRUB_CHUNK_SIZE;
+	job->range_chunks[2] = ((job->range_end[2] - job->range_start[2]) + SCRUB_CHUNK_SIZE - 1UL) / SCRUB_CHUNK_SIZE;
+	/** Set job->chunk_num to job->range_chunks[0] + job->range_chunks[1] + job->range_chunks[2] */
+	job->chunk_num = job->range_chunks[0] + job->range_chunks[1] + job->range_chunks[2];
+	/** Set job->next_chunk, job->done_chunks, job->bytes and job->helpers to 0 */
+	job->next_chunk = 0UL;
+	job->done_chunks = 0UL;
+	job->bytes = 0UL;
+	job->helpers = 0UL;
+	/** Set job->start_tsc to the return value of rdtsc() */
+	job->start_tsc = rdtsc();
+	/** Call cpu_write_memory_barrier in order to make the scrub visible before it is posted. */
+	cpu_write_memory_barrier();
+	/** Set job->state to SCRUB_POSTED */
+	job->state = SCRUB_POSTED;
+
+	/** For each vcpu in the online vCPUs of the given VM, using i as the loop counter */
+	foreach_vcpu(i, vm, vcpu) {
+		/** If the vCPU runs on another physical CPU than the current one */
+		if (pcpuid_from_vcpu(vcpu) != get_pcpu_id()) {
+			/** Call make_scrub_vm_request with the following parameters, in order to request the physical
+			 *  CPU to take part in the scrub.
+			 *  - pcpuid_from_vcpu(vcpu)
+			 *  - vm->vm_id
+			 */
+			make_scrub_vm_request(pcpuid_from_vcpu(vcpu), vm->vm_id);
+		}
+	}
+
+	/** Call scrub_hpa_range with the following parameters, in order to scrub the boot window, which is empty
+	 *  unless restart is true.
+	 *  - job
+	 *  - vm_config->memory.start_hpa
+	 *  - boot_end
+	 */
+	scrub_hpa_range(job, vm_config->memory.start_hpa, boot_end);
+}
+
+/**
+ * @brief Complete the scrub of the memory of the given VM.
+ *
+ * It takes chunks of the scrub along with the other physical CPUs of the VM, and returns once all the chunks are
+ * scrubbed, whether or not any other physical CPU took part. The size of the memory scrubbed and the throughput are
+ * logged.
+ *
+ * @param[in] vm Pointer to the VM whose memory is being scrubbed.
+ *
+ * @return None
+ *
+ * @pre vm != NULL
+ * @pre post_vm_scrub has been called for the VM on the current physical CPU.
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is called by shutdown_vm and restart_vm.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vm is different among parallel invocation
+ */
+void finish_vm_scrub(struct acrn_vm *vm)
+{
+	/** Declare the following local variables of type 'struct vm_scrub_job *'.
+	 *  - job representing the scrub of the VM, initialized as &vm_scrub_jobs[vm->vm_id].
+	 */
+	struct vm_scrub_job *job = &vm_scrub_jobs[vm->vm_id];
+	/** Declare the following local variables of type uint64_t.
+	 *  - us representing the time the scrub took in microseconds, not initialized.
+	 */
+	uint64_t us;
+
+	/** Call scrub_chunks with the following parameters, in order to take chunks along with the other physical
+	 *  CPUs of the VM.
+	 *  - job
+	 */
+	scrub_chunks(job);
+	/** Until job->done_chunks is equal to job->chunk_num */
+	while (*(volatile uint64_t *)&job->done_chunks != job->chunk_num) {
+		/** Call asm_pause in order to wait for the chunks taken by the other physical CPUs. */
+		asm_pause();
+	}
+	/** Set job->state to SCRUB_IDLE */
+	job->state = SCRUB_IDLE;
+
+	/** Set us to the time elapsed since the scrub was posted in microseconds, at least 1 */
+	us = (((rdtsc() - job->start_tsc) * 1000UL) / (uint64_t)get_tsc_khz()) + 1UL;
+	/** Logging the following information with a log level of LOG_ACRN.
+	 *  - vm->vm_id
+	 *  - the size of the memory scrubbed in MB
+	 *  - us
+	 *  - the throughput in MB per second
+	 *  - the number of physical CPUs that took part in the scrub
+	 */
+	pr_acrnlog("VM %hu: %lu MB scrubbed in %lu us (%lu MB/s) on %lu pCPUs", vm->vm_id, job->bytes / MEM_1M, us,
+		((job->bytes / us) * 1000000UL) / MEM_1M, job->helpers + 1UL);
+}
+
+/**
+ * @brief Check whether the physical CPU needs to take part in scrubbing the memory of a VM
+ *
+ * @param[in] pcpu_id ID of the physical CPU to check.
+ *
+ * @return Whether the physical CPU needs to take part in scrubbing the memory of a VM.
+ *
+ * @retval true if the physical CPU needs to take part in scrubbing the memory of a VM.
+ * @retval false if the physical CPU does not need to take part in scrubbing the memory of a VM.
+ *
+ * @pre pcpu_id < MAX_PCPU_NUM
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is a public API called by other modules.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+bool need_scrub_vm(uint16_t pcpu_id)
+{
+	/** Call bitmap_test_and_clear_lock with the following parameters, in order to check and clear the flag
+	 *  in the pcpu_flag field in the per-CPU region of the given physical CPU, and return its return value.
+	 *  - NEED_SCRUB_VM
+	 *  - &per_cpu(pcpu_flag, pcpu_id)
+	 */
+	return bitmap_test_and_clear_lock(NEED_SCRUB_VM, &per_cpu(pcpu_flag, pcpu_id));
+}
+
+/**
+ * @brief Take part in scrubbing the memory of the VM recorded in the per-CPU region of the physical CPU.
+ *
+ * The VM is the one whose VM ID equals to the value of shutdown_vm_id field of the per-CPU region of the physical CPU
+ * whose ID is \a pcpu_id. Chunks of its scrub are taken until none is left, if the scrub is still posted.
+ *
+ * @param[in] pcpu_id ID of the current physical CPU.
+ *
+ * @return None
+ *
+ * @pre pcpu_id < MAX_PCPU_NUM
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is called by the idle thread when need_scrub_vm(pcpu_id) returns true.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a pcpu_id is different among parallel invocation
+ */
+void scrub_vm_from_idle(uint16_t pcpu_id)
+{
+	/** Declare the following local variables of type 'struct vm_scrub_job *'.
+	 *  - job representing the scrub of the VM, initialized as &vm_scrub_jobs[per_cpu(shutdown_vm_id, pcpu_id)].
+	 */
+	struct vm_scrub_job *job = &vm_scrub_jobs[per_cpu(shutdown_vm_id, pcpu_id)];
+
+	/** If job->state is equal to SCRUB_POSTED */
+	if (*(volatile uint64_t *)&job->state == SCRUB_POSTED) {
+		/** Call atomic_inc64 with the following parameters, in order to account the current physical CPU as a
+		 *  helper of the scrub.
+		 *  - &job->helpers
+		 */
+		atomic_inc64(&job->helpers);
+		/** Call scrub_chunks with the following parameters, in order to take chunks of the scrub.
+		 *  - job
+		 */
+		scrub_chunks(job);
+	}
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,1378 @@
+/*
+ * Copyright (C) 2019 Intel Corporation. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <errno.h>
+#include <vm.h>
+#include <virq.h>
+#include <vmx.h>
+#include <pgtable.h>
+#include <mmu.h>
+#include <ept.h>
+#include <vtd.h>
+#include <e820.h>
+#include <reloc.h>
+#include <atomic.h>
+#include <timer.h>
+#include <bulk_mem.h>
+#include <logmsg.h>
+#include <vm_snapshot.h>
+
+/**
+ * @addtogroup vp-base_vm
+ *
+ * @{
+ */
+
+/**
+ * @file
+ * @brief This file implements the golden snapshot of a VM and the incremental checkpoints refreshing it.
+ *
+ * A VM whose configuration reserves memory for a golden snapshot (snapshot_hpa in its memory configuration) takes the
+ * snapshot once the guest writes to SNAPSHOT_PIO_PORT, which it does when it completes booting. All the vCPUs of the
+ * VM then meet in save_vcpu_snapshot, each one saving its own state on its own physical CPU, and copy the guest RAM
+ * to the reserved memory together, in chunks of SNAPSHOT_CHUNK_SIZE bytes, before any of them goes back to the guest.
+ *
+ * When the VM is restarted afterwards, restore_vm_snapshot copies the guest RAM back and resumes every vCPU at the
+ * state it was saved in instead of loading the guest OS image again. The guest resumes right after its write to
+ * SNAPSHOT_PIO_PORT, where reading the port tells it how many times it has been restored, so that it can reset the
+ * pass-through devices it owns, whose state is not part of the snapshot.
+ *
+ * The snapshot can be refreshed afterwards by checkpoints requested through take_vm_checkpoint, in the same way. If
+ * EPT accessed and dirty flags are enabled for the VM, all its pages are marked as clean each time its guest RAM is in
+ * sync with the snapshot, and a checkpoint only copies the pages found dirty since, split into chunks of the guest
+ * physical address space. A restore then only copies back those pages as well. Writes made by the hypervisor or by
+ * pass-through devices through DMA do not set the dirty flags. The hypervisor writes guest memory through
+ * copy_to_gpa, e.g. when loading the guest OS image or emulating INS, which sets the software dirty bit of the pages
+ * written. As DMA can land anywhere in the guest RAM, checkpoints and restores of a VM with devices assigned to its
+ * IOMMU domain always copy the whole guest RAM.
+ *
+ * The vCPU states are kept in two sets, and a snapshot being saved writes the set the complete snapshot is not made of.
+ * The guest RAM is only copied once all the vCPUs saved their state, and the set saved is committed when the last
+ * chunk is copied. If the VM is restarted while a snapshot is being saved, the copy is completed by restore_vm_snapshot
+ * if all the vCPUs saved their state, or the snapshot being saved is dropped otherwise, so that the last complete
+ * snapshot is never lost.
+ *
+ * The reserved memory can also be lent as scratch memory, e.g. to benchmark bulk memory operations, through
+ * lend_vm_snapshot_memory, as long as no snapshot is kept in it, and reclaim_vm_snapshot_memory.
+ *
+ * Helper functions include: is_snapshot_region_valid, is_dirty_tracking_complete, snapshot_io_read, snapshot_io_write, request_vm_snapshot,
+ * lookup_chunk_entry, sync_dirty_page, sync_dirty_chunk, copy_snapshot_chunks.
+ *
+ * Decomposed functions include: save_vcpu_regs, load_vcpu_regs.
+ */
+
+/**
+ * @brief Size of the chunks the guest RAM copy is split into to be shared by the vCPUs of a VM.
+ */
+#define SNAPSHOT_CHUNK_SIZE	MEM_2M
+
+/**
+ * @brief Mask of the bits of a leaf EPT entry that tell the page is written since the VM was last checkpointed.
+ */
+#define SNAPSHOT_DIRTY_MASK	((1UL << EPT_DIRTY_POS) | (1UL << EPT_SOFT_DIRTY_POS))
+
+#define SNAPSHOT_NONE		0UL	/**< No golden snapshot is taken */
+#define SNAPSHOT_SAVING		1UL	/**< The vCPUs are saving the golden snapshot */
+#define SNAPSHOT_READY		2UL	/**< The golden snapshot is complete */
+#define SNAPSHOT_LENT		3UL	/**< The reserved memory is lent as scratch memory by lend_vm_snapshot_memory */
+
+/**
+ * @brief Number of local APIC registers saved in the snapshot of a vCPU.
+ */
+#define SNAPSHOT_LAPIC_REG_NUM	11U
+
+/**
+ * @brief The x2APIC MSRs of the local APIC registers saved in the snapshot of a vCPU.
+ *
+ * They are listed in the order they are written back, the initial count register last as writing it starts the
+ * APIC timer.
+ */
+static const uint32_t snapshot_lapic_msrs[SNAPSHOT_LAPIC_REG_NUM] = {
+	MSR_IA32_EXT_APIC_DIV_CONF,
+	MSR_IA32_EXT_APIC_LVT_CMCI,
+	MSR_IA32_EXT_APIC_LVT_TIMER,
+	MSR_IA32_EXT_APIC_LVT_THERMAL,
+	MSR_IA32_EXT_APIC_LVT_PMI,
+	MSR_IA32_EXT_APIC_LVT_LINT0,
+	MSR_IA32_EXT_APIC_LVT_LINT1,
+	MSR_IA32_EXT_APIC_LVT_ERROR,
+	MSR_IA32_EXT_APIC_SIVR,
+	MSR_IA32_EXT_APIC_TPR,
+	MSR_IA32_EXT_APIC_INIT_COUNT,
+};
+
+/**
+ * @brief Data structure of the state of a vCPU saved in a golden snapshot.
+ *
+ * @consistency N/A
+ * @alignment 64
+ *
+ * @remark N/A
+ */
+struct vcpu_snapshot {
+	struct run_context run_ctx; /**< Run context with RIP pointing to the next guest instruction */
+	struct ext_context ext_ctx; /**< Extended context including the XSAVE area */
+	uint64_t guest_msrs[NUM_GUEST_MSRS]; /**< Emulated guest MSRs */
+	enum vm_cpu_mode cpu_mode; /**< Mode of the vCPU */
+	uint64_t dr7; /**< Guest DR7 */
+	uint64_t sysenter_esp; /**< Guest IA32_SYSENTER_ESP MSR */
+	uint64_t sysenter_eip; /**< Guest IA32_SYSENTER_EIP MSR */
+	uint32_t sysenter_cs; /**< Guest IA32_SYSENTER_CS MSR */
+	uint32_t interruptibility; /**< Guest interruptibility state */
+	uint32_t activity_state; /**< Guest activity state */
+	uint64_t tsc_deadline; /**< Guest IA32_TSC_DEADLINE MSR */
+	uint64_t lapic_regs[SNAPSHOT_LAPIC_REG_NUM]; /**< Local APIC registers listed in snapshot_lapic_msrs */
+};
+
+/**
+ * @brief Data structure of the golden snapshot of a VM.
+ *
+ * The guest RAM is saved in the memory reserved by the VM configuration, and everything else is saved here.
+ *
+ * @consistency N/A
+ * @alignment 64
+ *
+ * @remark N/A
+ */
+struct vm_snapshot {
+	bool enabled; /**< Whether the VM configuration reserves valid memory for the snapshot */
+	bool incremental; /**< Whether the snapshot being saved only copies the pages dirty since the previous one */
+	uint64_t state; /**< One of SNAPSHOT_NONE, SNAPSHOT_SAVING, SNAPSHOT_READY and SNAPSHOT_LENT */
+	uint64_t start_tsc; /**< TSC value when the snapshot is requested */
+	uint64_t vcpu_num; /**< Number of vCPUs taking part in the snapshot */
+	uint64_t arrived_vcpus; /**< Number of vCPUs that saved their state */
+	uint64_t chunk_num; /**< Number of chunks of the guest RAM */
+	uint64_t next_chunk; /**< Index of the next chunk to be taken */
+	uint64_t done_chunks; /**< Number of chunks already copied */
+	uint64_t dirty_chunk_num; /**< Number of chunks of the guest physical address space up to the end of RAM */
+	uint64_t copied_bytes; /**< Number of bytes copied by the snapshot being saved */
+	uint64_t restore_count; /**< Number of times the VM has been restored from the snapshot */
+	uint64_t prev_state; /**< State of the snapshot before the one being saved was requested */
+	uint32_t committed; /**< Index of the set of vCPU states the complete snapshot is made of */
+	struct vcpu_snapshot vcpus[2][MAX_VCPUS_PER_VM]; /**< Two sets of vCPU states indexed by vCPU ID */
+};
+
+/**
+ * @brief Golden snapshots indexed by VM ID.
+ */
+static struct vm_snapshot vm_snapshots[CONFIG_MAX_VM_NUM];
+
+/**
+ * @brief Check whether the memory reserved for the golden snapshot of a VM can be used.
+ *
+ * The memory shall be page aligned, lie in a single RAM entry of the host e820 table, and overlap no memory reserved
+ * for other uses, as checked by is_host_region_reserved.
+ *
+ * @param[in] vm_id The ID of the VM.
+ * @param[in] vm_config Pointer to the configuration data of the VM.
+ *
+ * @return Whether the reserved memory can be used.
+ *
+ * @pre vm_config != NULL
+ * @pre vm_config->memory.snapshot_hpa != 0
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_ROOT
+ *
+ * @remark It is an internal function called by init_vm_snapshot.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+static bool is_snapshot_region_valid(uint16_t vm_id, const struct acrn_vm_config *vm_config)
+{
+	/** Declare the following local variables of type uint64_t.
+	 *  - hpa representing the start of the reserved memory, initialized as vm_config->memory.snapshot_hpa.
+	 *  - size representing the size of the reserved memory, initialized as vm_config->memory.size.
+	 */
+	uint64_t hpa = vm_config->memory.snapshot_hpa;
+	uint64_t size = vm_config->memory.size;
+	/** Declare the following local variables of type 'const struct e820_entry *'.
+	 *  - entry representing the host e820 entries, initialized as the return value of get_e820_entry().
+	 */
+	const struct e820_entry *entry = get_e820_entry();
+	/** Declare the following local variables of type uint32_t.
+	 *  - i representing the index of the host e820 entry being checked, not initialized.
+	 */
+	uint32_t i;
+	/** Declare the following local variables of type bool.
+	 *  - valid representing whether the reserved memory can be used, initialized as false.
+	 */
+	bool valid = false;
+
+	/** If hpa and size are both page aligned */
+	if (((hpa | size) & (PAGE_SIZE - 1UL)) == 0UL) {
+		/** For each i ranging from 0 to get_e820_entries_count() - 1 [with a step of 1] */
+		for (i = 0U; i < get_e820_entries_count(); i++) {
+			/** If entry[i] is a RAM entry holding [hpa, hpa + size) */
+			if ((entry[i].type == E820_TYPE_RAM) && (hpa >= entry[i].baseaddr) &&
+				((hpa + size) <= (entry[i].baseaddr + entry[i].length))) {
+				/** Set valid to true */
+				valid = true;
+				/** Terminate the loop */
+				break;
+			}
+		}
+	}
+
+	/** Set 'valid' to false if [hpa, hpa + size) overlaps memory reserved for other uses */
+	valid = valid && !is_host_region_reserved(hpa, size, HOST_REGION_SNAPSHOT, vm_id);
+
+	/** Return 'valid' */
+	return valid;
+}
+
+/**
+ * @brief Check whether the EPT dirty flags of a VM track all the writes to its guest RAM.
+ *
+ * The flags are only set by the guest, so they miss the DMA writes of the pass-through devices assigned to the VM.
+ *
+ * @param[in] vm Pointer to the VM.
+ *
+ * @return Whether EPT accessed and dirty flags are enabled for the VM and no device is assigned to its IOMMU domain.
+ *
+ * @pre vm != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal function called by request_vm_snapshot and restore_vm_snapshot.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+static bool is_dirty_tracking_complete(const struct acrn_vm *vm)
+{
+	/** Return true if vm->arch_vm.ept_ad is true and vm->iommu is NULL or has no device assigned */
+	return vm->arch_vm.ept_ad && ((vm->iommu == NULL) || (vm->iommu->dev_count == 0U));
+}
+
+/**
+ * @brief Read handler of SNAPSHOT_PIO_PORT
+ *
+ * It returns how many times the VM has been restored from its golden snapshot.
+ *
+ * @param[inout] vcpu Pointer to the vCPU reading the port.
+ * @param[in] port The port being read.
+ * @param[in] size Size of the access in bytes.
+ *
+ * @return None
+ *
+ * @pre vcpu != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is registered by init_vm_snapshot.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+static void snapshot_io_read(struct acrn_vcpu *vcpu, __unused uint16_t port, __unused size_t size)
+{
+	/** Set vcpu->req.reqs.pio.value to the restore count of the VM */
+	vcpu->req.reqs.pio.value = (uint32_t)vm_snapshots[vcpu->vm->vm_id].restore_count;
+}
+
+/**
+ * @brief Request all the vCPUs of a VM to save their state into its snapshot.
+ *
+ * The snapshot is requested only if all the vCPUs of the VM are running and no snapshot is being saved. A checkpoint
+ * may refresh a complete snapshot, in which case only the pages dirty since then are copied if EPT accessed and
+ * dirty flags are enabled for the VM. Otherwise the snapshot is requested only if none is taken yet.
+ *
+ * @param[inout] vm Pointer to the VM.
+ * @param[in] checkpoint Whether the request is a checkpoint, which may refresh a complete snapshot.
+ *
+ * @return A status code indicating whether the snapshot is requested.
+ *
+ * @retval 0 The snapshot is requested.
+ * @retval -EBUSY Not all the vCPUs of the VM are running, or the snapshot cannot be taken in its current state.
+ *
+ * @pre vm != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal function called by snapshot_io_write and take_vm_checkpoint.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+static int32_t request_vm_snapshot(struct acrn_vm *vm, bool checkpoint)
+{
+	/** Declare the following local variables of type 'struct vm_snapshot *'.
+	 *  - snap representing the snapshot of the VM, initialized as &vm_snapshots[vm->vm_id].
+	 */
+	struct vm_snapshot *snap = &vm_snapshots[vm->vm_id];
+	/** Declare the following local variables of type 'struct acrn_vcpu *'.
+	 *  - tmp representing a vCPU of the VM, not initialized.
+	 */
+	struct acrn_vcpu *tmp;
+	/** Declare the following local variables of type uint16_t.
+	 *  - i representing the loop counter over the vCPUs of the VM, not initialized.
+	 */
+	uint16_t i;
+	/** Declare the following local variables of type uint64_t.
+	 *  - vcpu_num representing the number of vCPUs of the VM, initialized as 0.
+	 */
+	uint64_t vcpu_num = 0UL;
+	/** Declare the following local variables of type bool.
+	 *  - all_running representing whether all the vCPUs of the VM are running, initialized as true.
+	 */
+	bool all_running = true;
+	/** Declare the following local variables of type int32_t.
+	 *  - ret representing the status to be returned, initialized as -EBUSY.
+	 */
+	int32_t ret = -EBUSY;
+
+	/** Call spinlock_obtain with the following parameter, in order to serialize the request with the VM state
+	 *  transitions.
+	 *  - &vm->vm_lock
+	 */
+	spinlock_obtain(&vm->vm_lock);
+
+	/** If no snapshot is taken, or the request is a checkpoint and the snapshot is complete */
+	if ((snap->state == SNAPSHOT_NONE) || (checkpoint && (snap->state == SNAPSHOT_READY))) {
+		/** For each tmp in the vCPUs of the VM, using i as the loop counter */
+		foreach_vcpu(i, vm, tmp) {
+			/** Set all_running to false if tmp is not running */
+			all_running = all_running && (tmp->state == VCPU_RUNNING);
+			/** Increment vcpu_num by 1 */
+			vcpu_num++;
+		}
+
+		/** If all the vCPUs are running */
+		if (all_running) {
+			/** Set snap->start_tsc to the return value of rdtsc() */
+			snap->start_tsc = rdtsc();
+			/** Set snap->vcpu_num to vcpu_num */
+			snap->vcpu_num = vcpu_num;
+			/** Set snap->arrived_vcpus, snap->next_chunk, snap->done_chunks and snap->copied_bytes to 0 */
+			snap->arrived_vcpus = 0UL;
+			snap->next_chunk = 0UL;
+			snap->done_chunks = 0UL;
+			snap->copied_bytes = 0UL;
+			/** Set snap->incremental to whether the snapshot is complete and all the pages dirty since then
+			 *  are tracked by EPT dirty flags */
+			snap->incremental = (snap->state == SNAPSHOT_READY) && is_dirty_tracking_complete(vm);
+			/** If the snapshot is incremental */
+			if (snap->incremental) {
+				/** Set snap->chunk_num to snap->dirty_chunk_num */
+				snap->chunk_num = snap->dirty_chunk_num;
+			} else {
+				/** Set snap->chunk_num to the number of SNAPSHOT_CHUNK_SIZE sized chunks in the guest
+				 *  RAM */
+				snap->chunk_num = (get_vm_config(vm->vm_id)->memory.size + SNAPSHOT_CHUNK_SIZE - 1UL) /
+					SNAPSHOT_CHUNK_SIZE;
+			}
+			/** Set snap->prev_state to snap->state */
+			snap->prev_state = snap->state;
+			/** Set snap->state to SNAPSHOT_SAVING */
+			snap->state = SNAPSHOT_SAVING;
+
+			/** For each tmp in the vCPUs of the VM, using i as the loop counter */
+			foreach_vcpu(i, vm, tmp) {
+				/** Call vcpu_make_request with the following parameters, in order to have tmp save
+				 *  its state before it enters the guest again.
+				 *  - tmp
+				 *  - ACRN_REQUEST_SNAPSHOT_SAVE
+				 */
+				vcpu_make_request(tmp, ACRN_REQUEST_SNAPSHOT_SAVE);
+			}
+			/** Set ret to 0 */
+			ret = 0;
+		}
+	}
+
+	/** Call spinlock_release with the following parameter, in order to release the lock.
+	 *  - &vm->vm_lock
+	 */
+	spinlock_release(&vm->vm_lock);
+
+	/** Return 'ret' */
+	return ret;
+}
+
+/**
+ * @brief Write handler of SNAPSHOT_PIO_PORT
+ *
+ * It starts taking the golden snapshot of the VM if none is taken yet and all the vCPUs of the VM are running, by
+ * requesting every vCPU to save its state in save_vcpu_snapshot. The value written is ignored.
+ *
+ * @param[inout] vcpu Pointer to the vCPU writing the port.
+ * @param[in] port The port being written.
+ * @param[in] size Size of the access in bytes.
+ * @param[in] val The value written.
+ *
+ * @return None
+ *
+ * @pre vcpu != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is registered by init_vm_snapshot.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+static void snapshot_io_write(struct acrn_vcpu *vcpu, __unused uint16_t port, __unused size_t size,
+	__unused uint32_t val)
+{
+	/** If the golden snapshot is not taken yet and the return value of request_vm_snapshot(vcpu->vm, false)
+	 *  is not 0 */
+	if ((vm_snapshots[vcpu->vm->vm_id].state == SNAPSHOT_NONE) && (request_vm_snapshot(vcpu->vm, false) != 0)) {
+		/** Logging the following information with a log level of LOG_ERROR.
+		 *  - vcpu->vm->vm_id
+		 */
+		pr_err("VM %hu: golden snapshot requested before all vCPUs run", vcpu->vm->vm_id);
+	}
+}
+
+/**
+ * @brief Take a checkpoint of the given VM.
+ *
+ * The checkpoint replaces the snapshot of the VM, which the VM is restored from the next time it is restarted. All
+ * the vCPUs of the VM save their state and copy the guest RAM together before any of them goes back to the guest, so
+ * that the VM pauses as long as the copy takes. If EPT accessed and dirty flags are enabled for the VM and a snapshot
+ * is complete, only the pages dirty since then are copied. The number of pages copied and the pause time are logged.
+ *
+ * @param[inout] vm Pointer to the VM.
+ *
+ * @return A status code indicating whether the checkpoint is started.
+ *
+ * @retval 0 The checkpoint is started.
+ * @retval -EINVAL The VM configuration reserves no valid memory for the snapshot.
+ * @retval -EBUSY Not all the vCPUs of the VM are running, or a snapshot is being saved.
+ *
+ * @pre vm != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark The checkpoint completes asynchronously, before the vCPUs of the VM enter the guest again.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+int32_t take_vm_checkpoint(struct acrn_vm *vm)
+{
+	/** Declare the following local variables of type int32_t.
+	 *  - ret representing the status to be returned, initialized as -EINVAL.
+	 */
+	int32_t ret = -EINVAL;
+
+	/** If the snapshot of the VM is enabled */
+	if (vm_snapshots[vm->vm_id].enabled) {
+		/** Set ret to the return value of request_vm_snapshot(vm, true) */
+		ret = request_vm_snapshot(vm, true);
+	}
+
+	/** Return 'ret' */
+	return ret;
+}
+
+/**
+ * @brief Initialize the golden snapshot of the given VM
+ *
+ * If the VM configuration reserves valid memory for a golden snapshot, the snapshot is enabled and SNAPSHOT_PIO_PORT
+ * is registered for the guest to request it.
+ *
+ * @param[inout] vm Pointer to the VM.
+ *
+ * @return None
+ *
+ * @pre vm != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_ROOT
+ *
+ * @remark It is called by create_vm.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vm is different among parallel invocation
+ */
+void init_vm_snapshot(struct acrn_vm *vm)
+{
+	/** Declare the following local variables of type 'const struct acrn_vm_config *'.
+	 *  - vm_config representing the configuration data of the VM, initialized as get_vm_config(vm->vm_id).
+	 */
+	const struct acrn_vm_config *vm_config = get_vm_config(vm->vm_id);
+	/** Declare the following local variables of type 'struct vm_snapshot *'.
+	 *  - snap representing the golden snapshot of the VM, initialized as &vm_snapshots[vm->vm_id].
+	 */
+	struct vm_snapshot *snap = &vm_snapshots[vm->vm_id];
+	/** Declare the following local variables of type 'struct vm_io_range'.
+	 *  - range representing the port I/O range of SNAPSHOT_PIO_PORT. */
+	struct vm_io_range range = { .base = SNAPSHOT_PIO_PORT, .len = 4U };
+	/** Declare the following local variables of type uint64_t.
+	 *  - ram_end representing the end of the guest RAM in the guest physical address space, initialized as 0.
+	 */
+	uint64_t ram_end = 0UL;
+	/** Declare the following local variables of type uint32_t.
+	 *  - i representing the index of the e820 entry of the VM being checked, not initialized.
+	 */
+	uint32_t i;
+
+	/** Set snap->state to SNAPSHOT_NONE, snap->restore_count to 0 and snap->committed to 0 */
+	snap->state = SNAPSHOT_NONE;
+	snap->restore_count = 0UL;
+	snap->committed = 0U;
+	/** For each i ranging from 0 to vm->e820_entry_num - 1 [with a step of 1] */
+	for (i = 0U; i < vm->e820_entry_num; i++) {
+		/** If vm->e820_entries[i] is a RAM entry ending above ram_end */
+		if ((vm->e820_entries[i].type == E820_TYPE_RAM) &&
+			((vm->e820_entries[i].baseaddr + vm->e820_entries[i].length) > ram_end)) {
+			/** Set ram_end to the end of vm->e820_entries[i] */
+			ram_end = vm->e820_entries[i].baseaddr + vm->e820_entries[i].length;
+		}
+	}
+	/** Set snap->dirty_chunk_num to the number of SNAPSHOT_CHUNK_SIZE sized chunks in [0, ram_end) */
+	snap->dirty_chunk_num = (ram_end + SNAPSHOT_CHUNK_SIZE - 1UL) / SNAPSHOT_CHUNK_SIZE;
+	/** Set snap->enabled to whether the VM configuration reserves valid memory for the snapshot */
+	snap->enabled = (vm_config->memory.snapshot_hpa != 0UL) && is_snapshot_region_valid(vm->vm_id, vm_config);
+
+	/** If the snapshot is enabled */
+	if (snap->enabled) {
+		/** Call register_pio_emulation_handler with the following parameters, in order to let the guest
+		 *  request its golden snapshot.
+		 *  - vm
+		 *  - SNAPSHOT_PIO_IDX
+		 *  - &range
+		 *  - snapshot_io_read
+		 *  - snapshot_io_write
+		 */
+		register_pio_emulation_handler(vm, SNAPSHOT_PIO_IDX, &range, snapshot_io_read, snapshot_io_write);
+	} else if (vm_config->memory.snapshot_hpa != 0UL) {
+		/** Logging the following information with a log level of LOG_ERROR.
+		 *  - vm->vm_id
+		 *  - vm_config->memory.snapshot_hpa
+		 */
+		pr_err("VM %hu: invalid golden snapshot memory at 0x%lx", vm->vm_id, vm_config->memory.snapshot_hpa);
+	} else {
+		/* No golden snapshot for this VM */
+	}
+}
+
+/**
+ * @brief Save the state of the current vCPU.
+ *
+ * Registers that are only held in the VMCS or in the physical CPU while the guest runs are read from there, so it
+ * shall be called on the physical CPU of the vCPU.
+ *
+ * @param[inout] vcpu Pointer to the current vCPU.
+ * @param[out] vs Pointer to the snapshot of the vCPU.
+ *
+ * @return None
+ *
+ * @pre vcpu != NULL
+ * @pre vs != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal function called by save_vcpu_snapshot.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vcpu is different among parallel invocation
+ */
+static void save_vcpu_regs(struct acrn_vcpu *vcpu, struct vcpu_snapshot *vs)
+{
+	/** Declare the following local variables of type 'struct ext_context *'.
+	 *  - ectx representing the saved extended context, initialized as &vs->ext_ctx.
+	 */
+	struct ext_context *ectx = &vs->ext_ctx;
+	/** Declare the following local variables of type uint32_t.
+	 *  - i representing the index of the local APIC register being saved, not initialized.
+	 */
+	uint32_t i;
+
+	/** Copy the run context of the vCPU, which holds the general purpose registers and CR2, to vs->run_ctx */
+	(void)memcpy_s(&vs->run_ctx, sizeof(struct run_context), &vcpu->arch.context.run_ctx,
+		sizeof(struct run_context));
+	/** Set the RIP, RFLAGS, CR0, CR4 and IA32_EFER in vs->run_ctx to the current values of the vCPU, the RIP
+	 *  skipping the instruction that caused the VM exit if it is to be skipped */
+	vs->run_ctx.rip = vcpu_get_rip(vcpu) + vcpu->arch.inst_len;
+	vs->run_ctx.rflags = vcpu_get_rflags(vcpu);
+	vs->run_ctx.cr0 = vcpu_get_cr0(vcpu);
+	vs->run_ctx.cr4 = vcpu_get_cr4(vcpu);
+	vs->run_ctx.ia32_efer = vcpu_get_efer(vcpu);
+	/** Set vs->cpu_mode to vcpu->arch.cpu_mode */
+	vs->cpu_mode = vcpu->arch.cpu_mode;
+
+	/** Set ectx->cr3, the segment registers and the descriptor table registers to their guest values in the
+	 *  VMCS */
+	ectx->cr3 = exec_vmread(VMX_GUEST_CR3);
+	save_segment(ectx->cs, VMX_GUEST_CS);
+	save_segment(ectx->ss, VMX_GUEST_SS);
+	save_segment(ectx->ds, VMX_GUEST_DS);
+	save_segment(ectx->es, VMX_GUEST_ES);
+	save_segment(ectx->fs, VMX_GUEST_FS);
+	save_segment(ectx->gs, VMX_GUEST_GS);
+	save_segment(ectx->tr, VMX_GUEST_TR);
+	save_segment(ectx->ldtr, VMX_GUEST_LDTR);
+	ectx->gdtr.base = exec_vmread(VMX_GUEST_GDTR_BASE);
+	ectx->gdtr.limit = exec_vmread32(VMX_GUEST_GDTR_LIMIT);
+	ectx->idtr.base = exec_vmread(VMX_GUEST_IDTR_BASE);
+	ectx->idtr.limit = exec_vmread32(VMX_GUEST_IDTR_LIMIT);
+
+	/** Set the syscall MSRs in ectx to the values in the physical CPU, which the guest owns while it runs */
+	ectx->ia32_star = msr_read(MSR_IA32_STAR);
+	ectx->ia32_lstar = msr_read(MSR_IA32_LSTAR);
+	ectx->ia32_fmask = msr_read(MSR_IA32_FMASK);
+	ectx->ia32_kernel_gs_base = msr_read(MSR_IA32_KERNEL_GS_BASE);
+	/** Call save_xsave_area with the following parameters, in order to save the guest XSAVE state components.
+	 *  - ectx
+	 */
+	save_xsave_area(ectx);
+	/** Call write_xcr with the following parameters, in order to restore the guest XCR0 changed by
+	 *  save_xsave_area.
+	 *  - 0
+	 *  - ectx->xcr0
+	 */
+	write_xcr(0, ectx->xcr0);
+
+	/** Copy vcpu->arch.guest_msrs to vs->guest_msrs */
+	(void)memcpy_s(vs->guest_msrs, sizeof(vs->guest_msrs), vcpu->arch.guest_msrs, sizeof(vcpu->arch.guest_msrs));
+	/** Set the guest state fields in vs that are not emulated to their values in the VMCS */
+	vs->dr7 = exec_vmread(VMX_GUEST_DR7);
+	vs->sysenter_cs = exec_vmread32(VMX_GUEST_IA32_SYSENTER_CS);
+	vs->sysenter_esp = exec_vmread(VMX_GUEST_IA32_SYSENTER_ESP);
+	vs->sysenter_eip = exec_vmread(VMX_GUEST_IA32_SYSENTER_EIP);
+	vs->interruptibility = exec_vmread32(VMX_GUEST_INTERRUPTIBILITY_INFO);
+	vs->activity_state = exec_vmread32(VMX_GUEST_ACTIVITY_STATE);
+
+	/** Set vs->tsc_deadline to the return value of vlapic_get_tsc_deadline_msr(vcpu_vlapic(vcpu)) */
+	vs->tsc_deadline = vlapic_get_tsc_deadline_msr(vcpu_vlapic(vcpu));
+	/** For each i ranging from 0 to SNAPSHOT_LAPIC_REG_NUM - 1 [with a step of 1] */
+	for (i = 0U; i < SNAPSHOT_LAPIC_REG_NUM; i++) {
+		/** Set vs->lapic_regs[i] to the value of the passed-through local APIC register */
+		vs->lapic_regs[i] = msr_read(snapshot_lapic_msrs[i]);
+	}
+}
+
+/**
+ * @brief Look up the EPT entries mapping a chunk of the guest physical address space.
+ *
+ * @param[in] vm Pointer to the VM.
+ * @param[in] gpa The guest physical address of the chunk, aligned to SNAPSHOT_CHUNK_SIZE.
+ * @param[out] pg_size Pointer to the size of the pages the entries map.
+ *
+ * @return A pointer to the leaf entry mapping the chunk if it is mapped with a page not smaller than
+ * SNAPSHOT_CHUNK_SIZE, a pointer to the first of the PTEs mapping the chunk if it is mapped with 4-KByte pages, or
+ * NULL if the chunk is not mapped at all.
+ *
+ * @pre vm != NULL
+ * @pre pg_size != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal function called by sync_dirty_chunk.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+static uint64_t *lookup_chunk_entry(struct acrn_vm *vm, uint64_t gpa, uint64_t *pg_size)
+{
+	/** Declare the following local variables of type 'const struct memory_ops *'.
+	 *  - mem_ops representing the operations for the EPT, initialized as &vm->arch_vm.ept_mem_ops.
+	 */
+	const struct memory_ops *mem_ops = &vm->arch_vm.ept_mem_ops;
+	/** Declare the following local variables of type 'uint64_t *'.
+	 *  - pml4e representing the PML4E associated with gpa, initialized as
+	 *  pml4e_offset((uint64_t *)vm->arch_vm.nworld_eptp, gpa).
+	 *  - entry representing the entry to be returned, initialized as NULL.
+	 *  - pdpte representing the PDPTE associated with gpa, not initialized.
+	 *  - pde representing the PDE associated with gpa, not initialized.
+	 */
+	uint64_t *pml4e = pml4e_offset((uint64_t *)vm->arch_vm.nworld_eptp, gpa);
+	uint64_t *entry = NULL;
+	uint64_t *pdpte, *pde;
+
+	/** If the PML4E is present */
+	if (mem_ops->pgentry_present(*pml4e) != 0UL) {
+		/** Set pdpte to the return value of pdpte_offset(pml4e, gpa) */
+		pdpte = pdpte_offset(pml4e, gpa);
+		/** If the PDPTE is present and maps a 1-GByte page */
+		if ((mem_ops->pgentry_present(*pdpte) != 0UL) && (pdpte_large(*pdpte) != 0UL)) {
+			/** Set *pg_size to PDPTE_SIZE and entry to pdpte */
+			*pg_size = PDPTE_SIZE;
+			entry = pdpte;
+		/** If the PDPTE is present and references a page directory */
+		} else if (mem_ops->pgentry_present(*pdpte) != 0UL) {
+			/** Set pde to the return value of pde_offset(pdpte, gpa) */
+			pde = pde_offset(pdpte, gpa);
+			/** If the PDE is present and maps a 2-MByte page */
+			if ((mem_ops->pgentry_present(*pde) != 0UL) && (pde_large(*pde) != 0UL)) {
+				/** Set *pg_size to PDE_SIZE and entry to pde */
+				*pg_size = PDE_SIZE;
+				entry = pde;
+			/** If the PDE is present and references a page table */
+			} else if (mem_ops->pgentry_present(*pde) != 0UL) {
+				/** Set *pg_size to PTE_SIZE and entry to the return value of pte_offset(pde, gpa) */
+				*pg_size = PTE_SIZE;
+				entry = pte_offset(pde, gpa);
+			} else {
+				/* The chunk is not mapped */
+			}
+		} else {
+			/* The chunk is not mapped */
+		}
+	}
+
+	/** Return 'entry' */
+	return entry;
+}
+
+/**
+ * @brief Copy part of a dirty guest page between the guest RAM and the snapshot.
+ *
+ * Nothing is copied if the page is clean or not part of the guest RAM, e.g. a pass-through MMIO page.
+ *
+ * @param[in] vm_config Pointer to the configuration data of the VM.
+ * @param[in] pge The leaf EPT entry mapping the page.
+ * @param[in] pg_size The size of the page.
+ * @param[in] offset The offset of the part to be copied in the page.
+ * @param[in] len The size of the part to be copied.
+ * @param[in] restore Whether to copy from the snapshot to the guest RAM instead of the other way round.
+ *
+ * @return The number of bytes copied.
+ *
+ * @pre vm_config != NULL
+ * @pre offset + len <= pg_size
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal function called by sync_dirty_chunk.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+static uint64_t sync_dirty_page(const struct acrn_vm_config *vm_config, uint64_t pge, uint64_t pg_size,
+	uint64_t offset, uint64_t len, bool restore)
+{
+	/** Declare the following local variables of type uint64_t.
+	 *  - hpa representing the host physical address of the part to be copied, initialized as the address the page
+	 *  is mapped to plus offset.
+	 *  - ram_offset representing the offset of the part in the guest RAM, initialized as
+	 *  hpa - vm_config->memory.start_hpa.
+	 *  - copied representing the number of bytes copied, initialized as 0.
+	 */
+	uint64_t hpa = ((pge & ~EPT_PFN_HIGH_MASK) & ~(pg_size - 1UL)) + offset;
+	uint64_t ram_offset = hpa - vm_config->memory.start_hpa;
+	uint64_t copied = 0UL;
+
+	/** If the page is dirty and the part lies in the guest RAM */
+	if (((pge & SNAPSHOT_DIRTY_MASK) != 0UL) && (hpa >= vm_config->memory.start_hpa) &&
+		((ram_offset + len) <= vm_config->memory.size)) {
+		/** If the part is to be restored */
+		if (restore) {
+			/** Call bulk_copy in order to copy the part from the reserved memory to the guest RAM */
+			bulk_copy(hpa2hva(hpa), hpa2hva(vm_config->memory.snapshot_hpa + ram_offset), len);
+		} else {
+			/** Call bulk_copy in order to copy the part from the guest RAM to the reserved memory */
+			bulk_copy(hpa2hva(vm_config->memory.snapshot_hpa + ram_offset), hpa2hva(hpa), len);
+		}
+		/** Set copied to len */
+		copied = len;
+	}
+
+	/** Return 'copied' */
+	return copied;
+}
+
+/**
+ * @brief Copy the dirty pages in a chunk of the guest physical address space between the guest RAM and the snapshot.
+ *
+ * The dirty state of the pages is left as is, as a page larger than the chunk is shared with other chunks.
+ *
+ * @param[in] vm Pointer to the VM.
+ * @param[in] chunk The index of the chunk.
+ * @param[in] restore Whether to copy from the snapshot to the guest RAM instead of the other way round.
+ *
+ * @return The number of bytes copied.
+ *
+ * @pre vm != NULL
+ * @pre None of the vCPUs of the VM runs in the guest.
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal function called by copy_snapshot_chunks and restore_vm_snapshot.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a chunk is different among parallel invocation
+ */
+static uint64_t sync_dirty_chunk(struct acrn_vm *vm, uint64_t chunk, bool restore)
+{
+	/** Declare the following local variables of type 'const struct acrn_vm_config *'.
+	 *  - vm_config representing the configuration data of the VM, initialized as get_vm_config(vm->vm_id).
+	 */
+	const struct acrn_vm_config *vm_config = get_vm_config(vm->vm_id);
+	/** Declare the following local variables of type uint64_t.
+	 *  - gpa representing the guest physical address of the chunk, initialized as chunk * SNAPSHOT_CHUNK_SIZE.
+	 *  - pg_size representing the size of the pages mapping the chunk, initialized as 0.
+	 *  - copied representing the number of bytes copied, initialized as 0.
+	 *  - i representing the index of the PTE being checked, not initialized.
+	 */
+	uint64_t gpa = chunk * SNAPSHOT_CHUNK_SIZE;
+	uint64_t pg_size = 0UL;
+	uint64_t copied = 0UL;
+	uint64_t i;
+	/** Declare the following local variables of type 'const uint64_t *'.
+	 *  - entry representing the EPT entries mapping the chunk, initialized as the return value of
+	 *  lookup_chunk_entry(vm, gpa, &pg_size).
+	 */
+	const uint64_t *entry = lookup_chunk_entry(vm, gpa, &pg_size);
+
+	/** If the chunk is mapped with 4-KByte pages */
+	if (pg_size == PTE_SIZE) {
+		/** For each i ranging from 0 to PTRS_PER_PTE - 1 [with a step of 1] */
+		for (i = 0UL; i < PTRS_PER_PTE; i++) {
+			/** If entry[i] is present */
+			if (vm->arch_vm.ept_mem_ops.pgentry_present(entry[i]) != 0UL) {
+				/** Increment copied by the return value of sync_dirty_page(vm_config, entry[i],
+				 *  PTE_SIZE, 0, PTE_SIZE, restore) */
+				copied += sync_dirty_page(vm_config, entry[i], PTE_SIZE, 0UL, PTE_SIZE, restore);
+			}
+		}
+	/** If the chunk is mapped with a larger page */
+	} else if (entry != NULL) {
+		/** Set copied to the return value of sync_dirty_page(vm_config, *entry, pg_size,
+		 *  gpa & (pg_size - 1), SNAPSHOT_CHUNK_SIZE, restore) */
+		copied = sync_dirty_page(vm_config, *entry, pg_size, gpa & (pg_size - 1UL), SNAPSHOT_CHUNK_SIZE,
+			restore);
+	} else {
+		/* The chunk is not mapped */
+	}
+
+	/** Return 'copied' */
+	return copied;
+}
+
+/**
+ * @brief Copy chunks of the guest RAM to the snapshot until none is left.
+ *
+ * If the snapshot is incremental, the chunks are those of the guest physical address space and only their dirty pages
+ * are copied. The vCPU copying the last chunk marks all the pages of the VM as clean if EPT accessed and dirty flags
+ * are enabled for it, commits the vCPU states just saved and then completes the snapshot.
+ *
+ * @param[inout] snap Pointer to the snapshot being taken.
+ * @param[in] vm Pointer to the VM.
+ *
+ * @return None
+ *
+ * @pre snap != NULL
+ * @pre vm != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal function called by save_vcpu_snapshot and restore_vm_snapshot.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+static void copy_snapshot_chunks(struct vm_snapshot *snap, struct acrn_vm *vm)
+{
+	/** Declare the following local variables of type 'const struct acrn_vm_config *'.
+	 *  - vm_config representing the configuration data of the VM, initialized as get_vm_config(vm->vm_id).
+	 */
+	const struct acrn_vm_config *vm_config = get_vm_config(vm->vm_id);
+	/** Declare the following local variables of type uint64_t.
+	 *  - chunk representing the index of the chunk taken by the current vCPU, initialized as the return value of
+	 *  atomic_xadd64(&snap->next_chunk, 1).
+	 *  - offset representing the offset of the chunk in the guest RAM, not initialized.
+	 *  - len representing the size of the chunk, not initialized.
+	 */
+	uint64_t chunk = atomic_xadd64(&snap->next_chunk, 1UL);
+	uint64_t offset, len;
+
+	/** Until chunk is not less than snap->chunk_num */
+	while (chunk < snap->chunk_num) {
+		/** If the snapshot is incremental */
+		if (snap->incremental) {
+			/** Set len to the return value of sync_dirty_chunk(vm, chunk, false) */
+			len = sync_dirty_chunk(vm, chunk, false);
+		} else {
+			/** Set offset to chunk * SNAPSHOT_CHUNK_SIZE */
+			offset = chunk * SNAPSHOT_CHUNK_SIZE;
+			/** Set len to the smaller value between SNAPSHOT_CHUNK_SIZE and vm_config->memory.size - offset */
+			len = ((vm_config->memory.size - offset) > SNAPSHOT_CHUNK_SIZE) ? SNAPSHOT_CHUNK_SIZE :
+				(vm_config->memory.size - offset);
+			/** Call bulk_copy in order to copy the chunk from the guest RAM to the reserved memory */
+			bulk_copy(hpa2hva(vm_config->memory.snapshot_hpa + offset),
+				hpa2hva(vm_config->memory.start_hpa + offset), len);
+		}
+		/** Call atomic_xadd64 with the following parameters, in order to account the bytes copied.
+		 *  - &snap->copied_bytes
+		 *  - len
+		 */
+		(void)atomic_xadd64(&snap->copied_bytes, len);
+		/** If the chunk is the last one copied */
+		if (atomic_xadd64(&snap->done_chunks, 1UL) == (snap->chunk_num - 1UL)) {
+			/** If EPT accessed and dirty flags are enabled for the VM */
+			if (vm->arch_vm.ept_ad) {
+				/** Call ept_clear_dirty with the following parameters, in order to track the pages
+				 *  written from now on, the vCPUs flushing their cached EPT translations before they enter
+				 *  the guest again.
+				 *  - vm
+				 */
+				ept_clear_dirty(vm);
+			}
+			/** Set snap->committed to the index of the set of vCPU states just saved */
+			snap->committed ^= 1U;
+			/** Call cpu_write_memory_barrier in order to commit the vCPU states before the snapshot is
+			 *  complete. */
+			cpu_write_memory_barrier();
+			/** Set snap->state to SNAPSHOT_READY */
+			snap->state = SNAPSHOT_READY;
+			/** Logging the following information with a log level of LOG_ACRN.
+			 *  - vm->vm_id
+			 *  - whether the snapshot is incremental
+			 *  - the number of pages copied
+			 *  - the time elapsed since the snapshot was requested in microseconds
+			 */
+			pr_acrnlog("VM %hu: %s snapshot of %lu pages taken in %lu us", vm->vm_id,
+				snap->incremental ? "incremental" : "full", snap->copied_bytes / PAGE_SIZE,
+				((rdtsc() - snap->start_tsc) * 1000UL) / (uint64_t)get_tsc_khz());
+		}
+		/** Set chunk to the return value of atomic_xadd64(&snap->next_chunk, 1) */
+		chunk = atomic_xadd64(&snap->next_chunk, 1UL);
+	}
+}
+
+/**
+ * @brief Save the current vCPU into the snapshot of its VM.
+ *
+ * It saves the state of the vCPU, waits for all the vCPUs of the VM to save theirs, then copies chunks of the guest
+ * RAM along with them and returns once the snapshot is complete. It stops waiting if the vCPU is paused, in
+ * which case the snapshot is left incomplete and completed or dropped by restore_vm_snapshot when the VM is restarted.
+ * The state is saved in the set of vCPU states the complete snapshot is not made of.
+ *
+ * @param[inout] vcpu Pointer to the current vCPU.
+ *
+ * @return None
+ *
+ * @pre vcpu != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is called by acrn_handle_pending_request on ACRN_REQUEST_SNAPSHOT_SAVE.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vcpu is different among parallel invocation
+ */
+void save_vcpu_snapshot(struct acrn_vcpu *vcpu)
+{
+	/** Declare the following local variables of type 'struct vm_snapshot *'.
+	 *  - snap representing the golden snapshot of the VM, initialized as &vm_snapshots[vcpu->vm->vm_id].
+	 */
+	struct vm_snapshot *snap = &vm_snapshots[vcpu->vm->vm_id];
+
+	/** Call save_vcpu_regs with the following parameters, in order to save the state of the vCPU without
+	 *  overwriting the complete snapshot.
+	 *  - vcpu
+	 *  - &snap->vcpus[snap->committed ^ 1][vcpu->vcpu_id]
+	 */
+	save_vcpu_regs(vcpu, &snap->vcpus[snap->committed ^ 1U][vcpu->vcpu_id]);
+	/** Call atomic_inc64 with the following parameters, in order to account the vCPU as arrived.
+	 *  - &snap->arrived_vcpus
+	 */
+	atomic_inc64(&snap->arrived_vcpus);
+
+	/** Until all the vCPUs of the VM arrived or the vCPU is paused */
+	while ((*(volatile uint64_t *)&snap->arrived_vcpus != snap->vcpu_num) &&
+		(*(volatile enum vcpu_state *)&vcpu->state == VCPU_RUNNING)) {
+		/** Call asm_pause in order to wait for the other vCPUs. */
+		asm_pause();
+	}
+
+	/** If the vCPU is still running */
+	if (vcpu->state == VCPU_RUNNING) {
+		/** Call copy_snapshot_chunks with the following parameters, in order to copy the guest RAM along with
+		 *  the other vCPUs.
+		 *  - snap
+		 *  - vcpu->vm
+		 */
+		copy_snapshot_chunks(snap, vcpu->vm);
+		/** Until the snapshot is complete or the vCPU is paused */
+		while ((*(volatile uint64_t *)&snap->state == SNAPSHOT_SAVING) &&
+			(*(volatile enum vcpu_state *)&vcpu->state == VCPU_RUNNING)) {
+			/** Call asm_pause in order to wait for the chunks taken by the other vCPUs. */
+			asm_pause();
+		}
+	}
+}
+
+/**
+ * @brief Load the saved state of a vCPU into its context structures.
+ *
+ * @param[inout] vcpu Pointer to the vCPU.
+ * @param[in] vs Pointer to the snapshot of the vCPU.
+ *
+ * @return None
+ *
+ * @pre vcpu != NULL
+ * @pre vs != NULL
+ * @pre vcpu->state == VCPU_INIT
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal function called by restore_vm_snapshot.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vcpu is different among parallel invocation
+ */
+static void load_vcpu_regs(struct acrn_vcpu *vcpu, const struct vcpu_snapshot *vs)
+{
+	/** Copy vs->run_ctx, vs->ext_ctx and vs->guest_msrs to the corresponding structures of the vCPU */
+	(void)memcpy_s(&vcpu->arch.context.run_ctx, sizeof(struct run_context), &vs->run_ctx,
+		sizeof(struct run_context));
+	(void)memcpy_s(&vcpu->arch.context.ext_ctx, sizeof(struct ext_context), &vs->ext_ctx,
+		sizeof(struct ext_context));
+	(void)memcpy_s(vcpu->arch.guest_msrs, sizeof(vcpu->arch.guest_msrs), vs->guest_msrs, sizeof(vs->guest_msrs));
+	/** Set vcpu->arch.cpu_mode to vs->cpu_mode */
+	vcpu->arch.cpu_mode = vs->cpu_mode;
+
+	/** Call vcpu_set_rip, vcpu_set_rsp, vcpu_set_efer and vcpu_set_rflags in order to have the corresponding VMCS
+	 *  fields written before the vCPU enters the guest. CR0, CR3, CR4 and the segment registers are written when
+	 *  the VMCS is initialized. */
+	vcpu_set_rip(vcpu, vs->run_ctx.rip);
+	vcpu_set_rsp(vcpu, vs->run_ctx.cpu_regs.regs.rsp);
+	vcpu_set_efer(vcpu, vs->run_ctx.ia32_efer);
+	vcpu_set_rflags(vcpu, vs->run_ctx.rflags);
+}
+
+/**
+ * @brief Load the guest state of the current vCPU that lives in its VMCS and local APIC from the golden snapshot.
+ *
+ * @param[inout] vcpu Pointer to the current vCPU.
+ *
+ * @return None
+ *
+ * @pre vcpu != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is called by acrn_handle_pending_request on ACRN_REQUEST_SNAPSHOT_LOAD, after the VMCS and the local
+ * APIC of the vCPU are initialized.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vcpu is different among parallel invocation
+ */
+void load_vcpu_snapshot(struct acrn_vcpu *vcpu)
+{
+	/** Declare the following local variables of type 'const struct vcpu_snapshot *'.
+	 *  - vs representing the snapshot of the vCPU, initialized as
+	 *  &vm_snapshots[vcpu->vm->vm_id].vcpus[vm_snapshots[vcpu->vm->vm_id].committed][vcpu->vcpu_id].
+	 */
+	const struct vcpu_snapshot *vs =
+		&vm_snapshots[vcpu->vm->vm_id].vcpus[vm_snapshots[vcpu->vm->vm_id].committed][vcpu->vcpu_id];
+	/** Declare the following local variables of type uint32_t.
+	 *  - i representing the index of the local APIC register being loaded, not initialized.
+	 */
+	uint32_t i;
+
+	/** If the vCPU was in IA-32e mode */
+	if ((vs->run_ctx.ia32_efer & MSR_IA32_EFER_LMA_BIT) != 0UL) {
+		/** Call exec_vmwrite32 in order to set the IA-32e mode guest VM-entry control */
+		exec_vmwrite32(VMX_ENTRY_CONTROLS, exec_vmread32(VMX_ENTRY_CONTROLS) | VMX_ENTRY_CTLS_IA32E_MODE);
+	}
+	/** Write the guest PAT, DR7, SYSENTER MSRs, interruptibility state and activity state to the VMCS */
+	exec_vmwrite64(VMX_GUEST_IA32_PAT_FULL, vcpu_get_guest_msr(vcpu, MSR_IA32_PAT));
+	exec_vmwrite(VMX_GUEST_DR7, vs->dr7);
+	exec_vmwrite32(VMX_GUEST_IA32_SYSENTER_CS, vs->sysenter_cs);
+	exec_vmwrite(VMX_GUEST_IA32_SYSENTER_ESP, vs->sysenter_esp);
+	exec_vmwrite(VMX_GUEST_IA32_SYSENTER_EIP, vs->sysenter_eip);
+	exec_vmwrite32(VMX_GUEST_INTERRUPTIBILITY_INFO, vs->interruptibility);
+	exec_vmwrite32(VMX_GUEST_ACTIVITY_STATE, vs->activity_state);
+
+	/** For each i ranging from 0 to SNAPSHOT_LAPIC_REG_NUM - 1 [with a step of 1] */
+	for (i = 0U; i < SNAPSHOT_LAPIC_REG_NUM; i++) {
+		/** Write vs->lapic_regs[i] to the passed-through local APIC register */
+		msr_write(snapshot_lapic_msrs[i], vs->lapic_regs[i]);
+	}
+	/** Call vlapic_set_tsc_deadline_msr with the following parameters, in order to rearm the TSC deadline timer,
+	 *  which fires immediately if the deadline has passed.
+	 *  - vcpu_vlapic(vcpu)
+	 *  - vs->tsc_deadline
+	 */
+	vlapic_set_tsc_deadline_msr(vcpu_vlapic(vcpu), vs->tsc_deadline);
+}
+
+/**
+ * @brief Restore the given VM from its snapshot
+ *
+ * If the snapshot of the VM is complete, it copies the guest RAM back, only the pages written since the snapshot if
+ * EPT accessed and dirty flags are enabled for the VM and no device is assigned to it, loads the saved state into the
+ * vCPUs and requests each vCPU to initialize its VMCS and load the rest of its state on its own physical CPU.
+ *
+ * A snapshot left incomplete by pausing the VM is completed first if all the vCPUs saved their state, as the guest has
+ * not run since. Otherwise it is dropped and the snapshot goes back to its previous state, so that the VM is restored
+ * from the last complete snapshot, or the guest can request it again if none was taken.
+ *
+ * @param[inout] vm Pointer to the VM.
+ *
+ * @return Whether the VM is restored from its snapshot.
+ *
+ * @pre vm != NULL
+ * @pre vm->state == VM_PAUSED
+ * @pre All the vCPUs of the VM have been reset.
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is called by restart_vm, which launches all the vCPUs of the VM if it returns true.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vm is different among parallel invocation
+ */
+bool restore_vm_snapshot(struct acrn_vm *vm)
+{
+	/** Declare the following local variables of type 'const struct acrn_vm_config *'.
+	 *  - vm_config representing the configuration data of the VM, initialized as get_vm_config(vm->vm_id).
+	 */
+	const struct acrn_vm_config *vm_config = get_vm_config(vm->vm_id);
+	/** Declare the following local variables of type 'struct vm_snapshot *'.
+	 *  - snap representing the golden snapshot of the VM, initialized as &vm_snapshots[vm->vm_id].
+	 */
+	struct vm_snapshot *snap = &vm_snapshots[vm->vm_id];
+	/** Declare the following local variables of type 'struct acrn_vcpu *'.
+	 *  - vcpu representing a vCPU of the VM, not initialized.
+	 */
+	struct acrn_vcpu *vcpu;
+	/** Declare the following local variables of type uint16_t.
+	 *  - i representing the loop counter over the vCPUs of the VM, not initialized.
+	 */
+	uint16_t i;
+	/** Declare the following local variables of type uint64_t.
+	 *  - start_tsc representing the TSC value when the restore starts, initialized as rdtsc().
+	 *  - chunk representing the index of the chunk of the guest physical address space being restored, not
+	 *  initialized.
+	 */
+	uint64_t start_tsc = rdtsc();
+	uint64_t chunk;
+	/** Declare the following local variables of type bool.
+	 *  - restored representing whether the VM is restored, not initialized.
+	 */
+	bool restored;
+
+	/** If a snapshot is being saved and all the vCPUs saved their state */
+	if ((snap->state == SNAPSHOT_SAVING) && (snap->arrived_vcpus == snap->vcpu_num)) {
+		/** Call copy_snapshot_chunks with the following parameters, in order to copy the chunks no vCPU took
+		 *  before it was paused and complete the snapshot.
+		 *  - snap
+		 *  - vm
+		 */
+		copy_snapshot_chunks(snap, vm);
+	/** If a snapshot is being saved but not all the vCPUs saved their state */
+	} else if (snap->state == SNAPSHOT_SAVING) {
+		/** Set snap->state to snap->prev_state to drop the snapshot being saved, which has not touched the
+		 *  reserved memory */
+		snap->state = snap->prev_state;
+	} else {
+		/* No snapshot is being saved */
+	}
+	/** Set restored to whether the snapshot is complete */
+	restored = (snap->state == SNAPSHOT_READY);
+
+	/** If the snapshot is complete and all the pages written since then are tracked by EPT dirty flags */
+	if (restored && is_dirty_tracking_complete(vm)) {
+		/** For each chunk ranging from 0 to snap->dirty_chunk_num - 1 [with a step of 1] */
+		for (chunk = 0UL; chunk < snap->dirty_chunk_num; chunk++) {
+			/** Call sync_dirty_chunk with the following parameters, in order to copy the pages written
+			 *  since the snapshot back from the reserved memory.
+			 *  - vm
+			 *  - chunk
+			 *  - true
+			 */
+			(void)sync_dirty_chunk(vm, chunk, true);
+		}
+		/** Call ept_clear_dirty with the following parameters, in order to mark all the pages as clean again.
+		 *  - vm
+		 */
+		ept_clear_dirty(vm);
+	} else if (restored) {
+		/** Call bulk_copy in order to copy the guest RAM back from the reserved memory */
+		bulk_copy(hpa2hva(vm_config->memory.start_hpa), hpa2hva(vm_config->memory.snapshot_hpa),
+			vm_config->memory.size);
+	} else {
+		/* No complete snapshot to restore from */
+	}
+
+	/** If the snapshot is complete */
+	if (restored) {
+
+		/** For each vcpu in the vCPUs of the VM, using i as the loop counter */
+		foreach_vcpu(i, vm, vcpu) {
+			/** Call load_vcpu_regs with the following parameters, in order to load the saved state into the
+			 *  context structures of the vCPU.
+			 *  - vcpu
+			 *  - &snap->vcpus[snap->committed][i]
+			 */
+			load_vcpu_regs(vcpu, &snap->vcpus[snap->committed][i]);
+			/** Call vcpu_make_request with the following parameters, in order to have the vCPU initialize
+			 *  its VMCS from the loaded state.
+			 *  - vcpu
+			 *  - ACRN_REQUEST_INIT_VMCS
+			 */
+			vcpu_make_request(vcpu, ACRN_REQUEST_INIT_VMCS);
+			/** Call vcpu_make_request with the following parameters, in order to have the vCPU load the
+			 *  rest of its state on its own physical CPU.
+			 *  - vcpu
+			 *  - ACRN_REQUEST_SNAPSHOT_LOAD
+			 */
+			vcpu_make_request(vcpu, ACRN_REQUEST_SNAPSHOT_LOAD);
+		}
+
+		/** Increment snap->restore_count by 1 */
+		snap->restore_count++;
+		/** Logging the following information with a log level of LOG_INFO.
+		 *  - vm->vm_id
+		 *  - the time taken in microseconds
+		 */
+		pr_info("VM %hu restored from its snapshot in %lu us", vm->vm_id,
+			((rdtsc() - start_tsc) * 1000UL) / (uint64_t)get_tsc_khz());
+	}
+
+	/** Return 'restored' */
+	return restored;
+}
+
+/**
+ * @brief Lend the memory reserved for the snapshot of the given VM as scratch memory.
+ *
+ * The memory is only lent while it keeps no snapshot, so that a complete snapshot is never overwritten. No snapshot
+ * is taken until the memory is reclaimed by reclaim_vm_snapshot_memory.
+ *
+ * @param[inout] vm Pointer to the VM.
+ * @param[out] size Pointer to the size of the memory lent.
+ *
+ * @return The host virtual address of the memory lent, or NULL if the VM configuration reserves no valid memory for
+ * the snapshot, a snapshot is being saved or is complete, or the memory is already lent.
+ *
+ * @pre vm != NULL
+ * @pre size != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark N/A
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+void *lend_vm_snapshot_memory(struct acrn_vm *vm, uint64_t *size)
+{
+	/** Declare the following local variables of type 'struct vm_snapshot *'.
+	 *  - snap representing the snapshot of the VM, initialized as &vm_snapshots[vm->vm_id].
+	 */
+	struct vm_snapshot *snap = &vm_snapshots[vm->vm_id];
+	/** Declare the following local variables of type 'void *'.
+	 *  - hva representing the address to be returned, initialized as NULL.
+	 */
+	void *hva = NULL;
+
+	/** Call spinlock_obtain with the following parameter, in order to serialize with snapshot requests.
+	 *  - &vm->vm_lock
+	 */
+	spinlock_obtain(&vm->vm_lock);
+	/** If the snapshot is enabled and its memory keeps no snapshot and is not lent */
+	if (snap->enabled && (snap->state == SNAPSHOT_NONE)) {
+		/** Set snap->state to SNAPSHOT_LENT */
+		snap->state = SNAPSHOT_LENT;
+		/** Set *size to the size of the reserved memory */
+		*size = get_vm_config(vm->vm_id)->memory.size;
+		/** Set hva to the host virtual address of the reserved memory */
+		hva = hpa2hva(get_vm_config(vm->vm_id)->memory.snapshot_hpa);
+	}
+	/** Call spinlock_release with the following parameter, in order to release the lock.
+	 *  - &vm->vm_lock
+	 */
+	spinlock_release(&vm->vm_lock);
+
+	/** Return 'hva' */
+	return hva;
+}
+
+/**
+ * @brief Reclaim the memory reserved for the snapshot of the given VM after it is lent.
+ *
+ * @param[inout] vm Pointer to the VM.
+ *
+ * @return None
+ *
+ * @pre vm != NULL
+ * @pre The memory is lent by lend_vm_snapshot_memory.
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark N/A
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+void reclaim_vm_snapshot_memory(struct acrn_vm *vm)
+{
+	/** Call spinlock_obtain with the following parameter, in order to serialize with snapshot requests.
+	 *  - &vm->vm_lock
+	 */
+	spinlock_obtain(&vm->vm_lock);
+	/** Set the state of the snapshot of the VM to SNAPSHOT_NONE so that a snapshot can be taken again */
+	vm_snapshots[vm->vm_id].state = SNAPSHOT_NONE;
+	/** Call spinlock_release with the following parameter, in order to release the lock.
+	 *  - &vm->vm_lock
+	 */
+	spinlock_release(&vm->vm_lock);
+}
+
+/**
+ * @}
+ */
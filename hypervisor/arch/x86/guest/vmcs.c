@@ -835,6 +835,11 @@ static void init_exec_ctrl(struct acrn_vcpu *vcpu)
 	/** Set "value64" to return value of hva2hpa(vm->arch_vm.nworld_eptp) bitwise OR
 	 * ((3UL << 3U) | 6UL). */
 	value64 = hva2hpa(vm->arch_vm.nworld_eptp) | (3UL << 3U) | 6UL;
+	/** If vm->arch_vm.ept_ad is true */
+	if (vm->arch_vm.ept_ad) {
+		/** Bitwise OR value64 by VMX_EPTP_AD_ENABLE, in order to enable the EPT accessed and dirty flags */
+		value64 |= VMX_EPTP_AD_ENABLE;
+	}
 	/** Call exec_vmwrite64() with the following parameters, in order to write value64 to the field
 	 *  'EPT pointer' in current VMCS.
 	 *  - VMX_EPT_POINTER_FULL
@@ -846,8 +846,9 @@ static int32_t wbinvd_vmexit_handler(struct acrn_vcpu *vcpu)
 {
 	/** Call walk_ept_table() with the following parameters, in order to flush the cache derived from EPT.
 	 *  - vcpu->vm
-	 *  - ept_flush_leaf_page */
-	walk_ept_table(vcpu->vm, ept_flush_leaf_page);
+	 *  - ept_flush_leaf_page
+	 *  - NULL */
+	walk_ept_table(vcpu->vm, ept_flush_leaf_page, NULL);
 
 	/** Return 0 */
 	return 0;
@@ -17,6 +17,7 @@
 #include <trace.h>
 #include <logmsg.h>
 #include <virq.h>
+#include <instr_emul.h>
 
 /**
  * @addtogroup vp-dm_io-req
@@ -31,9 +32,375 @@
   * External APIs:
   * - pio_instr_vmexit_handler()
   * - ept_violation_vmexit_handler()
+  *
+  * Internal functions:
+  * - pio_string_mmio()
+  * - pio_string_instr()
   */
 
 
+/**
+ * @brief Maximum number of bytes transferred by one VM exit on a string I/O instruction.
+ *
+ * A REP prefixed INS/OUTS with a larger count is resumed by re-executing the instruction, which bounds
+ * the time spent in the hypervisor per exit and lets pending interrupts be delivered in between.
+ */
+#define PIO_STR_MAX_BYTES	256U
+
+/**
+ * @brief Transfer one element of a string I/O instruction from or to emulated MMIO.
+ *
+ * The guest buffer of INS/OUTS may lie in a range emulated by a MMIO handler, which has no host memory behind
+ * it. The element is then accessed through the MMIO handler covering \p gpa, using a request of its own as
+ * vcpu->req holds the port I/O request of the instruction.
+ *
+ * @param [in] vcpu Pointer to the instance of struct acrn_vcpu, which executes the string I/O instruction.
+ * @param [in] gpa Guest physical address of the element.
+ * @param [inout] elem Pointer to the host copy of the element, which is filled on REQUEST_READ and
+ *		       consumed on REQUEST_WRITE.
+ * @param [in] size Size of the element in bytes.
+ * @param [in] direction REQUEST_READ to read the element from MMIO, REQUEST_WRITE to write it.
+ *
+ * @return 0 if the access is emulated, otherwise the error returned by emulate_mmio().
+ *
+ * @pre vcpu != NULL
+ * @pre elem != NULL
+ * @pre size == 1 || size == 2 || size == 4
+ *
+ * @post None
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety This function is thread-safe under condition that /p vcpu is
+ *		 different among parallel invocations.
+ */
+static int32_t pio_string_mmio(struct acrn_vcpu *vcpu, uint64_t gpa, uint8_t *elem, uint32_t size,
+	uint32_t direction)
+{
+	/**
+	 * Declare the following local variables of type struct io_request.
+	 *  - mmio_io_req representing the MMIO request of the element, not initialized.
+	 */
+	struct io_request mmio_io_req;
+	/**
+	 * Declare the following local variables of type int32_t.
+	 *  - ret representing the result of the MMIO emulation, not initialized.
+	 */
+	int32_t ret;
+
+	/** Set the direction, address and size of mmio_io_req.reqs.mmio to direction, gpa and size */
+	mmio_io_req.reqs.mmio.direction = direction;
+	mmio_io_req.reqs.mmio.reserved = 0U;
+	mmio_io_req.reqs.mmio.address = gpa;
+	mmio_io_req.reqs.mmio.size = (uint64_t)size;
+	/** Set mmio_io_req.reqs.mmio.value to 0 */
+	mmio_io_req.reqs.mmio.value = 0UL;
+	/** If the element is written, copy it into the low bytes of mmio_io_req.reqs.mmio.value */
+	if (direction == REQUEST_WRITE) {
+		(void)memcpy_s(&mmio_io_req.reqs.mmio.value, sizeof(uint64_t), elem, size);
+	}
+
+	/** Call emulate_mmio() with vcpu and &mmio_io_req, setting ret to its return value */
+	ret = emulate_mmio(vcpu, &mmio_io_req);
+	/** If the element is read and the access is emulated, copy the low bytes of the value read to elem */
+	if ((ret == 0) && (direction == REQUEST_READ)) {
+		(void)memcpy_s(elem, size, &mmio_io_req.reqs.mmio.value, size);
+	}
+
+	/** Return ret */
+	return ret;
+}
+
+/**
+ * @brief Emulate a string I/O instruction (INS/OUTS, optionally REP prefixed).
+ *
+ * The address size and the segment of the memory operand are decoded from the VM-exit instruction information,
+ * the index register (RDI for INS, RSI for OUTS) and RFLAGS.DF give the guest buffer, which is translated
+ * through the guest paging structures. Up to PIO_STR_MAX_BYTES of the remaining count are run through the
+ * port I/O handler in this exit. The index register and RCX are advanced accordingly and the instruction is
+ * re-executed if elements remain.
+ *
+ * @param [inout] vcpu Pointer to the instance of struct acrn_vcpu, which triggers
+ *		       the VM exit on the string I/O instruction.
+ * @param [in] exit_qual VM exit qualification for the I/O instruction.
+ *
+ * @return None
+ *
+ * @pre vcpu != NULL
+ * @pre vcpu->req.reqs.pio.size == 1 || vcpu->req.reqs.pio.size == 2 || vcpu->req.reqs.pio.size == 4
+ * @pre vcpu->req.reqs.pio.direction == REQUEST_READ || vcpu->req.reqs.pio.direction == REQUEST_WRITE
+ *
+ * @post None
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety This function is thread-safe under condition that /p vcpu is
+ *		 different among parallel invocations.
+ *
+ * @remark A page fault is injected to the guest with no element transferred if the guest buffer can not be
+ *	   translated, so that the instruction is restarted after the guest handles the fault.
+ * @remark If the guest buffer is not backed by memory in the EPT, a single element is transferred per exit
+ *	   through the MMIO handler covering it. A general protection fault is injected with no element
+ *	   transferred if no MMIO handler covers it or the element crosses a page boundary.
+ */
+static void pio_string_instr(struct acrn_vcpu *vcpu, uint64_t exit_qual)
+{
+	/**
+	 * Declare the following local variables of type struct io_request *.
+	 *  - io_req representing current I/O request detailed information,
+	 *    initialized as &vcpu->req.
+	 */
+	struct io_request *io_req = &vcpu->req;
+	/**
+	 * Declare the following local variables of type uint8_t [PIO_STR_MAX_BYTES].
+	 *  - buf representing the host copy of the guest buffer, not initialized.
+	 */
+	uint8_t buf[PIO_STR_MAX_BYTES];
+	/**
+	 * Declare the following local variables of type uint64_t.
+	 *  - addr_mask representing the mask of the address size of the instruction, not initialized.
+	 *  - index representing the value of the index register, not initialized.
+	 *  - offset representing the lowest offset in the segment accessed by this exit, not initialized.
+	 *  - gva representing the lowest guest linear address accessed by this exit, not initialized.
+	 *  - count representing the number of elements still to transfer, not initialized.
+	 *  - gpa representing the guest physical address of gva, not initialized.
+	 *  - gpa_hi representing the guest physical address of the page holding the last byte,
+	 *    initialized as 0.
+	 */
+	uint64_t addr_mask, index, offset, gva, count, gpa, gpa_hi = 0UL;
+	/**
+	 * Declare the following local variables of type uint32_t.
+	 *  - info representing the VM-exit instruction information, not initialized.
+	 *  - size representing the size of each element in bytes, initialized as vcpu->req.reqs.pio.size.
+	 *  - seg representing the segment register of the memory operand, not initialized.
+	 *  - index_reg representing the index register of the memory operand, not initialized.
+	 *  - num representing the number of elements transferred in this exit, not initialized.
+	 *  - len representing the number of bytes transferred in this exit, not initialized.
+	 *  - len_lo representing the number of bytes in the page holding gva, not initialized.
+	 *  - err_code representing the page fault error code of a failed translation, not initialized.
+	 */
+	uint32_t info, size = (uint32_t)io_req->reqs.pio.size, seg, index_reg, num, len, len_lo, err_code;
+	/**
+	 * Declare the following local variables of type bool.
+	 *  - is_read representing whether the instruction is INS, initialized as true if the direction of
+	 *    the request is REQUEST_READ.
+	 *  - backward representing whether RFLAGS.DF is set, initialized accordingly.
+	 *  - is_rep representing whether the instruction is REP prefixed, initialized accordingly.
+	 */
+	bool is_read = (io_req->reqs.pio.direction == REQUEST_READ);
+	bool backward = ((vcpu_get_rflags(vcpu) & (1UL << 10U)) != 0UL);
+	bool is_rep = (vm_exit_io_instruction_is_rep(exit_qual) != 0UL);
+	/**
+	 * Declare the following local variables of type bool.
+	 *  - unbacked representing whether the guest buffer is not mapped in the EPT of the VM,
+	 *    initialized as false.
+	 *  - retry representing whether the guest buffer is translated again for a single element,
+	 *    initialized as true.
+	 */
+	bool unbacked = false, retry = true;
+	/**
+	 * Declare the following local variables of type int32_t.
+	 *  - ret representing the result of the translation of the guest buffer, then of the MMIO
+	 *    emulation of an unbacked one, initialized as 0.
+	 */
+	int32_t ret = 0;
+
+	/** Set info to the value of VMX_INSTR_INFO (VMCS field) */
+	info = exec_vmread32(VMX_INSTR_INFO);
+	/** If the address size in bits 9:7 of info is 16-bit */
+	if (((info >> 7U) & 0x7U) == 0U) {
+		/** Set addr_mask to 0xFFFF */
+		addr_mask = 0xFFFFUL;
+	/** If the address size in bits 9:7 of info is 32-bit */
+	} else if (((info >> 7U) & 0x7U) == 1U) {
+		/** Set addr_mask to 0xFFFFFFFF */
+		addr_mask = 0xFFFFFFFFUL;
+	} else {
+		/** Set addr_mask to all 1s for the 64-bit address size */
+		addr_mask = ~0UL;
+	}
+	/** If the instruction is INS, whose memory operand is always ES:[RDI] */
+	if (is_read) {
+		/** Set seg to 0 (ES) */
+		seg = 0U;
+		/** Set index_reg to CPU_REG_RDI */
+		index_reg = CPU_REG_RDI;
+	} else {
+		/** Set seg to the segment register in bits 17:15 of info */
+		seg = (info >> 15U) & 0x7U;
+		/** Set index_reg to CPU_REG_RSI */
+		index_reg = CPU_REG_RSI;
+	}
+
+	/** Set count to RCX masked with addr_mask if is_rep is true, or 1 otherwise */
+	count = is_rep ? (vcpu_get_gpreg(vcpu, CPU_REG_RCX) & addr_mask) : 1UL;
+	/** If count is not 0, as the instruction otherwise completes with no I/O */
+	if (count != 0UL) {
+		/** Set num to the smaller one of count and PIO_STR_MAX_BYTES / size */
+		num = (count < (uint64_t)(PIO_STR_MAX_BYTES / size)) ? (uint32_t)count : (PIO_STR_MAX_BYTES / size);
+		/** Set index to the index register masked with addr_mask */
+		index = vcpu_get_gpreg(vcpu, index_reg) & addr_mask;
+		/** If the address size is smaller than 64 bits, keep the elements of this exit from wrapping around
+		 *  the address size, which leaves a wrapping element to a following exit */
+		if (addr_mask != ~0UL) {
+			/** If descending elements would go below offset 0 */
+			if (backward && (index < ((uint64_t)(num - 1U) * size))) {
+				/** Set num to the number of elements from offset 0 to index */
+				num = (uint32_t)(index / size) + 1U;
+			/** If ascending elements would go beyond addr_mask */
+			} else if (!backward && ((index + ((uint64_t)num * size)) > (addr_mask + 1UL))) {
+				/** Set num to the number of elements from index to addr_mask, at least 1 */
+				num = (uint32_t)((addr_mask + 1UL - index) / size);
+				num = (num == 0U) ? 1U : num;
+			} else {
+				/* the elements do not wrap */
+			}
+		}
+		/** Translate the guest buffer of this exit, and again for a single element if it is unbacked */
+		while (retry) {
+			/** Set len to num * size */
+			len = num * size;
+			/** Set offset to the lowest offset accessed, which is index for ascending accesses and
+			 *  the offset of the last element for descending ones */
+			offset = backward ? ((index - (len - size)) & addr_mask) : index;
+			/** Set gva to the base of segment seg, whose VMCS field follows the one of ES by 2 * seg,
+			 *  plus offset */
+			gva = exec_vmread(VMX_GUEST_ES_BASE + (seg * 2U)) + offset;
+			/** If the vCPU is not in 64-bit mode, linear addresses are 32 bits */
+			if (get_vcpu_mode(vcpu) != CPU_MODE_64BIT) {
+				/** Truncate gva to 32 bits */
+				gva &= 0xFFFFFFFFUL;
+			}
+			/** Set len_lo to the number of bytes from gva to the end of its page, limited to len */
+			len_lo = PAGE_SIZE - ((uint32_t)gva & (PAGE_SIZE - 1U));
+			len_lo = (len_lo > len) ? len : len_lo;
+
+			/** Call gva2gpa() to translate gva and, if the buffer crosses a page boundary, the first byte
+			 *  of the following page, setting ret to the result */
+			ret = gva2gpa(vcpu, gva, is_read, &gpa, &err_code);
+			/** If gva is translated and the buffer crosses a page boundary */
+			if ((ret == 0) && (len_lo < len)) {
+				/** Translate the first byte of the following page into gpa_hi, setting ret to
+				 *  the result */
+				ret = gva2gpa(vcpu, gva + len_lo, is_read, &gpa_hi, &err_code);
+				/** If the translation fails, report the fault at the following page */
+				if (ret != 0) {
+					gva += len_lo;
+				}
+			}
+			/** Set unbacked to true if the guest buffer is translated but not mapped in the EPT of the VM,
+			 *  e.g. when it lies in emulated MMIO */
+			unbacked = (ret == 0) && ((gpa2hpa(vcpu->vm, gpa) == INVALID_HPA) ||
+				((len_lo < len) && (gpa2hpa(vcpu->vm, gpa_hi) == INVALID_HPA)));
+			/** Set retry to true if an unbacked buffer holds several elements, which are then transferred
+			 *  one per exit through the MMIO handler */
+			retry = unbacked && (num > 1U);
+			/** If the buffer is translated again */
+			if (retry) {
+				/** Set num to 1 */
+				num = 1U;
+			}
+		}
+
+		/** If the guest buffer can not be accessed */
+		if (ret != 0) {
+			/** Call vcpu_inject_pf() with the following parameters, in order to
+			 *  inject a page fault to the guest.
+			 *  - vcpu
+			 *  - gva
+			 *  - err_code
+			 */
+			vcpu_inject_pf(vcpu, gva, err_code);
+			/** Call vcpu_retain_rip() with vcpu, in order to restart the instruction after the fault */
+			vcpu_retain_rip(vcpu);
+		/** If the unbacked guest buffer crosses a page boundary or is not covered by a MMIO handler */
+		} else if (unbacked && ((len_lo < len) || !is_emulated_mmio(vcpu->vm, gpa))) {
+			/** Call vcpu_inject_gp() with vcpu and 0, in order to report the access to the guest */
+			vcpu_inject_gp(vcpu, 0U);
+		} else {
+			/** If the instruction is OUTS, copy the guest buffer to buf */
+			if (!is_read) {
+				/** If the guest buffer is unbacked */
+				if (unbacked) {
+					/** Call pio_string_mmio() to read the element at gpa into buf, setting ret
+					 *  to its return value */
+					ret = pio_string_mmio(vcpu, gpa, buf, size, REQUEST_READ);
+				} else {
+					/** Call copy_from_gpa() to copy the len_lo bytes at gpa to buf */
+					(void)copy_from_gpa(vcpu->vm, buf, gpa, len_lo);
+					/** If the buffer crosses a page boundary, copy the remaining bytes at gpa_hi */
+					if (len_lo < len) {
+						(void)copy_from_gpa(vcpu->vm, &buf[len_lo], gpa_hi, len - len_lo);
+					}
+				}
+			}
+
+			/** If no MMIO access to the guest buffer failed */
+			if (ret == 0) {
+				/**
+				 * Call emulate_io_string() with the following parameters, in order to
+				 * emulate the num elements of this exit.
+				 *  - vcpu
+				 *  - io_req
+				 *  - buf
+				 *  - num
+				 *  - backward
+				 */
+				emulate_io_string(vcpu, io_req, buf, num, backward);
+
+				/** If the instruction is INS, copy buf to the guest buffer */
+				if (is_read) {
+					/** If the guest buffer is unbacked */
+					if (unbacked) {
+						/** Call pio_string_mmio() to write the element in buf to gpa,
+						 *  setting ret to its return value */
+						ret = pio_string_mmio(vcpu, gpa, buf, size, REQUEST_WRITE);
+					} else {
+						/** Call copy_to_gpa() to copy the first len_lo bytes of buf to gpa */
+						copy_to_gpa(vcpu->vm, buf, gpa, len_lo);
+						/** If the buffer crosses a page boundary, copy the remaining bytes
+						 *  to gpa_hi */
+						if (len_lo < len) {
+							copy_to_gpa(vcpu->vm, &buf[len_lo], gpa_hi, len - len_lo);
+						}
+					}
+				}
+			}
+
+			/** If the MMIO handler fails the access */
+			if (ret != 0) {
+				/** Call vcpu_inject_gp() with vcpu and 0, in order to report the access to the guest */
+				vcpu_inject_gp(vcpu, 0U);
+			} else {
+				/** Set index to the index advanced past the transferred elements */
+				index = backward ? (index - len) : (index + len);
+				/** Set the index register to index, keeping the bits above a 16-bit address size
+				 *  (a 32-bit register write zero-extends) */
+				vcpu_set_gpreg(vcpu, index_reg, (addr_mask == 0xFFFFUL) ?
+					((vcpu_get_gpreg(vcpu, index_reg) & ~addr_mask) | (index & addr_mask)) :
+					(index & addr_mask));
+
+				/** If the instruction is REP prefixed */
+				if (is_rep) {
+					/** Set count to the number of elements left */
+					count -= num;
+					/** Set RCX to count in the same way as the index register */
+					vcpu_set_gpreg(vcpu, CPU_REG_RCX, (addr_mask == 0xFFFFUL) ?
+						((vcpu_get_gpreg(vcpu, CPU_REG_RCX) & ~addr_mask) | count) : count);
+					/** If elements remain, re-execute the instruction at next VM entry */
+					if (count != 0UL) {
+						vcpu_retain_rip(vcpu);
+					}
+				}
+			}
+		}
+	}
+}
+
 /**
  * @brief The handler of VM exits on I/O instructions
  *
@@ -122,12 +489,23 @@ int32_t pio_instr_vmexit_handler(struct acrn_vcpu *vcpu)
 		TRACE_4I(TRACE_VMEXIT_IO_INSTRUCTION, (uint32_t)pio_req->address, (uint32_t)pio_req->direction,
 			 (uint32_t)pio_req->size, 0U);
 
-		/**
-		 * Call emulate_io() with the following parameters, in order to emulate current I/O access.
-		 *  - vcpu
-		 *  - io_req
-		 */
-		emulate_io(vcpu, io_req);
+		/** If the I/O instruction is a string instruction (INS/OUTS) */
+		if (vm_exit_io_instruction_is_string(exit_qual) != 0UL) {
+			/**
+			 * Call pio_string_instr() with the following parameters, in order to emulate
+			 * the string I/O access on the guest buffer.
+			 *  - vcpu
+			 *  - exit_qual
+			 */
+			pio_string_instr(vcpu, exit_qual);
+		} else {
+			/**
+			 * Call emulate_io() with the following parameters, in order to emulate current I/O access.
+			 *  - vcpu
+			 *  - io_req
+			 */
+			emulate_io(vcpu, io_req);
+		}
 	}
 
 	/** Return ret */
@@ -137,6 +515,9 @@ int32_t pio_instr_vmexit_handler(struct acrn_vcpu *vcpu)
 /**
  * @brief The handler of VM exits on EPT violation.
  *
+ * Instruction fetches from cacheable memory are granted the execute right, data accesses to the MMIO ranges
+ * emulated for the VM are decoded and emulated, and any other violation is reported to the guest as a page fault.
+ *
  * @param [in] vcpu Pointer to the instance of struct acrn_vcpu,
  *		    which triggers the VM exit on EPT violation.
  *
@@ -201,23 +582,41 @@ int32_t ept_violation_vmexit_handler(struct acrn_vcpu *vcpu)
 	 *  to EPT_WB. */
 	if (((exit_qual & 0x4UL) != 0UL) && (pgentry != NULL) && ((*pgentry & EPT_MT_MASK) == EPT_WB)) {
 		/**
-		 * Call ept_modify_mr() with the following parameters,
-		 * in order to set EPT memory access right to be executable.
+		 * Call atomic_inc64() with the following parameters,
+		 * in order to count the instruction fetch EPT violation of the VM.
+		 *  - &vcpu->vm->exe_ept_violations
+		 */
+		atomic_inc64(&vcpu->vm->exe_ept_violations);
+		/**
+		 * Call ept_grant_exe_right() with the following parameters,
+		 * in order to set EPT memory access right to be executable for
+		 * the whole 2-MByte region containing gpa at once.
 		 *  - vcpu->vm
-		 *  - vcpu->vm->arch_vm.nworld_eptp
-		 *  - gpa & PAGE_MASK
+		 *  - gpa
 		 *  - PAGE_SIZE
-		 *  - EPT_EXE
-		 *  - 0UL
 		 */
-		ept_modify_mr(vcpu->vm, (uint64_t *)vcpu->vm->arch_vm.nworld_eptp, gpa & PAGE_MASK, PAGE_SIZE,
-			EPT_EXE, 0UL);
+		ept_grant_exe_right(vcpu->vm, gpa, PAGE_SIZE);
 		/**
 		 * Call vcpu_retain_rip() with the following parameters,
 		 * in order to retain guest RIP for next VM entry.
 		 *  - vcpu
 		 */
 		vcpu_retain_rip(vcpu);
+	/** If EPT violation is caused by a data access to a MMIO range emulated for the VM */
+	} else if (((exit_qual & 0x4UL) == 0UL) && is_emulated_mmio(vcpu->vm, gpa)) {
+		/** If the call to emulate_mmio_instruction() with the following parameters fails, in order to decode
+		 *  and emulate the instruction accessing gpa.
+		 *  - vcpu
+		 *  - gpa
+		 */
+		if (emulate_mmio_instruction(vcpu, gpa) != 0) {
+			/** Call vcpu_inject_gp() with the following parameters,
+			 *  in order to inject general protection exception to guest VM.
+			 *  - vcpu
+			 *  - 0U
+			 */
+			vcpu_inject_gp(vcpu, 0U);
+		}
 	} else {
 
 		/** Call vcpu_inject_pf() with the following parameters,
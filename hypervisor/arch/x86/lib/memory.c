@@ -35,6 +35,7 @@
  *
  * - memset: Set n bytes starting from base to v.
  * - memcpy_s: Copy slen bytes from a source address to a destination address.
+ * - memclr_nt: Clear n bytes starting from base with non-temporal stores.
  * - memset_erms: Set n bytes starting from base to v by using Enhanced REP MOVSB/STOSB.
  * - memcpy_erms: Copy slen bytes from source address to destination address by using Enhanced REP MOVSB/STOSB.
  */
@@ -183,6 +184,49 @@ void *memset(void *base, uint8_t v, size_t n)
 	return base;
 }
 
+/**
+ * @brief Clear n bytes starting from base with non-temporal stores
+ *
+ * The stores bypass the caches, so that clearing a large memory block neither reads it in nor evicts the working set
+ * of the physical processor. It is meant for memory that is not accessed again soon, such as the RAM of a VM being
+ * scrubbed.
+ *
+ * @param[inout]    base The address of the memory block to clear
+ * @param[in]       n The number of bytes to be cleared
+ *
+ * @return None
+ *
+ * @pre base != NULL
+ * @pre \a base is 8-byte aligned
+ * @pre n != 0 and n is a multiple of 32
+ * @pre Host logical address [\a base , \a base + \a n ) maps to memory with write privilege
+ *
+ * @mode HV_INIT, HV_OPERATIONAL, HV_TERMINATION
+ *
+ * @reentrancy Unspecified
+ * @threadsafety When the intersection of any virtual address range [\a base , \a base + \a n )
+ * set on different physical processor is null set.
+ */
+void memclr_nt(void *base, size_t n)
+{
+	/** Execute movnti four times per iteration until n bytes are cleared, then sfence in order to make the
+	 *  non-temporal stores globally visible before returning.
+	 *  - Input operands: RAX holds 0
+	 *  - Output operands: RDI holds base and RCX holds n, both updated by the loop
+	 *  - Clobbers: cc, memory */
+	asm volatile("1: movnti %%rax, (%%rdi)\n\t"
+		     "movnti %%rax, 8(%%rdi)\n\t"
+		     "movnti %%rax, 16(%%rdi)\n\t"
+		     "movnti %%rax, 24(%%rdi)\n\t"
+		     "add $32, %%rdi\n\t"
+		     "sub $32, %%rcx\n\t"
+		     "jnz 1b\n\t"
+		     "sfence"
+		     : "+D"(base), "+c"(n)
+		     : "a"(0UL)
+		     : "cc", "memory");
+}
+
 /**
  * @}
  */
@@ -12,6 +12,8 @@
 #include <vm_configurations.h>
 #include <security.h>
 #include <vm.h>
+#include <ept.h>
+#include <per_cpu.h>
 
 /**
  * @defgroup hwmgmt_page hwmgmt.page
@@ -81,16 +83,16 @@
  * This function could be invoked to populate these information into each VM's dedicated data structure.
  *
  * Following helper functions and variables are defined to implement 'ppt_mem_ops':
- * ppt_pml4_pages, ppt_pdpt_pages, ppt_pd_pages, ppt_pages_info, ppt_get_pml4_page, ppt_get_pdpt_page, ppt_get_pd_page,
- * ppt_get_default_access_right, ppt_pgentry_present, and ppt_clflush_pagewalk.
+ * ppt_pml4_pages, ppt_pdpt_pages, ppt_pd_pages, ppt_pt_pages, ppt_pages_info, ppt_get_pml4_page, ppt_get_pdpt_page,
+ * ppt_get_pd_page, ppt_get_pt_page, ppt_get_default_access_right, ppt_pgentry_present, and ppt_clflush_pagewalk.
  *
  * Following helper functions and variables are defined to implement 'init_ept_mem_ops':
  * uos_nworld_pml4_pages, uos_nworld_pdpt_pages, uos_nworld_pd_pages, uos_nworld_pt_pages, ept_pages_info,
  * ept_get_pml4_page, ept_get_pdpt_page, ept_get_pd_page, ept_get_pt_page, ept_get_default_access_right,
- * ept_pgentry_present, ept_clflush_pagewalk, ept_tweak_exe_right, and ept_recover_exe_right.
+ * ept_pgentry_present, ept_clflush_pagewalk, ept_tweak_exe_right, ept_recover_exe_right, and ept_flush_merged.
  *
  * Following helper functions are defined for those cases when no operation is to be conducted:
- * nop_tweak_exe_right and nop_recover_exe_right.
+ * nop_tweak_exe_right, nop_recover_exe_right, and nop_flush_merged.
  *
  */
 
@@ -106,6 +108,14 @@ static struct page ppt_pdpt_pages[PDPT_PAGE_NUM(CONFIG_PLATFORM_RAM_SIZE + PLATF
  * @brief An array that contains all page directories to be used by the hypervisor.
  */
 static struct page ppt_pd_pages[PD_PAGE_NUM(CONFIG_PLATFORM_RAM_SIZE + PLATFORM_LO_MMIO_SIZE)];
+/**
+ * @brief An array that contains all page tables to be used by the hypervisor.
+ *
+ * The hypervisor only maps 4-KByte pages for the 2-MByte regions holding the guard pages of the physical CPU stacks,
+ * so page tables are only provided for the region covered by 'per_cpu_data'. One more page table is needed as the
+ * region is not necessarily aligned with PDE_SIZE.
+ */
+static struct page ppt_pt_pages[PT_PAGE_NUM(sizeof(per_cpu_data)) + 1U];
 
 /**
  * @brief An array that contains all paging structures to be used by the hypervisor.
@@ -115,6 +125,7 @@ static union pgtable_pages_info ppt_pages_info = {
 		.pml4_base = ppt_pml4_pages,
 		.pdpt_base = ppt_pdpt_pages,
 		.pd_base = ppt_pd_pages,
+		.pt_base = ppt_pt_pages,
 	}
 };
 
@@ -330,6 +341,51 @@ static inline struct page *ppt_get_pd_page(const union pgtable_pages_info *info,
 	return pd_page;
 }
 
+/**
+ * @brief Get the specified page table to be used by the hypervisor.
+ *
+ * This page table could be used to establish the mapping for the specified host virtual address.
+ *
+ * It is supposed to be called when hypervisor splits the 2-MByte page holding a guard page of a physical CPU stack.
+ *
+ * @param[inout] info A pointer to the data structure that contains the information of the paging structures
+ *                    used by the hypervisor.
+ * @param[in] gpa The specified host virtual address that needs to be translated.
+ *
+ * @return A pointer to the specified page table to be used to establish the mapping for the specified
+ *         host virtual address.
+ *
+ * @pre info != NULL
+ * @pre round_pde_down((uint64_t)per_cpu_data) <= gpa < (uint64_t)per_cpu_data + sizeof(per_cpu_data)
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_PRE_SMP
+ *
+ * @remark N/A
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+static inline struct page *ppt_get_pt_page(const union pgtable_pages_info *info, uint64_t gpa)
+{
+	/** Declare the following local variables of type 'struct page *'.
+	 *  - pt_page representing a pointer to the page table to be used by the hypervisor
+	 *  and to establish the mapping for \a gpa, initialized as
+	 *  'info->ppt.pt_base + ((gpa - round_pde_down((uint64_t)per_cpu_data)) >> PDE_SHIFT)'. */
+	struct page *pt_page = info->ppt.pt_base + ((gpa - round_pde_down((uint64_t)per_cpu_data)) >> PDE_SHIFT);
+
+	/** Call memset with the following parameters, in order to set the contents stored in 'pt_page' to all 0s,
+	 *  and discard its return value.
+	 *  - pt_page
+	 *  - 0
+	 *  - PAGE_SIZE
+	 */
+	(void)memset(pt_page, 0U, PAGE_SIZE);
+	/** Return 'pt_page' */
+	return pt_page;
+}
+
 /**
  * @brief Callback function to tweak the execute permission when MCE mitigation is not needed.
  *
@@ -392,6 +448,36 @@ static inline void nop_recover_exe_right(__unused uint64_t *prot)
 {
 }
 
+/**
+ * @brief Callback function to invalidate the cached translations of a merged region for hypervisor's MMU.
+ *
+ * There is no operation to be conducted in this function, as the paging structures used by the hypervisor are
+ * only modified during initialization.
+ *
+ * @param[in] info A pointer to the information of the paging structures.
+ * @param[in] vaddr The base address of the merged region.
+ * @param[in] size The size of the merged region.
+ *                 Though these arguments are not used in this function, they are kept here since this function
+ *                 would be used as a callback function and other instances with same type need these arguments.
+ *
+ * @return None
+ *
+ * @pre N/A
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_PRE_SMP, HV_SUBMODE_INIT_ROOT
+ *
+ * @remark N/A
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+static inline void nop_flush_merged(__unused const union pgtable_pages_info *info, __unused uint64_t vaddr,
+	__unused uint64_t size)
+{
+}
+
 /**
  * @brief A global variable providing the information to be used for hypervisor's MMU operations.
  */
@@ -403,9 +489,11 @@ const struct memory_ops ppt_mem_ops = {
 	.get_pml4_page = ppt_get_pml4_page,
 	.get_pdpt_page = ppt_get_pdpt_page,
 	.get_pd_page = ppt_get_pd_page,
+	.get_pt_page = ppt_get_pt_page,
 	.clflush_pagewalk = ppt_clflush_pagewalk,
 	.tweak_exe_right = nop_tweak_exe_right,
 	.recover_exe_right = nop_recover_exe_right,
+	.flush_merged = nop_flush_merged,
 };
 
 /**
@@ -501,8 +589,9 @@ static inline uint64_t ept_pgentry_present(uint64_t pte)
  * @brief Flush the cache line that contains the specified EPT paging-structure entry.
  *
  * The cache of those EPT paging-structure entries needs to be flushed because they are shared between EPT and VT-d.
- * As page-walk coherency is not supported on the VT-d remapping hardware in current physical platform, the cache
- * needs to be flushed to let the modification on those paging structures be visible to VT-d remapping hardware.
+ * As the EPT is also the second-level translation table of VT-d remapping hardware, the modification on those paging
+ * structures needs to be made visible to it. 'iommu_flush_cache' skips the flush when the remapping hardware is
+ * page-walk coherent.
  *
  * It is supposed to be called when the paging structures used for EPT is modified.
  *
@@ -780,6 +869,41 @@ static inline void ept_recover_exe_right(uint64_t *prot)
 	*prot |= EPT_EXE;
 }
 
+/**
+ * @brief Callback function to invalidate the cached translations of a region just merged into a large page in EPT.
+ *
+ * The IOTLB and paging-structure caches of the VM's IOMMU domain and the EPT caches of all its vCPUs are
+ * invalidated before this function returns, so that the page table or page directory left unreferenced by the
+ * merge can be rewritten by a later split.
+ *
+ * @param[in] info A pointer to the information of the EPT paging structures of the VM.
+ * @param[in] vaddr The guest physical address of the merged region.
+ * @param[in] size The size of the merged region.
+ *
+ * @return None
+ *
+ * @pre info != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_PRE_SMP, HV_SUBMODE_INIT_POST_SMP, HV_SUBMODE_INIT_ROOT, HV_OPERATIONAL
+ *
+ * @remark N/A
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+static void ept_flush_merged(const union pgtable_pages_info *info, uint64_t vaddr, uint64_t size)
+{
+	/** Call ept_flush_sync with the following parameters, in order to invalidate the cached translations of the
+	 *  merged region and wait until no vCPU of the VM can use them anymore.
+	 *  - get_vm_from_vmid(info->ept.vm_id)
+	 *  - vaddr
+	 *  - size
+	 */
+	ept_flush_sync(get_vm_from_vmid(info->ept.vm_id), vaddr, size);
+}
+
 /**
  * @brief Populate the specified data structure with the information to be used for the specified VM's EPT operations.
  *
@@ -814,6 +938,8 @@ void init_ept_mem_ops(struct memory_ops *mem_ops, uint16_t vm_id, bool enforce_4
 	ept_pages_info[vm_id].ept.nworld_pd_base = uos_nworld_pd_pages[vm_id];
 	/** Set 'ept_pages_info[vm_id].ept.nworld_pt_base' to 'uos_nworld_pt_pages[vm_id]' */
 	ept_pages_info[vm_id].ept.nworld_pt_base = uos_nworld_pt_pages[vm_id];
+	/** Set 'ept_pages_info[vm_id].ept.vm_id' to \a vm_id */
+	ept_pages_info[vm_id].ept.vm_id = vm_id;
 
 	/** Set 'mem_ops->info' to '&ept_pages_info[vm_id]' */
 	mem_ops->info = &ept_pages_info[vm_id];
@@ -831,6 +957,8 @@ void init_ept_mem_ops(struct memory_ops *mem_ops, uint16_t vm_id, bool enforce_4
 	mem_ops->get_pt_page = ept_get_pt_page;
 	/** Set 'mem_ops->clflush_pagewalk' to 'ept_clflush_pagewalk' */
 	mem_ops->clflush_pagewalk = ept_clflush_pagewalk;
+	/** Set 'mem_ops->flush_merged' to 'ept_flush_merged' */
+	mem_ops->flush_merged = ept_flush_merged;
 	/** Set 'mem_ops->large_page_enabled' to true */
 	mem_ops->large_page_enabled = true;
 
@@ -31,7 +31,7 @@
  * - 'lookup_address' could be invoked to look for the mapping information.
  *
  * Following helper functions are defined to implement 'mmu_modify_or_del':
- * split_large_page, local_modify_or_del_pte, modify_or_del_pte, modify_or_del_pde, and modify_or_del_pdpte.
+ * split_large_page, merge_large_page, local_modify_or_del_pte, modify_or_del_pte, modify_or_del_pde, and modify_or_del_pdpte.
  *
  * Following helper functions are defined to implement 'mmu_add':
  * construct_pgentry, add_pte, add_pde, and add_pdpte.
@@ -168,6 +168,173 @@ static void split_large_page(
 	set_pgentry(pte, hva2hpa((void *)pbase) | ref_prot, mem_ops);
 }
 
+/**
+ * @brief Merge the next level pages referenced by the specified paging-structure entry back into a large page.
+ *
+ * The merge is done only when all 512 entries located in the next level paging structure map a physically
+ * contiguous region aligned with the size of the large page, and all of them have identical properties.
+ * It is the reverse operation of 'split_large_page'. The next level paging structure is statically allocated for
+ * the specified address, so it is simply left unreferenced after the merge. As the next split of the same region
+ * rewrites it, the cached translations of the region are invalidated by 'mem_ops->flush_merged' before this function
+ * returns, instead of being left to the deferred invalidation conducted by the callers of 'mmu_modify_or_del'.
+ *
+ * The merge is skipped if it would change the execute permission of the mapping, which would happen when the
+ * execute permission of large pages is tweaked by 'mem_ops->tweak_exe_right'.
+ *
+ * Only the following cases are supported:
+ * - Merge 512 2-MByte pages into a 1-GByte page.
+ * - Merge 512 4-KByte pages into a 2-MByte page.
+ *
+ * It is supposed to be called internally by 'modify_or_del_pdpte' and 'modify_or_del_pde'.
+ *
+ * @param[inout] pte A pointer to the specified paging-structure entry. It points to either a PDPTE or a PDE which
+ *                   references the next level paging structure.
+ * @param[in] level The specified paging-structure level.
+ * @param[in] vaddr An input address within the region mapped by \a pte.
+ * @param[in] mem_ops A pointer to the data structure containing the information of the specified memory operations.
+ *
+ * @return None
+ *
+ * @pre pte != NULL
+ * @pre mem_ops != NULL
+ * @pre (level == IA32E_PDPT) || (level == IA32E_PD)
+ * @pre mem_ops->pgentry_present(*pte) != 0
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_PRE_SMP, HV_SUBMODE_INIT_POST_SMP, HV_SUBMODE_INIT_ROOT, HV_OPERATIONAL
+ *
+ * @remark N/A
+ *
+ * @reentrancy Unspecified
+ * @threadsafety When \a pte is different among parallel invocation.
+ */
+static void merge_large_page(
+	uint64_t *pte, enum page_table_level level, uint64_t vaddr, const struct memory_ops *mem_ops)
+{
+	/** Declare the following local variables of type 'uint64_t *'.
+	 *  - pbase representing a pointer to the next level paging structure (either a page directory or a page table),
+	 *  not initialized. */
+	uint64_t *pbase;
+	/** Declare the following local variables of type uint64_t.
+	 *  - paddr representing the physical address mapped by the first entry located in the next level paging
+	 *  structure, not initialized.
+	 *  - paddrinc representing the size of the space controlled by the next level paging-structure entry
+	 *  (either a PDE or a PTE), not initialized.
+	 *  - size_mask representing the mask to check whether 'paddr' is aligned with the size of the large page,
+	 *  which is also the size of the large page minus 1, not initialized.
+	 */
+	uint64_t paddr, paddrinc, size_mask;
+	/** Declare the following local variables of type uint64_t.
+	 *  - i representing the index to go through all entries located in the next level paging structure,
+	 *  not initialized.
+	 *  - ref_prot representing the properties of the first entry located in the next level paging structure,
+	 *  not initialized.
+	 *  - large_prot representing the properties of the merged large page, not initialized.
+	 */
+	uint64_t i, ref_prot, large_prot;
+	/** Declare the following local variables of type bool.
+	 *  - mergeable representing whether the next level pages could be merged, not initialized. */
+	bool mergeable;
+
+	/** Depending on the paging-structure level specified by \a level */
+	switch (level) {
+	/** \a level is IA32E_PDPT */
+	case IA32E_PDPT:
+		/** Set 'pbase' to the return value of 'pdpte_page_vaddr(*pte)', which points to the page directory
+		 *  referenced by \a pte */
+		pbase = pdpte_page_vaddr(*pte);
+		/** Set 'paddr' to 'pbase[0] & PDE_PFN_MASK'. The PAT bit (Bit 12) of a PDE mapping a 2-MByte page
+		 *  is kept in 'paddr', so such pages fail the alignment check below and are never merged. */
+		paddr = pbase[0] & PDE_PFN_MASK;
+		/** Set 'paddrinc' to PDE_SIZE */
+		paddrinc = PDE_SIZE;
+		/** Set 'size_mask' to 'PDPTE_SIZE - 1' */
+		size_mask = PDPTE_SIZE - 1UL;
+		/** Set 'ref_prot' to 'pbase[0] & PDE_PROT_MASK' */
+		ref_prot = pbase[0] & PDE_PROT_MASK;
+		/** Set 'mergeable' to true if the first PDE maps a 2-MByte page; otherwise, set it to false */
+		mergeable = (pde_large(pbase[0]) != 0UL);
+		/** Set 'large_prot' to 'ref_prot', the Page Size Bit (Bit 7) is already set */
+		large_prot = ref_prot;
+		/** End of case */
+		break;
+	/** Otherwise */
+	default: /* IA32E_PD */
+		/** Set 'pbase' to the return value of 'pde_page_vaddr(*pte)', which points to the page table
+		 *  referenced by \a pte */
+		pbase = pde_page_vaddr(*pte);
+		/** Set 'paddr' to 'pbase[0] & PDE_PFN_MASK' */
+		paddr = pbase[0] & PDE_PFN_MASK;
+		/** Set 'paddrinc' to PTE_SIZE */
+		paddrinc = PTE_SIZE;
+		/** Set 'size_mask' to 'PDE_SIZE - 1' */
+		size_mask = PDE_SIZE - 1UL;
+		/** Set 'ref_prot' to 'pbase[0] & PDE_PROT_MASK' */
+		ref_prot = pbase[0] & PDE_PROT_MASK;
+		/** Set 'mergeable' to true if Bit 7 of the first PTE is 0; otherwise, set it to false. Bit 7 of a
+		 *  PTE is the PAT bit for hypervisor's MMU, which has no equivalent at the same position in a PDE. */
+		mergeable = ((ref_prot & PAGE_PS) == 0UL);
+		/** Set 'large_prot' to 'ref_prot | PAGE_PS' */
+		large_prot = ref_prot | PAGE_PS;
+		/** End of case */
+		break;
+	}
+
+	/** If all following conditions are satisfied:
+	 *  1. 'mem_ops->large_page_enabled' is true, indicating that the large pages are allowed to be used.
+	 *  2. 'mergeable' is true.
+	 *  3. The return value of 'mem_ops->pgentry_present(pbase[0])' is not 0.
+	 *  4. 'paddr' is aligned with the size of the large page.
+	 */
+	if (mem_ops->large_page_enabled && mergeable && (mem_ops->pgentry_present(pbase[0]) != 0UL) &&
+		((paddr & size_mask) == 0UL)) {
+		/** Set 'ref_prot' to 'large_prot' */
+		ref_prot = large_prot;
+		/** Call mem_ops->tweak_exe_right with the following parameters, in order to
+		 *  tweak the execute permission in 'large_prot'.
+		 *  - &large_prot
+		 */
+		mem_ops->tweak_exe_right(&large_prot);
+		/** Set 'mergeable' to true if 'large_prot' is not changed by the tweak */
+		mergeable = (large_prot == ref_prot);
+
+		/** For each 'i' ranging from 1 to 'PTRS_PER_PTE - 1' [with a step of 1], and while 'mergeable'
+		 *  is true */
+		for (i = 1UL; mergeable && (i < PTRS_PER_PTE); i++) {
+			/** Set 'mergeable' to false if the 'i'-th entry differs from the first entry in anything other
+			 *  than the physical address increment */
+			mergeable = (pbase[i] == (pbase[0] + (i * paddrinc)));
+		}
+
+		/** If 'mergeable' is true */
+		if (mergeable) {
+			/** Logging the following information with a log level of ACRN_DBG_MMU.
+			 *  - __func__
+			 *  - paddr
+			 *  - pbase
+			 */
+			dev_dbg(ACRN_DBG_MMU, "%s, paddr: 0x%lx, pbase: 0x%lx\n", __func__, paddr, pbase);
+			/** Call set_pgentry with the following parameters, in order to set the content stored in the
+			 *  paging-structure entry (either a PDPTE or a PDE) pointed by \a pte to 'paddr | large_prot'
+			 *  so that this paging-structure entry would map a large page.
+			 *  - pte
+			 *  - paddr | large_prot
+			 *  - mem_ops
+			 */
+			set_pgentry(pte, paddr | large_prot, mem_ops);
+			/** Call mem_ops->flush_merged with the following parameters, in order to invalidate the cached
+			 *  translations of the merged region before the paging structure left unreferenced can be
+			 *  reused.
+			 *  - mem_ops->info
+			 *  - vaddr & ~size_mask
+			 *  - size_mask + 1
+			 */
+			mem_ops->flush_merged(mem_ops->info, vaddr & ~size_mask, size_mask + 1UL);
+		}
+	}
+}
+
 /**
  * @brief Modify or delete the mapping established by the specified paging-structure entry.
  *
@@ -551,6 +718,17 @@ static void modify_or_del_pde(const uint64_t *pdpte, uint64_t vaddr_start, uint6
 			 *  - type
 			 */
 			modify_or_del_pte(pde, vaddr, vaddr_end_each_iter, prot_set, prot_clr, mem_ops, type);
+			/** If \a type is equal to MR_MODIFY */
+			if (type == MR_MODIFY) {
+				/** Call merge_large_page with the following parameters, in order to merge the
+				 *  PTEs referenced by 'pde' back into a large page if they became uniform again.
+				 *  - pde
+				 *  - IA32E_PD
+				 *  - vaddr
+				 *  - mem_ops
+				 */
+				merge_large_page(pde, IA32E_PD, vaddr, mem_ops);
+			}
 		}
 		/** If 'vaddr_next' is equal to or larger than \a vaddr_end, indicating that all PDEs
 		 *  associated with the specified input address space has been handled. */
@@ -719,6 +897,17 @@ static void modify_or_del_pdpte(const uint64_t *pml4e, uint64_t vaddr_start, uin
 			 *  - type
 			 */
 			modify_or_del_pde(pdpte, vaddr, vaddr_end_each_iter, prot_set, prot_clr, mem_ops, type);
+			/** If \a type is equal to MR_MODIFY */
+			if (type == MR_MODIFY) {
+				/** Call merge_large_page with the following parameters, in order to merge the
+				 *  PDEs referenced by 'pdpte' back into a large page if they became uniform again.
+				 *  - pdpte
+				 *  - IA32E_PDPT
+				 *  - vaddr
+				 *  - mem_ops
+				 */
+				merge_large_page(pdpte, IA32E_PDPT, vaddr, mem_ops);
+			}
 		}
 		/** If 'vaddr_next' is equal to or larger than \a vaddr_end, indicating that all PDPTEs
 		 *  associated with the specified input address space has been handled. */
@@ -1029,9 +1218,9 @@ static void add_pde(const uint64_t *pdpte, uint64_t paddr_start, uint64_t vaddr_
 	 *  initialized as the return value of 'pde_index(vaddr)'. */
 	uint64_t index = pde_index(vaddr);
 	/** Declare the following local variables of type uint64_t.
-	 *  - effective_prot representing the properties that eventually set to a paging-structure entry,
-	 *  initialized as \a prot. */
-	uint64_t effective_prot = prot;
+	 *  - effective_prot representing the properties that eventually set to a paging-structure entry mapping a
+	 *  large page, not initialized. */
+	uint64_t effective_prot;
 	/** Declare the following local variables of type uint64_t.
 	 *  - vaddr_end_each_iter representing the address determining the end of the input address space to be mapped
 	 *  in each iteration, not initialized. */
@@ -1079,6 +1268,10 @@ static void add_pde(const uint64_t *pdpte, uint64_t paddr_start, uint64_t vaddr_
 				 */
 				if (mem_ops->large_page_enabled && mem_aligned_check(paddr, PDE_SIZE) &&
 					mem_aligned_check(vaddr, PDE_SIZE) && (vaddr_next <= vaddr_end)) {
+					/** Set 'effective_prot' to \a prot. The execute permission is only tweaked for
+					 *  the large page itself, so the 4-KByte pages mapped by later iterations keep
+					 *  the execute permission specified by \a prot. */
+					effective_prot = prot;
 					/** Call mem_ops->tweak_exe_right with the following parameters, in order to
 					 *  tweak the execute permission in 'effective_prot'.
 					 *  - &effective_prot
@@ -1133,10 +1326,10 @@ static void add_pde(const uint64_t *pdpte, uint64_t paddr_start, uint64_t vaddr_
 			 *  - paddr
 			 *  - vaddr
 			 *  - vaddr_end_each_iter
-			 *  - effective_prot
+			 *  - prot
 			 *  - mem_ops
 			 */
-			add_pte(pde, paddr, vaddr, vaddr_end_each_iter, effective_prot, mem_ops);
+			add_pte(pde, paddr, vaddr, vaddr_end_each_iter, prot, mem_ops);
 		}
 		/** If 'vaddr_next' is equal to or larger than \a vaddr_end, indicating that all PDEs
 		 *  associated with the specified input address space has been mapped. */
@@ -1211,9 +1404,9 @@ static void add_pdpte(const uint64_t *pml4e, uint64_t paddr_start, uint64_t vadd
 	 *  initialized as the return value of 'pdpte_index(vaddr)'. */
 	uint64_t index = pdpte_index(vaddr);
 	/** Declare the following local variables of type uint64_t.
-	 *  - effective_prot representing the properties that eventually set to a paging-structure entry,
-	 *  initialized as \a prot. */
-	uint64_t effective_prot = prot;
+	 *  - effective_prot representing the properties that eventually set to a paging-structure entry mapping a
+	 *  large page, not initialized. */
+	uint64_t effective_prot;
 	/** Declare the following local variables of type uint64_t.
 	 *  - vaddr_end_each_iter representing the address determining the end of the input address space to be mapped
 	 *  in each iteration, not initialized. */
@@ -1261,6 +1454,10 @@ static void add_pdpte(const uint64_t *pml4e, uint64_t paddr_start, uint64_t vadd
 				 */
 				if (mem_ops->large_page_enabled && mem_aligned_check(paddr, PDPTE_SIZE) &&
 					mem_aligned_check(vaddr, PDPTE_SIZE) && (vaddr_next <= vaddr_end)) {
+					/** Set 'effective_prot' to \a prot. The execute permission is only tweaked for
+					 *  the large page itself, so the 4-KByte pages mapped by later iterations keep
+					 *  the execute permission specified by \a prot. */
+					effective_prot = prot;
 					/** Call mem_ops->tweak_exe_right with the following parameters, in order to
 					 *  tweak the execute permission in 'effective_prot'.
 					 *  - &effective_prot
@@ -1315,10 +1512,10 @@ static void add_pdpte(const uint64_t *pml4e, uint64_t paddr_start, uint64_t vadd
 			 *  - paddr
 			 *  - vaddr
 			 *  - vaddr_end_each_iter
-			 *  - effective_prot
+			 *  - prot
 			 *  - mem_ops
 			 */
-			add_pde(pdpte, paddr, vaddr, vaddr_end_each_iter, effective_prot, mem_ops);
+			add_pde(pdpte, paddr, vaddr, vaddr_end_each_iter, prot, mem_ops);
 		}
 		/** If 'vaddr_next' is equal to or larger than \a vaddr_end, indicating that all PDEs
 		 *  associated with the specified input address space has been mapped. */
@@ -1595,6 +1792,7 @@ const uint64_t *lookup_address(uint64_t *pml4_page, uint64_t addr, uint64_t *pg_
  * @param[in] pml4_page Pointer to the PML4 page of the paging structure to be visited
  * @param[in] mem_ops A collection of function pointers to paging structure specific operations
  * @param[in] cb The callback for each entry that identifies a page frame
+ * @param[inout] data The context passed to each call of \a cb, which may be NULL
  *
  * @return None
  *
@@ -1611,7 +1809,7 @@ const uint64_t *lookup_address(uint64_t *pml4_page, uint64_t addr, uint64_t *pg_
  * @reentrancy Unspecified
  * @threadsafety Yes
  */
-void walk_page_table(uint64_t *pml4_page, const struct memory_ops *mem_ops, pge_handler cb)
+void walk_page_table(uint64_t *pml4_page, const struct memory_ops *mem_ops, pge_handler cb, void *data)
 {
 	/** Declare the following local variables of type uint64_t *.
 	 *  - pml4e representing the PML4 Table entry, not initialized.
@@ -1666,8 +1864,9 @@ void walk_page_table(uint64_t *pml4_page, const struct memory_ops *mem_ops, pge_
 				/** Call \a cb with following parameters to perform an action for this page entry.
 				 *  - pdpte
 				 *  - PDPTE_SIZE
+				 *  - data
 				 */
-				cb(pdpte, PDPTE_SIZE);
+				cb(pdpte, PDPTE_SIZE, data);
 				/** Continue this loop */
 				continue;
 			}
@@ -1696,8 +1895,9 @@ void walk_page_table(uint64_t *pml4_page, const struct memory_ops *mem_ops, pge_
 					 *  action for this page entry.
 					 *  - pde
 					 *  - PDE_SIZE
+					 *  - data
 					 */
-					cb(pde, PDE_SIZE);
+					cb(pde, PDE_SIZE, data);
 					/** Continue this loop */
 					continue;
 				}
@@ -1719,8 +1919,9 @@ void walk_page_table(uint64_t *pml4_page, const struct memory_ops *mem_ops, pge_
 						 *  for this page entry.
 						 *  - pte
 						 *  - PTE_SIZE
+						 *  - data
 						 */
-						cb(pte, PTE_SIZE);
+						cb(pte, PTE_SIZE, data);
 					}
 				}
 			}
@@ -41,6 +41,30 @@
  */
 static uint64_t trampoline_start16_paddr;
 
+/**
+ * @brief Data structure of a slot in the table of AP stacks looked up by the trampoline code.
+ *
+ * The layout (x2APIC ID at offset 0, stack top at offset 8) is hard-coded in trampoline.S.
+ *
+ * @consistency N/A
+ * @alignment 16
+ *
+ * @remark N/A
+ */
+struct trampoline_stack_slot {
+	uint32_t lapic_id; /**< x2APIC ID of the physical CPU owning the slot */
+	uint32_t reserved; /**< Reserved */
+	uint64_t stack; /**< Host linear address of the stack top, 0 terminates the table */
+} __aligned(16);
+
+/**
+ * @brief Table of AP stacks, packed densely over the APs being started.
+ *
+ * Each AP picks its own slot by x2APIC ID so that all APs can be started at the same time. The slot following the
+ * last one written always has a stack top of 0 and terminates the table.
+ */
+static struct trampoline_stack_slot trampoline_stack_slots[MAX_PCPU_NUM + 1U];
+
 /**
  * @brief Get the start address of the relocated trampoline section.
  *
@@ -142,12 +166,18 @@ static uint64_t trampoline_relo_addr(const void *addr)
 /**
  * @brief Prepare the stack to be used for the given AP.
  *
- *  Prepare the stack to be used for the given AP whose id is \a pcpu_id.
+ *  Prepare the stack to be used for the given AP whose id is \a pcpu_id in the slot \a slot_idx of
+ *  trampoline_stack_slots, so that the stacks of all APs can be prepared before any of them is started. The slot
+ *  following \a slot_idx is cleared to terminate the table, so the caller shall fill the slots in increasing order
+ *  starting from 0.
  *
+ * @param[in]    slot_idx The index of the slot to be written.
  * @param[in]    pcpu_id The CPU id of AP whose stack is to be setup.
  *
  * @return None
  *
+ * @pre slot_idx < MAX_PCPU_NUM
+ *
  * @mode HV_SUBMODE_INIT_PRE_SMP
  *
  * @remark As global variable trampoline_start16_paddr (which is set up in prepare_trampoline)
@@ -156,18 +186,18 @@ static uint64_t trampoline_relo_addr(const void *addr)
  * @reentrancy Unspecified
  * @threadsafety Unspecified
  */
-void write_trampoline_stack_sym(uint16_t pcpu_id)
+void write_trampoline_stack_sym(uint16_t slot_idx, uint16_t pcpu_id)
 {
-	/** Declare the following local variables of type uint64_t *.
-	 *  - hva representing the stack symbol address of secondary_cpu_stack that will be updated, not initialized. */
-	uint64_t *hva;
+	/** Declare the following local variables of type struct trampoline_stack_slot *.
+	 *  - slot representing the slot of trampoline_stack_slots to be written, initialized as
+	 *  &trampoline_stack_slots[slot_idx].
+	 *  - next representing the slot terminating the table, initialized as &trampoline_stack_slots[slot_idx + 1]. */
+	struct trampoline_stack_slot *slot = &trampoline_stack_slots[slot_idx];
+	struct trampoline_stack_slot *next = &trampoline_stack_slots[slot_idx + 1U];
 	/** Declare the following local variables of type uint64_t.
 	 *  - stack_sym_addr representing stack start address of the physical CPU, where the physical CPU id is
 	 *  \a pcpu_id, not initialized. */
 	uint64_t stack_sym_addr;
-	/** Set hva to the host virtual address translated from the value, where the value is calculated
-	 *  by plusing trampoline_start16_paddr and trampoline_relo_addr(secondary_cpu_stack). */
-	hva = (uint64_t *)(hpa2hva(trampoline_start16_paddr + trampoline_relo_addr(secondary_cpu_stack)));
 
 	/** Set stack_sym_addr to the address of the stack field of the pcpu_id-th element in the per-CPU region, where
 	 *  pcpu_id is calculated by subtracting 1 from PCPU_STACK_SIZE, where the CPU's id is pcpu_id.  */
@@ -177,12 +207,21 @@ void write_trampoline_stack_sym(uint16_t pcpu_id)
 	 *  Clear the lower bits of stack_sym_addr to make it align with CPU_STACK_ALIGN.
 	 *  If bit x is 1 in 'CPU_STACK_ALIGN - 1', then, bit x needs to be cleared in stack_sym_addr. */
 	stack_sym_addr &= ~(CPU_STACK_ALIGN - 1UL);
-	/** Set *hva to stack_sym_addr. */
-	*hva = stack_sym_addr;
-
-	/** Call clflush with the following parameters, in order to flush cache line associated with 'hva'.
-	 *  - hva */
-	clflush(hva);
+	/** Set slot->lapic_id to per_cpu(lapic_id, pcpu_id). */
+	slot->lapic_id = per_cpu(lapic_id, pcpu_id);
+	/** Set slot->stack to stack_sym_addr. */
+	slot->stack = stack_sym_addr;
+	/** Set next->lapic_id to 0. */
+	next->lapic_id = 0U;
+	/** Set next->stack to 0. */
+	next->stack = 0UL;
+
+	/** Call clflush with the following parameters, in order to flush cache line associated with 'slot'.
+	 *  - slot */
+	clflush(slot);
+	/** Call clflush with the following parameters, in order to flush cache line associated with 'next'.
+	 *  - next */
+	clflush(next);
 }
 
 /**
@@ -265,6 +304,13 @@ static void update_trampoline_code_refs(uint64_t dest_pa)
 	/** Increase the contents in the memory region(64-bit) pointed by ptr
 	 *  by the return value of get_hv_image_delta() */
 	*(uint64_t *)ptr += get_hv_image_delta();
+
+	/* point the trampoline to the table of AP stacks */
+	/** Set ptr to the host virtual address translated from the value, where the value is calculated
+	 *  by plusing dest_pa and trampoline_relo_addr(secondary_cpu_stack). */
+	ptr = hpa2hva(dest_pa + trampoline_relo_addr(secondary_cpu_stack));
+	/** Set the contents in the memory region(64-bit) pointed by ptr to the address of trampoline_stack_slots */
+	*(uint64_t *)ptr = (uint64_t)trampoline_stack_slots;
 }
 
 /**
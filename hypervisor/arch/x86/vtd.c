@@ -19,6 +19,9 @@
 #include <io.h>
 #include <mmu.h>
 #include <lapic.h>
+#include <cpu_caps.h>
+#include <cpufeatures.h>
+#include <atomic.h>
 #include <vtd.h>
 #include <timer.h>
 #include <logmsg.h>
@@ -44,6 +47,8 @@
  * - 'hwmgmt.cpu' module depends on this module to initialize the remapping hardware and enable DMA remapping.
  * - 'hwmgmt.page' module depends on this module to flush cache lines that contain the specified memory region.
  * - 'vp-base.vm' module depends on this module to destroy an IOMMU domain.
+ * - 'vp-base.guest-mem' module depends on this module to invalidate the IOTLB entries caching a guest physical range
+ * whose EPT mappings are modified or deleted.
  * - 'vp-dm.ptirq' module depends on this module to assign and free the specified interrupt remapping entry.
  * - 'vp-dm.vperipheral' module depends on this module to create the IOMMU domains, assign the specified PCI device
  * to an IOMMU domain, and remove the specified PCI device from an IOMMU domain.
@@ -66,8 +71,9 @@
  * It also defines some helper functions to implement the features that are commonly used in this file.
  * In addition, it defines some decomposed functions to improve the readability of the code.
  *
- * External functions include: iommu_flush_cache, add_iommu_device, remove_iommu_device, create_iommu_domain,
- * destroy_iommu_domain, enable_iommu, init_iommu, dmar_assign_irte, and dmar_free_irte.
+ * External functions include: iommu_flush_cache, iommu_get_flushes_avoided, add_iommu_device, remove_iommu_device,
+ * iommu_invalidate_range, create_iommu_domain, destroy_iommu_domain, enable_iommu, init_iommu, dmar_assign_irte,
+ * and dmar_free_irte.
  *
  * Decomposed functions include: register_hrhd_units, dmar_register_hrhd, dmar_set_intr_remap_table,
  * dmar_set_root_table, dmar_prepare, dmar_enable, and get_dmar_info.
@@ -81,9 +87,11 @@
  * Helper functions to access remapping registers include: iommu_read32, iommu_write32, iommu_write64, and
  * dmar_wait_completion.
  *
- * Helper functions to invalidate the cache on remapping hardware include: dmar_issue_qi_request,
- * dmar_invalid_context_cache, dmar_invalid_context_cache_global, dmar_invalid_iotlb, dmar_invalid_iotlb_global,
- * dmar_invalid_iec, and dmar_invalid_iec_global.
+ * Helper functions to flush the processor cache for remapping hardware include: dmar_flush_cache.
+ *
+ * Helper functions to invalidate the cache on remapping hardware include: dmar_qi_wait, dmar_qi_submit,
+ * dmar_qi_queue_desc, dmar_iotlb_psi_am, dmar_invalid_context_cache, dmar_invalid_context_cache_global,
+ * dmar_invalid_iotlb, dmar_invalid_iotlb_global, dmar_invalid_iec, and dmar_invalid_iec_global.
  *
  * Helper functions to enable or disable the specified functionality include: dmar_enable_intr_remapping,
  * dmar_enable_qi, dmar_enable_translation, and dmar_disable_translation.
@@ -285,6 +293,18 @@ static inline uint64_t dmar_set_bitslice(uint64_t var, uint64_t mask, uint32_t p
  * @brief The size (in bytes) of each invalidation descriptor submitted into invalidation queue.
  */
 #define DMAR_QI_INV_ENTRY_SIZE       16U
+/**
+ * @brief The maximum number of invalidation descriptors that could be queued before one Invalidation Wait Descriptor.
+ *
+ * One slot of the invalidation queue is always reserved for the Invalidation Wait Descriptor closing a batch.
+ */
+#define DMAR_QI_BATCH_MAX            ((DMAR_INVALIDATION_QUEUE_SIZE / DMAR_QI_INV_ENTRY_SIZE) - 1U)
+/**
+ * @brief The maximum number of page-selective IOTLB invalidate descriptors used for one guest physical range.
+ *
+ * A range needing more descriptors is invalidated with one domain-selective invalidation instead.
+ */
+#define DMAR_IOTLB_PSI_MAX           8U
 /**
  * @brief The number of DMA/interrupt remapping entries contained in one 4-KByte page.
  */
@@ -428,13 +448,36 @@ enum dmar_iirg_type {
 	/**
 	 * @brief Page-Selective-within-Domain Invalidation.
 	 *
-	 * Refer to VT-d specification for details about this granularity.
-	 * It is not used in current scope, keeping it here for future scope extension.
-	 *
+	 * With this granularity, IOTLB entries caching mappings within the naturally aligned address range specified
+	 * by the address and the address mask are invalidated for the specified domain-id, together with the
+	 * paging-structure-cache entries covering that range (unless the invalidation hint is set).
 	 */
 	DMAR_IIRG_PAGE
 };
 
+/**
+ * @brief Enumeration type to indicate how the cache lines of remapping structures are written back to memory.
+ *
+ * It is supposed to be used when hypervisor makes the updates on root table, context table, interrupt remapping
+ * table or second-level translation table visible to remapping hardware.
+ *
+ * @remark N/A
+ */
+enum dmar_flush_policy {
+	/**
+	 * @brief No flush is needed since remapping hardware snoops the processor caches (page-walk coherency).
+	 */
+	DMAR_FLUSH_NONE = 0,
+	/**
+	 * @brief Flush with CLFLUSHOPT on each cache line followed by one fence for the whole region.
+	 */
+	DMAR_FLUSH_CLFLUSHOPT,
+	/**
+	 * @brief Flush with the serialized CLFLUSH on each cache line.
+	 */
+	DMAR_FLUSH_CLFLUSH
+};
+
 /**
  * @brief Data structure to store the runtime information for each DRHD structure.
  *
@@ -479,6 +522,22 @@ struct dmar_drhd_rt {
 	 * @brief The offset to the invalidation queue for the command that will be written next by software.
 	 */
 	uint16_t qi_tail;
+	/**
+	 * @brief The number of invalidation descriptors queued by software but not yet submitted to hardware.
+	 */
+	uint16_t qi_pending;
+	/**
+	 * @brief The cached content of Capability Register.
+	 */
+	uint64_t cap;
+	/**
+	 * @brief The cached content of Extended Capability Register.
+	 */
+	uint64_t ecap;
+	/**
+	 * @brief The policy used to flush the cache lines of remapping structures referenced by this DRHD structure.
+	 */
+	enum dmar_flush_policy flush_policy;
 
 	/**
 	 * @brief The cached content of Global Command Register.
@@ -720,7 +779,7 @@ static inline union dmar_ir_entry *get_ir_table(uint32_t dmar_index)
  *
  * Thus, the second element in 'dmar_drhd_units' is referenced directly at runtime to eliminate the effort to
  * look for the corresponding DRHD structure. This policy applies to following functions: add_iommu_device,
- * remove_iommu_device, dmar_assign_irte, and dmar_free_irte.
+ * remove_iommu_device, iommu_invalidate_range, dmar_assign_irte, and dmar_free_irte.
  */
 static struct dmar_drhd_rt dmar_drhd_units[DRHD_COUNT];
 
@@ -730,6 +789,19 @@ static struct dmar_drhd_rt dmar_drhd_units[DRHD_COUNT];
  */
 static struct dmar_info *platform_dmar_info = NULL;
 
+/**
+ * @brief The policy used to flush the cache lines of second-level translation tables.
+ *
+ * The second-level translation tables are shared among all DRHD structures which are not ignored, thus it is the
+ * strictest policy among them. It is the serialized CLFLUSH until all DRHD structures are registered.
+ */
+static enum dmar_flush_policy iommu_flush_policy = DMAR_FLUSH_CLFLUSH;
+
+/**
+ * @brief The number of cache flush requests skipped because remapping hardware is page-walk coherent.
+ */
+static uint64_t iommu_flushes_avoided;
+
 /**
  * @brief The maximum number of IOMMU domains.
  *
@@ -799,6 +871,10 @@ static void register_hrhd_units(void)
 	/** Declare the following local variables of type uint32_t.
 	 *  - i representing the loop counter as DRHD index, not initialized. */
 	uint32_t i;
+	/** Declare the following local variables of type 'enum dmar_flush_policy'.
+	 *  - policy representing the strictest flush policy among the DRHD structures which are not ignored,
+	 *  initialized as DMAR_FLUSH_NONE. */
+	enum dmar_flush_policy policy = DMAR_FLUSH_NONE;
 
 	/** For each 'i' ranging from 0 to 'platform_dmar_info->drhd_count - 1' [with a step of 1] */
 	for (i = 0U; i < platform_dmar_info->drhd_count; i++) {
@@ -823,7 +899,16 @@ static void register_hrhd_units(void)
 		 *  associated with 'drhd_rt' in hypervisor.
 		 *  - drhd_rt */
 		dmar_register_hrhd(drhd_rt);
+
+		/** If 'drhd_rt->drhd->ignore' is false and 'drhd_rt->flush_policy' is stricter than 'policy' */
+		if (!drhd_rt->drhd->ignore && (drhd_rt->flush_policy > policy)) {
+			/** Set 'policy' to 'drhd_rt->flush_policy' */
+			policy = drhd_rt->flush_policy;
+		}
 	}
+
+	/** Set 'iommu_flush_policy' to 'policy' */
+	iommu_flush_policy = policy;
 }
 
 /**
@@ -1033,10 +1118,16 @@ static inline void dmar_wait_completion(
 }
 
 /**
- * @brief Flush cache lines that contain the specified memory region.
+ * @brief Make the updates on the specified memory region visible to remapping hardware with the given policy.
  *
- * It is supposed to be called when root table, context table or second-level translation table is updated.
+ * With DMAR_FLUSH_NONE, nothing is flushed and the skipped request is counted in 'iommu_flushes_avoided'.
+ * With DMAR_FLUSH_CLFLUSHOPT, each cache line is flushed with CLFLUSHOPT and one fence is issued for the whole
+ * region. With DMAR_FLUSH_CLFLUSH, each cache line is flushed with the serialized CLFLUSH.
  *
+ * It is supposed to be called when root table, context table, interrupt remapping table or second-level translation
+ * table is updated.
+ *
+ * @param[in] policy The flush policy to be applied.
  * @param[in] p The base address of the memory region whose corresponding cache lines need to be invalidated.
  * @param[in] size The size of the memory region whose corresponding cache lines need to be invalidated.
  *
@@ -1046,30 +1137,116 @@ static inline void dmar_wait_completion(
  *
  * @post N/A
  *
- * @mode HV_SUBMODE_INIT_ROOT, HV_OPERATIONAL
+ * @mode HV_SUBMODE_INIT_PRE_SMP, HV_SUBMODE_INIT_ROOT, HV_OPERATIONAL
  *
  * @remark N/A
  *
  * @reentrancy Unspecified
  * @threadsafety The memory region specified by \a p and \a size is not overlapped among parallel invocation.
  */
-void iommu_flush_cache(const void *p, uint32_t size)
+static void dmar_flush_cache(enum dmar_flush_policy policy, const void *p, uint32_t size)
 {
-
 	/** Declare the following local variables of type uint32_t.
 	 *  - i representing the loop counter and it is used to calculate the base address of a memory region,
 	 *  not initialized. */
 	uint32_t i;
 
-	/** For each 'i' ranging from 0 to '(size - 1) / CACHE_LINE_SIZE' [with a step of CACHE_LINE_SIZE] */
-	for (i = 0U; i < size; i += CACHE_LINE_SIZE) {
-		/** Call clflush with the following parameters, in order to flush the cache line that contains the
-		 *  memory region whose base address is specified by '(const char *)p + i'.
-		 *  - (const char *)p + i */
-		clflush((const char *)p + i);
+	/** Depending on \a policy */
+	switch (policy) {
+	/** \a policy is DMAR_FLUSH_NONE */
+	case DMAR_FLUSH_NONE:
+		/** Call atomic_inc64 with the following parameters, in order to count the skipped flush request.
+		 *  - &iommu_flushes_avoided */
+		atomic_inc64(&iommu_flushes_avoided);
+		/** End of case */
+		break;
+	/** \a policy is DMAR_FLUSH_CLFLUSHOPT */
+	case DMAR_FLUSH_CLFLUSHOPT:
+		/** For each 'i' ranging from 0 to '(size - 1) / CACHE_LINE_SIZE' [with a step of CACHE_LINE_SIZE] */
+		for (i = 0U; i < size; i += CACHE_LINE_SIZE) {
+			/** Call clflushopt with the following parameters, in order to flush the cache line that
+			 *  contains the memory region whose base address is specified by '(const char *)p + i'.
+			 *  - (const char *)p + i */
+			clflushopt((const char *)p + i);
+		}
+		/** Call cpu_write_memory_barrier without any parameters, in order to order all the CLFLUSHOPT above
+		 *  before any later access to remapping hardware. */
+		cpu_write_memory_barrier();
+		/** End of case */
+		break;
+	/** Otherwise */
+	default:
+		/** For each 'i' ranging from 0 to '(size - 1) / CACHE_LINE_SIZE' [with a step of CACHE_LINE_SIZE] */
+		for (i = 0U; i < size; i += CACHE_LINE_SIZE) {
+			/** Call clflush with the following parameters, in order to flush the cache line that contains
+			 *  the memory region whose base address is specified by '(const char *)p + i'.
+			 *  - (const char *)p + i */
+			clflush((const char *)p + i);
+		}
+		/** End of case */
+		break;
 	}
 }
 
+/**
+ * @brief Flush cache lines that contain the specified memory region.
+ *
+ * The cache lines are flushed according to 'iommu_flush_policy', which is derived from the page-walk coherency of
+ * all DRHD structures that are not ignored.
+ *
+ * It is supposed to be called when the second-level translation table is updated.
+ *
+ * @param[in] p The base address of the memory region whose corresponding cache lines need to be invalidated.
+ * @param[in] size The size of the memory region whose corresponding cache lines need to be invalidated.
+ *
+ * @return None
+ *
+ * @pre p != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_ROOT, HV_OPERATIONAL
+ *
+ * @remark N/A
+ *
+ * @reentrancy Unspecified
+ * @threadsafety The memory region specified by \a p and \a size is not overlapped among parallel invocation.
+ */
+void iommu_flush_cache(const void *p, uint32_t size)
+{
+	/** Call dmar_flush_cache with the following parameters, in order to flush the cache lines that contain the
+	 *  specified memory region with the policy of the second-level translation tables.
+	 *  - iommu_flush_policy
+	 *  - p
+	 *  - size
+	 */
+	dmar_flush_cache(iommu_flush_policy, p, size);
+}
+
+/**
+ * @brief Get the number of cache flush requests skipped because remapping hardware is page-walk coherent.
+ *
+ * It is supposed to be called by the debug shell.
+ *
+ * @return The number of skipped cache flush requests since boot.
+ *
+ * @pre N/A
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark N/A
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+uint64_t iommu_get_flushes_avoided(void)
+{
+	/** Return 'iommu_flushes_avoided' */
+	return iommu_flushes_avoided;
+}
+
 /**
  * @brief Calculate the number of page walk levels corresponding to the given AGAW.
  *
@@ -1387,6 +1564,34 @@ static void dmar_register_hrhd(struct dmar_drhd_rt *dmar_unit)
 	/** Set 'dmar_unit->gcmd' to bitwise AND the return value of iommu_read32(dmar_unit, DMAR_GSTS_REG) by
 	 *  DMAR_GSTS_REG_MASK */
 	dmar_unit->gcmd = iommu_read32(dmar_unit, DMAR_GSTS_REG) & DMAR_GSTS_REG_MASK;
+	/** Set 'dmar_unit->cap' to the 64-bit content of Capability Register associated with \a dmar_unit, which is
+	 *  read as two 32-bit halves */
+	dmar_unit->cap = ((uint64_t)iommu_read32(dmar_unit, DMAR_CAP_REG + 4U) << 32U) |
+		(uint64_t)iommu_read32(dmar_unit, DMAR_CAP_REG);
+	/** Set 'dmar_unit->ecap' to the 64-bit content of Extended Capability Register associated with \a dmar_unit,
+	 *  which is read as two 32-bit halves */
+	dmar_unit->ecap = ((uint64_t)iommu_read32(dmar_unit, DMAR_ECAP_REG + 4U) << 32U) |
+		(uint64_t)iommu_read32(dmar_unit, DMAR_ECAP_REG);
+
+	/** If C (Page-walk Coherency) field (Bit 0) in 'dmar_unit->ecap' is 1 */
+	if ((dmar_unit->ecap & DMA_ECAP_C) != 0UL) {
+		/** Set 'dmar_unit->flush_policy' to DMAR_FLUSH_NONE, since hardware snoops the processor caches when
+		 *  it walks the remapping structures */
+		dmar_unit->flush_policy = DMAR_FLUSH_NONE;
+	} else if (pcpu_has_cap(X86_FEATURE_CLFLUSHOPT)) {
+		/** Set 'dmar_unit->flush_policy' to DMAR_FLUSH_CLFLUSHOPT */
+		dmar_unit->flush_policy = DMAR_FLUSH_CLFLUSHOPT;
+	} else {
+		/** Set 'dmar_unit->flush_policy' to DMAR_FLUSH_CLFLUSH */
+		dmar_unit->flush_policy = DMAR_FLUSH_CLFLUSH;
+	}
+	/** Logging the following information with a log level of ACRN_DBG_IOMMU.
+	 *  - dmar_unit->index
+	 *  - dmar_unit->ecap
+	 *  - dmar_unit->flush_policy
+	 */
+	dev_dbg(ACRN_DBG_IOMMU, "dmar unit [%d] ecap 0x%lx flush policy %d", dmar_unit->index, dmar_unit->ecap,
+		dmar_unit->flush_policy);
 
 	/** Call dmar_disable_translation with the following parameters, in order to disable DMA remapping on
 	 *  the DRHD structure specified by \a dmar_unit (if it's not disabled yet).
@@ -1395,19 +1600,181 @@ static void dmar_register_hrhd(struct dmar_drhd_rt *dmar_unit)
 }
 
 /**
- * @brief Submit the specified invalidation request to hardware and wait until hardware completes it.
+ * @brief Wait until hardware writes the completion status to the specified status word.
+ *
+ * If the physical CPU supports MONITOR/MWAIT, the status word is armed with MONITOR and the physical CPU enters an
+ * optimized state with MWAIT until hardware writes it. Otherwise, the status word is polled with PAUSE in between.
+ *
+ * It is supposed to be called only by 'dmar_qi_submit'.
+ *
+ * @param[in] qi_status A pointer to the status word of an Invalidation Wait Descriptor.
+ *
+ * @return The number of TSC cycles spent in waiting.
+ *
+ * @pre qi_status != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_PRE_SMP, HV_SUBMODE_INIT_ROOT, HV_OPERATIONAL
+ *
+ * @remark If hardware does not complete the descriptors within CYCLES_PER_MS TSC cycles, the timeout is logged
+ *	   once and the system is halted by panic(), instead of spinning forever with the DMAR lock held.
+ *
+ * @reentrancy Unspecified
+ * @threadsafety When \a qi_status is different among parallel invocation.
+ */
+static uint64_t dmar_qi_wait(volatile const uint32_t *qi_status)
+{
+	/** Declare the following local variables of type uint64_t.
+	 *  - start representing the TSC value right before hypervisor starts waiting, initialized as the return value
+	 *  of 'rdtsc()'. */
+	uint64_t start = rdtsc();
+	/** Declare the following local variables of type bool.
+	 *  - use_mwait representing whether MONITOR/MWAIT is used to wait, initialized as the return value of
+	 *  'has_monitor_cap()'. */
+	bool use_mwait = has_monitor_cap();
+
+	/** Until '*qi_status' is equal to DMAR_INV_STATUS_COMPLETED */
+	while (*qi_status != DMAR_INV_STATUS_COMPLETED) {
+		/** If 'use_mwait' is true */
+		if (use_mwait) {
+			/** Call asm_monitor with the following parameters, in order to let the status word pointed by
+			 *  \a qi_status be monitored by hardware.
+			 *  - qi_status
+			 *  - 0
+			 *  - 0 */
+			asm_monitor(qi_status, 0UL, 0UL);
+			/** If '*qi_status' is still not equal to DMAR_INV_STATUS_COMPLETED */
+			if (*qi_status != DMAR_INV_STATUS_COMPLETED) {
+				/** Call asm_mwait with the following parameters, in order to enter an
+				 *  implementation-dependent optimized state until hardware writes the status word.
+				 *  - 0
+				 *  - 0 */
+				asm_mwait(0UL, 0UL);
+			}
+		} else {
+			/** Call asm_pause without any parameters, in order to improve processor performance in this
+			 *  spin-wait loop. */
+			asm_pause();
+		}
+
+		/** If 'rdtsc() - start' is larger than CYCLES_PER_MS */
+		if ((rdtsc() - start) > CYCLES_PER_MS) {
+			/** Call panic() with the following parameters, in order to log the timeout once and halt
+			 *  the system, as the remapping structures can not be reused safely anymore.
+			 *  - "DMAR OP Timeout! @ %s"
+			 *  - __func__ */
+			panic("DMAR OP Timeout! @ %s", __func__);
+		}
+	}
+
+	/** Return 'rdtsc() - start' */
+	return rdtsc() - start;
+}
+
+/**
+ * @brief Submit all queued invalidation descriptors to hardware and wait until hardware completes them.
+ *
+ * One Invalidation Wait Descriptor is appended behind the descriptors queued by 'dmar_qi_queue_desc' and
+ * Invalidation Queue Tail Register is written once, so that the whole batch costs a single round trip to hardware.
+ * Nothing is done if no descriptor is queued.
+ *
+ * It is supposed to be called when hypervisor completes queuing invalidation requests.
+ *
+ * @param[inout] dmar_unit A pointer to a data structure that stores the runtime information for the specified
+ *                         DRHD structure where the invalidation requests are submitted to.
+ *
+ * @return None
+ *
+ * @pre dmar_unit != NULL
+ * @pre dmar_unit->drhd != NULL
+ * @pre The current physical CPU holds dmar_unit->lock.
+ *
+ * @post dmar_unit->qi_pending == 0
+ *
+ * @mode HV_SUBMODE_INIT_PRE_SMP, HV_SUBMODE_INIT_ROOT, HV_OPERATIONAL
+ *
+ * @remark N/A
+ *
+ * @reentrancy Unspecified
+ * @threadsafety When \a dmar_unit is different among parallel invocation.
+ */
+static void dmar_qi_submit(struct dmar_drhd_rt *dmar_unit)
+{
+	/** Declare the following local variables of type 'struct dmar_entry *'.
+	 *  - invalidate_desc_ptr representing a pointer to an invalidation descriptor, not initialized. */
+	struct dmar_entry *invalidate_desc_ptr;
+	/** Declare the following local variables of type uint32_t.
+	 *  - qi_status representing the queued invalidation status, initialized as DMAR_INV_STATUS_INCOMPLETE. */
+	volatile uint32_t qi_status = DMAR_INV_STATUS_INCOMPLETE;
+	/** Declare the following local variables of type uint64_t.
+	 *  - cycles representing the TSC cycles spent in waiting for hardware, not initialized.
+	 *  (This variable is only used for debug purpose.) */
+	__unused uint64_t cycles;
+
+	/** If 'dmar_unit->qi_pending' is not equal to 0, indicating that there are queued invalidation descriptors */
+	if (dmar_unit->qi_pending != 0U) {
+		/** Set 'invalidate_desc_ptr' to 'dmar_unit->qi_queue + dmar_unit->qi_tail / DMAR_QI_INV_ENTRY_SIZE',
+		 *  which is the pointer to the invalidation descriptor in the invalidation queue to be written next by
+		 *  software. It would be an Invalidation Wait Descriptor which is used to check whether hardware
+		 *  completes all invalidation requests or not. */
+		invalidate_desc_ptr = dmar_unit->qi_queue + (dmar_unit->qi_tail / DMAR_QI_INV_ENTRY_SIZE);
+
+		/** Set 'invalidate_desc_ptr->hi_64' to the return value of 'hva2hpa(&qi_status)', which is the
+		 *  host physical address of 'qi_status' and it specifies the Status Address field in the
+		 *  Invalidation Wait Descriptor. The value of 'qi_status' will be used to check if the hardware
+		 *  completes the invalidation requests. */
+		invalidate_desc_ptr->hi_64 = hva2hpa((void *)&qi_status);
+		/** Set 'invalidate_desc_ptr->lo_64' to DMAR_INV_WAIT_DESC_LOWER */
+		invalidate_desc_ptr->lo_64 = DMAR_INV_WAIT_DESC_LOWER;
+		/** Set 'dmar_unit->qi_tail' to
+		 *  '(dmar_unit->qi_tail + DMAR_QI_INV_ENTRY_SIZE) % DMAR_INVALIDATION_QUEUE_SIZE', which specifies the
+		 *  new base address of the invalidation queue tail. */
+		dmar_unit->qi_tail = (dmar_unit->qi_tail + DMAR_QI_INV_ENTRY_SIZE) % DMAR_INVALIDATION_QUEUE_SIZE;
+
+		/** Call iommu_write32 with the following parameters, in order to write 'dmar_unit->qi_tail' to
+		 *  Invalidation Queue Tail Register associated with \a dmar_unit.
+		 *  At this moment, all queued invalidation requests are submitted to hardware.
+		 *  - dmar_unit
+		 *  - DMAR_IQT_REG
+		 *  - dmar_unit->qi_tail
+		 */
+		iommu_write32(dmar_unit, DMAR_IQT_REG, dmar_unit->qi_tail);
+
+		/** Set 'cycles' to the return value of 'dmar_qi_wait(&qi_status)', which is the number of TSC cycles
+		 *  spent until hardware completes all submitted invalidation requests */
+		cycles = dmar_qi_wait(&qi_status);
+		/** Logging the following information with a log level of ACRN_DBG_IOMMU.
+		 *  - dmar_unit->qi_pending
+		 *  - cycles
+		 */
+		dev_dbg(ACRN_DBG_IOMMU, "qi: %hu descriptors completed in %lu cycles", dmar_unit->qi_pending, cycles);
+
+		/** Set 'dmar_unit->qi_pending' to 0 */
+		dmar_unit->qi_pending = 0U;
+	}
+}
+
+/**
+ * @brief Queue the specified invalidation descriptor into the invalidation queue without submitting it.
+ *
+ * The descriptor is written at the software tail of the invalidation queue, but Invalidation Queue Tail Register is
+ * not updated, so hardware does not fetch it until 'dmar_qi_submit' is called. This allows a caller to batch several
+ * invalidation descriptors behind one Invalidation Wait Descriptor and one tail register write.
+ * If the queue is about to be filled up, the descriptors queued so far are submitted first.
  *
  * It is supposed to be called when hypervisor attempts to invalidate the context cache, the interrupt entry cache,
  * and the IOTLB and paging structure caches.
  *
  * @param[inout] dmar_unit A pointer to a data structure that stores the runtime information for the specified
- *                         DRHD structure where the invalidation request is submitted to.
+ *                         DRHD structure where the invalidation request is queued to.
  * @param[in] invalidate_desc The specified invalidation descriptor.
  *
  * @return None
  *
  * @pre dmar_unit != NULL
  * @pre dmar_unit->drhd != NULL
+ * @pre The current physical CPU holds dmar_unit->lock.
  *
  * @post N/A
  *
@@ -1418,18 +1785,21 @@ static void dmar_register_hrhd(struct dmar_drhd_rt *dmar_unit)
  * @reentrancy Unspecified
  * @threadsafety When \a dmar_unit is different among parallel invocation.
  */
-static void dmar_issue_qi_request(struct dmar_drhd_rt *dmar_unit, struct dmar_entry invalidate_desc)
+static void dmar_qi_queue_desc(struct dmar_drhd_rt *dmar_unit, struct dmar_entry invalidate_desc)
 {
 	/** Declare the following local variables of type 'struct dmar_entry *'.
 	 *  - invalidate_desc_ptr representing a pointer to an invalidation descriptor, not initialized. */
 	struct dmar_entry *invalidate_desc_ptr;
-	/** Declare the following local variables of type uint32_t.
-	 *  - qi_status representing the queued invalidation status, not initialized. */
-	uint32_t qi_status;
-	/** Declare the following local variables of type uint64_t.
-	 *  - 'start' representing the TSC value right after hypervisor submits the invalidation request to hardware,
-	 *  not initialized. (This variable is only used for debug purpose.) */
-	__unused uint64_t start;
+
+	/** If 'dmar_unit->qi_pending' is equal to DMAR_QI_BATCH_MAX, indicating that only the slot reserved for
+	 *  the Invalidation Wait Descriptor is left in the invalidation queue */
+	if (dmar_unit->qi_pending == DMAR_QI_BATCH_MAX) {
+		/** Call dmar_qi_submit with the following parameters, in order to submit the queued invalidation
+		 *  descriptors to hardware and wait until hardware completes them.
+		 *  - dmar_unit
+		 */
+		dmar_qi_submit(dmar_unit);
+	}
 
 	/** Set 'invalidate_desc_ptr' to 'dmar_unit->qi_queue + dmar_unit->qi_tail / DMAR_QI_INV_ENTRY_SIZE', which is
 	 *  the pointer to the invalidation descriptor in the invalidation queue to be written next by software. */
@@ -1446,60 +1816,19 @@ static void dmar_issue_qi_request(struct dmar_drhd_rt *dmar_unit, struct dmar_en
 	 *  circular buffer and the size of each entry inside it is DMAR_QI_INV_ENTRY_SIZE.)
 	 */
 	dmar_unit->qi_tail = (dmar_unit->qi_tail + DMAR_QI_INV_ENTRY_SIZE) % DMAR_INVALIDATION_QUEUE_SIZE;
-
-	/** Set 'invalidate_desc_ptr' to 'dmar_unit->qi_queue + dmar_unit->qi_tail / DMAR_QI_INV_ENTRY_SIZE', which is
-	 *  the pointer to the invalidation descriptor in the invalidation queue to be written next by software.
-	 *  It would be an Invalidation Wait Descriptor which is used to check whether hardware completes
-	 *  all invalidation requests or not. */
-	invalidate_desc_ptr = dmar_unit->qi_queue + (dmar_unit->qi_tail / DMAR_QI_INV_ENTRY_SIZE);
-
-	/** Set 'invalidate_desc_ptr->hi_64' to the return value of 'hva2hpa(&qi_status)', which is the
-	 *  host physical address of 'qi_status' and it specifies the Status Address field in the
-	 *  Invalidation Wait Descriptor. The value of 'qi_status' will be used to check if the hardware completes
-	 *  the invalidation requests. */
-	invalidate_desc_ptr->hi_64 = hva2hpa(&qi_status);
-	/** Set 'invalidate_desc_ptr->lo_64' to DMAR_INV_WAIT_DESC_LOWER */
-	invalidate_desc_ptr->lo_64 = DMAR_INV_WAIT_DESC_LOWER;
-	/** Set 'dmar_unit->qi_tail' to '(dmar_unit->qi_tail + DMAR_QI_INV_ENTRY_SIZE) % DMAR_INVALIDATION_QUEUE_SIZE',
-	 *  which specifies the new base address of the invalidation queue tail. (The invalidation queue is a
-	 *  circular buffer and the size of each entry inside it is DMAR_QI_INV_ENTRY_SIZE.)
-	 */
-	dmar_unit->qi_tail = (dmar_unit->qi_tail + DMAR_QI_INV_ENTRY_SIZE) % DMAR_INVALIDATION_QUEUE_SIZE;
-
-	/** Set 'qi_status' to DMAR_INV_STATUS_INCOMPLETE */
-	qi_status = DMAR_INV_STATUS_INCOMPLETE;
-	/** Call iommu_write32 with the following parameters, in order to write 'dmar_unit->qi_tail' to
-	 *  Invalidation Queue Tail Register associated with \a dmar_unit.
-	 *  At this moment, the invalidation requests are submitted to hardware.
-	 *  - dmar_unit
-	 *  - DMAR_IQT_REG
-	 *  - dmar_unit->qi_tail
-	 */
-	iommu_write32(dmar_unit, DMAR_IQT_REG, dmar_unit->qi_tail);
-
-	/** Set 'start' to the return value of 'rdtsc()' */
-	start = rdtsc();
-	/** Until 'qi_status' is equal to DMAR_INV_STATUS_COMPLETED */
-	while (qi_status != DMAR_INV_STATUS_COMPLETED) {
-		/** If 'rdtsc() - start' is larger than CYCLES_PER_MS */
-		if ((rdtsc() - start) > CYCLES_PER_MS) {
-			/** Logging the following information with a log level of 3.
-			 *  - __func__ */
-			pr_err("DMAR OP Timeout! @ %s", __func__);
-		}
-		/** Call asm_pause without any parameters, in order to improve processor performance in this
-		 *  spin-wait loop. */
-		asm_pause();
-	}
+	/** Increment 'dmar_unit->qi_pending' by 1 */
+	dmar_unit->qi_pending++;
 }
 
 /**
- * @brief Submit the specified context cache invalidation request to hardware and wait until hardware completes it.
+ * @brief Queue the specified context cache invalidation request to hardware.
+ *
+ * The request takes effect after the caller submits it via 'dmar_qi_submit'.
  *
  * It is supposed to be called when hypervisor attempts to invalidate the context cache.
  *
  * @param[inout] dmar_unit A pointer to a data structure that stores the runtime information for the specified
- *                         DRHD structure where the invalidation request is submitted to.
+ *                         DRHD structure where the invalidation request is queued to.
  * @param[in] did The specified value for Domain ID field, which is to be set to a context cache invalidate descriptor.
  * @param[in] sid The specified value for Source ID field, which is to be set to a context cache invalidate descriptor.
  * @param[in] fm The specified value for Function Mask field, which is to be set to a context cache invalidate
@@ -1511,6 +1840,7 @@ static void dmar_issue_qi_request(struct dmar_drhd_rt *dmar_unit, struct dmar_en
  *
  * @pre dmar_unit != NULL
  * @pre dmar_unit->drhd != NULL
+ * @pre The current physical CPU holds dmar_unit->lock.
  * @pre (cirg == DMAR_CIRG_GLOBAL) || (cirg == DMAR_CIRG_DEVICE)
  *
  * @post N/A
@@ -1520,7 +1850,7 @@ static void dmar_issue_qi_request(struct dmar_drhd_rt *dmar_unit, struct dmar_en
  * @remark N/A
  *
  * @reentrancy Unspecified
- * @threadsafety Yes
+ * @threadsafety When \a dmar_unit is different among parallel invocation.
  */
 static void dmar_invalid_context_cache(
 	struct dmar_drhd_rt *dmar_unit, uint16_t did, uint16_t sid, uint8_t fm, enum dmar_cirg_type cirg)
@@ -1568,40 +1898,30 @@ static void dmar_invalid_context_cache(
 
 	/** If 'invalidate_desc.lo_64' is not equal to 0 */
 	if (invalidate_desc.lo_64 != 0UL) {
-		/** Call spinlock_obtain with the following parameters, in order to obtain the spin lock that
-		 *  is used to protect the operations on \a dmar_unit.
-		 *  - &(dmar_unit->lock) */
-		spinlock_obtain(&(dmar_unit->lock));
-
-		/** Call dmar_issue_qi_request with the following parameters, in order to submit the
-		 *  invalidation request specified by 'invalidate_desc' to the DRHD structure specified by \a dmar_unit
-		 *  and wait until hardware completes it.
+		/** Call dmar_qi_queue_desc with the following parameters, in order to queue the invalidation request
+		 *  specified by 'invalidate_desc' to the DRHD structure specified by \a dmar_unit.
 		 *  - dmar_unit
 		 *  - invalidate_desc
 		 */
-		dmar_issue_qi_request(dmar_unit, invalidate_desc);
-
-		/** Call spinlock_release with the following parameters, in order to release the spin lock that
-		 *  is used to protect the operations on \a dmar_unit.
-		 *  - &(dmar_unit->lock) */
-		spinlock_release(&(dmar_unit->lock));
+		dmar_qi_queue_desc(dmar_unit, invalidate_desc);
 	}
 }
 
 /**
- * @brief Submit a global context cache invalidation request to hardware and wait until hardware completes it.
+ * @brief Queue a global context cache invalidation request to hardware.
  *
  * All context-cache entries cached at the remapping hardware will be invalidated with this invalidation request.
  *
  * It is supposed to be called when hypervisor attempts to invalidate the context cache globally.
  *
  * @param[inout] dmar_unit A pointer to a data structure that stores the runtime information for the specified
- *                         DRHD structure where the invalidation request is submitted to.
+ *                         DRHD structure where the invalidation request is queued to.
  *
  * @return None
  *
  * @pre dmar_unit != NULL
  * @pre dmar_unit->drhd != NULL
+ * @pre The current physical CPU holds dmar_unit->lock.
  *
  * @post N/A
  *
@@ -1615,8 +1935,7 @@ static void dmar_invalid_context_cache(
 static void dmar_invalid_context_cache_global(struct dmar_drhd_rt *dmar_unit)
 {
 	/** Call dmar_invalid_context_cache with the following parameters, in order to
-	 *  submit a global context cache invalidation request to the DRHD structure specified by \a dmar_unit
-	 *  and wait until hardware completes it.
+	 *  queue a global context cache invalidation request to the DRHD structure specified by \a dmar_unit.
 	 *  - dmar_unit
 	 *  - 0H
 	 *  - 0H
@@ -1627,22 +1946,21 @@ static void dmar_invalid_context_cache_global(struct dmar_drhd_rt *dmar_unit)
 }
 
 /**
- * @brief Submit the specified IOTLB invalidation request to hardware and wait until hardware completes it.
+ * @brief Queue the specified IOTLB invalidation request to hardware.
+ *
+ * The request takes effect after the caller submits it via 'dmar_qi_submit'.
  *
  * It is supposed to be called when hypervisor attempts to invalidate the IOTLB and paging structure caches.
  *
  * @param[inout] dmar_unit A pointer to a data structure that stores the runtime information for the specified
- *                         DRHD structure where the invalidation request is submitted to.
+ *                         DRHD structure where the invalidation request is queued to.
  * @param[in] did The specified value for Domain ID field, which is to be set to an IOTLB invalidate descriptor.
  * @param[in] address The specified value for Address field, which is to be set to an IOTLB invalidate descriptor.
- *                    This argument is only needed for page-selective-within-domain invalidation, which is not
- *                    supported in current scope, keeping it here for scope extension in the future.
+ *                    This argument is only used for page-selective-within-domain invalidation.
  * @param[in] am The specified value for Address Mask field, which is to be set to an IOTLB invalidate descriptor.
- *               This argument is only needed for page-selective-within-domain invalidation, which is not
- *               supported in current scope, keeping it here for scope extension in the future.
+ *               This argument is only used for page-selective-within-domain invalidation.
  * @param[in] hint The specified value for Invalidation Hint field, which is to be set to an IOTLB invalidate
- *                 descriptor. This argument is only needed for page-selective-within-domain invalidation, which
- *                 is not supported in current scope, keeping it here for scope extension in the future.
+ *                 descriptor. This argument is only used for page-selective-within-domain invalidation.
  * @param[in] iirg The specified value for IOTLB Invalidation Request Granularity field, which is to be set to an IOTLB
  *                 invalidate descriptor.
  *
@@ -1650,7 +1968,9 @@ static void dmar_invalid_context_cache_global(struct dmar_drhd_rt *dmar_unit)
  *
  * @pre dmar_unit != NULL
  * @pre dmar_unit->drhd != NULL
- * @pre (iirg == DMAR_IIRG_GLOBAL) || (iirg == DMAR_IIRG_DOMAIN)
+ * @pre The current physical CPU holds dmar_unit->lock.
+ * @pre (iirg == DMAR_IIRG_GLOBAL) || (iirg == DMAR_IIRG_DOMAIN) || (iirg == DMAR_IIRG_PAGE)
+ * @pre (iirg != DMAR_IIRG_PAGE) || ((address & ((1UL << (PAGE_SHIFT + am)) - 1UL)) == 0UL)
  *
  * @post N/A
  *
@@ -1659,10 +1979,10 @@ static void dmar_invalid_context_cache_global(struct dmar_drhd_rt *dmar_unit)
  * @remark N/A
  *
  * @reentrancy Unspecified
- * @threadsafety Yes
+ * @threadsafety When \a dmar_unit is different among parallel invocation.
  */
-static void dmar_invalid_iotlb(struct dmar_drhd_rt *dmar_unit, uint16_t did, __unused uint64_t address,
-	__unused uint8_t am, __unused bool hint, enum dmar_iirg_type iirg)
+static void dmar_invalid_iotlb(
+	struct dmar_drhd_rt *dmar_unit, uint16_t did, uint64_t address, uint8_t am, bool hint, enum dmar_iirg_type iirg)
 {
 	/* set Drain Reads & Drain Writes,
 	 * if hardware doesn't support it, will be ignored by hardware
@@ -1700,6 +2020,25 @@ static void dmar_invalid_iotlb(struct dmar_drhd_rt *dmar_unit, uint16_t did, __u
 		invalidate_desc.lo_64 |= DMA_IOTLB_DOMAIN_INVL | dma_iotlb_did(did);
 		/** End of case */
 		break;
+	/** \a iirg is DMAR_IIRG_PAGE, indicating a page-selective-within-domain invalidation request */
+	case DMAR_IIRG_PAGE:
+		/** Set following fields in 'invalidate_desc.lo_64' to the specified values:
+		 *  - IOTLB Invalidation Request Granularity field (Bits 5:4) to 3
+		 *  - Domain-ID field (Bits 31:16) to \a did
+		 */
+		invalidate_desc.lo_64 |= DMA_IOTLB_PAGE_INVL | dma_iotlb_did(did);
+		/** Set following fields in 'invalidate_desc.hi_64' to the specified values:
+		 *  - Address field (Bits 63:12) to bits 63:12 of \a address
+		 *  - Address Mask field (Bits 5:0) to bits 5:0 of \a am
+		 */
+		invalidate_desc.hi_64 = (address & PAGE_MASK) | ((uint64_t)am & 0x3fUL);
+		/** If \a hint is true */
+		if (hint) {
+			/** Set Invalidation Hint field (Bit 6) in 'invalidate_desc.hi_64' to 1 */
+			invalidate_desc.hi_64 |= DMA_IOTLB_IH;
+		}
+		/** End of case */
+		break;
 	/** Otherwise */
 	default:
 		/** Set 'invalidate_desc.lo_64' to 0 */
@@ -1714,28 +2053,17 @@ static void dmar_invalid_iotlb(struct dmar_drhd_rt *dmar_unit, uint16_t did, __u
 
 	/** If 'invalidate_desc.lo_64' is not equal to 0 */
 	if (invalidate_desc.lo_64 != 0UL) {
-		/** Call spinlock_obtain with the following parameters, in order to obtain the spin lock that
-		 *  is used to protect the operations on \a dmar_unit.
-		 *  - &(dmar_unit->lock) */
-		spinlock_obtain(&(dmar_unit->lock));
-
-		/** Call dmar_issue_qi_request with the following parameters, in order to submit the
-		 *  invalidation request specified by 'invalidate_desc' to the DRHD structure specified by \a dmar_unit
-		 *  and wait until hardware completes it.
+		/** Call dmar_qi_queue_desc with the following parameters, in order to queue the invalidation request
+		 *  specified by 'invalidate_desc' to the DRHD structure specified by \a dmar_unit.
 		 *  - dmar_unit
 		 *  - invalidate_desc
 		 */
-		dmar_issue_qi_request(dmar_unit, invalidate_desc);
-
-		/** Call spinlock_release with the following parameters, in order to release the spin lock that
-		 *  is used to protect the operations on \a dmar_unit.
-		 *  - &(dmar_unit->lock) */
-		spinlock_release(&(dmar_unit->lock));
+		dmar_qi_queue_desc(dmar_unit, invalidate_desc);
 	}
 }
 
 /**
- * @brief Submit a global IOTLB invalidation request to hardware and wait until hardware completes it.
+ * @brief Queue a global IOTLB invalidation request to hardware.
  *
  * All IOTLB entries will be invalidated and all paging-structure-cache entries will be invalidated with this
  * invalidation request.
@@ -1743,12 +2071,13 @@ static void dmar_invalid_iotlb(struct dmar_drhd_rt *dmar_unit, uint16_t did, __u
  * It is supposed to be called when hypervisor attempts to invalidate the IOTLB and paging structure caches globally.
  *
  * @param[inout] dmar_unit A pointer to a data structure that stores the runtime information for the specified
- *                         DRHD structure where the invalidation request is submitted to.
+ *                         DRHD structure where the invalidation request is queued to.
  *
  * @return None
  *
  * @pre dmar_unit != NULL
  * @pre dmar_unit->drhd != NULL
+ * @pre The current physical CPU holds dmar_unit->lock.
  *
  * @post N/A
  *
@@ -1762,8 +2091,7 @@ static void dmar_invalid_iotlb(struct dmar_drhd_rt *dmar_unit, uint16_t did, __u
 static void dmar_invalid_iotlb_global(struct dmar_drhd_rt *dmar_unit)
 {
 	/** Call dmar_invalid_iotlb with the following parameters, in order to
-	 *  submit a global IOTLB invalidation request to the DRHD structure specified by \a dmar_unit
-	 *  and wait until hardware completes it.
+	 *  queue a global IOTLB invalidation request to the DRHD structure specified by \a dmar_unit.
 	 *  - dmar_unit
 	 *  - 0H
 	 *  - 0H
@@ -1872,14 +2200,14 @@ static void dmar_set_intr_remap_table(struct dmar_drhd_rt *dmar_unit)
 }
 
 /**
- * @brief Submit the specified interrupt entry cache invalidation request to hardware.
+ * @brief Queue the specified interrupt entry cache invalidation request to hardware.
  *
- * Submit the specified interrupt entry cache invalidation request to hardware and wait until hardware completes it.
+ * The request takes effect after the caller submits it via 'dmar_qi_submit'.
  *
  * It is supposed to be called when hypervisor attempts to invalidate the interrupt entry cache.
  *
  * @param[inout] dmar_unit A pointer to a data structure that stores the runtime information for the specified
- *                         DRHD structure where the invalidation request is submitted to.
+ *                         DRHD structure where the invalidation request is queued to.
  * @param[in] intr_index The specified value for Interrupt Index field, which is to be set to an interrupt entry
  *                       cache invalidate descriptor.
  * @param[in] index_mask The specified value for Index Mask field, which is to be set to an interrupt entry
@@ -1891,6 +2219,7 @@ static void dmar_set_intr_remap_table(struct dmar_drhd_rt *dmar_unit)
  *
  * @pre dmar_unit != NULL
  * @pre dmar_unit->drhd != NULL
+ * @pre The current physical CPU holds dmar_unit->lock.
  *
  * @post N/A
  *
@@ -1899,7 +2228,7 @@ static void dmar_set_intr_remap_table(struct dmar_drhd_rt *dmar_unit)
  * @remark N/A
  *
  * @reentrancy Unspecified
- * @threadsafety Yes
+ * @threadsafety When \a dmar_unit is different among parallel invocation.
  */
 static void dmar_invalid_iec(struct dmar_drhd_rt *dmar_unit, uint16_t intr_index, uint8_t index_mask, bool is_global)
 {
@@ -1926,40 +2255,29 @@ static void dmar_invalid_iec(struct dmar_drhd_rt *dmar_unit, uint16_t intr_index
 		invalidate_desc.lo_64 |= DMAR_IECI_INDEXED | dma_iec_index(intr_index, index_mask);
 	}
 
-	/** Call spinlock_obtain with the following parameters, in order to obtain the spin lock that is used to
-	 *  protect the operations on \a dmar_unit.
-	 *  - &(dmar_unit->lock) */
-	spinlock_obtain(&(dmar_unit->lock));
-
-	/** Call dmar_issue_qi_request with the following parameters, in order to submit the
-	 *  invalidation request specified by 'invalidate_desc' to the DRHD structure specified by \a dmar_unit
-	 *  and wait until hardware completes it.
+	/** Call dmar_qi_queue_desc with the following parameters, in order to queue the invalidation request
+	 *  specified by 'invalidate_desc' to the DRHD structure specified by \a dmar_unit.
 	 *  - dmar_unit
 	 *  - invalidate_desc
 	 */
-	dmar_issue_qi_request(dmar_unit, invalidate_desc);
-
-	/** Call spinlock_release with the following parameters, in order to release the spin lock that
-	 *  is used to protect the operations on \a dmar_unit.
-	 *  - &(dmar_unit->lock) */
-	spinlock_release(&(dmar_unit->lock));
+	dmar_qi_queue_desc(dmar_unit, invalidate_desc);
 }
 
 /**
- * @brief Submit a global interrupt entry cache invalidation request to hardware.
+ * @brief Queue a global interrupt entry cache invalidation request to hardware.
  *
- * Submit a global interrupt entry cache invalidation request to hardware and wait until hardware completes it.
  * All interrupt remapping entries cached at the remapping hardware will be invalidated with this invalidation request.
  *
  * It is supposed to be called when hypervisor attempts to invalidate the interrupt entry cache globally.
  *
  * @param[inout] dmar_unit A pointer to a data structure that stores the runtime information for the specified
- *                         DRHD structure where the invalidation request is submitted to.
+ *                         DRHD structure where the invalidation request is queued to.
  *
  * @return None
  *
  * @pre dmar_unit != NULL
  * @pre dmar_unit->drhd != NULL
+ * @pre The current physical CPU holds dmar_unit->lock.
  *
  * @post N/A
  *
@@ -1973,8 +2291,7 @@ static void dmar_invalid_iec(struct dmar_drhd_rt *dmar_unit, uint16_t intr_index
 static void dmar_invalid_iec_global(struct dmar_drhd_rt *dmar_unit)
 {
 	/** Call dmar_invalid_iec with the following parameters, in order to
-	 *  submit a global interrupt entry cache invalidation request to the DRHD structure specified by \a dmar_unit
-	 *  and wait until hardware completes it.
+	 *  queue a global interrupt entry cache invalidation request to the DRHD structure specified by \a dmar_unit.
 	 *  - dmar_unit
 	 *  - 0H
 	 *  - 0H
@@ -2226,24 +2543,35 @@ static void dmar_enable(struct dmar_drhd_rt *dmar_unit)
 	 *  - dmar_unit->drhd->reg_base_addr
 	 */
 	dev_dbg(ACRN_DBG_IOMMU, "enable dmar unit [0x%x]", dmar_unit->drhd->reg_base_addr);
+	/** Call spinlock_obtain with the following parameters, in order to obtain the spin lock that is used to
+	 *  protect the operations on \a dmar_unit.
+	 *  - &(dmar_unit->lock) */
+	spinlock_obtain(&(dmar_unit->lock));
 	/** Call dmar_invalid_context_cache_global with the following parameters, in order to
-	 *  submit a global context cache invalidation request to the DRHD structure specified by \a dmar_unit
-	 *  and wait until hardware completes it.
+	 *  queue a global context cache invalidation request to the DRHD structure specified by \a dmar_unit.
 	 *  - dmar_unit
 	 */
 	dmar_invalid_context_cache_global(dmar_unit);
 	/** Call dmar_invalid_iotlb_global with the following parameters, in order to
-	 *  submit a global IOTLB invalidation request to the DRHD structure specified by \a dmar_unit
-	 *  and wait until hardware completes it.
+	 *  queue a global IOTLB invalidation request to the DRHD structure specified by \a dmar_unit.
 	 *  - dmar_unit
 	 */
 	dmar_invalid_iotlb_global(dmar_unit);
-	/** Call dmar_invalid_iotlb_global with the following parameters, in order to
-	 *  submit a global interrupt entry cache invalidation request to the DRHD structure specified by \a dmar_unit
-	 *  and wait until hardware completes it.
+	/** Call dmar_invalid_iec_global with the following parameters, in order to
+	 *  queue a global interrupt entry cache invalidation request to the DRHD structure specified by \a dmar_unit.
 	 *  - dmar_unit
 	 */
 	dmar_invalid_iec_global(dmar_unit);
+	/** Call dmar_qi_submit with the following parameters, in order to submit the invalidation requests queued
+	 *  above to the DRHD structure specified by \a dmar_unit with a single Invalidation Wait Descriptor and
+	 *  wait until hardware completes them.
+	 *  - dmar_unit
+	 */
+	dmar_qi_submit(dmar_unit);
+	/** Call spinlock_release with the following parameters, in order to release the spin lock that
+	 *  is used to protect the operations on \a dmar_unit.
+	 *  - &(dmar_unit->lock) */
+	spinlock_release(&(dmar_unit->lock));
 	/** Call dmar_enable_translation with the following parameters, in order to
 	 *  enable DMA remapping on the DRHD structure specified by \a dmar_unit (if it's not enabled yet).
 	 *  - dmar_unit
@@ -2356,12 +2684,13 @@ int32_t add_iommu_device(struct iommu_domain *domain, uint8_t bus, uint8_t devfu
 		root_entry->hi_64 = 0UL;
 		/** Set 'root_entry->lo_64' to 'lo_64' */
 		root_entry->lo_64 = lo_64;
-		/** Call iommu_flush_cache with the following parameters, in order to flush cache lines that contain
+		/** Call dmar_flush_cache with the following parameters, in order to flush cache lines that contain
 		 *  the root entry (128-bit in size) pointed by 'root_entry'.
+		 *  - dmar_unit->flush_policy
 		 *  - root_entry
 		 *  - sizeof(struct dmar_entry)
 		 */
-		iommu_flush_cache(root_entry, sizeof(struct dmar_entry));
+		dmar_flush_cache(dmar_unit->flush_policy, root_entry, sizeof(struct dmar_entry));
 	} else {
 		/** Set 'context_table_addr' to CTP (Context-table Pointer) field (Bits 63:12) in 'root_entry->lo_64' */
 		context_table_addr =
@@ -2404,12 +2733,15 @@ int32_t add_iommu_device(struct iommu_domain *domain, uint8_t bus, uint8_t devfu
 	context_entry->hi_64 = hi_64;
 	/** Set 'context_entry->lo_64' to 'lo_64' */
 	context_entry->lo_64 = lo_64;
-	/** Call iommu_flush_cache with the following parameters, in order to flush cache lines that contain
+	/** Call dmar_flush_cache with the following parameters, in order to flush cache lines that contain
 	 *  the context entry (128-bit in size) pointed by 'context_entry'.
+	 *  - dmar_unit->flush_policy
 	 *  - context_entry
 	 *  - sizeof(struct dmar_entry)
 	 */
-	iommu_flush_cache(context_entry, sizeof(struct dmar_entry));
+	dmar_flush_cache(dmar_unit->flush_policy, context_entry, sizeof(struct dmar_entry));
+	/** Increment 'domain->dev_count' by 1 */
+	domain->dev_count++;
 
 	/** Return 'ret' */
 	return ret;
@@ -2420,7 +2752,7 @@ int32_t add_iommu_device(struct iommu_domain *domain, uint8_t bus, uint8_t devfu
  *
  * It is supposed to be called only by 'remove_vdev_pt_iommu_domain' from 'vp-dm.vperipheral' module.
  *
- * @param[in] domain The pointer which points to an IOMMU domain where the PCI device is removed from.
+ * @param[inout] domain The pointer which points to an IOMMU domain where the PCI device is removed from.
  * @param[in] bus The bus number of the specified PCI device.
  * @param[in] devfun The 8-bit device(5-bit):function(3-bit) of the specified PCI device.
  *
@@ -2446,7 +2778,7 @@ int32_t add_iommu_device(struct iommu_domain *domain, uint8_t bus, uint8_t devfu
  * @reentrancy Unspecified
  * @threadsafety Unspecified
  */
-int32_t remove_iommu_device(const struct iommu_domain *domain, uint8_t bus, uint8_t devfun)
+int32_t remove_iommu_device(struct iommu_domain *domain, uint8_t bus, uint8_t devfun)
 {
 	/** Declare the following local variables of type 'struct dmar_drhd_rt *'.
 	 *  - dmar_unit representing a pointer to the data structure that stores the runtime information for the
@@ -2513,16 +2845,20 @@ int32_t remove_iommu_device(const struct iommu_domain *domain, uint8_t bus, uint
 	/** Set 'context_entry->hi_64' to 0 */
 	context_entry->hi_64 = 0UL;
 
-	/** Call iommu_flush_cache with the following parameters, in order to flush cache lines that contain
+	/** Call dmar_flush_cache with the following parameters, in order to flush cache lines that contain
 	 *  the context entry (128-bit in size) pointed by 'context_entry'.
+	 *  - dmar_unit->flush_policy
 	 *  - context_entry
 	 *  - sizeof(struct dmar_entry)
 	 */
-	iommu_flush_cache(context_entry, sizeof(struct dmar_entry));
+	dmar_flush_cache(dmar_unit->flush_policy, context_entry, sizeof(struct dmar_entry));
 
-	/** Call dmar_invalid_context_cache with the following parameters, in order to submit a device-selective
-	 *  context cache invalidation request to the DRHD structure specified by \a dmar_unit
-	 *  and wait until hardware completes it.
+	/** Call spinlock_obtain with the following parameters, in order to obtain the spin lock that is used to
+	 *  protect the operations on \a dmar_unit.
+	 *  - &(dmar_unit->lock) */
+	spinlock_obtain(&(dmar_unit->lock));
+	/** Call dmar_invalid_context_cache with the following parameters, in order to queue a device-selective
+	 *  context cache invalidation request to the DRHD structure specified by \a dmar_unit.
 	 *  - dmar_unit
 	 *  - vmid_to_domainid(domain->vm_id)
 	 *  - sid.value
@@ -2530,9 +2866,8 @@ int32_t remove_iommu_device(const struct iommu_domain *domain, uint8_t bus, uint
 	 *  - DMAR_CIRG_DEVICE
 	 */
 	dmar_invalid_context_cache(dmar_unit, vmid_to_domainid(domain->vm_id), sid.value, 0U, DMAR_CIRG_DEVICE);
-	/** Call dmar_invalid_iotlb with the following parameters, in order to submit a domain-selective
-	 *  IOTLB invalidation request to the DRHD structure specified by \a dmar_unit
-	 *  and wait until hardware completes it.
+	/** Call dmar_invalid_iotlb with the following parameters, in order to queue a domain-selective
+	 *  IOTLB invalidation request to the DRHD structure specified by \a dmar_unit.
 	 *  - dmar_unit
 	 *  - vmid_to_domainid(domain->vm_id)
 	 *  - 0H
@@ -2541,11 +2876,191 @@ int32_t remove_iommu_device(const struct iommu_domain *domain, uint8_t bus, uint
 	 *  - DMAR_IIRG_DOMAIN
 	 */
 	dmar_invalid_iotlb(dmar_unit, vmid_to_domainid(domain->vm_id), 0UL, 0U, false, DMAR_IIRG_DOMAIN);
+	/** Call dmar_qi_submit with the following parameters, in order to submit the invalidation requests queued
+	 *  above to the DRHD structure specified by \a dmar_unit with a single Invalidation Wait Descriptor and
+	 *  wait until hardware completes them.
+	 *  - dmar_unit
+	 */
+	dmar_qi_submit(dmar_unit);
+	/** Call spinlock_release with the following parameters, in order to release the spin lock that
+	 *  is used to protect the operations on \a dmar_unit.
+	 *  - &(dmar_unit->lock) */
+	spinlock_release(&(dmar_unit->lock));
+
+	/** If 'domain->dev_count' is larger than 0 */
+	if (domain->dev_count > 0U) {
+		/** Decrement 'domain->dev_count' by 1 */
+		domain->dev_count--;
+	}
 
 	/** Return 'ret' */
 	return ret;
 }
 
+/**
+ * @brief Calculate the address mask of the largest naturally aligned block starting at the specified page.
+ *
+ * The block starts at the page specified by \a pfn, is aligned to its own size, does not cross \a end_pfn and
+ * covers at most 2^\a mamv pages.
+ *
+ * It is supposed to be called only by 'iommu_invalidate_range'.
+ *
+ * @param[in] pfn The page frame number where the block starts.
+ * @param[in] end_pfn The page frame number right after the range to be covered.
+ * @param[in] mamv The maximum address mask value supported by remapping hardware.
+ *
+ * @return The address mask of the block, i.e. the block covers 2^(return value) pages.
+ *
+ * @pre pfn < end_pfn
+ * @pre mamv <= 3fH
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark N/A
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+static uint8_t dmar_iotlb_psi_am(uint64_t pfn, uint64_t end_pfn, uint64_t mamv)
+{
+	/** Declare the following local variables of type uint8_t.
+	 *  - am representing the address mask of the block, initialized as 0. */
+	uint8_t am = 0U;
+
+	/** Until 'am' reaches \a mamv, or doubling the block breaks its natural alignment or crosses \a end_pfn */
+	while (((uint64_t)am < mamv) && ((pfn & ((1UL << (am + 1U)) - 1UL)) == 0UL) &&
+		((pfn + (1UL << (am + 1U))) <= end_pfn)) {
+		/** Increment 'am' by 1 */
+		am++;
+	}
+
+	/** Return 'am' */
+	return am;
+}
+
+/**
+ * @brief Invalidate the IOTLB entries of the specified IOMMU domain that cache the specified guest physical range.
+ *
+ * The range is split into naturally aligned power-of-two blocks of pages and each block is invalidated with one
+ * page-selective-within-domain IOTLB invalidate descriptor, so that contiguous pages are coalesced via the address
+ * mask. All descriptors are submitted to hardware with a single Invalidation Wait Descriptor.
+ * If remapping hardware does not support page-selective invalidation, or the range needs more than
+ * DMAR_IOTLB_PSI_MAX descriptors, one domain-selective invalidation is used instead.
+ * Nothing is done if no PCI device is assigned to the IOMMU domain.
+ *
+ * It is supposed to be called by 'ept_modify_mr' and 'ept_del_mr' from 'vp-base.guest-mem' module after the
+ * second-level translation table of the IOMMU domain is updated.
+ *
+ * @param[in] domain The pointer which points to the IOMMU domain whose IOTLB entries are to be invalidated.
+ * @param[in] gpa The start guest physical address of the range.
+ * @param[in] size The size of the range in bytes.
+ *
+ * @return None
+ *
+ * @pre N/A
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark N/A
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+void iommu_invalidate_range(const struct iommu_domain *domain, uint64_t gpa, uint64_t size)
+{
+	/** Declare the following local variables of type 'struct dmar_drhd_rt *'.
+	 *  - dmar_unit representing a pointer to the data structure that stores the runtime information for the
+	 *  DRHD structure which covers the PCI devices of the IOMMU domain, initialized as '&dmar_drhd_units[1]'. */
+	struct dmar_drhd_rt *dmar_unit = &dmar_drhd_units[1];
+	/** Declare the following local variables of type uint16_t.
+	 *  - did representing the domain identifier of \a domain, not initialized. */
+	uint16_t did;
+	/** Declare the following local variables of type uint64_t.
+	 *  - pfn representing the page frame number of the block to be invalidated next, not initialized.
+	 *  - end_pfn representing the page frame number right after the range, not initialized.
+	 *  - mamv representing the maximum address mask value supported by 'dmar_unit', not initialized. */
+	uint64_t pfn, end_pfn, mamv;
+	/** Declare the following local variables of type uint8_t.
+	 *  - am representing the address mask of the block to be invalidated next, not initialized. */
+	uint8_t am;
+	/** Declare the following local variables of type uint32_t.
+	 *  - psi_count representing the number of page-selective descriptors needed by the range, initialized as 0. */
+	uint32_t psi_count = 0U;
+
+	/** If \a domain is not NULL, at least one PCI device is assigned to it and \a size is not 0 */
+	if ((domain != NULL) && (domain->dev_count > 0U) && (size > 0UL)) {
+		/** Set 'did' to the return value of 'vmid_to_domainid(domain->vm_id)' */
+		did = vmid_to_domainid(domain->vm_id);
+		/** Set 'end_pfn' to the page frame number right after the last page touched by the range */
+		end_pfn = (gpa + size + PAGE_SIZE - 1UL) >> PAGE_SHIFT;
+		/** Set 'mamv' to MAMV field (Bits 53:48) in 'dmar_unit->cap' */
+		mamv = (dmar_unit->cap >> DMA_CAP_MAMV_SHIFT) & DMA_CAP_MAMV_MASK;
+
+		/** If 'dmar_unit' supports page-selective invalidation */
+		if ((dmar_unit->cap & DMA_CAP_PSI) != 0UL) {
+			/** For each block starting at 'pfn' ranging from the page of \a gpa to 'end_pfn - 1', stopping
+			 *  once more than DMAR_IOTLB_PSI_MAX blocks are counted */
+			for (pfn = gpa >> PAGE_SHIFT; (pfn < end_pfn) && (psi_count <= DMAR_IOTLB_PSI_MAX);
+				pfn += (1UL << dmar_iotlb_psi_am(pfn, end_pfn, mamv))) {
+				/** Increment 'psi_count' by 1 */
+				psi_count++;
+			}
+		} else {
+			/** Set 'psi_count' to 'DMAR_IOTLB_PSI_MAX + 1', so that a domain-selective invalidation is used */
+			psi_count = DMAR_IOTLB_PSI_MAX + 1U;
+		}
+
+		/** Call spinlock_obtain with the following parameters, in order to obtain the spin lock that is used to
+		 *  protect the operations on 'dmar_unit'.
+		 *  - &(dmar_unit->lock) */
+		spinlock_obtain(&(dmar_unit->lock));
+		/** If 'psi_count' is larger than DMAR_IOTLB_PSI_MAX */
+		if (psi_count > DMAR_IOTLB_PSI_MAX) {
+			/** Call dmar_invalid_iotlb with the following parameters, in order to queue a domain-selective
+			 *  IOTLB invalidation request to the DRHD structure specified by 'dmar_unit'.
+			 *  - dmar_unit
+			 *  - did
+			 *  - 0H
+			 *  - 0H
+			 *  - false
+			 *  - DMAR_IIRG_DOMAIN
+			 */
+			dmar_invalid_iotlb(dmar_unit, did, 0UL, 0U, false, DMAR_IIRG_DOMAIN);
+		} else {
+			/** For each block starting at 'pfn' ranging from the page of \a gpa to 'end_pfn - 1' */
+			for (pfn = gpa >> PAGE_SHIFT; pfn < end_pfn; pfn += (1UL << am)) {
+				/** Set 'am' to the return value of 'dmar_iotlb_psi_am(pfn, end_pfn, mamv)' */
+				am = dmar_iotlb_psi_am(pfn, end_pfn, mamv);
+				/** Call dmar_invalid_iotlb with the following parameters, in order to queue a
+				 *  page-selective-within-domain IOTLB invalidation request covering 2^am pages starting at
+				 *  'pfn' to the DRHD structure specified by 'dmar_unit'. The hint is cleared since the EPT
+				 *  update may also have changed non-leaf entries.
+				 *  - dmar_unit
+				 *  - did
+				 *  - pfn << PAGE_SHIFT
+				 *  - am
+				 *  - false
+				 *  - DMAR_IIRG_PAGE
+				 */
+				dmar_invalid_iotlb(dmar_unit, did, pfn << PAGE_SHIFT, am, false, DMAR_IIRG_PAGE);
+			}
+		}
+		/** Call dmar_qi_submit with the following parameters, in order to submit the invalidation requests
+		 *  queued above to the DRHD structure specified by 'dmar_unit' and wait until hardware completes them.
+		 *  - dmar_unit
+		 */
+		dmar_qi_submit(dmar_unit);
+		/** Call spinlock_release with the following parameters, in order to release the spin lock that
+		 *  is used to protect the operations on 'dmar_unit'.
+		 *  - &(dmar_unit->lock) */
+		spinlock_release(&(dmar_unit->lock));
+	}
+}
+
 /**
  * @brief Perform the specified action on all DRHD structures that are not ignored by hypervisor.
  *
@@ -2892,14 +3407,19 @@ void dmar_assign_irte(struct intr_source intr_src, union dmar_ir_entry irte, uin
 	/** Set 'ir_entry->entry.lo_64' to 'effective_irte.entry.lo_64' */
 	ir_entry->entry.lo_64 = effective_irte.entry.lo_64;
 
-	/** Call iommu_flush_cache with the following parameters, in order to flush cache lines that contain
+	/** Call dmar_flush_cache with the following parameters, in order to flush cache lines that contain
 	 *  the interrupt remapping entry (128-bit in size) pointed by 'ir_entry'.
+	 *  - dmar_unit->flush_policy
 	 *  - ir_entry
 	 *  - sizeof(struct dmar_ir_entry)
 	 */
-	iommu_flush_cache(ir_entry, sizeof(union dmar_ir_entry));
+	dmar_flush_cache(dmar_unit->flush_policy, ir_entry, sizeof(union dmar_ir_entry));
+	/** Call spinlock_obtain with the following parameters, in order to obtain the spin lock that is used to
+	 *  protect the operations on \a dmar_unit.
+	 *  - &(dmar_unit->lock) */
+	spinlock_obtain(&(dmar_unit->lock));
 	/** Call dmar_invalid_iec with the following parameters, in order to
-	 *  submit an index-selective interrupt entry cache invalidation request to the DRHD structure specified
+	 *  queue an index-selective interrupt entry cache invalidation request to the DRHD structure specified
 	 *  by \a dmar_unit.
 	 *  - dmar_unit
 	 *  - index
@@ -2907,6 +3427,16 @@ void dmar_assign_irte(struct intr_source intr_src, union dmar_ir_entry irte, uin
 	 *  - false
 	 */
 	dmar_invalid_iec(dmar_unit, index, 0U, false);
+	/** Call dmar_qi_submit with the following parameters, in order to submit the invalidation requests queued
+	 *  above to the DRHD structure specified by \a dmar_unit with a single Invalidation Wait Descriptor and
+	 *  wait until hardware completes them.
+	 *  - dmar_unit
+	 */
+	dmar_qi_submit(dmar_unit);
+	/** Call spinlock_release with the following parameters, in order to release the spin lock that
+	 *  is used to protect the operations on \a dmar_unit.
+	 *  - &(dmar_unit->lock) */
+	spinlock_release(&(dmar_unit->lock));
 }
 
 /**
@@ -2961,14 +3491,19 @@ void dmar_free_irte(__unused struct intr_source intr_src, uint16_t index)
 	 *  hardware. */
 	ir_entry->bits.present = 0x0UL;
 
-	/** Call iommu_flush_cache with the following parameters, in order to flush cache lines that contain
+	/** Call dmar_flush_cache with the following parameters, in order to flush cache lines that contain
 	 *  the interrupt remapping entry (128-bit in size) pointed by 'ir_entry'.
+	 *  - dmar_unit->flush_policy
 	 *  - ir_entry
 	 *  - sizeof(struct dmar_ir_entry)
 	 */
-	iommu_flush_cache(ir_entry, sizeof(union dmar_ir_entry));
+	dmar_flush_cache(dmar_unit->flush_policy, ir_entry, sizeof(union dmar_ir_entry));
+	/** Call spinlock_obtain with the following parameters, in order to obtain the spin lock that is used to
+	 *  protect the operations on \a dmar_unit.
+	 *  - &(dmar_unit->lock) */
+	spinlock_obtain(&(dmar_unit->lock));
 	/** Call dmar_invalid_iec with the following parameters, in order to
-	 *  submit an index-selective interrupt entry cache invalidation request to the DRHD structure specified
+	 *  queue an index-selective interrupt entry cache invalidation request to the DRHD structure specified
 	 *  by \a dmar_unit.
 	 *  - dmar_unit
 	 *  - index
@@ -2976,6 +3511,16 @@ void dmar_free_irte(__unused struct intr_source intr_src, uint16_t index)
 	 *  - false
 	 */
 	dmar_invalid_iec(dmar_unit, index, 0U, false);
+	/** Call dmar_qi_submit with the following parameters, in order to submit the invalidation requests queued
+	 *  above to the DRHD structure specified by \a dmar_unit with a single Invalidation Wait Descriptor and
+	 *  wait until hardware completes them.
+	 *  - dmar_unit
+	 */
+	dmar_qi_submit(dmar_unit);
+	/** Call spinlock_release with the following parameters, in order to release the spin lock that
+	 *  is used to protect the operations on \a dmar_unit.
+	 *  - &(dmar_unit->lock) */
+	spinlock_release(&(dmar_unit->lock));
 }
 
 /**
@@ -82,6 +82,7 @@
  * - init_vm_bootargs_info: Initialize virtual machine bootargs_info field.
  * - init_vm_kernel_info: Initialize the virtual machine kernel_info field of the given argument \a vm
  * - get_kernel_load_addr: Get guest physical address where the kernel image will be placed to
+ * - is_boot_module_overlapped: Check whether a host physical memory region overlaps any boot module
  */
 
 /**
@@ -405,6 +406,57 @@ void init_vm_boot_info(struct acrn_vm *vm)
 	clac();
 }
 
+/**
+ * @brief Check whether a host physical memory region overlaps any boot module
+ *
+ * The boot modules hold the guest kernel images and boot arguments, which are loaded again each time a VM without a
+ * golden snapshot is restarted, and may be mapped into a VM in place of its RAM.
+ *
+ * @param[in] hpa The host physical address where the region starts.
+ * @param[in] size The size of the region in bytes.
+ *
+ * @return true if [hpa, hpa + size) overlaps any boot module, otherwise false.
+ *
+ * @mode HV_SUBMODE_INIT_ROOT, HV_SUBMODE_INIT_POST_SMP
+ *
+ * @reentrancy unspecified
+ * @threadsafety yes
+ */
+bool is_boot_module_overlapped(uint64_t hpa, uint64_t size)
+{
+	/** Declare the following local variables of type struct multiboot_info *.
+	 *  - mbi representing the multiboot information structure given from the boot_regs which saves multiboot
+	 *  information pointer, initialized as hpa2hva(boot_regs[1]). */
+	const struct multiboot_info *mbi = (struct multiboot_info *)hpa2hva((uint64_t)boot_regs[1]);
+	/** Declare the following local variables of type struct multiboot_module *.
+	 *  - mods representing the module structure array whose elements comply with multiboot protocol, not
+	 *  initialized. */
+	const struct multiboot_module *mods;
+	/** Declare the following local variables of type uint32_t.
+	 *  - i representing the index of the module being checked, not initialized. */
+	uint32_t i;
+	/** Declare the following local variables of type bool.
+	 *  - overlapped representing the result, initialized as false. */
+	bool overlapped = false;
+
+	/** Call stac in order to set the AC flag bit in the EFLAGS register and make the supervisor-mode data have
+	 *  rights to access the user-mode pages even if the SMAP bit is set in the CR4 register.*/
+	stac();
+	/** set mods to the host virtual address translated from the mi_mods_addr field of mbi.*/
+	mods = (struct multiboot_module *)hpa2hva((uint64_t)mbi->mi_mods_addr);
+	/** For each i ranging from 0 to mbi->mi_mods_count - 1 [with a step of 1], and while overlapped is false */
+	for (i = 0U; (!overlapped) && (i < mbi->mi_mods_count); i++) {
+		/** Set overlapped to true if [hpa, hpa + size) overlaps the module mods[i] */
+		overlapped = (hpa < (uint64_t)mods[i].mm_mod_end) && ((hpa + size) > (uint64_t)mods[i].mm_mod_start);
+	}
+	/** Call clac in order to clear the AC bit in the EFLAGS register and make the supervisor-mode data do not
+	 *  have rights to access the user-mode pages*/
+	clac();
+
+	/** Return overlapped */
+	return overlapped;
+}
+
 /**
  * @}
  */
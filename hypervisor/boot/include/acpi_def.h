@@ -35,6 +35,7 @@
 #define ACPI_SIG_RSDP "RSD PTR " /**< Pre-defined signature for RSDP table */
 #define ACPI_SIG_XSDT "XSDT" /**< Pre-defined signature for XSDT table */
 #define ACPI_SIG_MADT "APIC" /**< Pre-defined signature for MADT table */
+#define ACPI_SIG_MCFG "MCFG" /**< Pre-defined signature for MCFG table */
 
 /**
  * @brief Data structure to represent ACPI table header info.
@@ -100,7 +101,42 @@ struct acpi_table_rsdp {
 struct acpi_table_xsdt {
 
 	struct acpi_table_header header; /**< Common ACPI table header */
-	uint64_t table_offset_entry[1]; /**< Array of pointers to ACPI tables */
+	uint64_t table_offset_entry[2]; /**< Array of pointers to ACPI tables */
+} __packed;
+
+/**
+ * @brief Data structure to represent all the info of MCFG table.
+ *
+ * This data structure represents the fixed part of MCFG (PCI Express Memory Mapped Configuration Space base address
+ * Description Table). It is followed by one or more configuration space base address allocation structures.
+ *
+ * @consistency N/A
+ * @alignment N/A
+ *
+ * @remark N/A
+ */
+struct acpi_table_mcfg {
+
+	struct acpi_table_header header; /**< Common ACPI table header */
+	uint8_t reserved[8]; /**< Reserved, must be zero */
+} __packed;
+
+/**
+ * @brief Data structure to represent a configuration space base address allocation structure in MCFG.
+ *
+ * This data structure represents the ECAM window of one PCI segment group and the bus range it decodes.
+ *
+ * @consistency N/A
+ * @alignment N/A
+ *
+ * @remark N/A
+ */
+struct acpi_mcfg_allocation {
+	uint64_t address; /**< Base address of the enhanced configuration mechanism */
+	uint16_t pci_segment; /**< PCI segment group number */
+	uint8_t start_bus_number; /**< Start PCI bus number decoded by this window */
+	uint8_t end_bus_number; /**< End PCI bus number decoded by this window */
+	uint32_t reserved; /**< Reserved, must be zero */
 } __packed;
 
 /**
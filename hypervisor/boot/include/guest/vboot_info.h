@@ -17,12 +17,14 @@
  * @file
  * @brief Declaration of the external API provided by the vp-base.vboot module.
  *
- * This file declares the init_vm_boot_info() which is the only external API provided by this module.
+ * This file declares the init_vm_boot_info() and is_boot_module_overlapped(), the external APIs provided by this
+ * module.
  */
 
 #include <vm.h>
 
 void init_vm_boot_info(struct acrn_vm *vm);
+bool is_boot_module_overlapped(uint64_t hpa, uint64_t size);
 
 /**
  * @}
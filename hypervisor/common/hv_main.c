@@ -6,7 +6,9 @@
 
 #include <vm.h>
 #include <vm_reset.h>
+#include <vm_scrub.h>
 #include <vmcs.h>
+#include <mmu.h>
 #include <vmexit.h>
 #include <irq.h>
 #include <schedule.h>
@@ -164,8 +166,23 @@ void vcpu_thread(struct thread_object *obj)
 		 *  - 0UL
 		 *  - 0UL */
 		TRACE_2L(TRACE_VM_ENTER, 0UL, 0UL);
+		/** Set vcpu->in_non_root to true, so that ept_flush_sync waits for the EPT flush of \a vcpu */
+		vcpu->in_non_root = true;
+		/** Call cpu_write_memory_barrier, in order to order the write above before the check below */
+		cpu_write_memory_barrier();
+		/** If an EPT flush is requested after the pending requests are handled, which ept_flush_sync might not
+		 *  wait for as it saw \a vcpu out of VMX non-root operation */
+		if (bitmap_test_and_clear_lock(ACRN_REQUEST_EPT_FLUSH, &vcpu->arch.pending_req)) {
+			/** Call invept() with the following parameters, in order to invalidate cached EPT mappings.
+			 *  - vcpu->vm->arch_vm.nworld_eptp
+			 */
+			invept(vcpu->vm->arch_vm.nworld_eptp);
+		}
 		/** Set ret to return value of run_vcpu(vcpu) */
 		ret = run_vcpu(vcpu);
+		/** Set vcpu->in_non_root to false, as \a vcpu conducts any EPT flush requested from now on before its
+		 *  next VM entry */
+		vcpu->in_non_root = false;
 		/** If 'ret' is not 0, indicating that error happened when handling run_vcpu()  */
 		if (ret != 0) {
 			/** If the VM associated with the given \a vcpu is safety vm */
@@ -287,6 +304,14 @@ void default_idle(__unused struct thread_object *obj)
 			 *  with the current running physical CPU.
 			 */
 			schedule();
+		/** If return value of need_scrub_vm(pcpu_id) is true. */
+		} else if (need_scrub_vm(pcpu_id)) {
+			/** Call scrub_vm_from_idle() with the following parameters, in order
+			 *  to take part in scrubbing the memory of the VM whose vm id equals to the value of
+			 *  shutdown_vm_id field of the per-CPU region of physical CPU whose id is pcpu_id.
+			 *  - pcpu_id
+			 */
+			scrub_vm_from_idle(pcpu_id);
 		/** If return value of need_offline(pcpu_id) is true. */
 		} else if (need_offline(pcpu_id)) {
 			/** Call cpu_dead() to halt the current running physical CPU. */
@@ -299,6 +324,14 @@ void default_idle(__unused struct thread_object *obj)
 			 *  - pcpu_id
 			 */
 			shutdown_vm_from_idle(pcpu_id);
+		/** If return value of need_restart_vm(pcpu_id) is true. */
+		} else if (need_restart_vm(pcpu_id)) {
+			/** Call restart_vm_from_idle() with the following parameters, in order
+			 *  to restart the VM whose vm id equals to the value of shutdown_vm_id field of the
+			 *  per-CPU region of physical CPU whose id is pcpu_id.
+			 *  - pcpu_id
+			 */
+			restart_vm_from_idle(pcpu_id);
 		} else {
 			/** Call cpu_do_idle() to pause the current running physical CPU. */
 			cpu_do_idle();
@@ -12,6 +12,8 @@
 #include <multiboot.h>
 #include <errno.h>
 #include <logmsg.h>
+#include <reloc.h>
+#include <atomic.h>
 
 /**
  * @addtogroup vp-base_vm
@@ -30,10 +32,52 @@
  * It defines some helper functions to implement the features that are commonly used in this file.
  * In addition, it defines some decomposed functions to improve the readability of the code.
  *
- * Helper functions include: get_guest_gdt_base_gpa, create_zeropage_e820, create_zero_page.
+ * Helper functions include: get_guest_gdt_base_gpa, create_zeropage_e820, create_zero_page, copy_image_chunks.
  *
- * Decomposed functions include: prepare_loading_bzimage, prepare_loading_rawimage.
+ * Decomposed functions include: place_kernel_image, parallel_copy_to_gpa, prepare_loading_bzimage,
+ * prepare_loading_rawimage.
+ *
+ * The guest kernel image is copied in chunks of IMAGE_LOAD_CHUNK_SIZE bytes. The physical CPUs of the VM other than
+ * its BP enter join_image_load from launch_vms and take chunks along with the BP, and the BP calls end_image_load
+ * when the VM is prepared to release the ones still waiting.
+ */
+
+/**
+ * @brief Size of the chunks a guest image copy is split into to be shared by the physical CPUs of a VM.
  */
+#define IMAGE_LOAD_CHUNK_SIZE	MEM_2M
+
+#define IMAGE_LOAD_IDLE		0UL	/**< No image copy is posted yet */
+#define IMAGE_LOAD_POSTED	1UL	/**< An image copy is posted and its chunks can be taken */
+#define IMAGE_LOAD_DONE		2UL	/**< The load phase of the VM is over */
+
+/**
+ * @brief Data structure of an image copy shared by the physical CPUs of a VM.
+ *
+ * All the fields but next_chunk, done_chunks and helpers are written by the BP of the VM before state becomes
+ * IMAGE_LOAD_POSTED and are never changed after that.
+ *
+ * @consistency N/A
+ * @alignment 8
+ *
+ * @remark N/A
+ */
+struct image_load_job {
+	struct acrn_vm *vm; /**< The VM the image is loaded into */
+	uint8_t *src; /**< Host virtual address of the image */
+	uint64_t gpa; /**< Guest physical address the image is loaded to */
+	uint64_t size; /**< Size of the image in bytes */
+	uint64_t chunk_num; /**< Number of chunks of the image */
+	uint64_t next_chunk; /**< Index of the next chunk to be taken */
+	uint64_t done_chunks; /**< Number of chunks already copied */
+	uint64_t helpers; /**< Number of physical CPUs other than the BP that took part in the copy */
+	uint64_t state; /**< One of IMAGE_LOAD_IDLE, IMAGE_LOAD_POSTED and IMAGE_LOAD_DONE */
+};
+
+/**
+ * @brief Image copies indexed by VM ID.
+ */
+static struct image_load_job image_load_jobs[CONFIG_MAX_VM_NUM];
 
 
 /**
@@ -273,6 +317,11 @@ static void prepare_loading_bzimage(struct acrn_vm *vm, struct acrn_vcpu *vcpu)
 	 *  not initialized.
 	 */
 	uint32_t kernel_entry_offset;
+	/** Declare the following local variables of type uint32_t.
+	 *  - init_size representing the linear memory required by the kernel during its initialization, not
+	 *  initialized.
+	 */
+	uint32_t init_size;
 	/** Declare the following local variables of type 'struct zero_page *'.
 	 *  - zeropage representing the zeropage of the kernel image used by the given VM, not initialized.
 	 */
@@ -290,11 +339,22 @@ static void prepare_loading_bzimage(struct acrn_vm *vm, struct acrn_vcpu *vcpu)
 	 *  right after the boot sector and setup sectors each of which consists of 512 bytes.
 	 */
 	kernel_entry_offset = (uint32_t)(zeropage->hdr.setup_sects + 1U) * 512U;
+	/** Set init_size to zeropage->hdr.init_size */
+	init_size = zeropage->hdr.init_size;
 	/** Call clac in order to forbid hypervisor to access guest's memory space protected by SMAP */
 	clac();
 	/** Set sw_kernel->kernel_entry_addr to sw_kernel->kernel_load_addr + kernel_entry_offset, the entry to run */
 	sw_kernel->kernel_entry_addr = sw_kernel->kernel_load_addr + kernel_entry_offset;
 
+	/** Call ept_grant_exe_right with the following parameters, in order to grant the execute permission to the
+	 *  memory the kernel is decompressed into and runs from before the guest starts, so that the kernel text
+	 *  does not fault on its first instruction fetches.
+	 *  - vm
+	 *  - sw_kernel->kernel_load_addr
+	 *  - max(sw_kernel->kernel_size, init_size)
+	 */
+	ept_grant_exe_right(vm, sw_kernel->kernel_load_addr, (uint64_t)max(sw_kernel->kernel_size, init_size));
+
 	/** For each i ranging from 0 to NUM_GPRS - 1 [with a step of 1] */
 	for (i = 0U; i < NUM_GPRS; i++) {
 		/** Call vcpu_set_gpreg with the following parameters, in order to clear each general purpose register.
@@ -356,6 +416,388 @@ static void prepare_loading_rawimage(struct acrn_vm *vm)
 
 	/** Set sw_kernel->kernel_entry_addr to vm_config->os_config.kernel_entry_addr */
 	sw_kernel->kernel_entry_addr = vm_config->os_config.kernel_entry_addr;
+
+	/** Call ept_grant_exe_right with the following parameters, in order to grant the execute permission to the
+	 *  loaded raw image before the guest starts.
+	 *  - vm
+	 *  - sw_kernel->kernel_load_addr
+	 *  - sw_kernel->kernel_size
+	 */
+	ept_grant_exe_right(vm, sw_kernel->kernel_load_addr, sw_kernel->kernel_size);
+}
+
+/**
+ * @brief Check whether the host physical memory of a kernel module could be handed over to the given VM.
+ *
+ * The module memory could be mapped into the given VM only if it overlaps no memory reserved for other uses, as
+ * checked by is_host_region_reserved, and no other VM is configured to boot from the same module.
+ *
+ * @param[in] vm Pointer to the VM which is to use the module.
+ * @param[in] hpa The host physical address where the module starts.
+ * @param[in] size The size of the module memory in bytes.
+ *
+ * @return Whether the module memory could be mapped into the given VM.
+ *
+ * @retval true The module memory could be mapped into the given VM.
+ * @retval false The module memory is not exclusive to the given VM.
+ *
+ * @pre vm != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_ROOT
+ *
+ * @remark It is an internal function called by place_kernel_image.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety true
+ */
+static bool is_kernel_module_exclusive(const struct acrn_vm *vm, uint64_t hpa, uint64_t size)
+{
+	/** Declare the following local variables of type uint16_t.
+	 *  - vm_id representing the ID of the VM whose configuration is being checked, not initialized.
+	 */
+	uint16_t vm_id;
+	/** Declare the following local variables of type 'const struct acrn_vm_config *'.
+	 *  - vm_config representing a pointer to the configuration data of the given VM, initialized as the return
+	 *  value of get_vm_config(vm->vm_id).
+	 *  - other_config representing a pointer to the configuration data of the VM being checked, not initialized.
+	 */
+	const struct acrn_vm_config *vm_config = get_vm_config(vm->vm_id), *other_config;
+	/** Declare the following local variables of type bool.
+	 *  - exclusive representing whether the module memory could be mapped into the given VM, initialized as
+	 *  true if [hpa, hpa + size) overlaps no memory reserved for other uses; otherwise, initialized as false.
+	 */
+	bool exclusive = !is_host_region_reserved(hpa, size, HOST_REGION_KERNEL_MODULE, vm->vm_id);
+
+	/** For each vm_id ranging from 0 to CONFIG_MAX_VM_NUM - 1 [with a step of 1], and while 'exclusive' is true */
+	for (vm_id = 0U; exclusive && (vm_id < CONFIG_MAX_VM_NUM); vm_id++) {
+		/** Set other_config to the return value of get_vm_config(vm_id) */
+		other_config = get_vm_config(vm_id);
+		/** If the VM being checked is not the given VM */
+		if (vm_id != vm->vm_id) {
+			/** Set 'exclusive' to false if the VM being checked boots from the same kernel module */
+			exclusive = (strncmp(other_config->os_config.kernel_mod_tag, vm_config->os_config.kernel_mod_tag,
+				MAX_MOD_TAG_LEN) != 0);
+		}
+	}
+
+	/** Return 'exclusive' */
+	return exclusive;
+}
+
+/**
+ * @brief Place the guest kernel image at its load address without copying it if possible
+ *
+ * The kernel image does not need to be copied in the following cases:
+ * - The bootloader has already placed the kernel module at the host physical memory backing the kernel load address
+ *   of the given VM.
+ * - GUEST_FLAG_KERNEL_IN_PLACE is set for the given VM, the kernel module and the kernel load address are both page
+ *   aligned and the module memory is exclusive to the given VM. The EPT mappings of the pages fully covered by the
+ *   image are redirected to the module memory, and only the trailing partial page is copied.
+ *
+ * In both cases the guest then runs the kernel in the memory it was originally saved in, so the VM cannot be restarted
+ * without a golden snapshot. The remapping is therefore opt-in, and it leaves the guest RAM backing the pages it
+ * covers unused.
+ *
+ * @param[inout] vm Pointer to the VM whose kernel image is to be placed.
+ *
+ * @return Whether the kernel image has been placed at its load address.
+ *
+ * @retval true The kernel image has been placed at its load address.
+ * @retval false The kernel image needs to be copied to its load address.
+ *
+ * @pre vm != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_ROOT
+ *
+ * @remark It is an internal function called by direct_boot_sw_loader.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety true
+ */
+static bool place_kernel_image(struct acrn_vm *vm)
+{
+	/** Declare the following local variables of type 'struct sw_kernel_info *'.
+	 *  - sw_kernel representing a pointer to the VM's kernel info, initialized as &(vm->sw.kernel_info).
+	 */
+	struct sw_kernel_info *sw_kernel = &(vm->sw.kernel_info);
+	/** Declare the following local variables of type uint64_t.
+	 *  - src_hpa representing the host physical address of the kernel module, initialized as
+	 *  hva2hpa(sw_kernel->kernel_src_addr).
+	 *  - load_gpa representing the kernel load address, initialized as sw_kernel->kernel_load_addr.
+	 *  - map_size representing the size of the pages fully covered by the kernel image, initialized as
+	 *  sw_kernel->kernel_size & PAGE_MASK.
+	 */
+	uint64_t src_hpa = hva2hpa(sw_kernel->kernel_src_addr);
+	uint64_t load_gpa = sw_kernel->kernel_load_addr;
+	uint64_t map_size = (uint64_t)sw_kernel->kernel_size & PAGE_MASK;
+	/** Declare the following local variables of type bool.
+	 *  - placed representing whether the kernel image has been placed at its load address, initialized as false.
+	 */
+	bool placed = false;
+
+	/** If the kernel module is already located at the host physical memory backing the whole kernel load range,
+	 *  which is contiguous for pre-launched VMs */
+	if ((gpa2hpa(vm, load_gpa) == src_hpa) &&
+		(gpa2hpa(vm, load_gpa + sw_kernel->kernel_size - 1UL) == (src_hpa + sw_kernel->kernel_size - 1UL))) {
+		/** Logging the following information with a log level of LOG_INFO.
+		 *  - __func__
+		 *  - vm->vm_id
+		 */
+		pr_info("%s, VM %d kernel module is already in place", __func__, vm->vm_id);
+		/** Set 'placed' to true */
+		placed = true;
+	/** If all following conditions are satisfied:
+	 *  1. GUEST_FLAG_KERNEL_IN_PLACE is set in the guest flags of the VM.
+	 *  2. Both src_hpa and load_gpa are page aligned.
+	 *  3. The kernel image covers at least one full page.
+	 *  4. The module memory is exclusive to the given VM. */
+	} else if (((get_vm_config(vm->vm_id)->guest_flags & GUEST_FLAG_KERNEL_IN_PLACE) != 0UL) &&
+		(((src_hpa | load_gpa) & (PAGE_SIZE - 1UL)) == 0UL) && (map_size != 0UL) &&
+		is_kernel_module_exclusive(vm, src_hpa, round_page_up(sw_kernel->kernel_size))) {
+		/** Call ept_del_mr with the following parameters, in order to remove the mappings of the guest memory
+		 *  at the kernel load address.
+		 *  - vm
+		 *  - (uint64_t *)vm->arch_vm.nworld_eptp
+		 *  - load_gpa
+		 *  - map_size
+		 */
+		ept_del_mr(vm, (uint64_t *)vm->arch_vm.nworld_eptp, load_gpa, map_size);
+		/** Call ept_add_mr with the following parameters, in order to map the module memory at the kernel load
+		 *  address.
+		 *  - vm
+		 *  - (uint64_t *)vm->arch_vm.nworld_eptp
+		 *  - src_hpa
+		 *  - load_gpa
+		 *  - map_size
+		 *  - EPT_RWX | EPT_WB
+		 */
+		ept_add_mr(vm, (uint64_t *)vm->arch_vm.nworld_eptp, src_hpa, load_gpa, map_size, EPT_RWX | EPT_WB);
+		/** If the kernel image ends in the middle of a page */
+		if (map_size < sw_kernel->kernel_size) {
+			/** Call copy_to_gpa with the following parameters, in order to copy the trailing partial page of
+			 *  the kernel image, as the rest of the module page may hold data not owned by the VM.
+			 *  - vm
+			 *  - hpa2hva(src_hpa + map_size)
+			 *  - load_gpa + map_size
+			 *  - sw_kernel->kernel_size - map_size
+			 */
+			copy_to_gpa(vm, hpa2hva(src_hpa + map_size), load_gpa + map_size,
+				sw_kernel->kernel_size - (uint32_t)map_size);
+		}
+		/** Logging the following information with a log level of LOG_INFO.
+		 *  - __func__
+		 *  - vm->vm_id
+		 *  - map_size
+		 */
+		pr_info("%s, VM %d kernel module remapped in place, 0x%lx bytes", __func__, vm->vm_id, map_size);
+		/** Set 'placed' to true */
+		placed = true;
+	}
+
+	/** Return 'placed' */
+	return placed;
+}
+
+/**
+ * @brief Copy chunks of a posted image copy until none is left.
+ *
+ * @param[inout] job Pointer to the image copy whose chunks are to be copied.
+ *
+ * @return None
+ *
+ * @pre job != NULL
+ * @pre job->state == IMAGE_LOAD_POSTED
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_ROOT
+ *
+ * @remark It is an internal function called by parallel_copy_to_gpa and join_image_load.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+static void copy_image_chunks(struct image_load_job *job)
+{
+	/** Declare the following local variables of type uint64_t.
+	 *  - chunk representing the index of the chunk taken by the current physical CPU, initialized as the return
+	 *  value of atomic_xadd64(&job->next_chunk, 1).
+	 *  - offset representing the offset of the chunk in the image, not initialized.
+	 */
+	uint64_t chunk = atomic_xadd64(&job->next_chunk, 1UL);
+	uint64_t offset;
+
+	/** Until chunk is not less than job->chunk_num */
+	while (chunk < job->chunk_num) {
+		/** Set offset to chunk * IMAGE_LOAD_CHUNK_SIZE */
+		offset = chunk * IMAGE_LOAD_CHUNK_SIZE;
+		/** Call copy_to_gpa with the following parameters, in order to copy the chunk to its run-time location.
+		 *  - job->vm
+		 *  - job->src + offset
+		 *  - job->gpa + offset
+		 *  - the smaller value between IMAGE_LOAD_CHUNK_SIZE and job->size - offset
+		 */
+		copy_to_gpa(job->vm, job->src + offset, job->gpa + offset,
+			(uint32_t)(((job->size - offset) > IMAGE_LOAD_CHUNK_SIZE) ? IMAGE_LOAD_CHUNK_SIZE :
+			(job->size - offset)));
+		/** Call atomic_inc64 with the following parameters, in order to account the chunk as copied.
+		 *  - &job->done_chunks
+		 */
+		atomic_inc64(&job->done_chunks);
+		/** Set chunk to the return value of atomic_xadd64(&job->next_chunk, 1) */
+		chunk = atomic_xadd64(&job->next_chunk, 1UL);
+	}
+}
+
+/**
+ * @brief Copy a guest image with the help of the other physical CPUs of the VM.
+ *
+ * The image is split into chunks of IMAGE_LOAD_CHUNK_SIZE bytes that the physical CPUs waiting in join_image_load
+ * take along with the current one. It returns when all the chunks are copied, whether or not any other physical CPU
+ * took part.
+ *
+ * @param[in] vm Pointer to the VM the image is loaded into.
+ * @param[in] src Host virtual address of the image.
+ * @param[in] gpa Guest physical address the image is loaded to.
+ * @param[in] size Size of the image in bytes.
+ *
+ * @return None
+ *
+ * @pre vm != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_ROOT
+ *
+ * @remark It is an internal function called by direct_boot_sw_loader. When the VM is restarted, no other physical
+ * CPU joins and the current one copies all the chunks.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vm is different among parallel invocation
+ */
+static void parallel_copy_to_gpa(struct acrn_vm *vm, void *src, uint64_t gpa, uint64_t size)
+{
+	/** Declare the following local variables of type 'struct image_load_job *'.
+	 *  - job representing the image copy of the VM, initialized as &image_load_jobs[vm->vm_id].
+	 */
+	struct image_load_job *job = &image_load_jobs[vm->vm_id];
+
+	/** Set job->vm to vm */
+	job->vm = vm;
+	/** Set job->src to src */
+	job->src = (uint8_t *)src;
+	/** Set job->gpa to gpa */
+	job->gpa = gpa;
+	/** Set job->size to size */
+	job->size = size;
+	/** Set job->chunk_num to the number of IMAGE_LOAD_CHUNK_SIZE sized chunks needed to cover size */
+	job->chunk_num = (size + IMAGE_LOAD_CHUNK_SIZE - 1UL) / IMAGE_LOAD_CHUNK_SIZE;
+	/** Set job->next_chunk to 0 */
+	job->next_chunk = 0UL;
+	/** Set job->done_chunks to 0 */
+	job->done_chunks = 0UL;
+	/** Set job->helpers to 0 */
+	job->helpers = 0UL;
+	/** Call cpu_write_memory_barrier in order to make the image copy visible before it is posted. */
+	cpu_write_memory_barrier();
+	/** Set job->state to IMAGE_LOAD_POSTED */
+	job->state = IMAGE_LOAD_POSTED;
+
+	/** Call copy_image_chunks with the following parameters, in order to take chunks along with the other
+	 *  physical CPUs of the VM.
+	 *  - job
+	 */
+	copy_image_chunks(job);
+	/** Until job->done_chunks is equal to job->chunk_num */
+	while (*(volatile uint64_t *)&job->done_chunks != job->chunk_num) {
+		/** Call asm_pause in order to wait for the chunks taken by the other physical CPUs. */
+		asm_pause();
+	}
+}
+
+/**
+ * @brief Help the BP of the given VM to load the guest image.
+ *
+ * It is called on each physical CPU of the VM other than its BP. It waits until the BP either posts the image copy or
+ * ends the load phase, and in the former case takes chunks of the copy until none is left.
+ *
+ * @param[in] vm_id The ID of the VM whose guest image is being loaded.
+ *
+ * @return None
+ *
+ * @pre vm_id < CONFIG_MAX_VM_NUM
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_ROOT
+ *
+ * @remark It is called by launch_vms.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+void join_image_load(uint16_t vm_id)
+{
+	/** Declare the following local variables of type 'struct image_load_job *'.
+	 *  - job representing the image copy of the VM, initialized as &image_load_jobs[vm_id].
+	 */
+	struct image_load_job *job = &image_load_jobs[vm_id];
+
+	/** Until job->state is not equal to IMAGE_LOAD_IDLE */
+	while (*(volatile uint64_t *)&job->state == IMAGE_LOAD_IDLE) {
+		/** Call asm_pause in order to wait for the BP of the VM. */
+		asm_pause();
+	}
+
+	/** If job->state is equal to IMAGE_LOAD_POSTED */
+	if (*(volatile uint64_t *)&job->state == IMAGE_LOAD_POSTED) {
+		/** Call atomic_inc64 with the following parameters, in order to account the current physical CPU as a
+		 *  helper of the copy.
+		 *  - &job->helpers
+		 */
+		atomic_inc64(&job->helpers);
+		/** Call copy_image_chunks with the following parameters, in order to take chunks of the copy.
+		 *  - job
+		 */
+		copy_image_chunks(job);
+	}
+}
+
+/**
+ * @brief End the load phase of the given VM.
+ *
+ * It releases the physical CPUs of the VM that are still waiting in join_image_load, which happens when no image
+ * copy was posted for the VM.
+ *
+ * @param[in] vm_id The ID of the VM whose load phase is over.
+ *
+ * @return None
+ *
+ * @pre vm_id < CONFIG_MAX_VM_NUM
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_ROOT
+ *
+ * @remark It is called by launch_vms on the BP of the VM after prepare_vm.
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety When \a vm_id is different among parallel invocation
+ */
+void end_image_load(uint16_t vm_id)
+{
+	/** Set image_load_jobs[vm_id].state to IMAGE_LOAD_DONE */
+	image_load_jobs[vm_id].state = IMAGE_LOAD_DONE;
 }
 
 /**
@@ -396,6 +838,10 @@ void direct_boot_sw_loader(struct acrn_vm *vm)
 	 *  vcpu_from_vid(vm, BOOT_CPU_ID).
 	 */
 	struct acrn_vcpu *vcpu = vcpu_from_vid(vm, BOOT_CPU_ID);
+	/** Declare the following local variables of type uint64_t.
+	 *  - start_tsc representing the TSC value when the load phase starts, initialized as rdtsc().
+	 */
+	uint64_t start_tsc = rdtsc();
 
 	/** Logging the following information with a log level of LOG_DEBUG.
 	 *  - "Loading guest to run-time location"
@@ -409,14 +855,21 @@ void direct_boot_sw_loader(struct acrn_vm *vm)
 	 */
 	init_vcpu_protect_mode_regs(vcpu, get_guest_gdt_base_gpa(vcpu->vm));
 
-	/** Call copy_to_gpa with the following parameters, in order to copy the guest kernel image to its run-time
-	 *  location.
-	 *  - vm
-	 *  - sw_kernel->kernel_src_addr
-	 *  - sw_kernel->kernel_load_addr
-	 *  - sw_kernel->kernel_size
-	 */
-	copy_to_gpa(vm, sw_kernel->kernel_src_addr, sw_kernel->kernel_load_addr, sw_kernel->kernel_size);
+	/** Set sw_kernel->kernel_in_place to the return value of place_kernel_image(vm) */
+	sw_kernel->kernel_in_place = place_kernel_image(vm);
+	/** If sw_kernel->kernel_in_place is false, indicating that the guest kernel image could not be placed at its
+	 *  run-time location without copying */
+	if (!sw_kernel->kernel_in_place) {
+		/** Call parallel_copy_to_gpa with the following parameters, in order to copy the guest kernel image to
+		 *  its run-time location with the help of the other physical CPUs of the VM.
+		 *  - vm
+		 *  - sw_kernel->kernel_src_addr
+		 *  - sw_kernel->kernel_load_addr
+		 *  - sw_kernel->kernel_size
+		 */
+		parallel_copy_to_gpa(vm, sw_kernel->kernel_src_addr, sw_kernel->kernel_load_addr,
+			sw_kernel->kernel_size);
+	}
 
 	/** If bootargs_info->size is not 0, which means the guest OS contains boot arguments info */
 	if (bootargs_info->size != 0U) {
@@ -474,6 +927,13 @@ void direct_boot_sw_loader(struct acrn_vm *vm)
 	 */
 	pr_info("%s, VM %hu VCPU %hu Entry: 0x%016lx ", __func__, vm->vm_id, vcpu->vcpu_id,
 		sw_kernel->kernel_entry_addr);
+	/** Logging the following information with a log level of LOG_INFO.
+	 *  - vm->vm_id
+	 *  - the microseconds elapsed since start_tsc
+	 *  - image_load_jobs[vm->vm_id].helpers + 1
+	 */
+	pr_info("VM %hu loaded in %lu us by %lu pCPUs", vm->vm_id, ((rdtsc() - start_tsc) * 1000UL) / get_tsc_khz(),
+		image_load_jobs[vm->vm_id].helpers + 1UL);
 }
 
 /**
@@ -23,10 +23,29 @@
  * and uses vp-base.vcpu module to access to vCPU registers during the emulation of I/O instructions.
  *
  * External APIs:
+ * - register_mmio_emulation_handler() This function is the API to register a MMIO emulation handler
+ *                                     for a guest physical address range of specific VM.
+ *					Depends on:
+ *					 - N/A.
+ *
+ * - unregister_mmio_emulation_handler() This function is the API to unregister the MMIO emulation handler
+ *                                     of a guest physical address range of specific VM.
+ *					Depends on:
+ *					 - N/A.
+ *
+ * - is_emulated_mmio()                This function checks whether a guest physical address is emulated.
+ *					Depends on:
+ *					 - find_mmio_node()
+ *
+ * - emulate_mmio()                    This function dispatches a MMIO access to its registered handler.
+ *					Depends on:
+ *					 - find_mmio_node()
+ *
  * - register_pio_emulation_handler()  This function is the API to register port IO emulation handlers
  *                                     (Read/Write callback functions) for specific VM.
  *					Depends on:
- *					 - N/A.
+ *					 - pio_map_lookup()
+ *					 - pio_map_set()
  *
  * - pio_instr_vmexit_handler()        This function handles VM exits on I/O instructions.
  *					Depends on:
@@ -35,6 +54,7 @@
  *					 - vm_exit_io_instruction_access_direction()
  *					 - vcpu_get_gpreg()
  *					 - emulate_io()
+ *					 - emulate_io_string()
  *
  * Internal functions:
  * - emulate_io()			This function implements port I/O instruction emulation and updates
@@ -43,8 +63,28 @@
  *					 - hv_emulate_pio()
  *					 - emulate_pio_complete()
  *
+ * - emulate_io_string()		This function runs the elements of a string port I/O instruction
+ *					through hv_emulate_pio() against a host buffer.
+ *					Depends on:
+ *					 - hv_emulate_pio()
+ *
  * - hv_emulate_pio()			This function implements port I/O read/write emulation.
  *					Depends on:
+ *					 - pio_map_lookup()
+ *
+ * - find_mmio_node()			This function finds the registered MMIO handler entry
+ *					covering a MMIO access.
+ *					Depends on:
+ *					 - N/A.
+ *
+ * - pio_map_lookup()			This function looks up the handler index of an I/O port
+ *					in the per-VM two-level port I/O handler map.
+ *					Depends on:
+ *					 - N/A.
+ *
+ * - pio_map_set()			This function updates the handler index of an I/O port
+ *					in the per-VM two-level port I/O handler map.
+ *					Depends on:
  *					 - N/A.
  *
  * - emulate_pio_complete()		This function updates vCPU register for port I/O read
@@ -71,10 +111,16 @@
   *
   * External APIs:
   * - register_pio_emulation_handler()
+  * - register_mmio_emulation_handler()
+  * - unregister_mmio_emulation_handler()
+  * - is_emulated_mmio()
+  * - emulate_mmio()
   *
   * Internal functions:
   * - pio_default_read()
   * - pio_default_write()
+  * - pio_map_lookup()
+  * - pio_map_set()
   * - hv_emulate_pio()
   * - emulate_pio_complete()
   * - emulate_pio()
@@ -158,6 +204,119 @@ static void pio_default_write(
 	/* ignore write */
 }
 
+/**
+ * @brief Look up the index of the emulation handler registered for the given I/O port.
+ *
+ * @param [in]     map   Pointer to the port I/O handler map of a VM.
+ * @param [in]     port  I/O port number being accessed.
+ *
+ * @return The index of the handler in the 'emul_pio' array of the VM plus one, or 0 if no handler is
+ *	   registered for \p port.
+ *
+ * @pre map != NULL
+ *
+ * @post return value <= EMUL_PIO_IDX_MAX
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety True
+ */
+static inline uint8_t pio_map_lookup(const struct vm_pio_map *map, uint16_t port)
+{
+	/** Declare the following local variables of type uint8_t.
+	 *  - dir representing the first-level entry covering port, initialized as map->dir[port >> 8]. */
+	uint8_t dir = map->dir[port >> 8U];
+
+	/** Return 0 if dir is 0, otherwise the second-level entry of port in page 'dir - 1' */
+	return (dir == 0U) ? 0U : map->page[dir - 1U][port & (PIO_MAP_PAGE_PORTS - 1U)];
+}
+
+/**
+ * @brief Set the handler map entry of the given I/O port.
+ *
+ *  A second-level page is taken from the pool when the first port of a 256-port block gets a handler, and
+ *  returned to the pool when the last one loses it.
+ *
+ * @param [inout]  map    Pointer to the port I/O handler map of a VM.
+ * @param [in]     port   I/O port number whose entry is set.
+ * @param [in]     entry  The handler index plus one, or 0 to remove the handler of \p port.
+ *
+ * @return None
+ *
+ * @pre map != NULL
+ * @pre entry <= EMUL_PIO_IDX_MAX
+ *
+ * @post None
+ *
+ * @mode HV_SUBMODE_INIT_POST_SMP, HV_OPERATIONAL
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety This function is thread-safe under condition that /p map is different among parallel
+ *		 invocations.
+ */
+static void pio_map_set(struct vm_pio_map *map, uint16_t port, uint8_t entry)
+{
+	/** Declare the following local variables of type uint32_t.
+	 *  - dir_idx representing the first-level index of port, initialized as port >> 8.
+	 *  - off representing the second-level index of port, initialized as port & (PIO_MAP_PAGE_PORTS - 1).
+	 *  - page_idx representing the second-level page covering port, not initialized. */
+	uint32_t dir_idx = (uint32_t)port >> 8U, off = (uint32_t)port & (PIO_MAP_PAGE_PORTS - 1U), page_idx;
+	/** Declare the following local variables of type bool.
+	 *  - mapped representing whether a second-level page covers port, initialized as map->dir[dir_idx] != 0. */
+	bool mapped = (map->dir[dir_idx] != 0U);
+
+	/** If no second-level page covers port yet and entry is not 0, as otherwise there is nothing to remove */
+	if ((!mapped) && (entry != 0U)) {
+		/** For each page_idx ranging from 0 to PIO_MAP_PAGE_NUM - 1, until a free page is found */
+		for (page_idx = 0U; page_idx < PIO_MAP_PAGE_NUM; page_idx++) {
+			/** If page page_idx holds no handler, indicating that it is free */
+			if (map->used[page_idx] == 0U) {
+				/** Terminate the loop */
+				break;
+			}
+		}
+		/** If no free page is left */
+		if (page_idx == PIO_MAP_PAGE_NUM) {
+			/** Logging the following information with a log level of LOG_ERROR.
+			 *  - port */
+			pr_err("%s: no free page to map port 0x%x", __func__, port);
+		} else {
+			/** Set map->dir[dir_idx] to page_idx + 1 */
+			map->dir[dir_idx] = (uint8_t)(page_idx + 1U);
+			/** Set mapped to true */
+			mapped = true;
+		}
+	}
+
+	/** If a second-level page covers port */
+	if (mapped) {
+		/** Set page_idx to map->dir[dir_idx] - 1 */
+		page_idx = (uint32_t)map->dir[dir_idx] - 1U;
+		/** If port has no handler and entry is not 0 */
+		if ((map->page[page_idx][off] == 0U) && (entry != 0U)) {
+			/** Increment map->used[page_idx] by 1 */
+			map->used[page_idx]++;
+		/** If port has a handler and entry is 0 */
+		} else if ((map->page[page_idx][off] != 0U) && (entry == 0U)) {
+			/** Decrement map->used[page_idx] by 1 */
+			map->used[page_idx]--;
+		} else {
+			/* the number of mapped ports is unchanged */
+		}
+		/** Set map->page[page_idx][off] to entry */
+		map->page[page_idx][off] = entry;
+
+		/** If page page_idx holds no handler any more */
+		if (map->used[page_idx] == 0U) {
+			/** Set map->dir[dir_idx] to 0 to return the page to the pool */
+			map->dir[dir_idx] = 0U;
+		}
+	}
+}
+
 /**
  * @brief This function handles the port I/O request by I/O handler registered to VMs or by
  *	  the default handlers when port range specific handlers are not registered.
@@ -190,9 +349,9 @@ static void hv_emulate_pio(struct acrn_vcpu *vcpu, struct io_request *io_req)
 	/** Declare the following local variables of type uint16_t.
 	 *  - size representing the size of port being accessed, not initialized. */
 	uint16_t size;
-	/** Declare the following local variables of type uint32_t.
-	 *  - idx representing index to vm->emul_pio[] array, not initialized. */
-	uint32_t idx;
+	/** Declare the following local variables of type uint8_t.
+	 *  - entry representing the index to vm->emul_pio[] array plus one, not initialized. */
+	uint8_t entry;
 	/** Declare the following local variables of type struct acrn_vm *.
 	 *  - vm representing pointer to an instance of struct acrn_vm, initialized as vcpu->vm. */
 	struct acrn_vm *vm = vcpu->vm;
@@ -217,19 +376,14 @@ static void hv_emulate_pio(struct acrn_vcpu *vcpu, struct io_request *io_req)
 	/** Set size to the size of I/O port being accessed from the guest VM */
 	size = (uint16_t)pio_req->size;
 
-	/** For each idx  ranging from 0 to EMUL_PIO_IDX_MAX - 1 with a step of 1 */
-	for (idx = 0U; idx < EMUL_PIO_IDX_MAX; idx++) {
-		/** Set handler to the address to (vm->emual_pio[idx)) */
-		handler = &(vm->emul_pio[idx]);
+	/** Set entry to the return value of pio_map_lookup(&vm->pio_map, port), which is the index of the
+	 *  handler registered for port plus one */
+	entry = pio_map_lookup(&vm->pio_map, port);
 
-		/**
-		 * port being accessed from guest VM is less than the start port address
-		 * of handler or  greater than or equal to the end port address of handler.
-		 */
-		if ((port < handler->port_start) || (port >= handler->port_end)) {
-			/** Continue to next iteration */
-			continue;
-		}
+	/** If a handler is registered for port */
+	if (entry != 0U) {
+		/** Set handler to the address to (vm->emul_pio[entry - 1]) */
+		handler = &(vm->emul_pio[entry - 1U]);
 
 		/** If io_read callback of handler is not NULL. */
 		if (handler->io_read != NULL) {
@@ -241,8 +395,6 @@ static void hv_emulate_pio(struct acrn_vcpu *vcpu, struct io_request *io_req)
 			/** Set io_write to handler->io_write */
 			io_write = handler->io_write;
 		}
-		/** Terminate the loop */
-		break;
 	}
 
 	/** If direction of pio_req is REQUEST_WRITE. */
@@ -385,9 +537,105 @@ void emulate_io(struct acrn_vcpu *vcpu, struct io_request *io_req)
 	emulate_pio_complete(vcpu, io_req);
 }
 
+/**
+ * @brief This function runs the elements of a string port I/O instruction through hv_emulate_pio()
+ *	  against a host buffer holding the guest memory operand.
+ *
+ *  The elements are taken from (OUTS) or stored into (INS) \p buf in the order the instruction
+ *  accesses them: ascending addresses when \p backward is false and descending addresses otherwise.
+ *  The RAX register of \p vcpu is not touched.
+ *
+ * @param [in]     vcpu     Pointer to the instance of struct acrn_vcpu, which is the context of virtual
+ *			    CPU that triggers the I/O access.
+ * @param [inout]  io_req   Pointer to the instance of struct io_request, which holds the port address,
+ *			    the size of each element and the direction of the access.
+ * @param [inout]  buf      Pointer to the host buffer of \p count elements laid out in guest memory order.
+ * @param [in]     count    Number of elements to transfer.
+ * @param [in]     backward Whether the elements are accessed from the highest address down (RFLAGS.DF set).
+ *
+ * @return None
+ *
+ * @pre io_req != NULL
+ * @pre vcpu != NULL
+ * @pre vcpu->vm != NULL
+ * @pre buf != NULL
+ * @pre io_req->reqs.pio.size == 1 || io_req->reqs.pio.size == 2 || io_req->reqs.pio.size == 4
+ *
+ * @post None
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety This function is thread-safe under condition that /p vcpu and /p io_req
+ *		 are different among parallel invocations.
+ */
+void emulate_io_string(struct acrn_vcpu *vcpu, struct io_request *io_req, uint8_t *buf, uint32_t count,
+	bool backward)
+{
+	/**
+	 * Declare the following local variables of type struct pio_request *.
+	 *  - pio_req representing a pointer to an instance of struct pio_request,
+	 *    initialized as &io_req->reqs.pio.
+	 */
+	struct pio_request *pio_req = &io_req->reqs.pio;
+	/**
+	 * Declare the following local variables of type uint32_t.
+	 *  - size representing the size of each element in bytes, initialized as pio_req->size.
+	 *  - i representing the loop counter, not initialized.
+	 */
+	uint32_t size = (uint32_t)pio_req->size, i;
+	/**
+	 * Declare the following local variables of type uint8_t *.
+	 *  - elem representing the element of buf being transferred, not initialized.
+	 */
+	uint8_t *elem;
+
+	/** For each i from 0 to count - 1 */
+	for (i = 0U; i < count; i++) {
+		/** Set elem to the i-th element accessed by the instruction, counted from the end of buf
+		 *  if backward is true */
+		elem = backward ? &buf[(count - 1U - i) * size] : &buf[i * size];
+		/** If direction of pio_req is REQUEST_WRITE */
+		if (pio_req->direction == REQUEST_WRITE) {
+			/** Set pio_req->value to 0 */
+			pio_req->value = 0U;
+			/** Call memcpy_s() with the following parameters, in order to load the element to be written
+			 *  into the low bytes of pio_req->value.
+			 *  - &pio_req->value
+			 *  - size
+			 *  - elem
+			 *  - size
+			 */
+			(void)memcpy_s(&pio_req->value, size, elem, size);
+		}
+		/** Call hv_emulate_pio() with the following parameters, in order to
+		 *  emulate the port I/O request of this element.
+		 *  - vcpu
+		 *  - io_req
+		 */
+		hv_emulate_pio(vcpu, io_req);
+		/** If direction of pio_req is REQUEST_READ */
+		if (pio_req->direction == REQUEST_READ) {
+			/** Call memcpy_s() with the following parameters, in order to store the low bytes of
+			 *  pio_req->value into the element.
+			 *  - elem
+			 *  - size
+			 *  - &pio_req->value
+			 *  - size
+			 */
+			(void)memcpy_s(elem, size, &pio_req->value, size);
+		}
+	}
+}
+
 /**
  * @brief Register a port I/O handler
  *
+ *  The ports of the range previously registered at \p pio_idx are removed from the port I/O handler
+ *  map of \p vm and the ports of \p range are mapped to \p pio_idx, so that each I/O exit finds its
+ *  handler with one table lookup.
+ *
  * @param [inout] vm		  Pointer to instance of struct acrn_vm for which the port I/O
  *				  handlers are registered
  * @param [in]    pio_idx	  The emulated port I/O address
@@ -413,6 +661,30 @@ void emulate_io(struct acrn_vcpu *vcpu, struct io_request *io_req)
 void register_pio_emulation_handler(struct acrn_vm *vm, uint32_t pio_idx, const struct vm_io_range *range,
 	io_read_fn_t io_read_fn_ptr, io_write_fn_t io_write_fn_ptr)
 {
+	/** Declare the following local variables of type uint32_t.
+	 *  - port representing the I/O port whose map entry is updated, not initialized. */
+	uint32_t port;
+
+	/** For each port in the range previously registered at pio_idx */
+	for (port = vm->emul_pio[pio_idx].port_start; port < vm->emul_pio[pio_idx].port_end; port++) {
+		/** If port is still mapped to pio_idx */
+		if (pio_map_lookup(&vm->pio_map, (uint16_t)port) == (uint8_t)(pio_idx + 1U)) {
+			/** Call pio_map_set with the following parameters, in order to remove the handler of port.
+			 *  - &vm->pio_map
+			 *  - port
+			 *  - 0 */
+			pio_map_set(&vm->pio_map, (uint16_t)port, 0U);
+		}
+	}
+	/** For each port in the range to be registered */
+	for (port = range->base; port < ((uint32_t)range->base + range->len); port++) {
+		/** Call pio_map_set with the following parameters, in order to map port to pio_idx.
+		 *  - &vm->pio_map
+		 *  - port
+		 *  - pio_idx + 1 */
+		pio_map_set(&vm->pio_map, (uint16_t)port, (uint8_t)(pio_idx + 1U));
+	}
+
 	/** Set vm->emul_pio[pio_idx].port_start to range->base */
 	vm->emul_pio[pio_idx].port_start = range->base;
 	/** Set vm->emul_pio[pio_idx].port_end to range->base + range->len */
@@ -423,6 +695,322 @@ void register_pio_emulation_handler(struct acrn_vm *vm, uint32_t pio_idx, const
 	vm->emul_pio[pio_idx].io_write = io_write_fn_ptr;
 }
 
+/**
+ * @brief Register a MMIO handler
+ *
+ *  A registration with the same \p start as an earlier one of \p vm replaces it, so a VM that is
+ *  initialized again keeps one entry per range.
+ *
+ * @param [inout] vm		  Pointer to instance of struct acrn_vm for which the MMIO handler is registered
+ * @param [in]    read_write	  The handler for emulating reads and writes to the given range
+ * @param [in]    start		  Guest physical base address of the range
+ * @param [in]    end		  Guest physical address right after the range
+ * @param [in]    handler_private_data The private data passed to \p read_write
+ *
+ * @return 0 if the handler is registered, -EBUSY if all EMUL_MMIO_REGIONS_MAX entries are used.
+ *
+ * @pre vm != NULL
+ * @pre read_write != NULL
+ * @pre start < end
+ *
+ * @post None
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety True, as vm->emul_mmio_lock is held while the entries of \p vm are updated
+ *
+ * @remark The range shall not be mapped in the EPT of \p vm, so that guest accesses cause EPT violations.
+ */
+int32_t register_mmio_emulation_handler(struct acrn_vm *vm, hv_mem_io_handler_t read_write, uint64_t start,
+	uint64_t end, void *handler_private_data)
+{
+	/** Declare the following local variables of type uint16_t.
+	 *  - i representing the index to vm->emul_mmio[], not initialized. */
+	uint16_t i;
+	/** Declare the following local variables of type struct mem_io_node *.
+	 *  - node representing the entry to fill in, initialized as NULL. */
+	struct mem_io_node *node = NULL;
+	/** Declare the following local variables of type int32_t.
+	 *  - ret representing the return value, initialized as 0. */
+	int32_t ret = 0;
+
+	/** Call spinlock_obtain with the following parameters, in order to keep the MMIO handler entries of \p vm
+	 *  consistent with the concurrent lookups from other vCPUs.
+	 *  - &vm->emul_mmio_lock */
+	spinlock_obtain(&vm->emul_mmio_lock);
+	/** For each i ranging from 0 to vm->nr_emul_mmio_regions - 1 */
+	for (i = 0U; i < vm->nr_emul_mmio_regions; i++) {
+		/** If the range of vm->emul_mmio[i] starts at start */
+		if (vm->emul_mmio[i].range_start == start) {
+			/** Set node to &vm->emul_mmio[i] to replace the earlier registration */
+			node = &vm->emul_mmio[i];
+			/** Terminate the loop */
+			break;
+		}
+	}
+
+	/** If no earlier registration for start is found */
+	if (node == NULL) {
+		/** If all entries of vm->emul_mmio[] are used */
+		if (vm->nr_emul_mmio_regions >= EMUL_MMIO_REGIONS_MAX) {
+			/** Logging the following information with a log level of LOG_ERROR.
+			 *  - start
+			 *  - end */
+			pr_err("%s: no free MMIO handler entry for [0x%lx, 0x%lx)", __func__, start, end);
+			/** Set ret to -EBUSY */
+			ret = -EBUSY;
+		} else {
+			/** Set node to the first unused entry of vm->emul_mmio[] */
+			node = &vm->emul_mmio[vm->nr_emul_mmio_regions];
+			/** Increment vm->nr_emul_mmio_regions by 1 */
+			vm->nr_emul_mmio_regions++;
+		}
+	}
+
+	/** If node is not NULL */
+	if (node != NULL) {
+		/** Set node->read_write to read_write */
+		node->read_write = read_write;
+		/** Set node->handler_private_data to handler_private_data */
+		node->handler_private_data = handler_private_data;
+		/** Set node->range_start to start */
+		node->range_start = start;
+		/** Set node->range_end to end */
+		node->range_end = end;
+	}
+	/** Call spinlock_release with the following parameters, in order to release the lock obtained above.
+	 *  - &vm->emul_mmio_lock */
+	spinlock_release(&vm->emul_mmio_lock);
+
+	/** Return ret */
+	return ret;
+}
+
+/**
+ * @brief Unregister the MMIO handler registered for a range starting at a given address
+ *
+ * @param [inout] vm	Pointer to instance of struct acrn_vm whose MMIO handler is unregistered
+ * @param [in]    start	Guest physical base address of the range given at registration
+ *
+ * @return None
+ *
+ * @pre vm != NULL
+ *
+ * @post None
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety True, as vm->emul_mmio_lock is held while the entries of \p vm are updated
+ *
+ * @remark Nothing is done if no handler is registered for \p start.
+ */
+void unregister_mmio_emulation_handler(struct acrn_vm *vm, uint64_t start)
+{
+	/** Declare the following local variables of type uint16_t.
+	 *  - i representing the index to vm->emul_mmio[], not initialized. */
+	uint16_t i;
+
+	/** Call spinlock_obtain with the following parameters, in order to keep the MMIO handler entries of \p vm
+	 *  consistent with the concurrent lookups from other vCPUs.
+	 *  - &vm->emul_mmio_lock */
+	spinlock_obtain(&vm->emul_mmio_lock);
+	/** For each i ranging from 0 to vm->nr_emul_mmio_regions - 1 */
+	for (i = 0U; i < vm->nr_emul_mmio_regions; i++) {
+		/** If the range of vm->emul_mmio[i] starts at start */
+		if (vm->emul_mmio[i].range_start == start) {
+			/** Decrement vm->nr_emul_mmio_regions by 1 */
+			vm->nr_emul_mmio_regions--;
+			/** Move the last used entry of vm->emul_mmio[] to vm->emul_mmio[i] */
+			vm->emul_mmio[i] = vm->emul_mmio[vm->nr_emul_mmio_regions];
+			/** Clear the entry just released */
+			(void)memset(&vm->emul_mmio[vm->nr_emul_mmio_regions], 0U, sizeof(struct mem_io_node));
+			/** Terminate the loop */
+			break;
+		}
+	}
+	/** Call spinlock_release with the following parameters, in order to release the lock obtained above.
+	 *  - &vm->emul_mmio_lock */
+	spinlock_release(&vm->emul_mmio_lock);
+}
+
+/**
+ * @brief This function finds the registered MMIO handler entry that covers a MMIO access.
+ *
+ * @param [in] vm      Pointer to instance of struct acrn_vm
+ * @param [in] address Guest physical address of the access
+ * @param [in] size    Size of the access in bytes
+ *
+ * @return Pointer to the entry of vm->emul_mmio[] covering [address, address + size), or NULL if none.
+ *
+ * @pre vm != NULL
+ *
+ * @post None
+ *
+ * @pre vm->emul_mmio_lock is held by the caller
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety True, as long as vm->emul_mmio_lock is held by the caller
+ *
+ * @remark The returned entry may be moved or cleared once vm->emul_mmio_lock is released.
+ */
+static const struct mem_io_node *find_mmio_node(const struct acrn_vm *vm, uint64_t address, uint64_t size)
+{
+	/** Declare the following local variables of type uint16_t.
+	 *  - i representing the index to vm->emul_mmio[], not initialized. */
+	uint16_t i;
+	/** Declare the following local variables of type const struct mem_io_node *.
+	 *  - node representing the entry found, initialized as NULL. */
+	const struct mem_io_node *node = NULL;
+
+	/** For each i ranging from 0 to vm->nr_emul_mmio_regions - 1 */
+	for (i = 0U; i < vm->nr_emul_mmio_regions; i++) {
+		/** If [address, address + size) lies in the range of vm->emul_mmio[i] */
+		if ((address >= vm->emul_mmio[i].range_start) && ((address + size) <= vm->emul_mmio[i].range_end)) {
+			/** Set node to &vm->emul_mmio[i] */
+			node = &vm->emul_mmio[i];
+			/** Terminate the loop */
+			break;
+		}
+	}
+
+	/** Return node */
+	return node;
+}
+
+/**
+ * @brief Check whether a guest physical address is emulated by a registered MMIO handler.
+ *
+ * @param [in] vm  Pointer to instance of struct acrn_vm
+ * @param [in] gpa The guest physical address
+ *
+ * @return true if a MMIO handler is registered for \p gpa, otherwise false.
+ *
+ * @pre vm != NULL
+ *
+ * @post None
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety True, as vm->emul_mmio_lock is held while the entries of \p vm are looked up
+ */
+bool is_emulated_mmio(struct acrn_vm *vm, uint64_t gpa)
+{
+	/** Declare the following local variables of type bool.
+	 *  - found representing whether a handler is registered for \p gpa, not initialized. */
+	bool found;
+
+	/** Call spinlock_obtain with the following parameters, in order to look up the entries consistently.
+	 *  - &vm->emul_mmio_lock */
+	spinlock_obtain(&vm->emul_mmio_lock);
+	/** Set found to true if find_mmio_node(vm, gpa, 1) finds an entry, otherwise false */
+	found = (find_mmio_node(vm, gpa, 1UL) != NULL);
+	/** Call spinlock_release with the following parameters, in order to release the lock obtained above.
+	 *  - &vm->emul_mmio_lock */
+	spinlock_release(&vm->emul_mmio_lock);
+
+	/** Return found */
+	return found;
+}
+
+/**
+ * @brief This function handles a MMIO access request by the MMIO handler registered for its range.
+ *
+ * @param [in]     vcpu    Pointer to the instance of struct acrn_vcpu, which is the context of virtual
+ *			   CPU that triggers the MMIO access.
+ * @param [inout]  io_req  Pointer to the instance of struct io_request, whose reqs.mmio holds the
+ *			   MMIO request and receives the value read.
+ *
+ * @return 0 if the access is emulated, -EINVAL if no registered range covers the access,
+ *	   otherwise the error returned by the handler.
+ *
+ * @pre vcpu != NULL
+ * @pre vcpu->vm != NULL
+ * @pre io_req != NULL
+ *
+ * @post None
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety This function is thread-safe under condition that /p vcpu and /p io_req
+ *		 are different among parallel invocations.
+ */
+int32_t emulate_mmio(struct acrn_vcpu *vcpu, struct io_request *io_req)
+{
+	/** Declare the following local variables of type struct mmio_request *.
+	 *  - mmio_req representing a pointer to the MMIO request, initialized as &io_req->reqs.mmio. */
+	struct mmio_request *mmio_req = &io_req->reqs.mmio;
+	/** Declare the following local variables of type struct acrn_vm *.
+	 *  - vm representing the VM the access comes from, initialized as vcpu->vm. */
+	struct acrn_vm *vm = vcpu->vm;
+	/** Declare the following local variables of type const struct mem_io_node *.
+	 *  - node representing the handler entry covering the access, not initialized. */
+	const struct mem_io_node *node;
+	/** Declare the following local variables of type hv_mem_io_handler_t.
+	 *  - read_write representing the handler covering the access, initialized as NULL. */
+	hv_mem_io_handler_t read_write = NULL;
+	/** Declare the following local variables of type void *.
+	 *  - handler_private_data representing the private data of read_write, initialized as NULL. */
+	void *handler_private_data = NULL;
+	/** Declare the following local variables of type int32_t.
+	 *  - ret representing the return value, initialized as -EINVAL. */
+	int32_t ret = -EINVAL;
+
+	/* The handler is copied out under the lock and called after it is released, as a handler may itself
+	 * register or unregister MMIO handlers of the VM. */
+	/** Call spinlock_obtain with the following parameters, in order to look up the entries consistently.
+	 *  - &vm->emul_mmio_lock */
+	spinlock_obtain(&vm->emul_mmio_lock);
+	/** Set node to the return value of find_mmio_node(vm, mmio_req->address, mmio_req->size) */
+	node = find_mmio_node(vm, mmio_req->address, mmio_req->size);
+	/** If a handler entry covers the access */
+	if (node != NULL) {
+		/** Set read_write to node->read_write */
+		read_write = node->read_write;
+		/** Set handler_private_data to node->handler_private_data */
+		handler_private_data = node->handler_private_data;
+	}
+	/** Call spinlock_release with the following parameters, in order to release the lock obtained above.
+	 *  - &vm->emul_mmio_lock */
+	spinlock_release(&vm->emul_mmio_lock);
+
+	/** If a handler covers the access */
+	if (read_write != NULL) {
+		/** Call read_write() with the following parameters and set ret to its return value,
+		 *  in order to emulate the MMIO access.
+		 *  - io_req
+		 *  - handler_private_data
+		 */
+		ret = read_write(io_req, handler_private_data);
+	} else {
+		/** Logging the following information with a log level of LOG_ERROR.
+		 *  - mmio_req->address
+		 *  - mmio_req->size */
+		pr_err("%s: MMIO access at 0x%lx size %lu crosses or misses the emulated ranges", __func__,
+			mmio_req->address, mmio_req->size);
+	}
+
+	/** Logging the following information with a log level of LOG_DEBUG.
+	 *  - mmio_req->direction
+	 *  - mmio_req->address
+	 *  - mmio_req->value */
+	pr_dbg("MMIO %s at 0x%lx, data 0x%lx", (mmio_req->direction == REQUEST_READ) ? "read" : "write",
+		mmio_req->address, mmio_req->value);
+
+	/** Return ret */
+	return ret;
+}
+
 /**
  * @}
  */
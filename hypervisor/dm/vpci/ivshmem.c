@@ -0,0 +1,859 @@
+/*
+ * Copyright (C) 2019 Intel Corporation. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <vm.h>
+#include <pci.h>
+#include <ept.h>
+#include <e820.h>
+#include <msr.h>
+#include <apicreg.h>
+#include <ptdev.h>
+#include <vlapic.h>
+#include <per_cpu.h>
+#include <logmsg.h>
+#include "vpci_priv.h"
+
+/**
+ * @addtogroup vp-dm_vperipheral
+ *
+ * @{
+ */
+
+/**
+ * @file
+ * @brief This file implements the virtual inter-VM shared memory (ivshmem) device.
+ *
+ * An ivshmem device exposes a memory region shared by the VMs whose configurations hold an ivshmem device with the
+ * same shm_hpa, so that partitions can exchange data without any VM exit. The device has two BARs:
+ * - BAR0, a 16-byte port I/O BAR holding the registers below. Port I/O is used as the hypervisor cannot trap MMIO.
+ * - BAR2, a 64-bit prefetchable memory BAR mapped with write-back memory type to the shared region in the EPT.
+ *
+ * Registers in BAR0, all 32-bit wide:
+ * - 00H IntrMask and 04H IntrStatus, which read as 0 as legacy interrupts are not supported.
+ * - 08H IVPosition, which reads as the ID of the VM, used as the peer ID of the device.
+ * - 0CH Doorbell, where writing (peer ID << 16) | vector raises the MSI programmed in the device of the peer VM
+ *   sharing the same region. Only vector 0 exists as the device has a single MSI.
+ *
+ * The MSI is raised by sending an IPI with the programmed vector to the physical CPU the destination vCPU of the
+ * peer runs on, which delivers it straight to the guest as its local APIC is passed through. Only fixed delivery
+ * mode and physical destination mode are supported, as for the IPIs of the guests.
+ *
+ * At most one ivshmem device is supported per VM, as its registers use the port I/O handler IVSHMEM_PIO_IDX. The
+ * shared region is neither cleared, scrubbed nor captured in snapshots: the peers shall treat its content as
+ * untrusted.
+ *
+ * Following functions are included:
+ * - init_ivshmem: initialize the device and map its BARs.
+ * - deinit_ivshmem: unmap the BARs of the device.
+ * - ivshmem_read_cfg: read a register from the configuration space of the device.
+ * - ivshmem_write_cfg: write a register in the configuration space of the device.
+ *
+ * Helper functions include: is_shm_region_valid, ivshmem_map_shm, ivshmem_unmap_shm, ivshmem_register_pio,
+ * ivshmem_write_io_vbar, ivshmem_write_msi_cfg, ivshmem_ring_doorbell, ivshmem_io_read and ivshmem_io_write.
+ */
+
+#define IVSHMEM_VENDOR_ID	0x1af4U	/**< Vendor ID of ivshmem devices */
+#define IVSHMEM_DEVICE_ID	0x1110U	/**< Device ID of ivshmem devices */
+#define IVSHMEM_CLASS		0x05U	/**< Memory controller class */
+
+#define IVSHMEM_REG_BAR		0U	/**< Index of the port I/O BAR holding the registers */
+#define IVSHMEM_SHM_BAR		2U	/**< Index of the 64-bit memory BAR of the shared region */
+#define IVSHMEM_REG_SIZE	16U	/**< Size in bytes of the port I/O BAR */
+
+#define IVSHMEM_IV_POSITION	0x8U	/**< Offset of the IVPosition register */
+#define IVSHMEM_DOORBELL	0xCU	/**< Offset of the Doorbell register */
+
+#define IVSHMEM_MSI_CAPOFF	0x40U	/**< Offset of the MSI capability in the configuration space */
+#define IVSHMEM_MSI_CAPLEN	14U	/**< Length of the 64-bit MSI capability */
+
+/**
+ * @brief The ivshmem device of each VM, NULL if the VM has none or it is de-initialized.
+ */
+static struct pci_vdev *ivshmem_vdevs[CONFIG_MAX_VM_NUM];
+
+/**
+ * @brief Check whether the region an ivshmem device shares can be mapped into guests.
+ *
+ * The region shall be a power of 2 no smaller than a page and sit in RAM, overlapping no memory reserved for other
+ * uses as checked by is_host_region_reserved, and the base address of BAR2 shall be aligned to its size.
+ *
+ * @param[in] dev_config The configuration of the ivshmem device.
+ *
+ * @return true if the region is valid, otherwise false.
+ *
+ * @pre dev_config != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_POST_SMP, HV_OPERATIONAL
+ *
+ * @remark It is an internal function called by init_ivshmem.
+ *
+ * @reentrancy unspecified
+ * @threadsafety Yes
+ */
+static bool is_shm_region_valid(const struct acrn_vm_pci_dev_config *dev_config)
+{
+	/** Declare the following local variables of type uint64_t.
+	 *  - hpa representing the start HPA of the region, initialized as dev_config->shm_hpa.
+	 *  - size representing the size of the region, initialized as dev_config->shm_size. */
+	uint64_t hpa = dev_config->shm_hpa, size = dev_config->shm_size;
+	/** Declare the following local variables of type 'const struct e820_entry *'.
+	 *  - entry representing the host E820 table, initialized as the return value of get_e820_entry(). */
+	const struct e820_entry *entry = get_e820_entry();
+	/** Declare the following local variables of type uint32_t.
+	 *  - i representing the loop index, not initialized. */
+	uint32_t i;
+	/** Declare the following local variables of type bool.
+	 *  - valid representing the result, initialized as false. */
+	bool valid = false;
+
+	/** If size is a power of 2 no smaller than PAGE_SIZE, hpa is page aligned and the GPA of BAR2 is aligned
+	 *  to size */
+	if ((size >= PAGE_SIZE) && ((size & (size - 1UL)) == 0UL) && ((hpa & (PAGE_SIZE - 1UL)) == 0UL) &&
+		((dev_config->vbar_base[IVSHMEM_SHM_BAR] & (size - 1UL)) == 0UL)) {
+		/** For each i ranging from 0 to get_e820_entries_count() - 1 [with a step of 1] */
+		for (i = 0U; i < get_e820_entries_count(); i++) {
+			/** If entry[i] is a RAM entry holding [hpa, hpa + size) */
+			if ((entry[i].type == E820_TYPE_RAM) && (hpa >= entry[i].baseaddr) &&
+				((hpa + size) <= (entry[i].baseaddr + entry[i].length))) {
+				/** Set valid to true */
+				valid = true;
+				/** Terminate the loop */
+				break;
+			}
+		}
+	}
+
+	/** Set 'valid' to false if [hpa, hpa + size) overlaps memory reserved for other uses */
+	valid = valid && !is_host_region_reserved(hpa, size, HOST_REGION_SHM, 0U);
+
+	/** Return 'valid' */
+	return valid;
+}
+
+/**
+ * @brief Map the shared region at the base address of BAR2 in the EPT of the VM.
+ *
+ * @param[in] vdev The ivshmem device.
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_POST_SMP, HV_OPERATIONAL
+ *
+ * @remark It is an internal function.
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev->vpci->vm is different among parallel invocation.
+ */
+static void ivshmem_map_shm(const struct pci_vdev *vdev)
+{
+	/** Declare the following local variables of type 'const struct pci_bar *'.
+	 *  - vbar representing BAR2 of the device, initialized as &vdev->bar[IVSHMEM_SHM_BAR]. */
+	const struct pci_bar *vbar = &vdev->bar[IVSHMEM_SHM_BAR];
+	/** Declare the following local variables of type 'struct acrn_vm *'.
+	 *  - vm representing the VM owning the device, initialized as vdev->vpci->vm. */
+	struct acrn_vm *vm = vdev->vpci->vm;
+
+	/** If vbar->base is not 0, which means the guest programmed a valid GPA */
+	if (vbar->base != 0UL) {
+		/** Call ept_add_mr with the following parameters, in order to map the shared region as write-back
+		 *  memory, so that the peers access it at memory speed.
+		 *  - vm
+		 *  - vm->arch_vm.nworld_eptp
+		 *  - vbar->base_hpa
+		 *  - vbar->base
+		 *  - vbar->size
+		 *  - EPT_RD | EPT_WR | EPT_WB
+		 */
+		ept_add_mr(vm, (uint64_t *)(vm->arch_vm.nworld_eptp), vbar->base_hpa, vbar->base, vbar->size,
+			EPT_RD | EPT_WR | EPT_WB);
+	}
+}
+
+/**
+ * @brief Unmap the shared region from the base address of BAR2 in the EPT of the VM.
+ *
+ * @param[in] vdev The ivshmem device.
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal function.
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev->vpci->vm is different among parallel invocation.
+ */
+static void ivshmem_unmap_shm(const struct pci_vdev *vdev)
+{
+	/** Declare the following local variables of type 'const struct pci_bar *'.
+	 *  - vbar representing BAR2 of the device, initialized as &vdev->bar[IVSHMEM_SHM_BAR]. */
+	const struct pci_bar *vbar = &vdev->bar[IVSHMEM_SHM_BAR];
+	/** Declare the following local variables of type 'struct acrn_vm *'.
+	 *  - vm representing the VM owning the device, initialized as vdev->vpci->vm. */
+	struct acrn_vm *vm = vdev->vpci->vm;
+
+	/** If vbar->base is not 0, which means the region is mapped */
+	if (vbar->base != 0UL) {
+		/** Call ept_del_mr with the following parameters, in order to unmap the shared region.
+		 *  - vm
+		 *  - vm->arch_vm.nworld_eptp
+		 *  - vbar->base
+		 *  - vbar->size
+		 */
+		ept_del_mr(vm, (uint64_t *)(vm->arch_vm.nworld_eptp), vbar->base, vbar->size);
+	}
+}
+
+/**
+ * @brief Ring the doorbell of the ivshmem device of a peer VM.
+ *
+ * It sends the MSI programmed in the device of the peer as an IPI to the physical CPU of the destination vCPU. The
+ * doorbell is dropped if the peer is not running, shares no region with the caller, or has not enabled a valid MSI.
+ *
+ * @param[in] vdev The ivshmem device whose doorbell is written.
+ * @param[in] val The value written to the Doorbell register.
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal function called by ivshmem_io_write.
+ *
+ * @reentrancy unspecified
+ * @threadsafety Yes
+ */
+static void ivshmem_ring_doorbell(const struct pci_vdev *vdev, uint32_t val)
+{
+	/** Declare the following local variables of type uint16_t.
+	 *  - peer_id representing the ID of the peer VM, initialized as bits 31:16 of val.
+	 *  - vcpu_id representing the ID of the destination vCPU, not initialized. */
+	uint16_t peer_id = (uint16_t)(val >> 16U), vcpu_id;
+	/** Declare the following local variables of type 'struct pci_vdev *'.
+	 *  - peer representing the ivshmem device of the peer VM, not initialized. */
+	struct pci_vdev *peer;
+	/** Declare the following local variables of type 'struct acrn_vm *'.
+	 *  - peer_vm representing the peer VM, not initialized. */
+	struct acrn_vm *peer_vm;
+	/** Declare the following local variables of type 'struct acrn_vcpu *'.
+	 *  - vcpu representing the destination vCPU, not initialized. */
+	struct acrn_vcpu *vcpu;
+	/** Declare the following local variables of type 'union msi_addr_reg'.
+	 *  - addr representing the MSI address programmed in the peer, initialized as 0. */
+	union msi_addr_reg addr = { .full = 0UL };
+	/** Declare the following local variables of type 'union msi_data_reg'.
+	 *  - data representing the MSI data programmed in the peer, initialized as 0. */
+	union msi_data_reg data = { .full = 0U };
+	/** Declare the following local variables of type uint64_t.
+	 *  - dmask representing the bitmap of the destination vCPUs, initialized as 0. */
+	uint64_t dmask = 0UL;
+
+	/** If peer_id is a valid VM ID and the vector in bits 15:0 of val is 0, the only vector of the device */
+	if ((peer_id < CONFIG_MAX_VM_NUM) && ((val & 0xFFFFU) == 0U)) {
+		/** Set peer_vm to the return value of get_vm_from_vmid(peer_id) */
+		peer_vm = get_vm_from_vmid(peer_id);
+		/** Call spinlock_obtain with the following parameters, in order to read the MSI of the peer while the
+		 *  peer cannot reprogram it.
+		 *  - &peer_vm->vpci.lock */
+		spinlock_obtain(&peer_vm->vpci.lock);
+		/** Set peer to ivshmem_vdevs[peer_id] */
+		peer = ivshmem_vdevs[peer_id];
+		/** If the peer VM is running, its device shares the same region and has MSI enabled */
+		if ((peer_vm->state == VM_STARTED) && (peer != NULL) &&
+			(peer->pci_dev_config->shm_hpa == vdev->pci_dev_config->shm_hpa) &&
+			((pci_vdev_read_cfg_u16(peer, IVSHMEM_MSI_CAPOFF + PCIR_MSI_CTRL) & PCIM_MSICTRL_MSI_ENABLE) != 0U)) {
+			/** Set addr.full to the 64-bit MSI address programmed in the peer */
+			addr.full = (uint64_t)pci_vdev_read_cfg_u32(peer, IVSHMEM_MSI_CAPOFF + PCIR_MSI_ADDR) |
+				((uint64_t)pci_vdev_read_cfg_u32(peer, IVSHMEM_MSI_CAPOFF + PCIR_MSI_ADDR_HIGH) << 32U);
+			/** Set data.full to the MSI data programmed in the peer */
+			data.full = pci_vdev_read_cfg_u16(peer, IVSHMEM_MSI_CAPOFF + PCIR_MSI_DATA_64BIT);
+		}
+		/** Call spinlock_release with the following parameters, in order to release the lock.
+		 *  - &peer_vm->vpci.lock */
+		spinlock_release(&peer_vm->vpci.lock);
+
+		/** If the MSI has a valid vector, fixed delivery mode and physical destination mode */
+		if ((data.bits.vector >= 0x10U) && (data.bits.vector <= 0xfeU) &&
+			(data.bits.delivery_mode == MSI_DATA_DELMODE_FIXED) &&
+			(addr.bits.dest_mode == MSI_ADDR_DESTMODE_PHYS)) {
+			/** Call vlapic_calc_dest with the following parameters, in order to find the vCPU whose APIC ID
+			 *  is the destination of the MSI.
+			 *  - peer_vm
+			 *  - &dmask
+			 *  - false
+			 *  - addr.bits.dest_field
+			 *  - true
+			 *  - false */
+			vlapic_calc_dest(peer_vm, &dmask, false, addr.bits.dest_field, true, false);
+			/** If a destination vCPU is found */
+			if (dmask != 0UL) {
+				/** Set vcpu_id to the return value of ffs64(dmask) */
+				vcpu_id = ffs64(dmask);
+				/** Set vcpu to the return value of vcpu_from_vid(peer_vm, vcpu_id) */
+				vcpu = vcpu_from_vid(peer_vm, vcpu_id);
+				/** If the vCPU is not offline */
+				if (vcpu->state != VCPU_OFFLINE) {
+					/** Call msr_write with the following parameters, in order to send the vector as
+					 *  a fixed IPI to the physical CPU of the vCPU, which delivers it to the guest.
+					 *  - MSR_IA32_EXT_APIC_ICR
+					 *  - (physical APIC ID of the pCPU << 32) | APIC_DELMODE_FIXED | vector
+					 */
+					msr_write(MSR_IA32_EXT_APIC_ICR,
+						((uint64_t)per_cpu(lapic_id, pcpuid_from_vcpu(vcpu)) << 32U) |
+						APIC_DELMODE_FIXED | data.bits.vector);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @brief Read handler of the registers of the ivshmem device of a VM.
+ *
+ * @param[inout] vcpu Pointer to the vCPU reading the port.
+ * @param[in] port The port being read.
+ * @param[in] size Size of the access in bytes.
+ *
+ * @return None
+ *
+ * @pre vcpu != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is registered by ivshmem_register_pio.
+ *
+ * @reentrancy unspecified
+ * @threadsafety Yes
+ */
+static void ivshmem_io_read(struct acrn_vcpu *vcpu, uint16_t port, size_t size)
+{
+	/** Declare the following local variables of type 'const struct pci_vdev *'.
+	 *  - vdev representing the ivshmem device of the VM, initialized as ivshmem_vdevs[vcpu->vm->vm_id]. */
+	const struct pci_vdev *vdev = ivshmem_vdevs[vcpu->vm->vm_id];
+	/** Declare the following local variables of type uint32_t.
+	 *  - val representing the value read, initialized as 0. */
+	uint32_t val = 0U;
+
+	/** If the device exists and IVPosition is read with a 4-byte access */
+	if ((vdev != NULL) && (size == 4U) &&
+		(port == (uint16_t)(vdev->bar[IVSHMEM_REG_BAR].base + IVSHMEM_IV_POSITION))) {
+		/** Set val to the ID of the VM, which is the peer ID of the device */
+		val = vcpu->vm->vm_id;
+	}
+	/** Set vcpu->req.reqs.pio.value to val */
+	vcpu->req.reqs.pio.value = val;
+}
+
+/**
+ * @brief Write handler of the registers of the ivshmem device of a VM.
+ *
+ * @param[inout] vcpu Pointer to the vCPU writing the port.
+ * @param[in] port The port being written.
+ * @param[in] size Size of the access in bytes.
+ * @param[in] val The value written.
+ *
+ * @return None
+ *
+ * @pre vcpu != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is registered by ivshmem_register_pio.
+ *
+ * @reentrancy unspecified
+ * @threadsafety Yes
+ */
+static void ivshmem_io_write(struct acrn_vcpu *vcpu, uint16_t port, size_t size, uint32_t val)
+{
+	/** Declare the following local variables of type 'const struct pci_vdev *'.
+	 *  - vdev representing the ivshmem device of the VM, initialized as ivshmem_vdevs[vcpu->vm->vm_id]. */
+	const struct pci_vdev *vdev = ivshmem_vdevs[vcpu->vm->vm_id];
+
+	/** If the device exists and Doorbell is written with a 4-byte access */
+	if ((vdev != NULL) && (size == 4U) &&
+		(port == (uint16_t)(vdev->bar[IVSHMEM_REG_BAR].base + IVSHMEM_DOORBELL))) {
+		/** Call ivshmem_ring_doorbell with the following parameters, in order to raise the MSI of the peer.
+		 *  - vdev
+		 *  - val */
+		ivshmem_ring_doorbell(vdev, val);
+	}
+}
+
+/**
+ * @brief Register the port I/O handlers of the registers at the base address of BAR0.
+ *
+ * The handlers are unregistered if BAR0 has no valid base address, e.g. while the guest is sizing it.
+ *
+ * @param[in] vdev The ivshmem device.
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_POST_SMP, HV_OPERATIONAL
+ *
+ * @remark It is an internal function.
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev->vpci->vm is different among parallel invocation.
+ */
+static void ivshmem_register_pio(const struct pci_vdev *vdev)
+{
+	/** Declare the following local variables of type 'struct vm_io_range'.
+	 *  - range representing the ports of the registers, initialized as the base and size of BAR0. */
+	struct vm_io_range range = { .base = (uint16_t)vdev->bar[IVSHMEM_REG_BAR].base, .len = IVSHMEM_REG_SIZE };
+
+	/** If BAR0 has no valid base address */
+	if (vdev->bar[IVSHMEM_REG_BAR].base == 0UL) {
+		/** Set range.len to 0 so that no port matches the handlers */
+		range.len = 0U;
+	}
+	/** Call register_pio_emulation_handler with the following parameters, in order to trap the registers.
+	 *  - vdev->vpci->vm
+	 *  - IVSHMEM_PIO_IDX
+	 *  - &range
+	 *  - ivshmem_io_read
+	 *  - ivshmem_io_write */
+	register_pio_emulation_handler(vdev->vpci->vm, IVSHMEM_PIO_IDX, &range, ivshmem_io_read, ivshmem_io_write);
+}
+
+/**
+ * @brief Write BAR0 of the ivshmem device and move its registers accordingly.
+ *
+ * @param[inout] vdev The ivshmem device.
+ * @param[in] val The value written to BAR0.
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_POST_SMP, HV_OPERATIONAL
+ *
+ * @remark It is an internal function.
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev->vpci->vm is different among parallel invocation.
+ */
+static void ivshmem_write_io_vbar(struct pci_vdev *vdev, uint32_t val)
+{
+	/** Declare the following local variables of type 'struct pci_bar *'.
+	 *  - vbar representing BAR0 of the device, initialized as &vdev->bar[IVSHMEM_REG_BAR]. */
+	struct pci_bar *vbar = &vdev->bar[IVSHMEM_REG_BAR];
+
+	/** Call pci_vdev_write_cfg_u32 with the following parameters, in order to update the BAR register.
+	 *  - vdev
+	 *  - pci_bar_offset(IVSHMEM_REG_BAR)
+	 *  - (val & vbar->mask) | vbar->fixed */
+	pci_vdev_write_cfg_u32(vdev, pci_bar_offset(IVSHMEM_REG_BAR), (val & vbar->mask) | vbar->fixed);
+	/** Set vbar->base to val & vbar->mask, or 0 if all the address bits are set, which is a sizing write */
+	vbar->base = ((val & vbar->mask) == vbar->mask) ? 0UL : (uint64_t)(val & vbar->mask);
+	/** Call ivshmem_register_pio with the following parameters, in order to move the registers.
+	 *  - vdev */
+	ivshmem_register_pio(vdev);
+}
+
+/**
+ * @brief Write a register in the MSI capability of the ivshmem device.
+ *
+ * Only the MSI enable bit, the message address and the message data are writable. The MSI is read when the doorbell
+ * is rung, so nothing is remapped here.
+ *
+ * @param[inout] vdev The ivshmem device.
+ * @param[in] offset The register offset in the configuration space.
+ * @param[in] bytes The length of the register to write.
+ * @param[in] val The value to write.
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ * @pre offset is in the MSI capability of the device.
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal function called by ivshmem_write_cfg.
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev->vpci->vm is different among parallel invocation.
+ */
+static void ivshmem_write_msi_cfg(struct pci_vdev *vdev, uint32_t offset, uint32_t bytes, uint32_t val)
+{
+	/** Declare the following local variables of type 'const uint8_t[]'.
+	 *  - msi_ro_mask representing the read-only bits of each byte of a 64-bit MSI capability. */
+	static const uint8_t msi_ro_mask[16U] = {0xffU, 0xffU, 0xfeU, 0xffU,
+						 0x03U, 0x00U, 0x00U, 0x00U,
+						 0x00U, 0x00U, 0x00U, 0x00U,
+						 0x00U, 0x00U, 0xffU, 0xffU};
+	/** Declare the following local variables of type uint32_t.
+	 *  - ro_mask representing the read-only bits of the register, initialized as 0FFFFFFFFH.
+	 *  - old representing the current value of the register, not initialized. */
+	uint32_t ro_mask = ~0U, old;
+
+	/** If the register does not cross the end of the MSI capability */
+	if ((offset + bytes) <= (IVSHMEM_MSI_CAPOFF + sizeof(msi_ro_mask))) {
+		/** Call memcpy_s with the following parameters, in order to get the read-only bits of the register.
+		 *  - &ro_mask
+		 *  - bytes
+		 *  - &msi_ro_mask[offset - IVSHMEM_MSI_CAPOFF]
+		 *  - bytes */
+		(void)memcpy_s((void *)&ro_mask, bytes, (const void *)&msi_ro_mask[offset - IVSHMEM_MSI_CAPOFF], bytes);
+		/** Set old to the current value of the register */
+		old = pci_vdev_read_cfg(vdev, offset, bytes);
+		/** Call pci_vdev_write_cfg with the following parameters, in order to update the writable bits.
+		 *  - vdev
+		 *  - offset
+		 *  - bytes
+		 *  - (old & ro_mask) | (val & ~ro_mask) */
+		pci_vdev_write_cfg(vdev, offset, bytes, (old & ro_mask) | (val & ~ro_mask));
+	}
+}
+
+/**
+ * @brief Initialize the ivshmem device.
+ *
+ * It builds the configuration space of the device, maps the shared region at the configured base address of BAR2
+ * and traps the registers at the configured base port of BAR0. BAR2 is not exposed if the region is invalid.
+ *
+ * @param[inout] vdev A vPCI device which will be initialized as an ivshmem device.
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ * @pre vdev->pci_dev_config != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_POST_SMP, HV_OPERATIONAL
+ *
+ * @remark It is an internal API called by vpci_init_vdev and vpci_reset.
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev->vpci->vm is different among parallel invocation.
+ */
+static void init_ivshmem(struct pci_vdev *vdev)
+{
+	/** Declare the following local variables of type 'const struct acrn_vm_pci_dev_config *'.
+	 *  - dev_config representing the configuration of the device, initialized as vdev->pci_dev_config. */
+	const struct acrn_vm_pci_dev_config *dev_config = vdev->pci_dev_config;
+	/** Declare the following local variables of type 'struct pci_bar *'.
+	 *  - vbar representing a BAR of the device, not initialized. */
+	struct pci_bar *vbar;
+
+	/** Call memset with the following parameters, in order to clear the configuration space.
+	 *  - &vdev->cfgdata
+	 *  - 0
+	 *  - sizeof(vdev->cfgdata) */
+	(void)memset((void *)&vdev->cfgdata, 0U, sizeof(vdev->cfgdata));
+	/** Call memset with the following parameters, in order to clear the BARs.
+	 *  - vdev->bar
+	 *  - 0
+	 *  - sizeof(vdev->bar) */
+	(void)memset((void *)vdev->bar, 0U, sizeof(vdev->bar));
+	/** Set vdev->nr_bars to PCI_BAR_COUNT */
+	vdev->nr_bars = PCI_BAR_COUNT;
+
+	/** Call pci_vdev_write_cfg_u16 with the following parameters, in order to write the vendor ID register.
+	 *  - vdev
+	 *  - PCIR_VENDOR
+	 *  - IVSHMEM_VENDOR_ID */
+	pci_vdev_write_cfg_u16(vdev, PCIR_VENDOR, (uint16_t)IVSHMEM_VENDOR_ID);
+	/** Call pci_vdev_write_cfg_u16 with the following parameters, in order to write the device ID register.
+	 *  - vdev
+	 *  - PCIR_DEVICE
+	 *  - IVSHMEM_DEVICE_ID */
+	pci_vdev_write_cfg_u16(vdev, PCIR_DEVICE, (uint16_t)IVSHMEM_DEVICE_ID);
+	/** Call pci_vdev_write_cfg_u8 with the following parameters, in order to write the revision ID register.
+	 *  - vdev
+	 *  - PCIR_REVID
+	 *  - 1 */
+	pci_vdev_write_cfg_u8(vdev, PCIR_REVID, 1U);
+	/** Call pci_vdev_write_cfg_u8 with the following parameters, in order to write the class ID register.
+	 *  - vdev
+	 *  - PCIR_CLASS
+	 *  - IVSHMEM_CLASS */
+	pci_vdev_write_cfg_u8(vdev, PCIR_CLASS, (uint8_t)IVSHMEM_CLASS);
+	/** Call pci_vdev_write_cfg_u8 with the following parameters, in order to write the header type register.
+	 *  - vdev
+	 *  - PCIR_HDRTYPE
+	 *  - PCIM_HDRTYPE_NORMAL */
+	pci_vdev_write_cfg_u8(vdev, PCIR_HDRTYPE, (uint8_t)PCIM_HDRTYPE_NORMAL);
+	/** Call pci_vdev_write_cfg_u8 with the following parameters, in order to write the Interrupt Line register,
+	 *  as no legacy interrupt is connected.
+	 *  - vdev
+	 *  - PCIR_INTERRUPT_LINE
+	 *  - INTERRUPT_LINE_NO_CONNECTION */
+	pci_vdev_write_cfg_u8(vdev, PCIR_INTERRUPT_LINE, INTERRUPT_LINE_NO_CONNECTION);
+
+	/** Call pci_vdev_write_cfg_u16 with the following parameters, in order to indicate the device has a
+	 *  capability list.
+	 *  - vdev
+	 *  - PCIR_STATUS
+	 *  - PCIM_STATUS_CAPPRESENT */
+	pci_vdev_write_cfg_u16(vdev, PCIR_STATUS, (uint16_t)PCIM_STATUS_CAPPRESENT);
+	/** Call pci_vdev_write_cfg_u8 with the following parameters, in order to point to the MSI capability.
+	 *  - vdev
+	 *  - PCIR_CAP_PTR
+	 *  - IVSHMEM_MSI_CAPOFF */
+	pci_vdev_write_cfg_u8(vdev, PCIR_CAP_PTR, (uint8_t)IVSHMEM_MSI_CAPOFF);
+	/** Call pci_vdev_write_cfg_u8 with the following parameters, in order to write the MSI capability ID.
+	 *  - vdev
+	 *  - IVSHMEM_MSI_CAPOFF + PCICAP_ID
+	 *  - PCIY_MSI */
+	pci_vdev_write_cfg_u8(vdev, IVSHMEM_MSI_CAPOFF + PCICAP_ID, (uint8_t)PCIY_MSI);
+	/** Call pci_vdev_write_cfg_u16 with the following parameters, in order to declare a 64-bit MSI with a single
+	 *  message, initially disabled.
+	 *  - vdev
+	 *  - IVSHMEM_MSI_CAPOFF + PCIR_MSI_CTRL
+	 *  - PCIM_MSICTRL_64BIT */
+	pci_vdev_write_cfg_u16(vdev, IVSHMEM_MSI_CAPOFF + PCIR_MSI_CTRL, (uint16_t)PCIM_MSICTRL_64BIT);
+	/** Call pci_vdev_write_cfg_u32 with the following parameters, in order to initialize the message address.
+	 *  - vdev
+	 *  - IVSHMEM_MSI_CAPOFF + PCIR_MSI_ADDR
+	 *  - MSG_INITIAL_VALUE */
+	pci_vdev_write_cfg_u32(vdev, IVSHMEM_MSI_CAPOFF + PCIR_MSI_ADDR, MSG_INITIAL_VALUE);
+	/** Set vdev->msi.is_64bit to true */
+	vdev->msi.is_64bit = true;
+	/** Set vdev->msi.capoff to IVSHMEM_MSI_CAPOFF */
+	vdev->msi.capoff = IVSHMEM_MSI_CAPOFF;
+	/** Set vdev->msi.caplen to IVSHMEM_MSI_CAPLEN */
+	vdev->msi.caplen = IVSHMEM_MSI_CAPLEN;
+
+	/** Set vbar to &vdev->bar[IVSHMEM_REG_BAR] */
+	vbar = &vdev->bar[IVSHMEM_REG_BAR];
+	/** Set vbar->type to PCIBAR_IO_SPACE */
+	vbar->type = PCIBAR_IO_SPACE;
+	/** Set vbar->size to IVSHMEM_REG_SIZE */
+	vbar->size = IVSHMEM_REG_SIZE;
+	/** Set vbar->mask to the address bits of a 16-byte port I/O BAR */
+	vbar->mask = 0xFFFFU & ~(IVSHMEM_REG_SIZE - 1U);
+	/** Set vbar->fixed to PCIM_BAR_IO_SPACE */
+	vbar->fixed = PCIM_BAR_IO_SPACE;
+	/** Call ivshmem_write_io_vbar with the following parameters, in order to trap the registers at the
+	 *  configured base port.
+	 *  - vdev
+	 *  - (uint32_t)dev_config->vbar_base[IVSHMEM_REG_BAR] */
+	ivshmem_write_io_vbar(vdev, (uint32_t)dev_config->vbar_base[IVSHMEM_REG_BAR]);
+
+	/** If the shared region is valid */
+	if (is_shm_region_valid(dev_config)) {
+		/** Set vbar to &vdev->bar[IVSHMEM_SHM_BAR] */
+		vbar = &vdev->bar[IVSHMEM_SHM_BAR];
+		/** Set vbar->type to PCIBAR_MEM64 */
+		vbar->type = PCIBAR_MEM64;
+		/** Set vbar->size to dev_config->shm_size */
+		vbar->size = dev_config->shm_size;
+		/** Set vbar->base_hpa to dev_config->shm_hpa */
+		vbar->base_hpa = dev_config->shm_hpa;
+		/** Set vbar->mask to the low 32 address bits of a BAR of the region size */
+		vbar->mask = (uint32_t)~(dev_config->shm_size - 1UL) & (uint32_t)PCI_BASE_ADDRESS_MEM_MASK;
+		/** Set vbar->fixed to mark a 64-bit prefetchable memory BAR */
+		vbar->fixed = PCIM_BAR_MEM_64 | PCIM_BAR_MEM_PREFETCH;
+		/** Set vbar to &vdev->bar[IVSHMEM_SHM_BAR + 1] */
+		vbar = &vdev->bar[IVSHMEM_SHM_BAR + 1U];
+		/** Set vbar->type to PCIBAR_MEM64HI */
+		vbar->type = PCIBAR_MEM64HI;
+		/** Set vbar->mask to the high 32 address bits of a BAR of the region size */
+		vbar->mask = (uint32_t)(~(dev_config->shm_size - 1UL) >> 32U);
+		/** Call pci_vdev_write_bar with the following parameters, in order to write the high 32 bits of the
+		 *  configured base address.
+		 *  - vdev
+		 *  - IVSHMEM_SHM_BAR + 1
+		 *  - bits 63:32 of dev_config->vbar_base[IVSHMEM_SHM_BAR] */
+		pci_vdev_write_bar(vdev, IVSHMEM_SHM_BAR + 1U, (uint32_t)(dev_config->vbar_base[IVSHMEM_SHM_BAR] >> 32U));
+		/** Call pci_vdev_write_bar with the following parameters, in order to write the low 32 bits of the
+		 *  configured base address and update the BAR base info.
+		 *  - vdev
+		 *  - IVSHMEM_SHM_BAR
+		 *  - bits 31:0 of dev_config->vbar_base[IVSHMEM_SHM_BAR] */
+		pci_vdev_write_bar(vdev, IVSHMEM_SHM_BAR, (uint32_t)dev_config->vbar_base[IVSHMEM_SHM_BAR]);
+		/** Call ivshmem_map_shm with the following parameters, in order to map the region at that address.
+		 *  - vdev */
+		ivshmem_map_shm(vdev);
+	} else {
+		/** Log an error message as the region cannot be shared */
+		pr_err("VM%u: invalid ivshmem region 0x%lx, size 0x%lx", vdev->vpci->vm->vm_id, dev_config->shm_hpa,
+			dev_config->shm_size);
+	}
+
+	/** Set ivshmem_vdevs[vm_id] to vdev so that peers can ring its doorbell */
+	ivshmem_vdevs[vdev->vpci->vm->vm_id] = vdev;
+}
+
+/**
+ * @brief De-initialize the ivshmem device.
+ *
+ * It unmaps the shared region and stops trapping the registers.
+ *
+ * @param[inout] vdev A vPCI device which is an ivshmem device.
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal API called by vpci_cleanup and vpci_reset.
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev->vpci->vm is different among parallel invocation.
+ */
+static void deinit_ivshmem(struct pci_vdev *vdev)
+{
+	/** Set ivshmem_vdevs[vm_id] to NULL so that peers cannot ring its doorbell */
+	ivshmem_vdevs[vdev->vpci->vm->vm_id] = NULL;
+	/** Call ivshmem_unmap_shm with the following parameters, in order to unmap the shared region.
+	 *  - vdev */
+	ivshmem_unmap_shm(vdev);
+	/** Set vdev->bar[IVSHMEM_REG_BAR].base to 0 */
+	vdev->bar[IVSHMEM_REG_BAR].base = 0UL;
+	/** Call ivshmem_register_pio with the following parameters, in order to stop trapping the registers.
+	 *  - vdev */
+	ivshmem_register_pio(vdev);
+}
+
+/**
+ * @brief Read a register in the configuration space of the ivshmem device.
+ *
+ * @param[in] vdev A vPCI device which is an ivshmem device.
+ * @param[in] offset The register offset in the configuration space.
+ * @param[in] bytes The length of the register to read.
+ * @param[out] val The pointer to save the value to read.
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal API called by read_cfg.
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev is different among parallel invocation.
+ */
+static void ivshmem_read_cfg(const struct pci_vdev *vdev, uint32_t offset, uint32_t bytes, uint32_t *val)
+{
+	/** Set '*val' to the value returned by pci_vdev_read_cfg, which reads the virtual configuration space */
+	*val = pci_vdev_read_cfg(vdev, offset, bytes);
+}
+
+/**
+ * @brief Write a register in the configuration space of the ivshmem device.
+ *
+ * BAR writes move the registers or remap the shared region, MSI capability writes program the MSI raised by the
+ * doorbell, and command register writes are kept. Other writes are ignored.
+ *
+ * @param[inout] vdev A vPCI device which is an ivshmem device.
+ * @param[in] offset The register offset in the configuration space.
+ * @param[in] bytes The length of the register to write.
+ * @param[in] val The value to write.
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal API called by write_cfg.
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev is different among parallel invocation.
+ */
+static void ivshmem_write_cfg(struct pci_vdev *vdev, uint32_t offset, uint32_t bytes, uint32_t val)
+{
+	/** Declare the following local variables of type uint32_t.
+	 *  - idx representing the index of the BAR written, not initialized. */
+	uint32_t idx;
+
+	/** If a BAR is written with an aligned 4-byte access */
+	if (vbar_access(vdev, offset) && (bytes == 4U) && ((offset & 0x3U) == 0U)) {
+		/** Set idx to the index of the BAR */
+		idx = (offset - PCIR_BARS) >> 2U;
+		/** If BAR0 is written */
+		if (idx == IVSHMEM_REG_BAR) {
+			/** Call ivshmem_write_io_vbar with the following parameters, in order to move the registers.
+			 *  - vdev
+			 *  - val */
+			ivshmem_write_io_vbar(vdev, val);
+		/** If BAR2 or BAR3 of a valid region is written */
+		} else if (((idx == IVSHMEM_SHM_BAR) || (idx == (IVSHMEM_SHM_BAR + 1U))) &&
+			(vdev->bar[IVSHMEM_SHM_BAR].type == PCIBAR_MEM64)) {
+			/** Call ivshmem_unmap_shm with the following parameters, in order to unmap the region first.
+			 *  - vdev */
+			ivshmem_unmap_shm(vdev);
+			/** Call pci_vdev_write_bar with the following parameters, in order to update the BAR.
+			 *  - vdev
+			 *  - idx
+			 *  - val */
+			pci_vdev_write_bar(vdev, idx, val);
+			/** Call ivshmem_map_shm with the following parameters, in order to map the region at its new
+			 *  base address.
+			 *  - vdev */
+			ivshmem_map_shm(vdev);
+		} else {
+			/* Other BARs are not implemented */
+		}
+	/** If the MSI capability is written */
+	} else if (msicap_access(vdev, offset)) {
+		/** Call ivshmem_write_msi_cfg with the following parameters, in order to program the MSI.
+		 *  - vdev
+		 *  - offset
+		 *  - bytes
+		 *  - val */
+		ivshmem_write_msi_cfg(vdev, offset, bytes, val);
+	/** If the command register is written */
+	} else if ((offset == PCIR_COMMAND) && (bytes <= 2U)) {
+		/** Call pci_vdev_write_cfg with the following parameters, in order to keep the value written.
+		 *  - vdev
+		 *  - offset
+		 *  - bytes
+		 *  - val */
+		pci_vdev_write_cfg(vdev, offset, bytes, val);
+	} else {
+		/* ignore other writing */
+	}
+}
+
+/**
+ * @brief A set of callback functions used to operate ivshmem devices.
+ */
+const struct pci_vdev_ops ivshmem_ops = {
+	.init_vdev = init_ivshmem,		/**< The function to initialize the device. */
+	.deinit_vdev = deinit_ivshmem,		/**< The function to de-init the device. */
+	.write_vdev_cfg = ivshmem_write_cfg,	/**< The function to write the configuration register. */
+	.read_vdev_cfg = ivshmem_read_cfg,	/**< The function to read the configuration register. */
+};
+
+/**
+ * @}
+ */
@@ -43,20 +43,27 @@
  * @brief This file implements BAR operation APIs which are used within vPCI component
  *
  * This file implements BAR operation APIs which are used within vPCI component. The main parts focus on
- * the BAR EPT remapping and unmapping between its MMIO GPA and HPA space. It also defines one helper function to
- * implement the features that are commonly used in this file. In addition, it defines two decomposed functions to
+ * the BAR EPT remapping and unmapping between its MMIO GPA and HPA space. It also defines two helper functions to
+ * implement the features that are commonly used in this file. In addition, it defines three decomposed functions to
  * improve the readability of the code.
  *
  * Following functions are internal APIs used by other source files within vPCI:
  * - init_vdev_pt: initialize the BAR registers of the vPCI device associated with a physical PCI device
  * - vdev_pt_write_vbar: write a BAR register of the vPCI device associated with a physical PCI device
+ * - vdev_pt_reset_vbars: put the BARs of the vPCI device back to their configured base addresses
+ * - vdev_pt_sync_vbars: map the BARs moved by the guest once memory space decoding is enabled
  *
  * Helper functions:
  * - pci_get_bar_type: get the type of a BAR according to the given register value, called by init_vdev_pt
+ * - is_mem_decoding_enabled: check the memory space enable bit of the physical command register
  *
  * Decomposed functions:
- * - vdev_pt_unmap_mem_vbar: unmap the MMIO GPA of the BAR, called by vdev_pt_write_vbar
- * - vdev_pt_map_mem_vbar: map the MMIO GPA of the BAR to its HPA, called by vdev_pt_write_vbar
+ * - vdev_pt_unmap_mem_vbar: unmap the MMIO GPA of the BAR and stop trapping its MSI-X table, called by
+ *   vdev_pt_update_mem_vbar
+ * - vdev_pt_map_mem_vbar: map the MMIO GPA of the BAR to its HPA except the MSI-X table pages, called by
+ *   vdev_pt_update_mem_vbar
+ * - vdev_pt_update_mem_vbar: move the BAR in the EPT if its base address has changed, called by
+ *   vdev_pt_write_vbar and vdev_pt_sync_vbars
  */
 
 /**
@@ -119,7 +126,8 @@ static inline enum pci_bar_type pci_get_bar_type(uint32_t val)
  * @brief Unmap a BAR MMIO space between GPA and HPA
  *
  * This function is called to unmap a BAR MMIO space between GPA and HPA. The BAR info is got from the given vPCI
- * device and the given index. It will call ept_del_mr to do the unmapping in EPT table.
+ * device and the given index. It will call ept_del_mr to remove the GPA where the BAR is currently mapped from the
+ * EPT table.
  *
  * @param[inout] vdev A vPCI device whose BAR space is to unmap.
  * @param[in] idx The BAR index.
@@ -131,11 +139,11 @@ static inline enum pci_bar_type pci_get_bar_type(uint32_t val)
  * @pre vdev->vpci->vm != NULL
  * @pre 0 <= idx && idx <= 5
  *
- * @post N/A
+ * @post vdev->bar[idx].mapped_base == 0
  *
  * @mode HV_SUBMODE_INIT_POST_SMP, HV_OPERATIONAL
  *
- * @remark It is an internal API called by vdev_pt_write_vbar.
+ * @remark It is an internal API called by vdev_pt_update_mem_vbar and vdev_pt_reset_vbars.
  *
  * @reentrancy unspecified
  * @threadsafety When \a vdev->vpci->vm is different among parallel invocation.
@@ -149,27 +157,38 @@ static void vdev_pt_unmap_mem_vbar(struct pci_vdev *vdev, uint32_t idx)
 	 *  - vm representing the VM that the given vPCI device belongs to, initialized as vdev->vpci->vm. */
 	struct acrn_vm *vm = vdev->vpci->vm;
 
-	/** If vbar->base is not 0, which means it is a valid GPA. */
-	if (vbar->base != 0UL) {
+	/** If vbar->mapped_base is not 0, which means the BAR is mapped. */
+	if (vbar->mapped_base != 0UL) {
 		/** Call ept_del_mr with the following parameters, in order to do the unmapping of the BAR
-		 *  space (BAR GPA base and its BAR size) in the EPT table.
+		 *  space (mapped BAR GPA base and its BAR size) in the EPT table.
 		 *  - vm
 		 *  - vm->arch_vm.nworld_eptp
-		 *  - vbar->base
+		 *  - vbar->mapped_base
 		 *  - vbar->size
 		 */
-		ept_del_mr(vm, (uint64_t *)(vm->arch_vm.nworld_eptp), vbar->base, /* GPA (old vbar) */
+		ept_del_mr(vm, (uint64_t *)(vm->arch_vm.nworld_eptp), vbar->mapped_base, /* GPA (old vbar) */
 			vbar->size);
+		/** If the BAR holds the MSI-X table of the given vPCI device */
+		if (has_msix_cap(vdev) && (vdev->msix.table_bar == idx)) {
+			/** Call vmsix_untrap_table with the following parameters, in order to stop emulating the MSI-X
+			 *  table at the old GPA.
+			 *  - vdev
+			 */
+			vmsix_untrap_table(vdev);
+		}
+		/** Set vbar->mapped_base to 0 */
+		vbar->mapped_base = 0UL;
 	}
 }
 
 /**
- * @brief Remap a BAR MMIO space between GPA and HPA
+ * @brief Map a BAR MMIO space between GPA and HPA
  *
- * This function is called to remap a BAR MMIO space between GPA and HPA. The BAR info is got from the given vPCI
- * device and the given index. It will call ept_add_mr to do the remapping in EPT table.
+ * This function is called to map a BAR MMIO space between GPA and HPA. The BAR info is got from the given vPCI
+ * device and the given index. Any other BAR of the device mapped over the destination range is unmapped first and the
+ * destination range is cleared, then ept_add_mr is called to do the mapping in EPT table.
  *
- * @param[inout] vdev A vPCI device whose BAR space is to remap.
+ * @param[inout] vdev A vPCI device whose BAR space is to map.
  * @param[in] idx The BAR index.
  *
  * @return None
@@ -178,12 +197,13 @@ static void vdev_pt_unmap_mem_vbar(struct pci_vdev *vdev, uint32_t idx)
  * @pre vdev->vpci != NULL
  * @pre vdev->vpci->vm != NULL
  * @pre 0 <= idx && idx <= 5
+ * @pre vdev->bar[idx].mapped_base == 0
  *
  * @post N/A
  *
  * @mode HV_SUBMODE_INIT_POST_SMP, HV_OPERATIONAL
  *
- * @remark It is an internal API called by vdev_pt_write_vbar.
+ * @remark It is an internal API called by init_vdev_pt, vdev_pt_update_mem_vbar and vdev_pt_reset_vbars.
  *
  * @reentrancy unspecified
  * @threadsafety When \a vdev->vpci->vm is different among parallel invocation.
@@ -196,19 +216,40 @@ static void vdev_pt_map_mem_vbar(struct pci_vdev *vdev, uint32_t idx)
 	/** Declare the following local variables of type 'struct acrn_vm *'.
 	 *  - vm representing the VM that the given vPCI device belongs to, initialized as vdev->vpci->vm. */
 	struct acrn_vm *vm = vdev->vpci->vm;
+	/** Declare the following local variables of type 'const struct pci_bar *'.
+	 *  - other representing a pointer to the info of another BAR of the device, not initialized. */
+	const struct pci_bar *other;
+	/** Declare the following local variables of type uint32_t.
+	 *  - i representing the index of another BAR of the device, not initialized. */
+	uint32_t i;
 
 	/** If vbar->base is not 0, which means it is a valid GPA. */
 	if (vbar->base != 0UL) {
-		/** Call ept_del_mr with the following parameters, in order to do the unmapping of the BAR
-		 *  space (BAR GPA base and its BAR size) in the EPT table.
+		/** For each i ranging from 0 to vdev->nr_bars - 1 [with a step of 1] */
+		for (i = 0U; i < vdev->nr_bars; i++) {
+			/** Set other to &vdev->bar[i] */
+			other = &vdev->bar[i];
+			/** If i is not idx and the BAR i is mapped at a range overlapping the new range of BAR idx */
+			if ((i != idx) && (other->mapped_base != 0UL) &&
+				(other->mapped_base < (vbar->base + vbar->size)) &&
+				(vbar->base < (other->mapped_base + other->size))) {
+				/** Call vdev_pt_unmap_mem_vbar with the following parameters, in order to evict the BAR
+				 *  i, so that its later move does not unmap the range of BAR idx.
+				 *  - vdev
+				 *  - i
+				 */
+				vdev_pt_unmap_mem_vbar(vdev, i);
+			}
+		}
+		/** Call ept_del_mr with the following parameters, in order to clear any stale translation in the
+		 *  destination range, as ept_add_mr does not overwrite present entries.
 		 *  - vm
 		 *  - vm->arch_vm.nworld_eptp
 		 *  - vbar->base
 		 *  - vbar->size
 		 */
-		ept_del_mr(vm, (uint64_t *)(vm->arch_vm.nworld_eptp), vbar->base, /* GPA (new vbar) */
-			vbar->size);
-		/** Call ept_add_mr with the following parameters, in order to do the remapping of the BAR
+		ept_del_mr(vm, (uint64_t *)(vm->arch_vm.nworld_eptp), vbar->base, vbar->size);
+		/** Call ept_add_mr with the following parameters, in order to do the mapping of the BAR
 		 *  space (BAR base and its BAR size) between GPA and HPA in the EPT table.
 		 *  - vm
 		 *  - vm->arch_vm.nworld_eptp
@@ -220,6 +261,230 @@ static void vdev_pt_map_mem_vbar(struct pci_vdev *vdev, uint32_t idx)
 		ept_add_mr(vm, (uint64_t *)(vm->arch_vm.nworld_eptp), vbar->base_hpa, /* HPA (pbar) */
 			vbar->base, /* GPA (new vbar) */
 			vbar->size, EPT_WR | EPT_RD | EPT_UNCACHED);
+		/** Set vbar->mapped_base to vbar->base */
+		vbar->mapped_base = vbar->base;
+		/** If the BAR holds the MSI-X table of the given vPCI device */
+		if (has_msix_cap(vdev) && (vdev->msix.table_bar == idx)) {
+			/** Call vmsix_trap_table with the following parameters, in order to emulate the MSI-X table at
+			 *  the new GPA.
+			 *  - vdev
+			 */
+			vmsix_trap_table(vdev);
+		}
+	}
+}
+
+/**
+ * @brief Check whether the memory space decoding of the physical PCI device of the given vPCI device is enabled.
+ *
+ * @param[in] vdev A vPCI device associated with a physical PCI device.
+ *
+ * @return True if the memory space enable bit of the physical command register is set, or return false.
+ *
+ * @pre vdev != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal API called by vdev_pt_write_vbar and vdev_pt_sync_vbars.
+ *
+ * @reentrancy unspecified
+ * @threadsafety Yes
+ */
+static inline bool is_mem_decoding_enabled(const struct pci_vdev *vdev)
+{
+	/** Return true if the PCIM_CMD_MEMEN bit of the physical command register is set, or return false */
+	return ((pci_pdev_read_cfg(vdev->pbdf, PCIR_COMMAND, 2U) & PCIM_CMD_MEMEN) != 0U);
+}
+
+/**
+ * @brief Apply the net change of a BAR base address to the EPT.
+ *
+ * The BAR is moved in the EPT only if its base address is valid and differs from the GPA where it is mapped. A base
+ * address of 0, which is what an invalid or half-written base decodes to, keeps the current mapping.
+ *
+ * @param[inout] vdev A vPCI device whose BAR space is to update.
+ * @param[in] idx The BAR index.
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ * @pre vdev->vpci != NULL
+ * @pre vdev->vpci->vm != NULL
+ * @pre 0 <= idx && idx <= 5
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal API called by vdev_pt_write_vbar and vdev_pt_sync_vbars.
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev->vpci->vm is different among parallel invocation.
+ */
+static void vdev_pt_update_mem_vbar(struct pci_vdev *vdev, uint32_t idx)
+{
+	/** Declare the following local variables of type 'const struct pci_bar *'.
+	 *  - vbar representing a pointer to the BAR info, initialized as &vdev->bar[idx]. */
+	const struct pci_bar *vbar = &vdev->bar[idx];
+
+	/** If vbar->base is not 0 and is not vbar->mapped_base */
+	if ((vbar->base != 0UL) && (vbar->base != vbar->mapped_base)) {
+		/** Call vdev_pt_unmap_mem_vbar with the following parameters, in order to unmap the BAR space at its
+		 *  old GPA.
+		 *  - vdev
+		 *  - idx
+		 */
+		vdev_pt_unmap_mem_vbar(vdev, idx);
+		/** Call vdev_pt_map_mem_vbar with the following parameters, in order to map the BAR space at its new
+		 *  GPA.
+		 *  - vdev
+		 *  - idx
+		 */
+		vdev_pt_map_mem_vbar(vdev, idx);
+	}
+}
+
+/**
+ * @brief Apply the BAR base addresses programmed by the guest to the EPT once memory decoding is enabled.
+ *
+ * This function is called after the command register of the given vPCI device is written. If memory space decoding
+ * is enabled, each memory BAR the guest has moved since it was mapped is unmapped from its old base address, and only
+ * then are the moved BARs mapped at their new base addresses.
+ *
+ * @param[inout] vdev A vPCI device associated with a physical PCI device.
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ * @pre vdev->vpci != NULL
+ * @pre vdev->vpci->vm != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal API called by other vPCI source file.
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev->vpci->vm is different among parallel invocation.
+ */
+void vdev_pt_sync_vbars(struct pci_vdev *vdev)
+{
+	/** Declare the following local variables of type uint32_t.
+	 *  - idx representing the index of the BAR to update, not initialized. */
+	uint32_t idx;
+
+	/** If the memory space decoding of the device is enabled */
+	if (is_mem_decoding_enabled(vdev)) {
+		/* Unmap all the moved BARs before mapping any of them, so that BARs swapping their ranges do not
+		 * keep each other's stale translations. */
+		/** For each idx ranging from 0 to vdev->nr_bars - 1 [with a step of 1] */
+		for (idx = 0U; idx < vdev->nr_bars; idx++) {
+			/** If vdev->bar[idx].type is PCIBAR_MEM32 or PCIBAR_MEM64, and vdev->bar[idx].base is neither 0
+			 *  nor vdev->bar[idx].mapped_base */
+			if (((vdev->bar[idx].type == PCIBAR_MEM32) || (vdev->bar[idx].type == PCIBAR_MEM64)) &&
+				(vdev->bar[idx].base != 0UL) && (vdev->bar[idx].base != vdev->bar[idx].mapped_base)) {
+				/** Call vdev_pt_unmap_mem_vbar with the following parameters, in order to unmap the
+				 *  BAR space at its old GPA.
+				 *  - vdev
+				 *  - idx
+				 */
+				vdev_pt_unmap_mem_vbar(vdev, idx);
+			}
+		}
+		/** For each idx ranging from 0 to vdev->nr_bars - 1 [with a step of 1] */
+		for (idx = 0U; idx < vdev->nr_bars; idx++) {
+			/** If vdev->bar[idx].type is PCIBAR_MEM32 or PCIBAR_MEM64 */
+			if ((vdev->bar[idx].type == PCIBAR_MEM32) || (vdev->bar[idx].type == PCIBAR_MEM64)) {
+				/** Call vdev_pt_update_mem_vbar with the following parameters, in order to move the
+				 *  BAR if its base address has changed.
+				 *  - vdev
+				 *  - idx
+				 */
+				vdev_pt_update_mem_vbar(vdev, idx);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Put the BARs of the given vPCI device back to their configured base addresses.
+ *
+ * This function is called when the VM of the given vPCI device is restarted. Only the BARs the guest has moved are
+ * remapped, and the low and high halves of a 64-bit BAR are both written before the BAR is mapped again, so that no
+ * transient base address is ever mapped.
+ *
+ * @param[inout] vdev A vPCI device whose BARs are to reset.
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ * @pre vdev->vpci != NULL
+ * @pre vdev->vpci->vm != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal API called by other vPCI source file.
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev->vpci->vm is different among parallel invocation.
+ */
+void vdev_pt_reset_vbars(struct pci_vdev *vdev)
+{
+	/** Declare the following local variables of type uint32_t.
+	 *  - idx representing the index of the BAR to reset, not initialized. */
+	uint32_t idx;
+	/** Declare the following local variables of type uint64_t.
+	 *  - base representing the configured base address of the BAR, not initialized. */
+	uint64_t base;
+	/** Declare the following local variables of type 'struct pci_bar *'.
+	 *  - vbar representing a pointer to the BAR info, not initialized. */
+	struct pci_bar *vbar;
+
+	/** For each idx ranging from 0 to vdev->nr_bars - 1 [with a step of 1] */
+	for (idx = 0U; idx < vdev->nr_bars; idx++) {
+		/** Set vbar to &vdev->bar[idx] */
+		vbar = &vdev->bar[idx];
+		/** Set base to vdev->pci_dev_config->vbar_base[idx] with the low 4 bits (the BAR type bits) cleared */
+		base = vdev->pci_dev_config->vbar_base[idx] & ~0xFUL;
+
+		/** If vbar->type is PCIBAR_MEM32 or PCIBAR_MEM64, and vbar->base or vbar->mapped_base is not base */
+		if (((vbar->type == PCIBAR_MEM32) || (vbar->type == PCIBAR_MEM64)) &&
+			((vbar->base != base) || (vbar->mapped_base != base))) {
+			/** Call vdev_pt_unmap_mem_vbar with the following parameters, in order to unmap the BAR space
+			 *  at the base address it is mapped at.
+			 *  - vdev
+			 *  - idx
+			 */
+			vdev_pt_unmap_mem_vbar(vdev, idx);
+			/** If vbar->type is PCIBAR_MEM64 */
+			if (vbar->type == PCIBAR_MEM64) {
+				/** Call pci_vdev_write_bar with the following parameters, in order to write the high
+				 *  32 bits of the configured base address.
+				 *  - vdev
+				 *  - idx + 1
+				 *  - bits 63:32 of base
+				 */
+				pci_vdev_write_bar(vdev, idx + 1U, (uint32_t)(base >> 32U));
+			}
+			/** Call pci_vdev_write_bar with the following parameters, in order to write the low 32 bits of
+			 *  the configured base address and update the BAR base info.
+			 *  - vdev
+			 *  - idx
+			 *  - bits 31:0 of base
+			 */
+			pci_vdev_write_bar(vdev, idx, (uint32_t)base);
+			/** Call vdev_pt_map_mem_vbar with the following parameters, in order to map the BAR space at
+			 *  the configured base address.
+			 *  - vdev
+			 *  - idx
+			 */
+			vdev_pt_map_mem_vbar(vdev, idx);
+		}
 	}
 }
 
@@ -227,8 +492,10 @@ static void vdev_pt_map_mem_vbar(struct pci_vdev *vdev, uint32_t idx)
  * @brief Write a BAR register of the given vPCI device associated with a physical PCI device.
  *
  * This function is called to write a BAR register of the given vPCI device associated with a physical PCI device.
- * The BAR info is got from the given vPCI device and the given index. According to the given 'val' to write, it could
- * do unmapping / remapping for the BAR MMIO space between GPA and HPA.
+ * The BAR info is got from the given vPCI device and the given index. The EPT is only changed when the write programs
+ * a valid base address different from the mapped one while memory space decoding is enabled, so that sizing a BAR
+ * (writing all ones, then restoring it) or moving it with decoding disabled causes no EPT update. A move with
+ * decoding disabled is applied by vdev_pt_sync_vbars when decoding is enabled.
  *
  * @param[inout] vdev A vPCI device whose BAR register is to write.
  * @param[in] idx The BAR index.
@@ -243,7 +510,7 @@ static void vdev_pt_map_mem_vbar(struct pci_vdev *vdev, uint32_t idx)
  *
  * @post N/A
  *
- * @mode HV_SUBMODE_INIT_POST_SMP, HV_OPERATIONAL
+ * @mode HV_OPERATIONAL
  *
  * @remark It is an internal API called by other vPCI source file.
  *
@@ -274,11 +541,6 @@ void vdev_pt_write_vbar(struct pci_vdev *vdev, uint32_t idx, uint32_t val)
 			/** Decrement update_idx by 1, for BAR base updating need start from low 32bits */
 			update_idx -= 1U;
 		}
-		/** Call vdev_pt_unmap_mem_vbar with the following parameters, in order to unmap the BAR space first.
-		 *  - vdev
-		 *  - update_idx
-		 */
-		vdev_pt_unmap_mem_vbar(vdev, update_idx);
 
 		/** Call pci_vdev_write_bar with the following parameters, in order to write the BAR register
 		 *  in its virtual configuration space and update its BAR base info.
@@ -287,12 +549,16 @@ void vdev_pt_write_vbar(struct pci_vdev *vdev, uint32_t idx, uint32_t val)
 		 *  - val
 		 */
 		pci_vdev_write_bar(vdev, idx, val);
-		/** Call vdev_pt_map_mem_vbar with the following parameters, in order to remap the BAR space
-		 *  between the new GPA of BAR base and its HPA.
-		 *  - vdev
-		 *  - update_idx
-		 */
-		vdev_pt_map_mem_vbar(vdev, update_idx);
+
+		/** If the memory space decoding of the device is enabled */
+		if (is_mem_decoding_enabled(vdev)) {
+			/** Call vdev_pt_update_mem_vbar with the following parameters, in order to move the BAR space
+			 *  if its base address has changed.
+			 *  - vdev
+			 *  - update_idx
+			 */
+			vdev_pt_update_mem_vbar(vdev, update_idx);
+		}
 
 		/** End of case */
 		break;
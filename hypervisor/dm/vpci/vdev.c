@@ -192,6 +192,8 @@ void pci_vdev_write_cfg(struct pci_vdev *vdev, uint32_t offset, uint32_t bytes,
  * @brief Find a vPCI device from the vPCI devices list according to the given virtual BDF
  *
  * This function is called to find a vPCI device from the vPCI devices list according to the given virtual BDF.
+ * The lookup is done through the bitmap of populated virtual BDFs and the index from virtual BDF to vPCI device,
+ * so that probing an absent function costs one bit test and finding a present one costs one indexed load.
  *
  * @param[in] vpci A pointer to the vPCI device list.
  * @param[in] vbdf The virtual BDF of the vPCI device to find.
@@ -215,25 +217,17 @@ struct pci_vdev *pci_find_vdev(struct acrn_vpci *vpci, union pci_bdf vbdf)
 {
 	/** Declare the following local variables of type 'struct pci_vdev *'.
 	 *  - vdev representing the vPCI device to be found, initialized as NULL.
-	 *  - tmp representing a vPCI device in the devices list, initialized as NULL.
 	 */
-	struct pci_vdev *vdev = NULL, *tmp = NULL;
-	/** Declare the following local variables of type uint32_t.
-	 *  - i representing the index to probe the vPCI device, not initialized. */
-	uint32_t i;
-
-	/** For each i ranging from 0 to vpci->pci_vdev_cnt - 1 [with a step of 1] */
-	for (i = 0U; i < vpci->pci_vdev_cnt; i++) {
-		/** Set tmp to &(vpci->pci_vdevs[i]), the pointer to one vPCI device from the devices list */
-		tmp = &(vpci->pci_vdevs[i]);
+	struct pci_vdev *vdev = NULL;
+	/** Declare the following local variables of type uint16_t.
+	 *  - idx representing the given virtual BDF as a bit index, initialized as vbdf.value. */
+	uint16_t idx = vbdf.value;
 
-		/** If the probed vPCI device's virtual BDF equals the given one */
-		if (tmp->bdf.value == vbdf.value) {
-			/** Set vdev to tmp, which is the target vPCI device */
-			vdev = tmp;
-			/** End of case */
-			break;
-		}
+	/** If idx is less than VPCI_BDF_NUM and the (idx & 3FH)-th bit of vpci->vbdf_bitmap[idx >> 6] is set, which
+	 *  means a vPCI device populates the given virtual BDF */
+	if ((idx < VPCI_BDF_NUM) && bitmap_test(idx & 0x3FU, &vpci->vbdf_bitmap[idx >> 6U])) {
+		/** Set vdev to &(vpci->pci_vdevs[vpci->vbdf_index[idx]]), which is the target vPCI device */
+		vdev = &(vpci->pci_vdevs[vpci->vbdf_index[idx]]);
 	}
 
 	/** Return vdev, which is the found vPCI device or NULL */
@@ -437,7 +431,8 @@ static void pci_vdev_update_bar_base(struct pci_vdev *vdev, uint32_t idx)
  * @brief Write a BAR register to the configuration space of the given vPCI
  *
  * This function is called to write a BAR register to the configuration space of the given vPCI. It will write
- * the given value to the BAR register, and update the BAR base info.
+ * the given value to the BAR register, and update the BAR base info unless the value is 0FFFFFFFFH, which sizes the
+ * BAR.
  *
  * @param[inout] vdev A vPCI device whose BAR register is to write
  * @param[in] idx The BAR index.
@@ -489,20 +484,24 @@ void pci_vdev_write_bar(struct pci_vdev *vdev, uint32_t idx, uint32_t val)
 	 */
 	pci_vdev_write_cfg_u32(vdev, offset, bar);
 
-	/** If vbar->type is a 64bits BAR */
-	if (vbar->type == PCIBAR_MEM64HI) {
-		/** Decrement update_idx by 1, for a 64bits BAR, it need update its BAR base address according to its
-		 *  low 32bits register and high 32bits register in pair.
+	/** If val is not 0FFFFFFFFH, as writing all ones only sizes the BAR and keeps its base address until the
+	 *  guest restores or moves it */
+	if (val != ~0U) {
+		/** If vbar->type is a 64bits BAR */
+		if (vbar->type == PCIBAR_MEM64HI) {
+			/** Decrement update_idx by 1, for a 64bits BAR, it need update its BAR base address according to
+			 *  its low 32bits register and high 32bits register in pair.
+			 */
+			update_idx -= 1U;
+		}
+
+		/** Call pci_vdev_update_bar_base with the following parameters, in order to update the base address
+		 *  info of the given vPCI device's BAR.
+		 *  - vdev
+		 *  - update_idx
 		 */
-		update_idx -= 1U;
+		pci_vdev_update_bar_base(vdev, update_idx);
 	}
-
-	/** Call pci_vdev_update_bar_base with the following parameters, in order to update the base address info
-	 *  of the given vPCI device's BAR.
-	 *  - vdev
-	 *  - update_idx
-	 */
-	pci_vdev_update_bar_base(vdev, update_idx);
 }
 
 /**
@@ -0,0 +1,798 @@
+/*
+ * Copyright (C) 2019 Intel Corporation. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <vm.h>
+#include <io.h>
+#include <ept.h>
+#include <pgtable.h>
+#include <ptdev.h>
+#include <assign.h>
+#include <logmsg.h>
+#include <vpci.h>
+#include "vpci_priv.h"
+
+/**
+ * @addtogroup vp-dm_vperipheral
+ *
+ * @{
+ */
+
+/**
+ * @file
+ * @brief This file implements MSI-X operation APIs which are used within vPCI component
+ *
+ * This file implements the MSI-X capability emulation of the vPCI devices associated with a physical PCI device.
+ *
+ * About MSI-X, refer the PCI spec:
+ * - The messages of a function are programmed in the MSI-X table, which resides in one of its memory BARs. Each
+ * 16-byte entry of the table holds the message address, the message data and a vector control whose bit 0 masks the
+ * vector. The Pending Bit Array (PBA) resides in a memory BAR as well.
+ *
+ * About MSI-X emulation:
+ * - The guest pages holding the MSI-X table are removed from the EPT of the VM and each access to them is emulated by
+ * the MMIO handler registered for them. The guest programs up to CONFIG_MAX_MSIX_TABLE_NUM entries, each of which is
+ * remapped through ptirq_msix_remap to its own interrupt remapping entry when the guest enables MSI-X or updates the
+ * entry. The physical vector is masked whenever the virtual one is, or its virtual vector is invalid.
+ * - The rest of the trapped pages, such as a PBA sharing the pages of the table, is passed through by forwarding the
+ * accesses to the physical pages. The rest of the BAR stays mapped in the EPT.
+ *
+ * Following functions are internal APIs used by other source files within vPCI:
+ * - init_vmsix: initialize the virtual MSI-X info of the vPCI device which is associated with a physical PCI device
+ * - deinit_vmsix: disable the physical MSI-X and remove the interrupt remapping of the vPCI device
+ * - vmsix_write_cfg: write the MSI-X capability structure, which may enable or disable MSI-X
+ * - vmsix_trap_table: register the MMIO handler of the MSI-X table pages and remove them from the EPT
+ * - vmsix_untrap_table: unregister the MMIO handler of the MSI-X table pages
+ *
+ * Helper functions:
+ * - vmsix_table_hva: get the host virtual address of a physical MSI-X table entry
+ * - write_phys_msix_ctrl: write the control register of the physical MSI-X capability
+ *
+ * Decomposed functions:
+ * - remap_vmsix_entry: do the interrupt remapping of one MSI-X table entry
+ * - vmsix_table_entry_access: emulate an access to the emulated MSI-X table entries
+ * - vmsix_passthrough_access: forward an access to the trapped pages outside the emulated entries
+ * - vmsix_table_mmio_access: the MMIO handler of the trapped MSI-X table pages
+ */
+
+/**
+ * @brief Get the host virtual address of an entry of the physical MSI-X table of the given vPCI device.
+ *
+ * @param[in] vdev A vPCI device associated with a physical PCI device which has a MSI-X capability
+ * @param[in] index The index of the MSI-X table entry
+ *
+ * @return The host virtual address of the physical MSI-X table entry.
+ *
+ * @pre vdev != NULL
+ * @pre has_msix_cap(vdev) == true
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark The BAR holding the MSI-X table shall be identity-mapped in the host page tables.
+ *
+ * @reentrancy unspecified
+ * @threadsafety Yes
+ */
+static inline void *vmsix_table_hva(const struct pci_vdev *vdev, uint32_t index)
+{
+	/** Return the value returned by hpa2hva with the HPA of the MSI-X table entry being the parameter */
+	return hpa2hva(vdev->bar[vdev->msix.table_bar].base_hpa + vdev->msix.table_offset +
+		((uint64_t)index * MSIX_TABLE_ENTRY_SIZE));
+}
+
+/**
+ * @brief Write the control register of the physical MSI-X capability of the given vPCI device.
+ *
+ * Only the MSI-X enable and function mask bits are written, the other bits being read-only.
+ *
+ * @param[in] vdev A vPCI device associated with a physical PCI device which has a MSI-X capability
+ * @param[in] msgctrl The value of the MSI-X control register to write
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ * @pre has_msix_cap(vdev) == true
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_POST_SMP, HV_OPERATIONAL
+ *
+ * @remark N/A
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev is different among parallel invocation.
+ */
+static inline void write_phys_msix_ctrl(const struct pci_vdev *vdev, uint32_t msgctrl)
+{
+	/** Call pci_pdev_write_cfg with the following parameters, in order to write the physical MSI-X control
+	 *  register.
+	 *  - vdev->pbdf
+	 *  - vdev->msix.capoff + PCIR_MSIX_CTRL
+	 *  - 2
+	 *  - msgctrl & (PCIM_MSIXCTRL_MSIX_ENABLE | PCIM_MSIXCTRL_FUNCTION_MASK)
+	 */
+	pci_pdev_write_cfg(vdev->pbdf, vdev->msix.capoff + PCIR_MSIX_CTRL, 2U,
+		msgctrl & (PCIM_MSIXCTRL_MSIX_ENABLE | PCIM_MSIXCTRL_FUNCTION_MASK));
+}
+
+/**
+ * @brief Remap one virtual MSI-X table entry to its physical MSI-X table entry
+ *
+ * This function masks the physical entry, programs it with the message built by ptirq_msix_remap from the virtual
+ * entry, and unmasks it if the virtual entry is unmasked. An entry with an invalid virtual vector is left masked.
+ *
+ * @param[in] vdev A vPCI device associated with a physical PCI device which has a MSI-X capability
+ * @param[in] index The index of the MSI-X table entry to remap
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ * @pre vdev->vpci != NULL
+ * @pre vdev->vpci->vm != NULL
+ * @pre index < vdev->msix.table_count
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal API called by vmsix_write_cfg and vmsix_table_entry_access.
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev is different among parallel invocation.
+ */
+static void remap_vmsix_entry(const struct pci_vdev *vdev, uint32_t index)
+{
+	/** Declare the following local variables of type 'const struct msix_table_entry *'.
+	 *  - entry representing the virtual MSI-X table entry, initialized as &vdev->msix.tables[index]. */
+	const struct msix_table_entry *entry = &vdev->msix.tables[index];
+	/** Declare the following local variables of type 'uint8_t *'.
+	 *  - hva representing the host virtual address of the physical MSI-X table entry, initialized as the value
+	 *  returned by vmsix_table_hva with vdev and index being the parameters. */
+	uint8_t *hva = (uint8_t *)vmsix_table_hva(vdev, index);
+	/** Declare the following local variables of type 'struct ptirq_msi_info'.
+	 *  - info representing a data structure of the physical and virtual MSI information, not initialized. */
+	struct ptirq_msi_info info;
+
+	/** Call mmio_write32 with the following parameters, in order to mask the physical entry while it is updated.
+	 *  - PCIM_MSIX_VCTRL_MASK
+	 *  - hva + MSIX_ENTRY_VCTRL
+	 */
+	mmio_write32(PCIM_MSIX_VCTRL_MASK, (void *)(hva + MSIX_ENTRY_VCTRL));
+
+	/** Set info.vmsi_addr.full to entry->addr */
+	info.vmsi_addr.full = entry->addr;
+	/** Set info.vmsi_data.full to entry->data */
+	info.vmsi_data.full = entry->data;
+
+	/** If the remmaping vector number is in the range [0x10,0xfe], where 0x10 and 0xfe are the smallest and largest
+	 *  valid vector for MSIs */
+	if ((info.vmsi_data.bits.vector >= 0x10U) && (info.vmsi_data.bits.vector <= 0xfeU)) {
+		/** Call ptirq_msix_remap with the following parameters, in order to calculate the physical message
+		 *  data and message address of the entry according to its virtual data and address.
+		 *  - vdev->vpci->vm
+		 *  - vdev->bdf.value
+		 *  - vdev->pbdf.value
+		 *  - (uint16_t)index
+		 *  - &info
+		 */
+		ptirq_msix_remap(vdev->vpci->vm, vdev->bdf.value, vdev->pbdf.value, (uint16_t)index, &info);
+		/** Call mmio_write32 to write the low 32 bits of the physical message address */
+		mmio_write32((uint32_t)info.pmsi_addr.full, (void *)(hva + MSIX_ENTRY_ADDR));
+		/** Call mmio_write32 to write the high 32 bits of the physical message address */
+		mmio_write32((uint32_t)(info.pmsi_addr.full >> 32U), (void *)(hva + MSIX_ENTRY_ADDR + 4U));
+		/** Call mmio_write32 to write the physical message data */
+		mmio_write32(info.pmsi_data.full, (void *)(hva + MSIX_ENTRY_DATA));
+
+		/** If the virtual entry is not masked */
+		if ((entry->vector_control & PCIM_MSIX_VCTRL_MASK) == 0U) {
+			/** Call mmio_write32 with the following parameters, in order to unmask the physical entry.
+			 *  - 0
+			 *  - hva + MSIX_ENTRY_VCTRL
+			 */
+			mmio_write32(0U, (void *)(hva + MSIX_ENTRY_VCTRL));
+		}
+	}
+}
+
+/**
+ * @brief Write the register in the MSI-X capability structure
+ *
+ * Only the MSI-X enable and function mask bits of the control register are writable. When the guest enables MSI-X,
+ * each emulated entry is remapped and the other physical entries are masked before MSI-X is enabled on the physical
+ * device.
+ *
+ * @param[in] vdev A vPCI device which is associated with a physical PCI device
+ * @param[in] offset The register offset in the PCI configure space.
+ * @param[in] bytes The length of the register to write.
+ * @param[in] val The value to write.
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ * @pre msixcap_access(vdev, offset) == true
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal callback API called by write_cfg, with vdev->vpci->lock held.
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev is different among parallel invocation.
+ */
+void vmsix_write_cfg(struct pci_vdev *vdev, uint32_t offset, uint32_t bytes, uint32_t val)
+{
+	/** Declare the following local variables of type uint32_t.
+	 *  - old_ctrl representing the virtual MSI-X control register before the write, not initialized.
+	 *  - new_ctrl representing the virtual MSI-X control register after the write, not initialized.
+	 *  - old representing the value of the \a bytes value located in the vPCI configurations space,
+	 *  not initialized.
+	 *  - i representing the index of a MSI-X table entry, not initialized. */
+	uint32_t old_ctrl, new_ctrl, old, i;
+	/** Declare the following local variables of type uint32_t.
+	 *  - ro_mask representing the MSI-X read-only bit, initialized as ~0. */
+	uint32_t ro_mask = ~0U;
+	/** Declare the following local variables of type const uint8_t [12].
+	 *  - msix_ro_mask representing the MSI-X read-only bit. */
+	static const uint8_t msix_ro_mask[12U] = {0xffU, 0xffU, 0xffU, 0x3fU,
+						  0xffU, 0xffU, 0xffU, 0xffU,
+						  0xffU, 0xffU, 0xffU, 0xffU};
+
+	/** Call memcpy_s with the following parameters, in order to set ro_mask to MSI-X read-only mask.
+	 *  - &ro_mask
+	 *  - bytes
+	 *  - &msix_ro_mask[offset - vdev->msix.capoff]
+	 *  - bytes
+	 */
+	(void)memcpy_s((void *)&ro_mask, bytes, (const void *)&msix_ro_mask[offset - vdev->msix.capoff], bytes);
+
+	/** If there is any bit that is not set in ro_mask. */
+	if (ro_mask != ~0U) {
+		/** Set old_ctrl to the virtual MSI-X control register */
+		old_ctrl = pci_vdev_read_cfg(vdev, vdev->msix.capoff + PCIR_MSIX_CTRL, 2U);
+		/** Set old to the value returned by pci_vdev_read_cfg with vdev, offset and bytes being the
+		 *  parameters, which reads a bytes value from the configuration space of the given vPCI device.
+		 */
+		old = pci_vdev_read_cfg(vdev, offset, bytes);
+		/** Call pci_vdev_write_cfg with the following parameters, in order to write the writable bits of val
+		 *  into the given vPCI configuration space.
+		 * - vdev
+		 * - offset
+		 * - bytes
+		 * - (old & ro_mask) | (val & ~ro_mask)
+		 */
+		pci_vdev_write_cfg(vdev, offset, bytes, (old & ro_mask) | (val & ~ro_mask));
+		/** Set new_ctrl to the virtual MSI-X control register */
+		new_ctrl = pci_vdev_read_cfg(vdev, vdev->msix.capoff + PCIR_MSIX_CTRL, 2U);
+
+		/** If the enable bit of the control register is set by this write */
+		if (((new_ctrl & ~old_ctrl) & PCIM_MSIXCTRL_MSIX_ENABLE) != 0U) {
+			/** For each i ranging from 0 to vdev->msix.table_size / MSIX_TABLE_ENTRY_SIZE - 1 */
+			for (i = 0U; i < (vdev->msix.table_size / MSIX_TABLE_ENTRY_SIZE); i++) {
+				/** If i is smaller than vdev->msix.table_count */
+				if (i < vdev->msix.table_count) {
+					/** Call remap_vmsix_entry to remap the i-th entry */
+					remap_vmsix_entry(vdev, i);
+				} else {
+					/** Call mmio_write32 to mask the i-th physical entry not exposed to the guest */
+					mmio_write32(PCIM_MSIX_VCTRL_MASK,
+						(void *)((uint8_t *)vmsix_table_hva(vdev, i) + MSIX_ENTRY_VCTRL));
+				}
+			}
+		}
+
+		/** If the enable or function mask bit of the control register is changed by this write */
+		if (((old_ctrl ^ new_ctrl) & (PCIM_MSIXCTRL_MSIX_ENABLE | PCIM_MSIXCTRL_FUNCTION_MASK)) != 0U) {
+			/** Call write_phys_msix_ctrl to apply the new enable and function mask bits to the physical
+			 *  device */
+			write_phys_msix_ctrl(vdev, new_ctrl);
+		}
+	}
+}
+
+/**
+ * @brief Emulate an access to the emulated entries of the MSI-X table
+ *
+ * A write to a vector control, or to an unmasked entry, remaps the entry if MSI-X is enabled by the guest. Accesses
+ * crossing an entry are ignored, which reads as 0.
+ *
+ * @param[inout] vdev A vPCI device which is associated with a physical PCI device
+ * @param[inout] mmio The MMIO request to emulate
+ * @param[in] table_off The offset of the access in the MSI-X table
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ * @pre mmio != NULL
+ * @pre table_off < vdev->msix.table_count * MSIX_TABLE_ENTRY_SIZE
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal API called by vmsix_table_mmio_access, with vdev->vpci->lock held.
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev is different among parallel invocation.
+ */
+static void vmsix_table_entry_access(struct pci_vdev *vdev, struct mmio_request *mmio, uint32_t table_off)
+{
+	/** Declare the following local variables of type uint32_t.
+	 *  - index representing the index of the accessed entry, initialized as table_off / MSIX_TABLE_ENTRY_SIZE.
+	 *  - entry_off representing the offset of the access in the entry, initialized as
+	 *  table_off % MSIX_TABLE_ENTRY_SIZE.
+	 *  - bytes representing the access size in bytes, initialized as mmio->size. */
+	uint32_t index = table_off / MSIX_TABLE_ENTRY_SIZE;
+	uint32_t entry_off = table_off % MSIX_TABLE_ENTRY_SIZE;
+	uint32_t bytes = (uint32_t)mmio->size;
+	/** Declare the following local variables of type 'struct msix_table_entry *'.
+	 *  - entry representing the accessed virtual entry, initialized as &vdev->msix.tables[index]. */
+	struct msix_table_entry *entry = &vdev->msix.tables[index];
+	/** Declare the following local variables of type 'uint8_t *'.
+	 *  - field representing the accessed bytes of the entry, initialized as (uint8_t *)entry + entry_off. */
+	uint8_t *field = (uint8_t *)entry + entry_off;
+	/** Declare the following local variables of type uint64_t.
+	 *  - val representing the value read, initialized as 0. */
+	uint64_t val = 0UL;
+	/** Declare the following local variables of type uint32_t.
+	 *  - msgctrl representing the virtual MSI-X control register, not initialized. */
+	uint32_t msgctrl;
+
+	/** If the access is a naturally aligned 4-byte or 8-byte access */
+	if (((bytes == 4U) || (bytes == 8U)) && ((entry_off & (bytes - 1U)) == 0U)) {
+		/** If mmio->direction is REQUEST_READ */
+		if (mmio->direction == REQUEST_READ) {
+			/** Call memcpy_s to copy the accessed bytes of the entry to val */
+			(void)memcpy_s((void *)&val, bytes, (const void *)field, bytes);
+		} else {
+			/** Call memcpy_s to copy the written value to the accessed bytes of the entry */
+			(void)memcpy_s((void *)field, bytes, (const void *)&mmio->value, bytes);
+			/** Set msgctrl to the virtual MSI-X control register */
+			msgctrl = pci_vdev_read_cfg(vdev, vdev->msix.capoff + PCIR_MSIX_CTRL, 2U);
+			/** If MSI-X is enabled by the guest, and the vector control is written or the entry is
+			 *  unmasked */
+			if (((msgctrl & PCIM_MSIXCTRL_MSIX_ENABLE) != 0U) &&
+				(((entry_off + bytes) > MSIX_ENTRY_VCTRL) ||
+				((entry->vector_control & PCIM_MSIX_VCTRL_MASK) == 0U))) {
+				/** Call remap_vmsix_entry to remap the entry */
+				remap_vmsix_entry(vdev, index);
+			}
+		}
+	}
+
+	/** If mmio->direction is REQUEST_READ */
+	if (mmio->direction == REQUEST_READ) {
+		/** Set mmio->value to val */
+		mmio->value = val;
+	}
+}
+
+/**
+ * @brief Forward an access to the trapped pages of the MSI-X table outside the emulated entries
+ *
+ * The access is performed on the corresponding physical page, which passes through the PBA and the other registers
+ * sharing the pages of the MSI-X table. The physical entries not exposed to the guest read as 0 and ignore writes.
+ *
+ * @param[in] vdev A vPCI device which is associated with a physical PCI device
+ * @param[inout] mmio The MMIO request to forward
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ * @pre mmio != NULL
+ * @pre vdev->msix.mmio_gpa <= mmio->address < vdev->msix.mmio_gpa + vdev->msix.mmio_size
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal API called by vmsix_table_mmio_access.
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev is different among parallel invocation.
+ */
+static void vmsix_passthrough_access(const struct pci_vdev *vdev, struct mmio_request *mmio)
+{
+	/** Declare the following local variables of type uint64_t.
+	 *  - table_gpa representing the GPA of the MSI-X table, initialized as
+	 *  vdev->bar[vdev->msix.table_bar].mapped_base + vdev->msix.table_offset.
+	 *  - val representing the value read, initialized as 0. */
+	uint64_t table_gpa = vdev->bar[vdev->msix.table_bar].mapped_base + vdev->msix.table_offset;
+	uint64_t val = 0UL;
+	/** Declare the following local variables of type 'uint8_t *'.
+	 *  - hva representing the host virtual address of the access, initialized as the value returned by hpa2hva
+	 *  with the corresponding HPA being the parameter. */
+	uint8_t *hva = (uint8_t *)hpa2hva(vdev->msix.mmio_hpa + (mmio->address - vdev->msix.mmio_gpa));
+
+	/** If the access does not overlap the physical MSI-X table */
+	if (((mmio->address + mmio->size) <= table_gpa) || (mmio->address >= (table_gpa + vdev->msix.table_size))) {
+		/** If mmio->direction is REQUEST_READ */
+		if (mmio->direction == REQUEST_READ) {
+			/** Depending on mmio->size */
+			switch (mmio->size) {
+			/** mmio->size is 1 */
+			case 1UL:
+				/** Set val to the byte read from hva */
+				val = (uint64_t)mmio_read8((const void *)hva);
+				/** End of case */
+				break;
+			/** mmio->size is 2 */
+			case 2UL:
+				/** Set val to the word read from hva */
+				val = (uint64_t)mmio_read16((const void *)hva);
+				/** End of case */
+				break;
+			/** mmio->size is 4 */
+			case 4UL:
+				/** Set val to the dword read from hva */
+				val = (uint64_t)mmio_read32((const void *)hva);
+				/** End of case */
+				break;
+			/** Otherwise, mmio->size is 8 */
+			default:
+				/** Set val to the two dwords read from hva and hva + 4 */
+				val = (uint64_t)mmio_read32((const void *)hva) |
+					((uint64_t)mmio_read32((const void *)(hva + 4U)) << 32U);
+				/** End of case */
+				break;
+			}
+		} else {
+			/** Depending on mmio->size */
+			switch (mmio->size) {
+			/** mmio->size is 1 */
+			case 1UL:
+				/** Write the low byte of mmio->value to hva */
+				mmio_write8((uint8_t)mmio->value, (void *)hva);
+				/** End of case */
+				break;
+			/** mmio->size is 2 */
+			case 2UL:
+				/** Write the low word of mmio->value to hva */
+				mmio_write16((uint16_t)mmio->value, (void *)hva);
+				/** End of case */
+				break;
+			/** mmio->size is 4 */
+			case 4UL:
+				/** Write the low dword of mmio->value to hva */
+				mmio_write32((uint32_t)mmio->value, (void *)hva);
+				/** End of case */
+				break;
+			/** Otherwise, mmio->size is 8 */
+			default:
+				/** Write the low and high dwords of mmio->value to hva and hva + 4 */
+				mmio_write32((uint32_t)mmio->value, (void *)hva);
+				mmio_write32((uint32_t)(mmio->value >> 32U), (void *)(hva + 4U));
+				/** End of case */
+				break;
+			}
+		}
+	}
+
+	/** If mmio->direction is REQUEST_READ */
+	if (mmio->direction == REQUEST_READ) {
+		/** Set mmio->value to val */
+		mmio->value = val;
+	}
+}
+
+/**
+ * @brief The MMIO handler of the trapped pages of the MSI-X table
+ *
+ * @param[inout] io_req The MMIO request to emulate
+ * @param[in] handler_private_data The vPCI device whose MSI-X table is trapped
+ *
+ * @return 0, as each access to the trapped pages is completed.
+ *
+ * @pre io_req != NULL
+ * @pre handler_private_data != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is registered by vmsix_trap_table.
+ *
+ * @reentrancy unspecified
+ * @threadsafety Yes
+ */
+static int32_t vmsix_table_mmio_access(struct io_request *io_req, void *handler_private_data)
+{
+	/** Declare the following local variables of type 'struct pci_vdev *'.
+	 *  - vdev representing the vPCI device whose MSI-X table is trapped, initialized as handler_private_data. */
+	struct pci_vdev *vdev = (struct pci_vdev *)handler_private_data;
+	/** Declare the following local variables of type 'struct acrn_vpci *'.
+	 *  - vpci representing the vPCI of the VM owning the device, initialized as &vdev->vpci->vm->vpci. */
+	struct acrn_vpci *vpci = &vdev->vpci->vm->vpci;
+	/** Declare the following local variables of type 'struct mmio_request *'.
+	 *  - mmio representing the MMIO request to emulate, initialized as &io_req->reqs.mmio. */
+	struct mmio_request *mmio = &io_req->reqs.mmio;
+	/** Declare the following local variables of type uint64_t.
+	 *  - table_gpa representing the GPA of the MSI-X table, not initialized. */
+	uint64_t table_gpa;
+
+	/** Call spinlock_obtain to serialize the access with the accesses to the configuration space of the VM */
+	spinlock_obtain(&vpci->lock);
+	/** Set table_gpa to vdev->bar[vdev->msix.table_bar].mapped_base + vdev->msix.table_offset */
+	table_gpa = vdev->bar[vdev->msix.table_bar].mapped_base + vdev->msix.table_offset;
+	/** If the access is not in the trapped pages any more, as the BAR has been moved after the handler was
+	 *  looked up */
+	if ((vdev->msix.mmio_gpa == 0UL) || (mmio->address < vdev->msix.mmio_gpa) ||
+		((mmio->address + mmio->size) > (vdev->msix.mmio_gpa + vdev->msix.mmio_size))) {
+		/** If mmio->direction is REQUEST_READ */
+		if (mmio->direction == REQUEST_READ) {
+			/** Set mmio->value to 0, as for an access to an unbacked range */
+			mmio->value = 0UL;
+		}
+	/** If the access starts in the emulated entries of the MSI-X table */
+	} else if ((mmio->address >= table_gpa) &&
+		(mmio->address < (table_gpa + ((uint64_t)vdev->msix.table_count * MSIX_TABLE_ENTRY_SIZE)))) {
+		/** Call vmsix_table_entry_access to emulate the access */
+		vmsix_table_entry_access(vdev, mmio, (uint32_t)(mmio->address - table_gpa));
+	} else {
+		/** Call vmsix_passthrough_access to forward the access to the physical page */
+		vmsix_passthrough_access(vdev, mmio);
+	}
+	/** Call spinlock_release to release the lock obtained above */
+	spinlock_release(&vpci->lock);
+
+	/** Return 0 */
+	return 0;
+}
+
+/**
+ * @brief Trap the guest pages holding the MSI-X table of the given vPCI device
+ *
+ * The MMIO handler of the pages is registered and the pages are removed from the EPT of the VM. If the handler
+ * cannot be registered, the pages are left mapped and untrapped, as a guest access to pages that are neither
+ * mapped nor emulated could never complete.
+ *
+ * @param[inout] vdev A vPCI device associated with a physical PCI device which has a MSI-X capability
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ * @pre vdev->vpci != NULL
+ * @pre vdev->vpci->vm != NULL
+ * @pre has_msix_cap(vdev) == true
+ * @pre vdev->bar[vdev->msix.table_bar].mapped_base != 0
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_POST_SMP, HV_OPERATIONAL
+ *
+ * @remark It is an internal API called by vdev_pt_map_mem_vbar after the BAR holding the table is mapped.
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev->vpci->vm is different among parallel invocation.
+ */
+void vmsix_trap_table(struct pci_vdev *vdev)
+{
+	/** Declare the following local variables of type 'struct acrn_vm *'.
+	 *  - vm representing the VM that the given vPCI device belongs to, initialized as vdev->vpci->vm. */
+	struct acrn_vm *vm = vdev->vpci->vm;
+	/** Declare the following local variables of type 'const struct pci_bar *'.
+	 *  - vbar representing the BAR holding the MSI-X table, initialized as &vdev->bar[vdev->msix.table_bar]. */
+	const struct pci_bar *vbar = &vdev->bar[vdev->msix.table_bar];
+	/** Declare the following local variables of type uint64_t.
+	 *  - table_gpa representing the GPA of the MSI-X table, initialized as
+	 *  vbar->mapped_base + vdev->msix.table_offset. */
+	uint64_t table_gpa = vbar->mapped_base + vdev->msix.table_offset;
+
+	/** Set vdev->msix.mmio_gpa to the GPA of the page holding the start of the MSI-X table */
+	vdev->msix.mmio_gpa = table_gpa & PAGE_MASK;
+	/** Set vdev->msix.mmio_hpa to the HPA of the page holding the start of the MSI-X table */
+	vdev->msix.mmio_hpa = (vbar->base_hpa + vdev->msix.table_offset) & PAGE_MASK;
+	/** Set vdev->msix.mmio_size to the size of the pages holding the MSI-X table */
+	vdev->msix.mmio_size = ((table_gpa + vdev->msix.table_size + PAGE_SIZE - 1UL) & PAGE_MASK) -
+		vdev->msix.mmio_gpa;
+
+	/** Call register_mmio_emulation_handler with the following parameters, in order to emulate the accesses to
+	 *  the pages holding the MSI-X table, and if it succeeds. A failure is logged by the callee.
+	 *  - vm
+	 *  - vmsix_table_mmio_access
+	 *  - vdev->msix.mmio_gpa
+	 *  - vdev->msix.mmio_gpa + vdev->msix.mmio_size
+	 *  - vdev
+	 */
+	if (register_mmio_emulation_handler(vm, vmsix_table_mmio_access, vdev->msix.mmio_gpa,
+		vdev->msix.mmio_gpa + vdev->msix.mmio_size, (void *)vdev) == 0) {
+		/** Call ept_del_mr with the following parameters, in order to remove the pages from the EPT.
+		 *  - vm
+		 *  - vm->arch_vm.nworld_eptp
+		 *  - vdev->msix.mmio_gpa
+		 *  - vdev->msix.mmio_size
+		 */
+		ept_del_mr(vm, (uint64_t *)(vm->arch_vm.nworld_eptp), vdev->msix.mmio_gpa, vdev->msix.mmio_size);
+	} else {
+		/** Set vdev->msix.mmio_gpa to 0, which means the pages are not trapped */
+		vdev->msix.mmio_gpa = 0UL;
+		/** Set vdev->msix.mmio_size to 0 */
+		vdev->msix.mmio_size = 0UL;
+	}
+}
+
+/**
+ * @brief Stop trapping the guest pages holding the MSI-X table of the given vPCI device
+ *
+ * @param[inout] vdev A vPCI device associated with a physical PCI device which has a MSI-X capability
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ * @pre vdev->vpci != NULL
+ * @pre vdev->vpci->vm != NULL
+ *
+ * @post vdev->msix.mmio_gpa == 0
+ *
+ * @mode HV_SUBMODE_INIT_POST_SMP, HV_OPERATIONAL
+ *
+ * @remark It is an internal API called by vdev_pt_unmap_mem_vbar, which removes the pages from the EPT.
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev->vpci->vm is different among parallel invocation.
+ */
+void vmsix_untrap_table(struct pci_vdev *vdev)
+{
+	/** If vdev->msix.mmio_gpa is not 0, which means the pages are trapped */
+	if (vdev->msix.mmio_gpa != 0UL) {
+		/** Call unregister_mmio_emulation_handler with the following parameters, in order to stop emulating
+		 *  the pages.
+		 *  - vdev->vpci->vm
+		 *  - vdev->msix.mmio_gpa
+		 */
+		unregister_mmio_emulation_handler(vdev->vpci->vm, vdev->msix.mmio_gpa);
+		/** Set vdev->msix.mmio_gpa to 0 */
+		vdev->msix.mmio_gpa = 0UL;
+		/** Set vdev->msix.mmio_size to 0 */
+		vdev->msix.mmio_size = 0UL;
+	}
+}
+
+/**
+ * @brief Deinit the virtual MSI-X of the given vPCI device
+ *
+ * This function disables MSI-X on the physical device and removes the interrupt remapping of each emulated entry.
+ *
+ * @param[in] vdev A vPCI device which is associated with a physical PCI device
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ * @pre vdev->vpci != NULL
+ * @pre vdev->vpci->vm != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal API called by vpci_deinit_pt_dev and vpci_reset_pt_dev.
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev is different among parallel invocation.
+ */
+void deinit_vmsix(const struct pci_vdev *vdev)
+{
+	/** If there is MSI-X capability in the given vPCI device */
+	if (has_msix_cap(vdev)) {
+		/** Call write_phys_msix_ctrl to disable MSI-X on the physical device */
+		write_phys_msix_ctrl(vdev, 0U);
+		/** Call ptirq_remove_msix_remapping with the following parameters, in order to remove the interrupt
+		 *  remapping of each emulated entry.
+		 *  - vdev->vpci->vm
+		 *  - vdev->bdf.value
+		 *  - vdev->msix.table_count
+		 */
+		ptirq_remove_msix_remapping(vdev->vpci->vm, vdev->bdf.value, vdev->msix.table_count);
+	}
+}
+
+/**
+ * @brief Initialize the virtual MSI-X of the given vPCI device
+ *
+ * This function initializes the MSI-X capability registers in the virtual configuration space and the MSI-X
+ * information of the given vPCI device, and disables MSI-X on the physical device. The virtual MSI-X capability is
+ * linked after the virtual MSI capability, if any, as the last item of the virtual capabilities list. Its table size
+ * is limited to CONFIG_MAX_MSIX_TABLE_NUM entries, all masked.
+ *
+ * @param[inout] vdev A vPCI device which is associated with a physical PCI device
+ *
+ * @return None
+ *
+ * @pre vdev != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_POST_SMP, HV_OPERATIONAL
+ *
+ * @remark It is an internal API called by vpci_init_pt_dev and vpci_reset_pt_dev, after init_vmsi.
+ *
+ * @reentrancy unspecified
+ * @threadsafety When \a vdev is different among parallel invocation.
+ */
+void init_vmsix(struct pci_vdev *vdev)
+{
+	/** Declare the following local variables of type uint32_t.
+	 *  - val representing a register value in the configuration space, not initialized.
+	 *  - msgctrl representing the physical MSI-X control register, not initialized.
+	 *  - i representing the index of a MSI-X table entry, not initialized. */
+	uint32_t val, msgctrl, i;
+
+	/** Set val to the offset of the first capability structure of the physical device */
+	val = pci_pdev_read_cfg(vdev->pbdf, PCIR_CAP_PTR, 1U);
+	/** Until 'val' (the offset) is equal to 0 or FFH */
+	while ((val != 0U) && (val != 0xFFU)) {
+		/** If the capability ID at val is PCIY_MSIX */
+		if (pci_pdev_read_cfg(vdev->pbdf, val + PCICAP_ID, 1U) == PCIY_MSIX) {
+			/** Set vdev->msix.capoff to 'val', the offset of the MSI-X capability structure. */
+			vdev->msix.capoff = val;
+			/** Terminate the loop */
+			break;
+		}
+		/** Set val to the next pointer register of the capability structure */
+		val = pci_pdev_read_cfg(vdev->pbdf, val + PCICAP_NEXTPTR, 1U);
+	}
+
+	/** If the given vPCI device has the MSI-X capability */
+	if (has_msix_cap(vdev)) {
+		/** Set vdev->msix.caplen to 12 */
+		vdev->msix.caplen = 12U;
+		/** Set msgctrl to the physical MSI-X control register */
+		msgctrl = pci_pdev_read_cfg(vdev->pbdf, vdev->msix.capoff + PCIR_MSIX_CTRL, 2U);
+		/** Set vdev->msix.table_size to the size in bytes of the physical MSI-X table */
+		vdev->msix.table_size = ((msgctrl & PCIM_MSIXCTRL_TABLE_SIZE) + 1U) * MSIX_TABLE_ENTRY_SIZE;
+		/** Set vdev->msix.table_count to the number of physical entries */
+		vdev->msix.table_count = (msgctrl & PCIM_MSIXCTRL_TABLE_SIZE) + 1U;
+		/** If vdev->msix.table_count is larger than CONFIG_MAX_MSIX_TABLE_NUM */
+		if (vdev->msix.table_count > CONFIG_MAX_MSIX_TABLE_NUM) {
+			/** Set vdev->msix.table_count to CONFIG_MAX_MSIX_TABLE_NUM */
+			vdev->msix.table_count = CONFIG_MAX_MSIX_TABLE_NUM;
+		}
+
+		/** Set val to the physical MSI-X table offset/BIR register */
+		val = pci_pdev_read_cfg(vdev->pbdf, vdev->msix.capoff + PCIR_MSIX_TABLE, 4U);
+		/** Set vdev->msix.table_bar to the BAR indicator of val */
+		vdev->msix.table_bar = val & PCIM_MSIX_BIR_MASK;
+		/** Set vdev->msix.table_offset to the table offset of val */
+		vdev->msix.table_offset = val & ~PCIM_MSIX_BIR_MASK;
+
+		/** Call pci_vdev_write_cfg to write the virtual capability ID, a null next pointer and a control
+		 *  register with MSI-X disabled and the emulated table size */
+		pci_vdev_write_cfg(vdev, vdev->msix.capoff, 4U,
+			PCIY_MSIX | ((vdev->msix.table_count - 1U) << 16U));
+		/** Call pci_vdev_write_cfg to write the virtual table offset/BIR register */
+		pci_vdev_write_cfg(vdev, vdev->msix.capoff + PCIR_MSIX_TABLE, 4U, val);
+		/** Call pci_vdev_write_cfg to write the virtual PBA offset/BIR register with the physical one */
+		pci_vdev_write_cfg(vdev, vdev->msix.capoff + PCIR_MSIX_PBA, 4U,
+			pci_pdev_read_cfg(vdev->pbdf, vdev->msix.capoff + PCIR_MSIX_PBA, 4U));
+
+		/** If the given vPCI device has the MSI capability */
+		if (has_msi_cap(vdev)) {
+			/** Call pci_vdev_write_cfg to link the MSI-X capability after the MSI capability */
+			pci_vdev_write_cfg(vdev, vdev->msi.capoff + PCICAP_NEXTPTR, 1U, vdev->msix.capoff);
+		} else {
+			/** Call pci_vdev_write_cfg to make the MSI-X capability the first one */
+			pci_vdev_write_cfg(vdev, PCIR_CAP_PTR, 1U, vdev->msix.capoff);
+		}
+
+		/** For each i ranging from 0 to vdev->msix.table_count - 1 */
+		for (i = 0U; i < vdev->msix.table_count; i++) {
+			/** Set vdev->msix.tables[i].addr to 0 */
+			vdev->msix.tables[i].addr = 0UL;
+			/** Set vdev->msix.tables[i].data to 0 */
+			vdev->msix.tables[i].data = 0U;
+			/** Set vdev->msix.tables[i].vector_control to PCIM_MSIX_VCTRL_MASK, the reset value */
+			vdev->msix.tables[i].vector_control = PCIM_MSIX_VCTRL_MASK;
+		}
+
+		/** Call write_phys_msix_ctrl to disable MSI-X on the physical device */
+		write_phys_msix_ctrl(vdev, 0U);
+	}
+}
+
+/**
+ * @}
+ */
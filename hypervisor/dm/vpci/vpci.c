@@ -48,8 +48,10 @@
  * which is not related with the physical hostbridge. But to the passthrough PCI devices, some operations is based on
  * their virtual configuration space, some are mapped to their physical configuration space, like MSI and BAR registers.
  *
- * It defines one initial function, one de-init function, and four callback functions (read/write address and data
- * register) which are registered and called when PCI port IO is accessed. It also defines some helper functions to
+ * It defines one initial function, one de-init function, one reset function, and four callback functions (read/write address and data
+ * register) which are registered and called when PCI port IO is accessed. One more callback function is registered
+ * for the virtual ECAM (MMCONFIG) window advertised in the MCFG table, so that a single MMIO access reaches the
+ * configuration register of a vBDF, including the 4KB PCI Express extended configuration space. It also defines some helper functions to
  * implement the features that are commonly used in this file. In addition, it defines some decomposed functions to
  * improve the readability of the code.
  *
@@ -57,7 +59,7 @@
  *
  * Decomposed functions: read_cfg, write_cfg, vpci_init_vdevs, assign_vdev_pt_iommu_domain,
  * remove_vdev_pt_iommu_domain, init_default_cfg, vpci_init_pt_dev, vpci_deinit_pt_dev, vpci_write_pt_dev_cfg,
- * vpci_read_pt_dev_cfg, vpci_init_vdev, vpci_init_vdevs
+ * vpci_read_pt_dev_cfg, vpci_init_vdev, vpci_init_vdevs, vpci_reset_pt_dev
  *
  * Note: for FuSa scope, the passthrough PCI devices just includes: USB controller and Ethernet card.
  */
@@ -441,13 +443,111 @@ static void pci_cfgdata_io_write(struct acrn_vcpu *vcpu, uint16_t addr, size_t b
 	}
 }
 
+/**
+ * @brief Read or write a register in the virtual PCI configuration space through the virtual ECAM window
+ *
+ * This function is called when a guest VM accesses the virtual ECAM (MMCONFIG) window at VPCI_ECAM_BASE. The
+ * accessed address encodes both the BDF (bits 12-27 relative to the window base) and the register offset (bits
+ * 0-11), so one MMIO access is resolved to read_cfg / write_cfg directly, instead of the pair of port IO accesses
+ * through 0CF8H and 0CFCH. Invalid accesses read 0FFFFFFFFH and drop writes, as the port IO path does.
+ *
+ * @param[inout] io_req The MMIO request decoded from the guest instruction.
+ * @param[in] handler_private_data A pointer to the vPCI which belongs to the VM.
+ *
+ * @return 0
+ *
+ * @pre io_req != NULL
+ * @pre handler_private_data != NULL
+ * @pre (io_req->reqs.mmio.address >= VPCI_ECAM_BASE) &&
+ *      ((io_req->reqs.mmio.address + io_req->reqs.mmio.size) <= (VPCI_ECAM_BASE + VPCI_ECAM_SIZE))
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is a callback function and called only after vpci_init has been called.
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety Yes
+ */
+static int32_t vpci_mmio_cfg_access(struct io_request *io_req, void *handler_private_data)
+{
+	/** Declare the following local variables of type 'struct acrn_vpci *'.
+	 *  - vpci representing the vPCI which belongs to the VM, initialized as handler_private_data. */
+	struct acrn_vpci *vpci = (struct acrn_vpci *)handler_private_data;
+	/** Declare the following local variables of type 'struct mmio_request *'.
+	 *  - mmio_req representing the MMIO request to emulate, initialized as &io_req->reqs.mmio. */
+	struct mmio_request *mmio_req = &io_req->reqs.mmio;
+	/** Declare the following local variables of type uint64_t.
+	 *  - ecam_offset representing the offset of the access in the virtual ECAM window, initialized as
+	 *  'mmio_req->address - VPCI_ECAM_BASE'.
+	 */
+	uint64_t ecam_offset = mmio_req->address - VPCI_ECAM_BASE;
+	/** Declare the following local variables of type uint32_t.
+	 *  - target_reg representing the register offset in the PCI configuration space, initialized as
+	 *  'ecam_offset & PCIE_REGMAX'.
+	 */
+	uint32_t target_reg = (uint32_t)ecam_offset & PCIE_REGMAX;
+	/** Declare the following local variables of type uint32_t.
+	 *  - bytes representing the access size in bytes, initialized as mmio_req->size. */
+	uint32_t bytes = (uint32_t)mmio_req->size;
+	/** Declare the following local variables of type 'union pci_bdf'.
+	 *  - bdf representing the BDF info of the PCI device this access targets, not initialized. */
+	union pci_bdf bdf;
+	/** Declare the following local variables of type uint32_t.
+	 *  - val representing the value read from or written to the PCI configuration space, initialized as
+	 *  0FFFFFFFFH. */
+	uint32_t val = ~0U;
+
+	/** Set bdf.value to bits 12-27 of ecam_offset */
+	bdf.value = (uint16_t)(ecam_offset >> 12U);
+
+	/** If the value returned by vpci_is_valid_access (with target_reg and bytes being the parameters) is true,
+	 *  which means this access is valid. 8-byte accesses are not valid. */
+	if (vpci_is_valid_access(target_reg, bytes)) {
+		/** If mmio_req->direction is REQUEST_READ */
+		if (mmio_req->direction == REQUEST_READ) {
+			/** Call read_cfg with the following parameters, in order to read the register's value from
+			 *  the corresponding PCI device configuration space.
+			 *  - vpci
+			 *  - bdf
+			 *  - target_reg
+			 *  - bytes
+			 *  - &val
+			 */
+			read_cfg(vpci, bdf, target_reg, bytes, &val);
+		} else {
+			/** Call write_cfg with the following parameters, in order to write the value to the target
+			 *  register of the corresponding PCI device configuration space.
+			 *  - vpci
+			 *  - bdf
+			 *  - target_reg
+			 *  - bytes
+			 *  - (uint32_t)mmio_req->value
+			 */
+			write_cfg(vpci, bdf, target_reg, bytes, (uint32_t)mmio_req->value);
+		}
+	}
+
+	/** If mmio_req->direction is REQUEST_READ */
+	if (mmio_req->direction == REQUEST_READ) {
+		/** Set mmio_req->value to val, which will be returned to the guest VM. */
+		mmio_req->value = (uint64_t)val;
+	}
+
+	/** Return 0 */
+	return 0;
+}
+
 /**
  * @brief Initialize the vPCI component which belongs to the given VM
  *
  * This function is called to initialize the vPCI component which belongs to the given VM. It will initialize each
  * PCI device owned by the given VM. Also it will register PCI port IO access callback functions, including read
- * and write functions for address and data IO ports. So when the VM accesses its PCI port IO, it will trap into
- * hypervisor and call these functions.
+ * and write functions for address and data IO ports, and the access callback function of the virtual ECAM window.
+ * So when the VM accesses its PCI port IO or the virtual ECAM window, it will trap into hypervisor and call these
+ * functions.
  *
  * @param[inout] vm A pointer to a VM instance whose vPCI component is to be initialized.
  *
@@ -519,6 +619,19 @@ void vpci_init(struct acrn_vm *vm)
 	register_pio_emulation_handler(
 		vm, PCI_CFGDATA_PIO_IDX, &pci_cfgdata_range, pci_cfgdata_io_read, pci_cfgdata_io_write);
 
+	/** Call register_mmio_emulation_handler with the following parameters, in order to intercept the virtual
+	 *  ECAM window advertised in the MCFG table of the VM. The window is never mapped in EPT, so each access
+	 *  to it traps into hypervisor and calls the registered function. The return value is ignored as the
+	 *  handler table of a VM being initialized cannot be full.
+	 *  - vm
+	 *  - vpci_mmio_cfg_access
+	 *  - VPCI_ECAM_BASE
+	 *  - VPCI_ECAM_BASE + VPCI_ECAM_SIZE
+	 *  - &vm->vpci
+	 */
+	(void)register_mmio_emulation_handler(vm, vpci_mmio_cfg_access, VPCI_ECAM_BASE,
+		VPCI_ECAM_BASE + VPCI_ECAM_SIZE, (void *)&vm->vpci);
+
 	/** Call spinlock_init with the following parameters, in order to initialize the vPCI lock.
 	 *  - &vm->vpci.lock
 	 */
@@ -828,7 +941,8 @@ static void init_default_cfg(struct pci_vdev *vdev)
  * @brief Initialize the passthrough PCI device associated with the given vPCI
  *
  * This function is called to initialize the passthrough PCI device associated with the given vPCI device. It will
- * call internal functions to initialize the given vPCI's virtual configuration space, virtual MSI and BAR remapping.
+ * call internal functions to initialize the given vPCI's virtual configuration space, virtual MSI and MSI-X and BAR
+ * remapping.
  *
  * @param[in] vdev A vPCI device which is associated with a physical PCI device
  *
@@ -860,6 +974,11 @@ static void vpci_init_pt_dev(struct pci_vdev *vdev)
 	 *  - vdev
 	 */
 	init_vmsi(vdev);
+	/** Call init_vmsix with the following parameters, in order to initialize the virtual MSI-X fields of the
+	 *  given vPCI device. It shall precede init_vdev_pt, which traps the MSI-X table when mapping its BAR.
+	 *  - vdev
+	 */
+	init_vmsix(vdev);
 	/** Call init_vdev_pt with the following parameters, in order to initialize the virtual BAR info of the
 	 *  given vPCI device, and do the BAR mapping between the guest VM's memory space (GPA) and HPA according to
 	 *  the guest VM's configuration for the vBAR base of the given vPCI device.
@@ -878,7 +997,7 @@ static void vpci_init_pt_dev(struct pci_vdev *vdev)
  * @brief Release the resource of the passthrough PCI device associated with the given vPCI device
  *
  * This function is called to release the resource of the passthrough PCI device associated with the given vPCI device.
- * It will call internal functions to remove the device from the VM's IOMMU domain, and remove MSI remapping.
+ * It will call internal functions to remove the device from the VM's IOMMU domain, and remove MSI and MSI-X remapping.
  *
  * @param[in] vdev A vPCI device which is associated with a physical PCI device
  *
@@ -908,6 +1027,10 @@ static void vpci_deinit_pt_dev(struct pci_vdev *vdev)
 	 *  - vdev
 	 */
 	deinit_vmsi(vdev);
+	/** Call deinit_vmsix with the following parameters, in order to remove the MSI-X remapping.
+	 *  - vdev
+	 */
+	deinit_vmsix(vdev);
 }
 
 /**
@@ -994,6 +1117,17 @@ static void vpci_write_pt_dev_cfg(struct pci_vdev *vdev, uint32_t offset, uint32
 		 * - val
 		 */
 		vmsi_write_cfg(vdev, offset, bytes, val);
+	/** If it's true returned by msixcap_access with vdev and offset being the parameters, which means the
+	 *  accessing register is within the MSI-X capability */
+	} else if (msixcap_access(vdev, offset)) {
+		/** Call vmsix_write_cfg with the following parameters, in order to handle MSI-X capability register
+		 *  writing operation, which could enable or disable MSI-X.
+		 * - vdev
+		 * - offset
+		 * - bytes
+		 * - val
+		 */
+		vmsix_write_cfg(vdev, offset, bytes, val);
 	/** If offset is in the range between 04H and 07H, which includes command and status registers. */
 	} else if ((offset >= PCIR_COMMAND) && (offset < PCIR_REVID)) {
 		/** If offset is 05H and bytes is 1, which means the high byte of the command register. */
@@ -1031,6 +1165,15 @@ static void vpci_write_pt_dev_cfg(struct pci_vdev *vdev, uint32_t offset, uint32
 			 */
 			pci_pdev_write_cfg(vdev->pbdf, offset, bytes, val);
 		}
+
+		/** If offset is 04H, which means the memory space enable bit may be written */
+		if (offset == PCIR_COMMAND) {
+			/** Call vdev_pt_sync_vbars with the following parameters, in order to map the BARs moved by the
+			 *  guest while memory space decoding was disabled.
+			 *  - vdev
+			 */
+			vdev_pt_sync_vbars(vdev);
+		}
 	} else {
 		/* ignore other writing */
 		/** Logging the following information with a log level of LOG_DEBUG.
@@ -1136,7 +1279,7 @@ static const struct pci_vdev_ops pci_pt_dev_ops = {
  *
  * @mode HV_OPERATIONAL
  *
- * @remark It is an internal API called by pci_cfgdata_io_read.
+ * @remark It is an internal API called by pci_cfgdata_io_read and vpci_mmio_cfg_access.
  *
  * @reentrancy unspecified
  * @threadsafety Yes
@@ -1157,14 +1300,22 @@ static void read_cfg(struct acrn_vpci *vpci, union pci_bdf bdf, uint32_t offset,
 	vdev = pci_find_vdev(vpci, bdf);
 	/** If 'vdev' is not NULL */
 	if (vdev != NULL) {
-		/** Call vdev->vdev_ops->read_vdev_cfg with the following parameters, in order to call its callback
-		 *  function to read its register.
-		 *  - vdev
-		 *  - offset
-		 *  - bytes
-		 *  - val
-		 */
-		vdev->vdev_ops->read_vdev_cfg(vdev, offset, bytes, val);
+		/** If offset is beyond PCI_REGMAX, which means the register is in the PCI Express extended
+		 *  configuration space */
+		if (offset > PCI_REGMAX) {
+			/** Set '*val' to 0, which terminates the extended capability list, as no vPCI device
+			 *  exposes extended capabilities */
+			*val = 0U;
+		} else {
+			/** Call vdev->vdev_ops->read_vdev_cfg with the following parameters, in order to call its
+			 *  callback function to read its register.
+			 *  - vdev
+			 *  - offset
+			 *  - bytes
+			 *  - val
+			 */
+			vdev->vdev_ops->read_vdev_cfg(vdev, offset, bytes, val);
+		}
 	}
 	/** Call spinlock_release with the following parameters, in order to unlock the access to the vPCI
 	 *  configuration space.
@@ -1194,7 +1345,7 @@ static void read_cfg(struct acrn_vpci *vpci, union pci_bdf bdf, uint32_t offset,
  *
  * @mode HV_OPERATIONAL
  *
- * @remark It is an internal API called by pci_cfgdata_io_write.
+ * @remark It is an internal API called by pci_cfgdata_io_write and vpci_mmio_cfg_access.
  *
  * @reentrancy unspecified
  * @threadsafety Yes
@@ -1215,14 +1366,18 @@ static void write_cfg(struct acrn_vpci *vpci, union pci_bdf bdf, uint32_t offset
 	vdev = pci_find_vdev(vpci, bdf);
 	/** If 'vdev' is not NULL */
 	if (vdev != NULL) {
-		/** Call vdev->vdev_ops->write_vdev_cfg with the following parameters, in order to call its registered
-		 *  function to write its register.
-		 *  - vdev
-		 *  - offset
-		 *  - bytes
-		 *  - val
-		 */
-		vdev->vdev_ops->write_vdev_cfg(vdev, offset, bytes, val);
+		/** If offset is not beyond PCI_REGMAX. Writes to the PCI Express extended configuration space are
+		 *  dropped, as no vPCI device exposes extended capabilities */
+		if (offset <= PCI_REGMAX) {
+			/** Call vdev->vdev_ops->write_vdev_cfg with the following parameters, in order to call its
+			 *  registered function to write its register.
+			 *  - vdev
+			 *  - offset
+			 *  - bytes
+			 *  - val
+			 */
+			vdev->vdev_ops->write_vdev_cfg(vdev, offset, bytes, val);
+		}
 	}
 	/** Call spinlock_release with the following parameters, in order to unlock the access to the vPCI
 	 *  configuration space.
@@ -1235,8 +1390,8 @@ static void write_cfg(struct acrn_vpci *vpci, union pci_bdf bdf, uint32_t offset
  * @brief Allocate a vPCI instance with the info from the given device configuration
  *
  * This function is called to allocate a vPCI instance with the info from the given device configuration.
- * First it allocates an instance from the given vPCI devices list, then fills the info according to the given
- * device configuration.
+ * First it allocates an instance from the given vPCI devices list and records its virtual BDF in the lookup bitmap
+ * and index, then fills the info according to the given device configuration.
  *
  * @param[inout] vpci A pointer to a list of vPCI devices
  * @param[in] dev_config The device configuration info of the VM.
@@ -1251,6 +1406,8 @@ static void write_cfg(struct acrn_vpci *vpci, union pci_bdf bdf, uint32_t offset
  * @mode HV_SUBMODE_INIT_POST_SMP
  *
  * @remark It is an internal API called by vpci_init_vdevs.
+ * @remark A device whose virtual BDF is not less than VPCI_BDF_NUM is rejected with an error log and not created,
+ *	   as its virtual bus is not indexed for lookup.
  *
  * @reentrancy unspecified
  * @threadsafety When \a vpci->vm is different among parallel invocation.
@@ -1262,33 +1419,52 @@ static void vpci_init_vdev(struct acrn_vpci *vpci, struct acrn_vm_pci_dev_config
 	 *  &vpci->pci_vdevs[vpci->pci_vdev_cnt].
 	 */
 	struct pci_vdev *vdev = &vpci->pci_vdevs[vpci->pci_vdev_cnt];
+	/** Declare the following local variables of type uint16_t.
+	 *  - vbdf representing the virtual BDF of the vPCI device, initialized as dev_config->vbdf.value. */
+	uint16_t vbdf = dev_config->vbdf.value;
 
-	/** Increment vpci->pci_vdev_cnt by 1 */
-	vpci->pci_vdev_cnt++;
-	/** Set vdev->vpci to vpci */
-	vdev->vpci = vpci;
-	/** Set vdev->bdf.value to dev_config->vbdf.value */
-	vdev->bdf.value = dev_config->vbdf.value;
-	/** Set vdev->pbdf to dev_config->pbdf */
-	vdev->pbdf = dev_config->pbdf;
-	/** Set vdev->pci_dev_config to dev_config */
-	vdev->pci_dev_config = dev_config;
-
-	/** If dev_config->vdev_ops is not NULL */
-	if (dev_config->vdev_ops != NULL) {
-		/** Set vdev->vdev_ops to dev_config->vdev_ops */
-		vdev->vdev_ops = dev_config->vdev_ops;
+	/** If vbdf is not less than VPCI_BDF_NUM, which means the virtual bus is not indexed for lookup */
+	if (vbdf >= VPCI_BDF_NUM) {
+		/** Logging the following information with a log level of LOG_ERROR.
+		 *  - __func__
+		 *  - vbdf */
+		pr_err("%s: vBDF 0x%x is out of the indexed virtual buses, the device is not created", __func__, vbdf);
 	} else {
-		/** Set vdev->vdev_ops to &pci_pt_dev_ops, which is for physical PCI device */
-		vdev->vdev_ops = &pci_pt_dev_ops;
-		/** Assert that dev_config->emu_type is PCI_DEV_TYPE_PTDEV */
-		ASSERT(dev_config->emu_type == PCI_DEV_TYPE_PTDEV,
-			"Only PCI_DEV_TYPE_PTDEV could not configuration vdev_ops");
-	}
+		/** Set vpci->vbdf_index[vbdf] to vpci->pci_vdev_cnt, the index of vdev in vpci->pci_vdevs */
+		vpci->vbdf_index[vbdf] = (uint8_t)vpci->pci_vdev_cnt;
+		/** Call bitmap_set_nolock with the following parameters, in order to mark vbdf as populated.
+		 *  - vbdf & 3FH
+		 *  - &vpci->vbdf_bitmap[vbdf >> 6]
+		 */
+		bitmap_set_nolock(vbdf & 0x3FU, &vpci->vbdf_bitmap[vbdf >> 6U]);
 
-	/** Call vdev->vdev_ops->init_vdev with the following parameters, in order to initialzie the vPCI device.
-	 *  - vdev */
-	vdev->vdev_ops->init_vdev(vdev);
+		/** Increment vpci->pci_vdev_cnt by 1 */
+		vpci->pci_vdev_cnt++;
+		/** Set vdev->vpci to vpci */
+		vdev->vpci = vpci;
+		/** Set vdev->bdf.value to dev_config->vbdf.value */
+		vdev->bdf.value = dev_config->vbdf.value;
+		/** Set vdev->pbdf to dev_config->pbdf */
+		vdev->pbdf = dev_config->pbdf;
+		/** Set vdev->pci_dev_config to dev_config */
+		vdev->pci_dev_config = dev_config;
+
+		/** If dev_config->vdev_ops is not NULL */
+		if (dev_config->vdev_ops != NULL) {
+			/** Set vdev->vdev_ops to dev_config->vdev_ops */
+			vdev->vdev_ops = dev_config->vdev_ops;
+		} else {
+			/** Set vdev->vdev_ops to &pci_pt_dev_ops, which is for physical PCI device */
+			vdev->vdev_ops = &pci_pt_dev_ops;
+			/** Assert that dev_config->emu_type is PCI_DEV_TYPE_PTDEV */
+			ASSERT(dev_config->emu_type == PCI_DEV_TYPE_PTDEV,
+				"Only PCI_DEV_TYPE_PTDEV could not configuration vdev_ops");
+		}
+
+		/** Call vdev->vdev_ops->init_vdev with the following parameters, in order to initialzie the vPCI device.
+		 *  - vdev */
+		vdev->vdev_ops->init_vdev(vdev);
+	}
 }
 
 /**
@@ -1338,6 +1514,125 @@ static void vpci_init_vdevs(struct acrn_vm *vm)
 	}
 }
 
+/**
+ * @brief Put a vPCI device associated with a physical PCI device back to its configured state
+ *
+ * This function is called to stop the physical PCI device from initiating DMA, to reset the virtual configuration space
+ * of the given vPCI device and its vMSI and vMSI-X, and to put its BARs back to their configured base addresses, while
+ * the device stays assigned to the IOMMU domain of its VM. Bus mastering is cleared first so that no DMA of the
+ * previous guest instance lands in the RAM of the VM while it is scrubbed, loaded again or restored from its snapshot.
+ *
+ * @param[inout] vdev A vPCI device which is associated with a physical PCI device
+ *
+ * @return None.
+ *
+ * @pre vdev != NULL
+ * @pre vdev->vpci != NULL
+ * @pre vdev->vpci->vm != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is an internal API called by vpci_reset.
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety When \a vdev->vpci->vm is different among parallel invocation.
+ */
+static void vpci_reset_pt_dev(struct pci_vdev *vdev)
+{
+	/** Declare the following local variables of type uint32_t.
+	 *  - pci_command representing the value of the physical command register, initialized as the value returned
+	 *  by pci_pdev_read_cfg with vdev->pbdf, PCIR_COMMAND and 2H being the parameters. */
+	uint32_t pci_command = pci_pdev_read_cfg(vdev->pbdf, PCIR_COMMAND, 2U);
+
+	/** Call pci_pdev_write_cfg with the following parameters, in order to stop the physical PCI device from
+	 *  initiating DMA before the RAM of the VM is reused.
+	 *  - vdev->pbdf
+	 *  - PCIR_COMMAND
+	 *  - 2
+	 *  - pci_command & ~PCIM_CMD_BUSMASTEN
+	 */
+	pci_pdev_write_cfg(vdev->pbdf, PCIR_COMMAND, 2U, pci_command & ~PCIM_CMD_BUSMASTEN);
+	/** Call init_default_cfg with the following parameters, in order to reload its virtual configuration space
+	 *  from the physical one.
+	 *  - vdev */
+	init_default_cfg(vdev);
+	/** Call deinit_vmsi with the following parameters, in order to drop the MSI remapping set up by the guest.
+	 *  - vdev */
+	deinit_vmsi(vdev);
+	/** Call deinit_vmsix with the following parameters, in order to drop the MSI-X remapping set up by the guest.
+	 *  - vdev */
+	deinit_vmsix(vdev);
+	/** Call init_vmsi with the following parameters, in order to reset its vMSI capability.
+	 *  - vdev */
+	init_vmsi(vdev);
+	/** Call init_vmsix with the following parameters, in order to reset its vMSI-X capability and table.
+	 *  - vdev */
+	init_vmsix(vdev);
+	/** Call vdev_pt_reset_vbars with the following parameters, in order to put its BARs back to their configured
+	 *  base addresses.
+	 *  - vdev */
+	vdev_pt_reset_vbars(vdev);
+}
+
+/**
+ * @brief Put the vPCI devices of the given VM back to their configured state
+ *
+ * This function is called when the given VM is restarted, while all its vCPUs are paused, and before its RAM is
+ * scrubbed or restored. The vPCI devices keep their IOMMU domain and the EPT mappings of the BARs the guest has not
+ * moved, and the physical PCI devices have bus mastering cleared. The emulated vPCI devices are initialized again.
+ *
+ * @param[inout] vm A pointer to a VM whose vPCI devices are to reset.
+ *
+ * @return None.
+ *
+ * @pre vm != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @remark It is a public API called by vp-base.vm module.
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety When \a vm is different among parallel invocation.
+ */
+void vpci_reset(struct acrn_vm *vm)
+{
+	/** Declare the following local variables of type 'struct pci_vdev *'.
+	 *  - vdev representing a pointer to a vPCI device in the given VM, not initialized. */
+	struct pci_vdev *vdev;
+	/** Declare the following local variables of type uint32_t.
+	 *  - i representing an index used in the loop to probe the vPCI device in the given VM, not initialized. */
+	uint32_t i;
+
+	/** For each i ranging from 0 to vm->vpci.pci_vdev_cnt -1 [with a step of 1] */
+	for (i = 0U; i < vm->vpci.pci_vdev_cnt; i++) {
+		/** Set vdev to &(vm->vpci.pci_vdevs[i]) */
+		vdev = &(vm->vpci.pci_vdevs[i]);
+
+		/** If vdev->vdev_ops is &pci_pt_dev_ops, which means the vPCI device is associated with a physical
+		 *  PCI device. */
+		if (vdev->vdev_ops == &pci_pt_dev_ops) {
+			/** Call vpci_reset_pt_dev with the following parameters, in order to reset the vPCI device.
+			 *  - vdev */
+			vpci_reset_pt_dev(vdev);
+		} else {
+			/** Call vdev->vdev_ops->deinit_vdev with the following parameters, in order to drop the state of
+			 *  the emulated device, e.g. the BAR mappings of an ivshmem device.
+			 *  - vdev */
+			vdev->vdev_ops->deinit_vdev(vdev);
+			/** Call vdev->vdev_ops->init_vdev with the following parameters, in order to initialize the
+			 *  emulated device again.
+			 *  - vdev */
+			vdev->vdev_ops->init_vdev(vdev);
+		}
+	}
+}
+
 /**
  * @}
  */
@@ -382,13 +382,79 @@ static inline bool msicap_access(const struct pci_vdev *vdev, uint32_t offset)
 	return (has_msi_cap(vdev) && in_range(offset, vdev->msi.capoff, vdev->msi.caplen));
 }
 
+/**
+ * @brief Check whether the given vPCI device has a MSI-X capability
+ *
+ * This function is called to check whether the given vPCI device has a MSI-X capability. If it has a MSI-X capability,
+ * the offset of the MSI-X capability structure should not be 0.
+ *
+ * @param[in] vdev A vPCI device whose MSI-X info is to check
+ *
+ * @return True if the given vPCI device has a MSI-X capability, or return false.
+ *
+ * @pre vdev != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_POST_SMP, HV_OPERATIONAL
+ *
+ * @remark It is an internal helper function and shall be called after the vPCI device initialized.
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety Yes
+ */
+static inline bool has_msix_cap(const struct pci_vdev *vdev)
+{
+	/** Return true if vdev->msix.capoff is not 0, or return false. */
+	return (vdev->msix.capoff != 0U);
+}
+
+/**
+ * @brief Check whether a register is within the range of the given vPCI device's MSI-X capability structure.
+ *
+ * @param[in] vdev A vPCI device whose MSI-X capability structure is to check
+ * @param[in] offset The register offset in the configuration space.
+ *
+ * @return True if the register is in the range of the given vPCI device's MSI-X capability structure, or return
+ *         false.
+ *
+ * @pre vdev != NULL
+ *
+ * @post N/A
+ *
+ * @mode HV_SUBMODE_INIT_POST_SMP, HV_OPERATIONAL
+ *
+ * @remark It is an internal helper function and shall be called after the vPCI device initialized.
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety Yes
+ */
+static inline bool msixcap_access(const struct pci_vdev *vdev, uint32_t offset)
+{
+	/** Return true if the given vPCI device has a MSI-X capability (determined by calling has_msix_cap with vdev)
+	 *  and the given register's offset in the range of its MSI-X capability structure (determined by calling
+	 *  in_range with offset, vdev->msix.capoff and vdev->msix.caplen).
+	 */
+	return (has_msix_cap(vdev) && in_range(offset, vdev->msix.capoff, vdev->msix.caplen));
+}
+
 void init_vdev_pt(struct pci_vdev *vdev);
 void vdev_pt_write_vbar(struct pci_vdev *vdev, uint32_t idx, uint32_t val);
+void vdev_pt_reset_vbars(struct pci_vdev *vdev);
+void vdev_pt_sync_vbars(struct pci_vdev *vdev);
 
 void init_vmsi(struct pci_vdev *vdev);
 void vmsi_write_cfg(struct pci_vdev *vdev, uint32_t offset, uint32_t bytes, uint32_t val);
 void deinit_vmsi(const struct pci_vdev *vdev);
 
+void init_vmsix(struct pci_vdev *vdev);
+void vmsix_write_cfg(struct pci_vdev *vdev, uint32_t offset, uint32_t bytes, uint32_t val);
+void deinit_vmsix(const struct pci_vdev *vdev);
+void vmsix_trap_table(struct pci_vdev *vdev);
+void vmsix_untrap_table(struct pci_vdev *vdev);
+
 uint32_t pci_vdev_read_cfg(const struct pci_vdev *vdev, uint32_t offset, uint32_t bytes);
 void pci_vdev_write_cfg(struct pci_vdev *vdev, uint32_t offset, uint32_t bytes, uint32_t val);
 
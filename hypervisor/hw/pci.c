@@ -34,6 +34,7 @@
 #include <types.h>
 #include <spinlock.h>
 #include <io.h>
+#include <pgtable.h>
 #include <pci.h>
 #include <uart16550.h>
 #include <logmsg.h>
@@ -50,13 +51,17 @@
  * This module implements the APIs to operate PCI configuration registers of a physical PCI device. The main functions
  * include: read a register from PCI configuration space and write a register to PCI configuration space.
  *
+ * When the platform reports an ECAM region in its MCFG (MCFG_BASE in the board ACPI info), a register of a bus
+ * decoded by that region is accessed with a single MMIO load or store, without any lock. Otherwise the access falls
+ * back to the port 0CF8H/0CFCH pair, serialized by a global lock.
+ *
  * Usage:
  * - 'vp-dm.vperipheral' module depends on this module to operate the physical PCI device associated with the
  * virtual PCI device.
  *
  * Dependency:
  * - This module depends on 'lib.lock' module to do spin lock and unlock for PCI devices operation.
- * - This module depends on 'hwmgmt.io' module to do port IO read/write operations.
+ * - This module depends on 'hwmgmt.io' module to do port IO and MMIO read/write operations.
  *
  * @{
  */
@@ -68,14 +73,16 @@
  * This file implements all external functions, data structures, and macros that shall be provided by the
  * hwmgmt.pci module.
  *
- * It also defines a helper functions:
+ * It also defines some helper functions:
  * - pci_pdev_calc_address: calculate the address used to do port I/O operation for PCI configuration registers.
+ * - pci_pdev_ecam_address: calculate the host virtual address of a PCI configuration register in the ECAM region.
+ * - pci_pdev_read_cfg_pio / pci_pdev_write_cfg_pio: access a PCI configuration register through port I/O.
  *
  */
 
 /**
- * @brief A spin lock variable used in PCI read/write operation, to avoid different guest VMs to operate the PCI
- * configuration space in parallel.
+ * @brief A spin lock variable used in PCI read/write operation through port I/O, to avoid different guest VMs to
+ * operate the PCI configuration address and data ports in parallel.
  */
 static spinlock_t pci_device_lock = {
 	.head = 0U,
@@ -123,7 +130,51 @@ static uint32_t pci_pdev_calc_address(union pci_bdf bdf, uint32_t offset)
 }
 
 /**
- * @brief Read a register from the physical PCI device configuration space
+ * @brief Calculate the host virtual address of a PCI configuration register in the platform ECAM region
+ *
+ * This function is called to calculate the host virtual address of a PCI configuration register in the ECAM region
+ * reported by the platform MCFG. The ECAM region is in the low MMIO hole, which the hypervisor page tables map
+ * as uncached with a one-to-one mapping, so the address can be accessed directly.
+ *
+ * @param[in] bdf The BDF number of the PCI device.
+ * @param[in] offset The register offset in the PCI configuration space.
+ *
+ * @return The host virtual address of the register, or NULL if the platform reports no ECAM region or the bus of
+ * the given BDF is not decoded by it.
+ *
+ * @pre offset <= PCIE_REGMAX
+ *
+ * @post N/A
+ *
+ * @mode HV_INIT, HV_OPERATIONAL
+ *
+ * @remark It is an internal function called by pci_pdev_read_cfg and pci_pdev_write_cfg
+ *
+ * @reentrancy unspecified
+ * @threadsafety Yes
+ */
+static void *pci_pdev_ecam_address(union pci_bdf bdf, uint32_t offset)
+{
+	/** Declare the following local variables of type 'void *'.
+	 *  - hva representing the address to be returned, initialized as NULL. */
+	void *hva = NULL;
+
+	/** If the platform reports an ECAM region and the bus of \a bdf is in [MCFG_START_BUS, MCFG_END_BUS] */
+	if ((MCFG_BASE != 0UL) && (((uint32_t)bdf.bits.b - MCFG_START_BUS) <= (MCFG_END_BUS - MCFG_START_BUS))) {
+		/** Set hva to the value returned by hpa2hva with the following parameter, where every function of
+		 *  the decoded buses owns 4KB of the region, indexed by its BDF relative to the start bus.
+		 *  - MCFG_BASE + (((bdf.value - (MCFG_START_BUS << 8)) << 12) | offset)
+		 */
+		hva = hpa2hva(MCFG_BASE + ((((uint64_t)bdf.value - ((uint64_t)MCFG_START_BUS << 8U)) << 12U) |
+			(uint64_t)offset));
+	}
+
+	/** Return hva */
+	return hva;
+}
+
+/**
+ * @brief Read a register from the physical PCI device configuration space through port I/O
  *
  * This function is called to read a register from the physical PCI device configuration space. It calculates an
  * addressable value according to the input parameters of the PCI device: BDF, offset and bytes. And write the
@@ -143,12 +194,12 @@ static uint32_t pci_pdev_calc_address(union pci_bdf bdf, uint32_t offset)
  *
  * @mode HV_INIT, HV_OPERATIONAL
  *
- * @remark It is a public API called by other modules.
+ * @remark It is an internal function called by pci_pdev_read_cfg.
  *
  * @reentrancy unspecified
  * @threadsafety Yes
  */
-uint32_t pci_pdev_read_cfg(union pci_bdf bdf, uint32_t offset, uint32_t bytes)
+static uint32_t pci_pdev_read_cfg_pio(union pci_bdf bdf, uint32_t offset, uint32_t bytes)
 {
 	/** Declare the following local variables of type uint32_t.
 	 *  - addr representing the value to address the register of the physical PCI device, not initialized. */
@@ -226,7 +277,7 @@ uint32_t pci_pdev_read_cfg(union pci_bdf bdf, uint32_t offset, uint32_t bytes)
 }
 
 /**
- * @brief Write a value to a configuration register of the physical PCI device
+ * @brief Write a value to a configuration register of the physical PCI device through port I/O
  *
  * This function is called to write a value to a configuration register of the physical PCI device. It calculates an
  * addressable value according to the input parameters of the PCI device: BDF, offset and bytes. And write the
@@ -247,12 +298,12 @@ uint32_t pci_pdev_read_cfg(union pci_bdf bdf, uint32_t offset, uint32_t bytes)
  *
  * @mode HV_INIT, HV_OPERATIONAL
  *
- * @remark It is a public API called by other modules.
+ * @remark It is an internal function called by pci_pdev_write_cfg.
  *
  * @reentrancy unspecified
  * @threadsafety Yes
  */
-void pci_pdev_write_cfg(union pci_bdf bdf, uint32_t offset, uint32_t bytes, uint32_t val)
+static void pci_pdev_write_cfg_pio(union pci_bdf bdf, uint32_t offset, uint32_t bytes, uint32_t val)
 {
 	/** Declare the following local variables of type uint32_t.
 	 *  - addr representing the value to address the register of the physical PCI device, not initialized. */
@@ -327,6 +378,113 @@ void pci_pdev_write_cfg(union pci_bdf bdf, uint32_t offset, uint32_t bytes, uint
 	spinlock_release(&pci_device_lock);
 }
 
+/**
+ * @brief Read a register from the physical PCI device configuration space
+ *
+ * This function is called to read a register from the physical PCI device configuration space. If the bus of the
+ * PCI device is decoded by the platform ECAM region, the register is read with a single MMIO load, which needs no
+ * lock; otherwise it is read through the PCI configuration-address and data ports.
+ *
+ * @param[in] bdf The BDF number of the PCI device.
+ * @param[in] offset The register offset in the PCI configuration space.
+ * @param[in] bytes The length to read.
+ *
+ * @return The register value of the phyiscal PCI device in its configuration space.
+ *
+ * @pre offset < PCI_REGMAX
+ * @pre (offset & (bytes - 1)) == 0
+ * @pre bytes == 1 || bytes == 2 || bytes == 4
+ *
+ * @post N/A
+ *
+ * @mode HV_INIT, HV_OPERATIONAL
+ *
+ * @remark It is a public API called by other modules.
+ *
+ * @reentrancy unspecified
+ * @threadsafety Yes
+ */
+uint32_t pci_pdev_read_cfg(union pci_bdf bdf, uint32_t offset, uint32_t bytes)
+{
+	/** Declare the following local variables of type 'const void *'.
+	 *  - hva representing the address of the register in the ECAM region, initialized as the value returned by
+	 *  pci_pdev_ecam_address with bdf and offset being the parameters. */
+	const void *hva = pci_pdev_ecam_address(bdf, offset);
+	/** Declare the following local variables of type uint32_t.
+	 *  - val representing the value of the register to read, not initialized. */
+	uint32_t val;
+
+	/** If hva is NULL, which means the register is not reachable through an ECAM region */
+	if (hva == NULL) {
+		/** Set val to the value returned by pci_pdev_read_cfg_pio with bdf, offset and bytes being the
+		 *  parameters, which reads the register through port I/O */
+		val = pci_pdev_read_cfg_pio(bdf, offset, bytes);
+	} else if (bytes == 1U) {
+		/** Set val to the value returned by mmio_read8 with hva being the parameter */
+		val = (uint32_t)mmio_read8(hva);
+	} else if (bytes == 2U) {
+		/** Set val to the value returned by mmio_read16 with hva being the parameter */
+		val = (uint32_t)mmio_read16(hva);
+	} else {
+		/** Set val to the value returned by mmio_read32 with hva being the parameter */
+		val = mmio_read32(hva);
+	}
+
+	/** Return 'val' which is the register value. */
+	return val;
+}
+
+/**
+ * @brief Write a value to a configuration register of the physical PCI device
+ *
+ * This function is called to write a value to a configuration register of the physical PCI device. If the bus of
+ * the PCI device is decoded by the platform ECAM region, the register is written with a single MMIO store, which
+ * needs no lock; otherwise it is written through the PCI configuration-address and data ports.
+ *
+ * @param[in] bdf The BDF number of the PCI device.
+ * @param[in] offset The register offset in the PCI configuration space.
+ * @param[in] bytes The length to write.
+ * @param[in] val The value to write.
+ *
+ * @return None
+ *
+ * @pre offset < PCI_REGMAX
+ * @pre (offset & (bytes - 1)) == 0
+ * @pre bytes == 1 || bytes == 2 || bytes == 4
+ *
+ * @post N/A
+ *
+ * @mode HV_INIT, HV_OPERATIONAL
+ *
+ * @remark It is a public API called by other modules.
+ *
+ * @reentrancy unspecified
+ * @threadsafety Yes
+ */
+void pci_pdev_write_cfg(union pci_bdf bdf, uint32_t offset, uint32_t bytes, uint32_t val)
+{
+	/** Declare the following local variables of type 'void *'.
+	 *  - hva representing the address of the register in the ECAM region, initialized as the value returned by
+	 *  pci_pdev_ecam_address with bdf and offset being the parameters. */
+	void *hva = pci_pdev_ecam_address(bdf, offset);
+
+	/** If hva is NULL, which means the register is not reachable through an ECAM region */
+	if (hva == NULL) {
+		/** Call pci_pdev_write_cfg_pio with bdf, offset, bytes and val being the parameters, in order to
+		 *  write the register through port I/O */
+		pci_pdev_write_cfg_pio(bdf, offset, bytes, val);
+	} else if (bytes == 1U) {
+		/** Call mmio_write8 with (uint8_t)val and hva being the parameters */
+		mmio_write8((uint8_t)val, hva);
+	} else if (bytes == 2U) {
+		/** Call mmio_write16 with (uint16_t)val and hva being the parameters */
+		mmio_write16((uint16_t)val, hva);
+	} else {
+		/** Call mmio_write32 with val and hva being the parameters */
+		mmio_write32(val, hva);
+	}
+}
+
 /**
  * @}
  */
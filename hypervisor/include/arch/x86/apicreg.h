@@ -164,6 +164,7 @@ union ioapic_rte {
 #define APIC_VECTOR_MASK 0x000000ffU /**< Mask of vector in local APIC ICR register */
 
 #define APIC_DELMODE_MASK    0x00000700U /**< Mask of delivery mode in local APIC ICR register */
+#define APIC_DELMODE_FIXED   0x00000000U /**< Delivery mode of Fixed in local APIC ICR register */
 #define APIC_DELMODE_INIT    0x00000500U /**< Delivery mode of INIT in local APIC ICR register */
 #define APIC_DELMODE_STARTUP 0x00000600U /**< Delivery mode of STARTUP in local APIC ICR register */
 
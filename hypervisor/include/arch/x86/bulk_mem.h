@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2019 Intel Corporation. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef BULK_MEM_H
+#define BULK_MEM_H
+
+/**
+ * @addtogroup hwmgmt_bulk_mem
+ *
+ * @{
+ */
+
+/**
+ * @file
+ * @brief This file declares the external APIs of the hwmgmt.bulk-mem module.
+ */
+
+#include <types.h>
+
+void init_bulk_mem(void);
+const char *get_bulk_kernel(void);
+void bulk_copy(void *d, const void *s, size_t n);
+void bulk_clear(void *d, size_t n);
+
+/**
+ * @}
+ */
+
+#endif /* BULK_MEM_H */
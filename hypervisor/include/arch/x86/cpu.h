@@ -68,6 +68,8 @@
  * - sidt: Get the base address of the IDT.
  * - asm_pause: Pause the current CPU.
  * - asm_hlt: Stop instruction execution and place the processor in a HALT state.
+ * - asm_monitor: Set up a linear address range to be monitored by hardware and activate the monitor.
+ * - asm_mwait: Enter an implementation-dependent optimized state.
  * - CPU_IRQ_DISABLE: Disable interrupts on the current CPU.
  * - CPU_IRQ_ENABLE: Enable interrupts on the current CPU.
  * - cpu_write_memory_barrier: Synchronize all write and read accesses to memory.
@@ -245,6 +247,26 @@
  * manage the BNDCFGU and BNDSTATUS registers
  */
 #define XCR0_BNDCSR (1UL << 4U)
+/**
+ * @brief XCR0 opmask state.
+ *
+ * If the opmask state is enabled along with the ZMM_Hi256 and Hi16_ZMM states, AVX-512 instructions can be executed
+ * and the XSAVE feature set can be used to manage the opmask registers k0–k7.
+ */
+#define XCR0_OPMASK (1UL << 5U)
+/**
+ * @brief XCR0 ZMM_Hi256 state.
+ *
+ * If the ZMM_Hi256 state is enabled, the XSAVE feature set can be used to manage the upper halves of the ZMM0–ZMM15
+ * registers.
+ */
+#define XCR0_ZMM_HI256 (1UL << 6U)
+/**
+ * @brief XCR0 Hi16_ZMM state.
+ *
+ * If the Hi16_ZMM state is enabled, the XSAVE feature set can be used to manage the ZMM16–ZMM31 registers.
+ */
+#define XCR0_HI16_ZMM (1UL << 7U)
 /*
  * Entries in the Interrupt Descriptor Table (IDT)
  */
@@ -485,6 +507,14 @@ enum pcpu_boot_state {
  * @brief The message flag of CPU representing the vm will shutdown, where the vm holds the CPU.
  */
 #define NEED_SHUTDOWN_VM (2U)
+/**
+ * @brief The message flag of CPU representing the vm will restart, where the vm holds the CPU.
+ */
+#define NEED_RESTART_VM  (3U)
+/**
+ * @brief The message flag of CPU representing the memory of the vm will be scrubbed, where the vm holds the CPU.
+ */
+#define NEED_SCRUB_VM    (4U)
 void make_pcpu_offline(uint16_t pcpu_id);
 bool need_offline(uint16_t pcpu_id);
 
@@ -664,6 +694,55 @@ static inline void asm_hlt(void)
 	asm volatile("hlt");
 }
 
+/**
+ * @brief Set up a linear address range to be monitored by hardware and activate the monitor.
+ *
+ * @param[in]    addr The start address to be monitored.
+ * @param[in]    ecx Optional extensions of MONITOR instruction.
+ * @param[in]    edx Optional hints of MONITOR instruction.
+ *
+ * @return None
+ *
+ * @mode HV_SUBMODE_INIT_PRE_SMP, HV_SUBMODE_INIT_POST_SMP, HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+static inline void asm_monitor(volatile const void *addr, uint64_t ecx, uint64_t edx)
+{
+	/** Execute monitor in order to set up a linear address range to be monitored by hardware and activate the
+	 *  monitor.
+	 *  - Input operands: RAX holds addr, RCX holds ecx, RDX holds edx
+	 *  - Output operands: None
+	 *  - Clobbers: None */
+	asm volatile("monitor\n" : : "a"(addr), "c"(ecx), "d"(edx));
+}
+
+/**
+ * @brief Enter an implementation-dependent optimized state.
+ *
+ * Make processor to stop instruction execution and enter an implementation-dependent optimized state until occurrence
+ * of a class of events.
+ *
+ * @param[in]    eax A value contain hints such as the preferred optimized state the processor should enter.
+ * @param[in]    ecx Optional extensions for the MWAIT instruction.
+ *
+ * @return None
+ *
+ * @mode HV_SUBMODE_INIT_PRE_SMP, HV_SUBMODE_INIT_POST_SMP, HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+static inline void asm_mwait(uint64_t eax, uint64_t ecx)
+{
+	/** Execute mwait in order to enter an implementation-dependent optimized state.
+	 *  - Input operands: RAX holds eax, RCX holds ecx.
+	 *  - Output operands: None
+	 *  - Clobbers:None */
+	asm volatile("mwait\n" : : "a"(eax), "c"(ecx));
+}
+
 /**
  * @brief Disable interrupts on the current CPU.
  *
@@ -1102,7 +1181,7 @@ static inline void clac(void)
 }
 
 uint16_t get_pcpu_nums(void);
-extern void write_trampoline_stack_sym(uint16_t pcpu_id);
+extern void write_trampoline_stack_sym(uint16_t slot_idx, uint16_t pcpu_id);
 extern uint64_t prepare_trampoline(void);
 #else /* ASSEMBLER defined */
 
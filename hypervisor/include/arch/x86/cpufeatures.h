@@ -34,6 +34,40 @@
  * The lower 5 bits represent the bit position (associated with the specified feature) to be checked.
  */
 #define X86_FEATURE_OSXSAVE ((FEAT_1_ECX << 5U) + 27U)
+/**
+ * @brief A flag used to check whether the processor supports AVX instructions.
+ *
+ * This flag is associated with the array "cpuid_leaves" defined in the data structure "struct cpuinfo_x86".
+ * The higher 27 bits represent the index of the element (associated the specified feature) in the array.
+ * The lower 5 bits represent the bit position (associated with the specified feature) to be checked.
+ */
+#define X86_FEATURE_AVX ((FEAT_1_ECX << 5U) + 28U)
+
+/* Intel-defined CPU features, CPUID level 0x00000007 (EBX) */
+/**
+ * @brief A flag used to check whether the processor supports AVX2 instructions.
+ *
+ * This flag is associated with the array "cpuid_leaves" defined in the data structure "struct cpuinfo_x86".
+ * The higher 27 bits represent the index of the element (associated the specified feature) in the array.
+ * The lower 5 bits represent the bit position (associated with the specified feature) to be checked.
+ */
+#define X86_FEATURE_AVX2 ((FEAT_7_0_EBX << 5U) + 5U)
+/**
+ * @brief A flag used to check whether the processor supports AVX-512 Foundation instructions.
+ *
+ * This flag is associated with the array "cpuid_leaves" defined in the data structure "struct cpuinfo_x86".
+ * The higher 27 bits represent the index of the element (associated the specified feature) in the array.
+ * The lower 5 bits represent the bit position (associated with the specified feature) to be checked.
+ */
+#define X86_FEATURE_AVX512F ((FEAT_7_0_EBX << 5U) + 16U)
+/**
+ * @brief A flag used to check whether the processor supports the CLFLUSHOPT instruction.
+ *
+ * This flag is associated with the array "cpuid_leaves" defined in the data structure "struct cpuinfo_x86".
+ * The higher 27 bits represent the index of the element (associated the specified feature) in the array.
+ * The lower 5 bits represent the bit position (associated with the specified feature) to be checked.
+ */
+#define X86_FEATURE_CLFLUSHOPT ((FEAT_7_0_EBX << 5U) + 23U)
 
 /* Intel-defined CPU features, CPUID level 0x00000007 (EDX) */
 /**
@@ -37,7 +37,7 @@
  * @return None
  *
  * @pre vm != NULL
- * @pre entry_nr == 0
+ * @pre entry_nr < CONFIG_MAX_MSIX_TABLE_NUM
  * @pre info != NULL
  * @pre (virt_bdf & FFH) < 3FH
  *
@@ -65,7 +65,7 @@ void ptirq_msix_remap(
  * @return None
  *
  * @pre vm != NULL
- * @pre vector_count == 1
+ * @pre vector_count <= CONFIG_MAX_MSIX_TABLE_NUM
  *
  * @post N/A
  *
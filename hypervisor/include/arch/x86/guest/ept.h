@@ -38,9 +38,19 @@ void ept_modify_mr(struct acrn_vm *vm, uint64_t *pml4_page, uint64_t gpa,
 
 void ept_del_mr(struct acrn_vm *vm, uint64_t *pml4_page, uint64_t gpa, uint64_t size);
 
-void ept_flush_leaf_page(uint64_t *pge, uint64_t size);
+void ept_flush_sync(struct acrn_vm *vm, uint64_t gpa, uint64_t size);
 
-void walk_ept_table(struct acrn_vm *vm, pge_handler cb);
+void ept_grant_exe_right(struct acrn_vm *vm, uint64_t gpa, uint64_t size);
+
+void ept_flush_leaf_page(uint64_t *pge, uint64_t size, void *data);
+
+void walk_ept_table(struct acrn_vm *vm, pge_handler cb, void *data);
+
+void ept_harvest_ad(struct acrn_vm *vm, uint64_t *accessed, uint64_t *dirty);
+
+void ept_clear_dirty(struct acrn_vm *vm);
+
+void ept_set_soft_dirty(struct acrn_vm *vm, uint64_t gpa, uint64_t size);
 
 void *get_ept_entry(struct acrn_vm *vm);
 
@@ -23,6 +23,19 @@
 
 #include <types.h>
 
+/**
+ * @brief Bit indicator in a page fault error code that the fault was caused by a page-level protection violation.
+ */
+#define PAGE_FAULT_P_FLAG	0x00000001U
+/**
+ * @brief Bit indicator in a page fault error code that the access causing the fault was a write.
+ */
+#define PAGE_FAULT_WR_FLAG	0x00000002U
+/**
+ * @brief Bit indicator in a page fault error code that the access causing the fault was a user-mode access.
+ */
+#define PAGE_FAULT_US_FLAG	0x00000004U
+
 struct acrn_vcpu;
 struct acrn_vm;
 
@@ -34,6 +47,8 @@ void *gpa2hva(struct acrn_vm *vm, uint64_t x);
 
 uint64_t gpa2hpa(struct acrn_vm *vm, uint64_t gpa);
 
+int32_t gva2gpa(struct acrn_vcpu *vcpu, uint64_t gva, bool is_write, uint64_t *gpa, uint32_t *err_code);
+
 #endif /* !ASSEMBLER */
 
 /**
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2019 Intel Corporation. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef INSTR_EMUL_H
+#define INSTR_EMUL_H
+
+/**
+ * @addtogroup vp-dm_io-req
+ *
+ * @{
+ */
+
+/**
+ * @file
+ * @brief this file declares the data structures and APIs to decode and emulate the guest
+ *	  instructions accessing emulated MMIO ranges.
+ */
+
+#include <types.h>
+
+/**
+ * @brief Maximum length in bytes of an x86 instruction.
+ */
+#define VIE_INST_SIZE		15U
+
+/**
+ * @brief Number of decoded instructions cached per vCPU, which shall be a power of 2.
+ */
+#define VIE_CACHE_ENTRIES	8U
+
+/**
+ * @brief The emulated operation of a decoded instruction.
+ *
+ * @remark N/A
+ */
+enum vie_op_type {
+	VIE_OP_TYPE_NONE = 0,	/**< Not decoded */
+	VIE_OP_TYPE_MOV_TO_MEM,	/**< MOV r/m, reg (88H, 89H) */
+	VIE_OP_TYPE_MOV_FROM_MEM,	/**< MOV reg, r/m (8AH, 8BH) */
+	VIE_OP_TYPE_MOV_IMM_TO_MEM,	/**< MOV r/m, imm (C6H /0, C7H /0) */
+	VIE_OP_TYPE_MOVZX,	/**< MOVZX reg, r/m8 or r/m16 (0FH B6H, 0FH B7H) */
+	VIE_OP_TYPE_MOVSX,	/**< MOVSX reg, r/m8 or r/m16 (0FH BEH, 0FH BFH) */
+	VIE_OP_TYPE_STOS,	/**< STOS with an optional REP prefix (AAH, ABH) */
+	VIE_OP_TYPE_AND_TO_MEM,	/**< AND r/m, reg or imm (20H, 21H, 80H /4, 81H /4, 83H /4) */
+	VIE_OP_TYPE_AND_FROM_MEM,	/**< AND reg, r/m (22H, 23H) */
+	VIE_OP_TYPE_OR_TO_MEM,	/**< OR r/m, reg or imm (08H, 09H, 80H /1, 81H /1, 83H /1) */
+	VIE_OP_TYPE_OR_FROM_MEM,	/**< OR reg, r/m (0AH, 0BH) */
+	VIE_OP_TYPE_TEST,	/**< TEST r/m, reg or imm (84H, 85H, F6H /0, F7H /0) */
+};
+
+/**
+ * @brief A decoded instruction accessing an emulated MMIO range.
+ *
+ * @consistency inst_len <= VIE_INST_SIZE
+ *
+ * @alignment 8
+ *
+ * @remark The instruction is identified by the guest RIP and CR3 it was decoded at, and by its bytes.
+ */
+struct instr_emul_vie {
+	uint64_t rip;		/**< Guest RIP of the instruction */
+	uint64_t cr3;		/**< Guest CR3 when the instruction was decoded */
+	uint64_t inst_gpa;	/**< Guest physical address of the instruction bytes */
+	uint64_t immediate;	/**< Immediate operand, sign-extended to 64 bits */
+	enum vie_op_type op_type;	/**< The emulated operation */
+	uint8_t inst[VIE_INST_SIZE];	/**< Bytes of the instruction */
+	uint8_t inst_len;	/**< Length of the instruction in bytes */
+	uint8_t opsize;		/**< Operand size in bytes (1, 2, 4 or 8) */
+	uint8_t mem_size;	/**< Size of the memory access in bytes (1, 2, 4 or 8) */
+	uint8_t addrsize;	/**< Address size in bytes (2, 4 or 8) */
+	uint8_t reg;		/**< Register operand, CPU_REG_RAX to CPU_REG_R15 */
+	bool has_imm;		/**< Whether the source operand is the immediate */
+	bool rex_present;	/**< Whether a REX prefix is present, which selects SPL-DIL for byte registers 4-7 */
+	bool rep;		/**< Whether a REP prefix is present */
+};
+
+/**
+ * @brief Per-vCPU cache of decoded instructions, indexed by guest RIP and CR3.
+ *
+ * @consistency N/A
+ *
+ * @alignment 8
+ *
+ * @remark N/A
+ */
+struct instr_emul_ctxt {
+	struct instr_emul_vie cache[VIE_CACHE_ENTRIES];	/**< Direct-mapped cache entries */
+};
+
+struct acrn_vcpu;
+
+int32_t emulate_mmio_instruction(struct acrn_vcpu *vcpu, uint64_t gpa);
+
+/**
+ * @}
+ */
+
+#endif /* INSTR_EMUL_H */
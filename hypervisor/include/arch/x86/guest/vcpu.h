@@ -33,6 +33,7 @@
 #include <vlapic.h>
 #include <schedule.h>
 #include <io_req.h>
+#include <instr_emul.h>
 #include <msr.h>
 #include <cpu.h>
 
@@ -76,6 +77,16 @@
  */
 #define ACRN_REQUEST_LAPIC_RESET 9U
 
+/**
+ * @brief Request for saving the vCPU state into the golden snapshot of the VM
+ */
+#define ACRN_REQUEST_SNAPSHOT_SAVE 10U
+
+/**
+ * @brief Request for loading the vCPU state from the golden snapshot of the VM
+ */
+#define ACRN_REQUEST_SNAPSHOT_LOAD 11U
+
 /**
  * @brief Virtual XCR0 reserved bits
  *
@@ -112,6 +123,37 @@
 		exec_vmwrite32(SEG_NAME##_ATTR, (seg).attr);    \
 	}
 
+/**
+ * @brief This macro is used to pre-define save segment function which get selector, base, limit and
+ *  attribute of specified selector.
+ *
+ * The macro is the reverse of load_segment. It reads the VMCS fields encoded by SEG_NAME\#\# _SEL,
+ * SEG_NAME\#\# _BASE, SEG_NAME\#\# _LIMIT and SEG_NAME\#\# _ATTR into seg.selector, seg.base, seg.limit and
+ * seg.attr respectively.
+ *
+ * @param[out] seg The segment_sel structure that receives the details of the segment
+ * @param[in] SEG_NAME The name of the segment (e.g. CS) to be saved
+ *
+ * @return None
+ *
+ * @pre  None
+ *
+ * @post None
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+#define save_segment(seg, SEG_NAME)                                  \
+	{                                                            \
+		(seg).selector = (uint16_t)exec_vmread32(SEG_NAME##_SEL); \
+		(seg).base = exec_vmread(SEG_NAME##_BASE);            \
+		(seg).limit = exec_vmread32(SEG_NAME##_LIMIT);        \
+		(seg).attr = exec_vmread32(SEG_NAME##_ATTR);          \
+	}
+
 #define REAL_MODE_BSP_INIT_CODE_SEL (0xf000U)    /**< code segment selector of real mode operation */
 #define REAL_MODE_DATA_SEG_AR       (0x0093U)    /**< data segment attributes of real mode operation */
 #define REAL_MODE_CODE_SEG_AR       (0x009bU)    /**< code segment attributes of real mode operation */
@@ -553,8 +595,10 @@ struct acrn_vcpu {
 	struct thread_object thread_obj;
 	bool launched; /**< Whether the vcpu is launched on target pcpu */
 	bool running; /**< vcpu is picked up and run? */
+	volatile bool in_non_root; /**< Whether the vcpu may be in VMX non-root operation and use its EPT caches */
 
 	struct io_request req; /**< io request structure */
+	struct instr_emul_ctxt inst_ctxt; /**< cache of the decoded instructions accessing emulated MMIO */
 
 	/**
 	 * @brief bitmap indicating the registers whose values have been cached in the
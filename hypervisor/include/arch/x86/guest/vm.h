@@ -87,6 +87,7 @@ struct sw_kernel_info {
 	uint64_t kernel_load_addr; /**< the GPA where the kernel shall be loaded at */
 	uint64_t kernel_entry_addr; /**< the GPA where the entry point starts to run */
 	uint32_t kernel_size; /**< the kernel size */
+	bool kernel_in_place; /**< whether the guest runs the kernel in the memory it was originally saved in */
 };
 
 /**
@@ -136,6 +137,7 @@ struct vm_arch {
 
 	void *nworld_eptp;  /**< the pointer to the EPT table of one VM */
 	struct memory_ops ept_mem_ops;  /**< the EPT memory operations of one VM */
+	bool ept_ad; /**< whether the EPT accessed and dirty flags are enabled for one VM */
 } __aligned(PAGE_SIZE);
 
 /**
@@ -160,9 +162,14 @@ struct acrn_vm {
 	struct iommu_domain *iommu; /**< iommu domain of this VM */
 
 	spinlock_t ept_lock;	/**< Spin-lock used to protect ept add/modify/remove for a VM */
+	uint64_t exe_ept_violations; /**< Number of EPT violations caused by instruction fetches in this VM */
 
 	spinlock_t vm_lock; /**< The lock that protects VM state updates */
 	struct vm_io_handler_desc emul_pio[EMUL_PIO_IDX_MAX]; /**< emulated port I/O handler descriptor */
+	struct vm_pio_map pio_map; /**< map from an I/O port to its index in 'emul_pio' */
+	spinlock_t emul_mmio_lock; /**< The lock that protects 'nr_emul_mmio_regions' and 'emul_mmio' */
+	uint16_t nr_emul_mmio_regions; /**< number of the used entries in 'emul_mmio' */
+	struct mem_io_node emul_mmio[EMUL_MMIO_REGIONS_MAX]; /**< emulated MMIO handler descriptor */
 
 	uint32_t vcpuid_entry_nr;  /**< the vCPUID entries number */
 	uint32_t vcpuid_level;  /**< the maximum leaf of basic function vCPUID information */
@@ -261,16 +268,27 @@ static inline struct acrn_vcpu *vcpu_from_pid(struct acrn_vm *vm, uint16_t pcpu_
 void make_shutdown_vm_request(uint16_t pcpu_id);
 bool need_shutdown_vm(uint16_t pcpu_id);
 int32_t shutdown_vm(struct acrn_vm *vm);
+void make_restart_vm_request(uint16_t pcpu_id);
+bool need_restart_vm(uint16_t pcpu_id);
+int32_t restart_vm(struct acrn_vm *vm);
 void pause_vm(struct acrn_vm *vm);
 void prepare_vm(uint16_t vm_id, const struct acrn_vm_config *vm_config);
 void launch_vms(uint16_t pcpu_id);
 struct acrn_vm *get_vm_from_vmid(uint16_t vm_id);
 
 void direct_boot_sw_loader(struct acrn_vm *vm);
+void join_image_load(uint16_t vm_id);
+void end_image_load(uint16_t vm_id);
 
 void vrtc_init(struct acrn_vm *vm);
 
 bool is_safety_vm(const struct acrn_vm *vm);
+
+#define HOST_REGION_SNAPSHOT		0U	/**< The golden snapshot memory reserved for a VM */
+#define HOST_REGION_SHM			1U	/**< The region shared by ivshmem devices */
+#define HOST_REGION_KERNEL_MODULE	2U	/**< A kernel module to be mapped into a VM in place */
+
+bool is_host_region_reserved(uint64_t hpa, uint64_t size, uint32_t kind, uint16_t vm_id);
 #endif /* !ASSEMBLER */
 
 /**
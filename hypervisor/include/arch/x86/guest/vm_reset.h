@@ -15,7 +15,7 @@
 
 /**
  * @file
- * @brief This file declares the APIs of requesting and handling VM shutdown.
+ * @brief This file declares the APIs of requesting and handling VM shutdown and restart.
  */
 
 #include <acrn_common.h>
@@ -23,6 +23,8 @@
 
 void shutdown_vm_from_idle(uint16_t pcpu_id);
 void fatal_error_shutdown_vm(struct acrn_vcpu *vcpu);
+void restart_vm_from_idle(uint16_t pcpu_id);
+void request_vm_restart(struct acrn_vm *vm);
 
 /**
  * @}
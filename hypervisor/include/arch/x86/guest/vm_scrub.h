@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2019 Intel Corporation. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef VM_SCRUB_H_
+#define VM_SCRUB_H_
+
+/**
+ * @addtogroup vp-base_vm
+ *
+ * @{
+ */
+
+/**
+ * @file
+ * @brief This file declares the APIs of scrubbing the memory of a VM on the physical CPUs it holds.
+ */
+
+#include <types.h>
+
+struct acrn_vm;
+
+void post_vm_scrub(struct acrn_vm *vm, bool restart);
+void finish_vm_scrub(struct acrn_vm *vm);
+bool need_scrub_vm(uint16_t pcpu_id);
+void scrub_vm_from_idle(uint16_t pcpu_id);
+
+/**
+ * @}
+ */
+
+#endif /* VM_SCRUB_H_ */
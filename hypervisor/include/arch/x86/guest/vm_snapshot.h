@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2019 Intel Corporation. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef VM_SNAPSHOT_H_
+#define VM_SNAPSHOT_H_
+
+/**
+ * @addtogroup vp-base_vm
+ *
+ * @{
+ */
+
+/**
+ * @file
+ * @brief This file declares the APIs of taking and restoring the golden snapshot and the checkpoints of a VM.
+ */
+
+#include <types.h>
+
+/**
+ * @brief The I/O port the guest writes to once it completes booting, to request its golden snapshot.
+ *
+ * Reading the port returns how many times the VM has been restored from its golden snapshot.
+ */
+#define SNAPSHOT_PIO_PORT	0xF8U
+
+struct acrn_vm;
+struct acrn_vcpu;
+
+void init_vm_snapshot(struct acrn_vm *vm);
+void save_vcpu_snapshot(struct acrn_vcpu *vcpu);
+void load_vcpu_snapshot(struct acrn_vcpu *vcpu);
+bool restore_vm_snapshot(struct acrn_vm *vm);
+int32_t take_vm_checkpoint(struct acrn_vm *vm);
+void *lend_vm_snapshot_memory(struct acrn_vm *vm, uint64_t *size);
+void reclaim_vm_snapshot_memory(struct acrn_vm *vm);
+
+/**
+ * @}
+ */
+
+#endif /* VM_SNAPSHOT_H_ */
@@ -216,6 +216,52 @@ static inline uint64_t vm_exit_io_instruction_access_direction(uint64_t exit_qua
 	return (vm_exit_qualification_bit_mask(exit_qual, 3U, 3U) >> 3U);
 }
 
+/**
+ * @brief This function returns whether the IO instruction causing the vm exit is a string instruction.
+ *
+ * @param[in] exit_qual The VM exit qualification.
+ *
+ * @return bit4(string instruction) of the exit_qual
+ *
+ * @pre  None
+ *
+ * @post None
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+static inline uint64_t vm_exit_io_instruction_is_string(uint64_t exit_qual)
+{
+	/** Return bit4(string instruction) of the exit_qual for I/O instruction */
+	return (vm_exit_qualification_bit_mask(exit_qual, 4U, 4U) >> 4U);
+}
+
+/**
+ * @brief This function returns whether the IO instruction causing the vm exit has a REP prefix.
+ *
+ * @param[in] exit_qual The VM exit qualification.
+ *
+ * @return bit5(REP prefixed) of the exit_qual
+ *
+ * @pre  None
+ *
+ * @post None
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ *
+ * @threadsafety Yes
+ */
+static inline uint64_t vm_exit_io_instruction_is_rep(uint64_t exit_qual)
+{
+	/** Return bit5(REP prefixed) of the exit_qual for I/O instruction */
+	return (vm_exit_qualification_bit_mask(exit_qual, 5U, 5U) >> 5U);
+}
+
 /**
  * @brief This function returns port number of attempted access of IO instruction when vm exit happens.
  *
@@ -121,10 +121,21 @@
  *	  port I/O handler array of VMs. Reserved for future use.
  */
 #define PIO_RESET_REG_IDX        (CF9_PIO_IDX + 1U)
+
+/**
+ * @brief Index to the port I/O handler descriptor for the golden snapshot port in
+ *	  the port I/O handler array of VMs.
+ */
+#define SNAPSHOT_PIO_IDX         (PIO_RESET_REG_IDX + 1U)
+/**
+ * @brief Index to the port I/O handler descriptor for the registers of the ivshmem
+ *	  device in the port I/O handler array of VMs.
+ */
+#define IVSHMEM_PIO_IDX          (SNAPSHOT_PIO_IDX + 1U)
 /**
  * @brief Size of the port I/O handler array of VMs
  */
-#define EMUL_PIO_IDX_MAX         (PIO_RESET_REG_IDX + 1U)
+#define EMUL_PIO_IDX_MAX         (IVSHMEM_PIO_IDX + 1U)
 
 /**
  * @brief The handler of VM exits on I/O instructions
@@ -17,7 +17,8 @@
  * Usage:
  * - 'hwmgmt.irq' module depends on this module to disable PIC.
  * - 'vp-dm.vperipheral' module depends on this module to read physical RTC value.
- * - 'hwmgmt.pci' module depends on this module to read/write PCI configuration space registers.
+ * - 'hwmgmt.pci' module depends on this module to read/write PCI configuration space registers, through port I/O or
+ *   through the platform ECAM region.
  * - 'hwmgmt.apic' module depends on this module to read/write IOAPIC registers.
  * - 'hwmgmt.vtd' module depends on this module to read/write remapping registers.
  *
@@ -220,6 +221,98 @@ static inline uint32_t pio_read32(uint16_t port)
 	return value;
 }
 
+/**
+ * @brief To write an 8-bits value to a memory mapped IO device.
+ *
+ * @param[in] value The 8-bits value to write.
+ * @param[in] addr The memory address to write to.
+
+ * @return None
+ *
+ * @pre hva2hpa(addr) is in the platform ECAM region reported by the MCFG.
+
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+static inline void mmio_write8(uint8_t value, void *addr)
+{
+	/** Write \a value to the specified memory addressed by the virtual address \a addr */
+	*((volatile uint8_t *)addr) = value;
+}
+
+/**
+ * @brief To read an 8-bits value from a memory mapped IO device.
+ *
+ * @param[in] addr The memory address to read from.
+ *
+ * @return An 8-bits value read from the given address.
+
+ * @pre hva2hpa(addr) is in the platform ECAM region reported by the MCFG.
+
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+static inline uint8_t mmio_read8(const void *addr)
+{
+	/** Return an 8-bits value read from the virtual address \a addr */
+	return *((volatile const uint8_t *)addr);
+}
+
+/**
+ * @brief To write a 16-bits value to a memory mapped IO device.
+ *
+ * @param[in] value The 16-bits value to write.
+ * @param[in] addr The memory address to write to.
+
+ * @return None
+ *
+ * @pre hva2hpa(addr) is in the platform ECAM region reported by the MCFG.
+ * @pre ((uint64_t)addr & 1H) == 0
+
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+static inline void mmio_write16(uint16_t value, void *addr)
+{
+	/** Write \a value to the specified memory addressed by the virtual address \a addr */
+	*((volatile uint16_t *)addr) = value;
+}
+
+/**
+ * @brief To read a 16-bits value from a memory mapped IO device.
+ *
+ * @param[in] addr The memory address to read from.
+ *
+ * @return A 16-bits value read from the given address.
+
+ * @pre hva2hpa(addr) is in the platform ECAM region reported by the MCFG.
+ * @pre ((uint64_t)addr & 1H) == 0
+
+ * @post N/A
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+static inline uint16_t mmio_read16(const void *addr)
+{
+	/** Return a 16-bits value read from the virtual address \a addr */
+	return *((volatile const uint16_t *)addr);
+}
+
 /**
  * @brief To write a 32-bits value to a memory mapped IO device.
  *
@@ -228,7 +321,8 @@ static inline uint32_t pio_read32(uint16_t port)
 
  * @return None
  *
- * @pre (0FEC00000H <= hva2hpa(addr) <= 0FEC003FFH) || (0FED90000H <= hva2hpa(addr) < 0FED92000H)
+ * @pre (0FEC00000H <= hva2hpa(addr) <= 0FEC003FFH) || (0FED90000H <= hva2hpa(addr) < 0FED92000H) ||
+ *      hva2hpa(addr) is in the platform ECAM region reported by the MCFG
 
  * @post N/A
  *
@@ -257,7 +351,8 @@ static inline void mmio_write32(uint32_t value, void *addr)
  *
  * @return A 32-bits value read from the given address.
 
- * @pre (0FEC00000H <= hva2hpa(addr) <= 0FEC003FFH) || (0FED90000H <= hva2hpa(addr) < 0FED92000H)
+ * @pre (0FEC00000H <= hva2hpa(addr) <= 0FEC003FFH) || (0FED90000H <= hva2hpa(addr) < 0FED92000H) ||
+ *      hva2hpa(addr) is in the platform ECAM region reported by the MCFG
 
  * @post N/A
  *
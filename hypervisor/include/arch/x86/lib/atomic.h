@@ -54,7 +54,8 @@
  * @file
  * @brief The definition and implementation of atomic infrastructures.
  *
- * It provides external APIs for atomically exchanging register/memory with register.
+ * It provides external APIs for atomically exchanging register/memory with register and for atomically
+ * incrementing or adding to a counter in memory.
  */
 #include <types.h>
 
@@ -102,6 +103,83 @@
  */
 build_atomic_swap(atomic_swap32, "l", uint32_t)
 
+#define build_atomic_inc(name, size, type)                                        \
+	static inline void name(type *ptr)                                        \
+	{                                                                         \
+		asm volatile(BUS_LOCK "inc" size " %0" : "=m"(*ptr) : "m"(*ptr)); \
+	}
+/**
+ * @brief Declare a function named atomic_inc64 by using build_atomic_inc.
+ *        This function atomically increments the 64-bit value stored at the address \a ptr by 1.
+ *
+ * It does following things:
+ *
+ * Execute inline assembly ("inc")
+ *  with following parameters, in order to increment a memory operand with the bus locked
+ *  - Instruction template: BUS_LOCK "inc" size " %0".
+ *  - Input operands: Memory pointed to by ptr holds the value to be incremented.
+ *  - Output operands: Memory pointed to by ptr holds the incremented value.
+ *  - Clobbers: None
+ *
+ * @param[inout] ptr The address of the value to be incremented.
+ *
+ * @return None
+ *
+ * @pre ptr != NULL
+ *
+ * @post N/A
+ *
+ * @mode N/A
+ *
+ * @remark N/A
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+build_atomic_inc(atomic_inc64, "q", uint64_t)
+
+#define build_atomic_xadd(name, size, type)                                                         \
+	static inline type name(type *ptr, type v)                                                  \
+	{                                                                                           \
+		asm volatile(BUS_LOCK "xadd" size " %0,%1" : "+r"(v), "+m"(*ptr) : : "cc", "memory"); \
+		return v;                                                                           \
+	}
+/**
+ * @brief Declare a function named atomic_xadd64 by using build_atomic_xadd.
+ *        This function atomically adds \a v to the 64-bit value stored at the address \a ptr and returns the
+ *        original value.
+ *
+ * It does following things:
+ *
+ * Execute inline assembly ("xadd")
+ *  with following parameters, in order to exchange and add a memory operand with the bus locked
+ *  - Instruction template: BUS_LOCK "xadd" size " %0,%1".
+ *  - Input operands: None
+ *  - Output operands:
+ *	- A general register holds the value to be added and receives the original content.
+ *	- Memory pointed to by ptr holds the value to be added to.
+ *  - Clobbers: "cc", "memory"
+ *
+ * Return the original content in the address pointed by \a ptr.
+ *
+ * @param[inout] ptr The address of the value to be added to.
+ * @param[in] v The value to be added.
+ *
+ * @return The original content in the address pointed by \a ptr.
+ *
+ * @pre ptr != NULL
+ *
+ * @post N/A
+ *
+ * @mode N/A
+ *
+ * @remark N/A
+ *
+ * @reentrancy Unspecified
+ * @threadsafety Yes
+ */
+build_atomic_xadd(atomic_xadd64, "q", uint64_t)
+
 /**
  * @}
  */
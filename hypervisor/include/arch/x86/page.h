@@ -245,6 +245,10 @@ union pgtable_pages_info {
 		 * @brief A pointer to the page tables to be used for EPT.
 		 */
 		struct page *nworld_pt_base;
+		/**
+		 * @brief The identifier of the VM that uses these EPT paging structures.
+		 */
+		uint16_t vm_id;
 	} ept;
 };
 
@@ -336,6 +340,18 @@ struct memory_ops {
 	 * There is no operation needed to be conducted for all the other cases.
 	 */
 	void (*recover_exe_right)(uint64_t *prot);
+
+	/**
+	 * @brief A function pointer to invalidate the cached translations of a region just merged into a large page.
+	 *
+	 * The paging structure that mapped the region is left unreferenced by the merge and is reused by the next
+	 * split of the same region, so it shall no longer be referenced by any paging-structure cache or IOTLB when
+	 * this function returns.
+	 *
+	 * There is no operation needed to be conducted for the paging structures used by the hypervisor, which are
+	 * only modified during initialization.
+	 */
+	void (*flush_merged)(const union pgtable_pages_info *info, uint64_t vaddr, uint64_t size);
 };
 
 extern const struct memory_ops ppt_mem_ops;
@@ -38,13 +38,13 @@
 #include <vm_config.h>
 
 /**
- * @brief Size of the 2-MByte page.
+ * @brief Size of the guard pages around the physical CPU normal stack in Byte.
  */
-#define GUARD_PAGE_SIZE  0x200000U
+#define GUARD_PAGE_SIZE  PAGE_SIZE
 /**
- * @brief The physical CPU normal stack size in Byte
+ * @brief The physical CPU normal stack size in Byte. It shall be a multiple of PAGE_SIZE.
  */
-#define PCPU_STACK_SIZE  0x200000U
+#define PCPU_STACK_SIZE  CONFIG_PCPU_STACK_SIZE
 /**
  * @brief The structure to hold all per CPU information.
  *
@@ -55,21 +55,21 @@ struct per_cpu_region {
 	/**
 	 * @brief The guard page.
 	 *
-	 * This guard page is to mitigate stack overflow. This page is 2M-byte
+	 * This guard page is to mitigate stack overflow. This page is 4K-byte
 	 * alignment and will be unmapped during page initialization.
 	 */
 	uint8_t before_guard_page[GUARD_PAGE_SIZE] __aligned(GUARD_PAGE_SIZE);
 	/**
 	 * @brief The physical CPU stack.
 	 *
-	 * This stack is the physical CPU stack on the logical processor. This stack is 2M-byte
+	 * This stack is the physical CPU stack on the logical processor. This stack is 4K-byte
 	 * alignment.
 	 */
-	uint8_t stack[PCPU_STACK_SIZE] __aligned(PCPU_STACK_SIZE);
+	uint8_t stack[PCPU_STACK_SIZE] __aligned(PAGE_SIZE);
 	/**
 	 * @brief The guard page.
 	 *
-	 * This guard page is to mitigate stack underflow. This page is 2M-byte
+	 * This guard page is to mitigate stack underflow. This page is 4K-byte
 	 * alignment and will be unmapped during page initialization.
 	 */
 	uint8_t after_guard_page[GUARD_PAGE_SIZE] __aligned(GUARD_PAGE_SIZE);
@@ -101,8 +101,8 @@ struct per_cpu_region {
 							    *   processor.This stack is 16-byte aligned. */
 	uint32_t lapic_id; /**< lapic id. */
 	uint32_t lapic_ldr; /**< lapic local destination register. */
-	uint16_t shutdown_vm_id; /**< ID representing the VM that requests to be shutdown. */
-} __aligned(GUARD_PAGE_SIZE); /* per_cpu_region size aligned with GUARD_PAGE_SIZE */
+	uint16_t shutdown_vm_id; /**< ID representing the VM that requests to be shutdown, restarted or scrubbed. */
+} __aligned(PAGE_SIZE); /* per_cpu_region size aligned with PAGE_SIZE */
 
 extern struct per_cpu_region per_cpu_data[MAX_PCPU_NUM];
 /**
@@ -131,6 +131,28 @@
  */
 #define EPT_MT_MASK (7UL << EPT_MT_SHIFT)
 
+/**
+ * @brief Position of the Accessed Bit in a leaf EPT paging-structure entry.
+ *
+ * The processor sets it when the page is accessed, if accessed and dirty flags for EPT are enabled.
+ */
+#define EPT_ACCESSED_POS 8U
+
+/**
+ * @brief Position of the Dirty Bit in a leaf EPT paging-structure entry.
+ *
+ * The processor sets it when the page is written, if accessed and dirty flags for EPT are enabled.
+ */
+#define EPT_DIRTY_POS 9U
+
+/**
+ * @brief Position of the software dirty bit in a leaf EPT paging-structure entry.
+ *
+ * The bit is ignored by the processor and by VT-d. The hypervisor sets it when it clears the dirty bit for a purpose
+ * other than a VM checkpoint, so that the page is still copied by the next checkpoint.
+ */
+#define EPT_SOFT_DIRTY_POS 52U
+
 /**
  * @brief Bit indicator for Snoop Bit in a second-level paging-structure entry used for VT-d.
  *
@@ -805,10 +827,12 @@ void mmu_modify_or_del(uint64_t *pml4_page, uint64_t vaddr_base, uint64_t size,
 
 /**
  * @brief The callback function type for walking through EPT, it will be called on every table entry.
+ *
+ * The last parameter is the caller-provided context passed to the walk, which may be NULL.
  */
-typedef void (*pge_handler)(uint64_t *pgentry, uint64_t size);
+typedef void (*pge_handler)(uint64_t *pgentry, uint64_t size, void *data);
 
-void walk_page_table(uint64_t *pml4_page, const struct memory_ops *mem_ops, pge_handler cb);
+void walk_page_table(uint64_t *pml4_page, const struct memory_ops *mem_ops, pge_handler cb, void *data);
 
 /**
  * @}
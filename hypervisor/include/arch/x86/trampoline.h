@@ -108,10 +108,11 @@ extern uint8_t trampoline_start64_fixup;
 extern uint64_t main_entry[1];
 
 /**
- * @brief Host linear address of the stack used by the trampoline
+ * @brief Host linear address of the table of stacks used by the trampoline
  *
- * This variable holds the host linear address of the stack that the trampoline code shall use after switching to 64-bit
- * mode and shall be initialized properly in the relocated trampoline section before the trampoline code is executed.
+ * This variable holds the host linear address of the table the trampoline code looks up, by the x2APIC ID of the
+ * running AP, for the stack it shall use after switching to 64-bit mode. It shall be initialized properly in the
+ * relocated trampoline section before the trampoline code is executed.
  *
  * Refer to section 11.1.1.11 in Software Architecture Design Specification for details.
  */
@@ -63,6 +63,7 @@
 struct acrn_vm_mem_config {
 	uint64_t start_hpa;	/**< Starting HPA of the memory allocated to a pre-launched VM */
 	uint64_t size;		/**< Size of the memory allocated to a VM */
+	uint64_t snapshot_hpa;	/**< Starting HPA of the memory holding the golden snapshot of a VM, 0 if none */
 };
 
 
@@ -175,6 +176,8 @@ struct acrn_vm_pci_dev_config {
 	union pci_bdf pbdf; /**< Physical BDF value of PCI device */
 	uint64_t vbar_base[PCI_BAR_COUNT]; /**< Virtual BAR base address of PCI device */
 	const struct pci_vdev_ops *vdev_ops; /**< Link to operations for PCI configuration access */
+	uint64_t shm_hpa; /**< Start HPA of the region shared by ivshmem devices, only used by ivshmem devices */
+	uint64_t shm_size; /**< Size in bytes of the region shared by ivshmem devices, a power of 2 */
 } __aligned(8);
 
 /**
@@ -190,7 +193,8 @@ struct acrn_vm_config {
 	char name[MAX_VM_OS_NAME_LEN];  /**< VM name, for debug usage. */
 	uint16_t vcpu_num;		/**< Number of VCPU of the VM */
 	uint64_t vcpu_affinity[MAX_VCPUS_PER_VM]; /**< Bitmaps for vCPUs' affinity */
-	uint64_t guest_flags; /**< VM flags, only GUEST_FLAG_HIGHEST_SEVERITY is supported */
+	uint64_t guest_flags; /**< VM flags, GUEST_FLAG_HIGHEST_SEVERITY, GUEST_FLAG_EPT_AD and
+			       *   GUEST_FLAG_KERNEL_IN_PLACE are supported */
 	struct acrn_vm_mem_config memory; /**< Memory configuration of VM */
 	uint16_t pci_dev_num;		  /**< Number of PCI pass-through devices in a VM */
 	struct acrn_vm_pci_dev_config *pci_devs; /**< A pointer to the list of all PCI devices pass-throughed to a VM */
@@ -262,6 +262,10 @@
  * @brief Address of VM exit instruction length field in the VMCS.
  */
 #define VMX_EXIT_INSTR_LEN      0x0000440cU
+/**
+ * @brief Address of VM exit instruction information field in the VMCS.
+ */
+#define VMX_INSTR_INFO          0x0000440eU
 /**
  * @brief Address of guest ES segment limit control field in the VMCS.
  */
@@ -896,6 +900,11 @@
  */
 #define VMX_PROCBASED_CTLS2_XSVE_XRSTR (1U << 20U)
 
+/**
+ * @brief Bit field in the IA32_VMX_EPT_VPID_CAP MSR that determines
+ * whether accessed and dirty flags for EPT are supported.
+ */
+#define VMX_EPT_AD (1U << 21U)
 /**
  * @brief Bit field in the IA32_VMX_EPT_VPID_CAP MSR that determines
  * whether the single context INVEPT type is supported.
@@ -906,6 +915,10 @@
  * whether the all context INVEPT type is supported.
  */
 #define VMX_EPT_INVEPT_GLOBAL_CONTEXT (1U << 26U)
+/**
+ * @brief Bit field in the EPT pointer that enables accessed and dirty flags for EPT.
+ */
+#define VMX_EPTP_AD_ENABLE (1UL << 6U)
 
 /**
  * @brief Single context INVVPID type which indicates only specified VPID's mappings will be invalidated.
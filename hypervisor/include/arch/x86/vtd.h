@@ -32,6 +32,8 @@
  * Intel IOMMU register specification per version 1.0 public spec.
  */
 
+#define DMAR_CAP_REG    0x08U /**< Register offset of Capability Register. */
+#define DMAR_ECAP_REG   0x10U /**< Register offset of Extended Capability Register. */
 #define DMAR_GCMD_REG   0x18U /**< Register offset of Global Command Register. */
 #define DMAR_GSTS_REG   0x1cU /**< Register offset of Global Status Register. */
 #define DMAR_RTADDR_REG 0x20U /**< Register offset of Root Table Address Register. */
@@ -41,6 +43,14 @@
 
 #define DMAR_GSTS_REG_MASK   0x96FFFFFFU /**< Mask of GSTS_REG enable/disable bits*/
 
+/* CAP_REG */
+#define DMA_CAP_PSI          (((uint64_t)1UL) << 39U) /**< Bit indicator for Page Selective Invalidation support. */
+#define DMA_CAP_MAMV_SHIFT   48U /**< Starting bit position of MAMV (Maximum Address Mask Value) field. */
+#define DMA_CAP_MAMV_MASK    0x3fUL /**< Mask of MAMV (Maximum Address Mask Value) field after shifting. */
+
+/* ECAP_REG */
+#define DMA_ECAP_C           (((uint64_t)1UL) << 0U) /**< Bit indicator for Page-walk Coherency support. */
+
 /* Values for entry_type in ACPI_DMAR_DEVICE_SCOPE - device types */
 /**
  * @brief Data structure to enumerate different Device Scope Entry types.
@@ -90,6 +100,7 @@ struct iommu_domain {
 	uint16_t vm_id; /**< The VM identifier corresponding to this IOMMU domain. */
 	uint32_t addr_width; /**< The address width (in bit) of this IOMMU domain. */
 	uint64_t trans_table_ptr; /**< The base address of the translation table associated with this IOMMU domain. */
+	uint16_t dev_count; /**< The number of PCI devices currently assigned to this IOMMU domain. */
 };
 
 /**
@@ -292,6 +303,16 @@ static inline uint64_t dma_ccmd_did(uint16_t did)
  * @brief Setting of the granularity for Domain-Selective Invalidation in an IOTLB Invalidate Descriptor.
  */
 #define DMA_IOTLB_DOMAIN_INVL (((uint64_t)2UL) << 4U)
+/**
+ * @brief Setting of the granularity for Page-Selective-within-Domain Invalidation in an IOTLB Invalidate Descriptor.
+ */
+#define DMA_IOTLB_PAGE_INVL   (((uint64_t)3UL) << 4U)
+/**
+ * @brief Bit indicator for Invalidation Hint Bit in the high 64-bits of an IOTLB Invalidate Descriptor.
+ *
+ * When it is set, only the leaf (last-level) paging-structure entries of the invalidated range were modified.
+ */
+#define DMA_IOTLB_IH          (((uint64_t)1UL) << 6U)
 
 /**
  * @brief Bit indicator for Drain Reads Bit in IOTLB Invalidate Descriptor.
@@ -639,7 +660,7 @@ union dmar_ir_entry {
 	} bits __packed;
 };
 
-int32_t remove_iommu_device(const struct iommu_domain *domain, uint8_t bus, uint8_t devfun);
+int32_t remove_iommu_device(struct iommu_domain *domain, uint8_t bus, uint8_t devfun);
 int32_t add_iommu_device(struct iommu_domain *domain, uint8_t bus, uint8_t devfun);
 
 struct iommu_domain *create_iommu_domain(uint16_t vm_id, uint64_t translation_table, uint32_t addr_width);
@@ -652,6 +673,8 @@ void dmar_assign_irte(struct intr_source intr_src, union dmar_ir_entry irte, uin
 void dmar_free_irte(__unused struct intr_source intr_src, uint16_t index);
 
 void iommu_flush_cache(const void *p, uint32_t size);
+uint64_t iommu_get_flushes_avoided(void);
+void iommu_invalidate_range(const struct iommu_domain *domain, uint64_t gpa, uint64_t size);
 
 /**
  * @brief This is the declaration of the global variable 'plat_dmar_info' that stores the physical information of
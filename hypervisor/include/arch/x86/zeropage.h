@@ -120,10 +120,15 @@ struct zero_page {
 		 * @brief A preferred load address for the kernel, refer to Linux kernel: Documentation/x86/boot.txt
 		 */
 		uint64_t pref_addr; /* 0x258 */    /**<  */
+		/**
+		 * @brief The linear memory required during initialization of the kernel, starting at the load
+		 * address, refer to Linux kernel: Documentation/x86/boot.txt
+		 */
+		uint32_t init_size; /* 0x260 */
 		/**
 		 * @brief Aligned data for this structure
 		 */
-		uint8_t hdr_pad7[8]; /* 0x260 */
+		uint8_t hdr_pad7[4]; /* 0x264 */
 	} __packed hdr;
 	/**
 	 * @brief Aligned data for this structure
@@ -23,6 +23,7 @@
 #define CONFIG_BOARD                     "nuc7i7dnb" /**< Set string name of board */
 #define CONFIG_RELEASE                   1 /**< Set release version when compiling */
 #define CONFIG_STACK_SIZE                0x2000U /**< Stack size in bytes */
+#define CONFIG_PCPU_STACK_SIZE           0x8000U /**< Size of the normal stack of each physical CPU in bytes */
 #define CONFIG_LOG_DESTINATION           7U /**< Bitmap setting for destination of log messages */
 #define CONFIG_LOW_RAM_SIZE              0x00010000U /**< Memory size of low memory */
 #define CONFIG_HV_RAM_START              0x00400000UL /**< Start memory address of hypervisor */
@@ -31,9 +32,10 @@
 #define CONFIG_UOS_RAM_SIZE              0x200000000UL /**< Size of the memory allocated to a User VM */
 #define CONFIG_MAX_IOAPIC_NUM            1U /**< Number of physical IOAPICs on current platform */
 #define CONFIG_MAX_IOAPIC_LINES          120U /**< Number of input line of IOAPICs */
-#define CONFIG_MAX_IR_ENTRIES            256U /**< Maximum number of Interrupt Remapping entries */
+#define CONFIG_MAX_IR_ENTRIES            2048U /**< Maximum number of Interrupt Remapping entries */
 #define CONFIG_IOMMU_BUS_NUM             0x100U /**< Maximum PCI bus number supported by IOMMU */
 #define CONFIG_MAX_PCI_DEV_NUM           96U /**< Maximum PCI device number supported by hypervisor */
+#define CONFIG_MAX_MSIX_TABLE_NUM        16U /**< Maximum number of MSI-X table entries emulated per device */
 #define CONFIG_UEFI_OS_LOADER_NAME       "\\EFI\\org.clearlinux\\bootloaderx64.efi" /**< Name of bootloader */
 
 /**
@@ -11,6 +11,7 @@ CONFIG_RELEASE=y
 CONFIG_MAX_EMULATED_MMIO_REGIONS=16
 CONFIG_MAX_PT_IRQ_ENTRIES=64
 CONFIG_STACK_SIZE=0x2000
+CONFIG_PCPU_STACK_SIZE=0x8000
 CONFIG_LOG_BUF_SIZE=0x40000
 CONFIG_LOG_DESTINATION=7
 CONFIG_LOW_RAM_SIZE=0x00010000
@@ -24,7 +25,7 @@ CONFIG_UOS_RAM_SIZE=0x200000000
 # CONFIG_RELOC is not set
 CONFIG_MAX_IOAPIC_NUM=1
 CONFIG_MAX_IOAPIC_LINES=120
-CONFIG_MAX_IR_ENTRIES=256
+CONFIG_MAX_IR_ENTRIES=2048
 CONFIG_IOMMU_BUS_NUM=0x100
 CONFIG_MAX_PCI_DEV_NUM=96
 CONFIG_MAX_MSIX_TABLE_NUM=16
@@ -16,7 +16,7 @@
 /**
  * @file
  * @brief this file declares the external data structures and APIs for registering
- *	  port I/O emulation handler to a specific VM.
+ *	  port I/O and MMIO emulation handlers to a specific VM.
  */
 
 #include <types.h>
@@ -161,6 +161,94 @@ struct vm_io_handler_desc {
 	io_write_fn_t io_write;
 } __aligned(8);
 
+/**
+ * @brief Callback function type for MMIO read/write emulation.
+ *
+ *  Callback function with this type shall be registered, in order to emulate MMIO accesses
+ *  to a specific guest physical address range of guest VM.
+ *
+ * @param [inout]  io_req  Pointer to the instance of struct io_request, whose reqs.mmio holds the
+ *			   address, size and direction of the access, the value to write (MMIO write)
+ *			   and receives the value read (MMIO read).
+ * @param [in]     handler_private_data The private data registered with the handler.
+ *
+ * @return 0 if the access is emulated, otherwise a negative error code.
+ *
+ * @pre io_req != NULL
+ * @pre io_req->reqs.mmio.size == 1 || io_req->reqs.mmio.size == 2 || io_req->reqs.mmio.size == 4 ||
+ *	io_req->reqs.mmio.size == 8
+ *
+ * @post None
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety This function is thread-safe under condition that /p io_req is
+ *		 different among parallel invocations.
+ */
+typedef int32_t (*hv_mem_io_handler_t)(struct io_request *io_req, void *handler_private_data);
+
+/**
+ * @brief Describes a single MMIO handler description entry.
+ *
+ * @consistency range_start < range_end
+ *
+ * @alignment 8
+ *
+ * @remark N/A
+ */
+struct mem_io_node {
+	hv_mem_io_handler_t read_write; /**< The handler of reads and writes to the range. */
+	void *handler_private_data; /**< The private data passed to read_write. */
+	uint64_t range_start; /**< Guest physical base address of the range. */
+	uint64_t range_end; /**< Guest physical address right after the range. */
+};
+
+/**
+ * @brief Maximum number of MMIO ranges emulated by the hypervisor for one VM.
+ */
+#define EMUL_MMIO_REGIONS_MAX	8U
+
+/**
+ * @brief Number of I/O ports covered by one second-level page of the port I/O handler map.
+ */
+#define PIO_MAP_PAGE_PORTS	256U
+
+/**
+ * @brief Number of first-level entries of the port I/O handler map, one per 256 ports of the 64K port space.
+ */
+#define PIO_MAP_DIR_NUM		256U
+
+/**
+ * @brief Number of second-level pages of the port I/O handler map available to one VM.
+ *
+ * Each registered range of up to 256 ports touches at most two pages, so this provides two pages for each of the
+ * EMUL_PIO_IDX_MAX (at most 20) handler slots.
+ */
+#define PIO_MAP_PAGE_NUM	40U
+
+/**
+ * @brief Per-VM two-level map from an I/O port to the index of its emulation handler.
+ *
+ * The first level is indexed by bits 15:8 of the port and holds the number of a second-level page plus one (0 if
+ * no port of those 256 ports has a handler). The second level is indexed by bits 7:0 of the port and holds the
+ * handler index in 'emul_pio' of the VM plus one (0 if the port has no handler).
+ * Second-level pages are taken from a fixed pool when a handler is registered in them and returned to the pool
+ * when their last port is unregistered.
+ *
+ * @consistency For each page p with used[p] == 0, all entries of page[p] are 0 and no dir entry refers to p.
+ *
+ * @alignment 2
+ *
+ * @remark N/A
+ */
+struct vm_pio_map {
+	uint8_t dir[PIO_MAP_DIR_NUM]; /**< First-level entries, second-level page number plus one. */
+	uint8_t page[PIO_MAP_PAGE_NUM][PIO_MAP_PAGE_PORTS]; /**< Second-level pages, handler index plus one. */
+	uint16_t used[PIO_MAP_PAGE_NUM]; /**< Number of ports with a handler in each second-level page. */
+};
+
 /**
  * @brief This function wraps hv_emulate_pio() and emulate_pio_complete() to handle port I/O
  *	  access from guest VM.
@@ -188,9 +276,49 @@ struct vm_io_handler_desc {
  */
 void emulate_io(struct acrn_vcpu *vcpu, struct io_request *io_req);
 
+/**
+ * @brief This function runs the elements of a string port I/O instruction through hv_emulate_pio()
+ *	  against a host buffer holding the guest memory operand.
+ *
+ *  The elements are taken from (OUTS) or stored into (INS) \p buf in the order the instruction
+ *  accesses them: ascending addresses when \p backward is false and descending addresses otherwise.
+ *  The RAX register of \p vcpu is not touched.
+ *
+ * @param [in]     vcpu     Pointer to the instance of struct acrn_vcpu, which is the context of virtual
+ *			    CPU that triggers the I/O access.
+ * @param [inout]  io_req   Pointer to the instance of struct io_request, which holds the port address,
+ *			    the size of each element and the direction of the access.
+ * @param [inout]  buf      Pointer to the host buffer of \p count elements laid out in guest memory order.
+ * @param [in]     count    Number of elements to transfer.
+ * @param [in]     backward Whether the elements are accessed from the highest address down (RFLAGS.DF set).
+ *
+ * @return None
+ *
+ * @pre io_req != NULL
+ * @pre vcpu != NULL
+ * @pre vcpu->vm != NULL
+ * @pre buf != NULL
+ * @pre io_req->reqs.pio.size == 1 || io_req->reqs.pio.size == 2 || io_req->reqs.pio.size == 4
+ *
+ * @post None
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety This function is thread-safe under condition that /p vcpu and /p io_req
+ *		 are different among parallel invocations.
+ */
+void emulate_io_string(struct acrn_vcpu *vcpu, struct io_request *io_req, uint8_t *buf, uint32_t count,
+	bool backward);
+
 /**
  * @brief Register a port I/O handler
  *
+ *  The ports of the range previously registered at \p pio_idx are removed from the port I/O handler
+ *  map of \p vm and the ports of \p range are mapped to \p pio_idx, so that each I/O exit finds its
+ *  handler with one table lookup.
+ *
  * @param [inout] vm		  Pointer to instance of struct acrn_vm for which the port I/O
  *				  handlers are registered
  * @param [in]    pio_idx	  The emulated port I/O address
@@ -216,6 +344,105 @@ void emulate_io(struct acrn_vcpu *vcpu, struct io_request *io_req);
 void register_pio_emulation_handler(struct acrn_vm *vm, uint32_t pio_idx, const struct vm_io_range *range,
 	io_read_fn_t io_read_fn_ptr, io_write_fn_t io_write_fn_ptr);
 
+/**
+ * @brief Register a MMIO handler
+ *
+ *  A registration with the same \p start as an earlier one of \p vm replaces it, so a VM that is
+ *  initialized again keeps one entry per range.
+ *
+ * @param [inout] vm		  Pointer to instance of struct acrn_vm for which the MMIO handler is registered
+ * @param [in]    read_write	  The handler for emulating reads and writes to the given range
+ * @param [in]    start		  Guest physical base address of the range
+ * @param [in]    end		  Guest physical address right after the range
+ * @param [in]    handler_private_data The private data passed to \p read_write
+ *
+ * @return 0 if the handler is registered, -EBUSY if all EMUL_MMIO_REGIONS_MAX entries are used.
+ *
+ * @pre vm != NULL
+ * @pre read_write != NULL
+ * @pre start < end
+ *
+ * @post None
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety True, as vm->emul_mmio_lock is held while the entries of \p vm are updated
+ *
+ * @remark The range shall not be mapped in the EPT of \p vm, so that guest accesses cause EPT violations.
+ */
+int32_t register_mmio_emulation_handler(struct acrn_vm *vm, hv_mem_io_handler_t read_write, uint64_t start,
+	uint64_t end, void *handler_private_data);
+
+/**
+ * @brief Unregister the MMIO handler registered for a range starting at a given address
+ *
+ * @param [inout] vm	Pointer to instance of struct acrn_vm whose MMIO handler is unregistered
+ * @param [in]    start	Guest physical base address of the range given at registration
+ *
+ * @return None
+ *
+ * @pre vm != NULL
+ *
+ * @post None
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety True, as vm->emul_mmio_lock is held while the entries of \p vm are updated
+ *
+ * @remark Nothing is done if no handler is registered for \p start.
+ */
+void unregister_mmio_emulation_handler(struct acrn_vm *vm, uint64_t start);
+
+/**
+ * @brief Check whether a guest physical address is emulated by a registered MMIO handler.
+ *
+ * @param [in] vm  Pointer to instance of struct acrn_vm
+ * @param [in] gpa The guest physical address
+ *
+ * @return true if a MMIO handler is registered for \p gpa, otherwise false.
+ *
+ * @pre vm != NULL
+ *
+ * @post None
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety True, as vm->emul_mmio_lock is held while the entries of \p vm are looked up
+ */
+bool is_emulated_mmio(struct acrn_vm *vm, uint64_t gpa);
+
+/**
+ * @brief This function handles a MMIO access request by the MMIO handler registered for its range.
+ *
+ * @param [in]     vcpu    Pointer to the instance of struct acrn_vcpu, which is the context of virtual
+ *			   CPU that triggers the MMIO access.
+ * @param [inout]  io_req  Pointer to the instance of struct io_request, whose reqs.mmio holds the
+ *			   MMIO request and receives the value read.
+ *
+ * @return 0 if the access is emulated, -EINVAL if no registered range covers the access,
+ *	   otherwise the error returned by the handler.
+ *
+ * @pre vcpu != NULL
+ * @pre vcpu->vm != NULL
+ * @pre io_req != NULL
+ *
+ * @post None
+ *
+ * @mode HV_OPERATIONAL
+ *
+ * @reentrancy unspecified
+ *
+ * @threadsafety This function is thread-safe under condition that /p vcpu and /p io_req
+ *		 are different among parallel invocations.
+ */
+int32_t emulate_mmio(struct acrn_vcpu *vcpu, struct io_request *io_req);
+
 /**
  * @}
  */
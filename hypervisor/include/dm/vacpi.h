@@ -37,8 +37,9 @@
  *  Layout
  *  ------
  *   RSDP  ->   0xf2400    (36 bytes fixed)
- *     XSDT  ->   0xf2480    (36 bytes + 8*7 table addrs, 4 used)
+ *     XSDT  ->   0xf2480    (36 bytes + 8*2 table addrs)
  *       MADT  ->   0xf2500  (depends on the number of CPUs)
+ *       MCFG  ->   0xf2600  (44 bytes + 16 bytes for the virtual ECAM window)
  */
 
 #include <types.h>
@@ -51,6 +52,7 @@
 #define ACPI_RSDP_ADDR (ACPI_BASE + 0x0U)  /**< Pre-defined ACPI RSDP table base GPA */
 #define ACPI_XSDT_ADDR (ACPI_BASE + 0x080U) /**< Pre-defined ACPI XSDT table base GPA */
 #define ACPI_MADT_ADDR (ACPI_BASE + 0x100U) /**< Pre-defined ACPI MADT table base GPA */
+#define ACPI_MCFG_ADDR (ACPI_BASE + 0x200U) /**< Pre-defined ACPI MCFG table base GPA */
 
 #define ACPI_OEM_ID               "ACRN  " /**< Pre-defined ACPI OEM ID */
 #define ACPI_ASL_COMPILER_ID      "INTL"  /**< Pre-defined ACPI ASL compiler ID */
@@ -62,7 +64,7 @@ struct acrn_vm; /**< Declare the VM data structure, which is used in this file *
  * @brief Data structure to represent all ACPI sub tables.
  *
  * The instance of this data structure caches preliminary ACPI tables and sub-tables exposed to the VMs built.
- * It includes RSDP, XSDT, MADT and LAPIC.
+ * It includes RSDP, XSDT, MADT, LAPIC and MCFG.
  *
  * @consistency N/A
  * @alignment N/A
@@ -77,6 +79,11 @@ struct acpi_table_info {
 		struct acpi_table_madt madt; /**< data structure of MADT table  */
 		struct acpi_madt_local_apic lapic_array[MAX_PCPU_NUM]; /**< data structure of LAPIC ACPI array */
 	} __packed;
+
+	struct {
+		struct acpi_table_mcfg mcfg; /**< data structure of MCFG table  */
+		struct acpi_mcfg_allocation mcfg_entry; /**< data structure of the virtual ECAM window allocation */
+	} __packed;
 };
 
 void build_vacpi(struct acrn_vm *vm);
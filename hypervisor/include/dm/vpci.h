@@ -53,11 +53,39 @@
  */
 #define PCIM_NEXTPTR	0xFFU
 
+/**
+ * @brief Pre-defined guest physical base address of the virtual ECAM (MMCONFIG) window.
+ *
+ * It lies in the guest MMIO hole, above the virtual BARs and below the local APIC, and is never mapped in EPT.
+ */
+#define VPCI_ECAM_BASE		0xE0000000UL
+
+/**
+ * @brief Pre-defined last bus number decoded by the virtual ECAM window. All vPCI devices sit on bus 0.
+ */
+#define VPCI_ECAM_BUS_END	0x0U
+
+/**
+ * @brief Pre-defined size of the virtual ECAM window: 1MB (4KB per function) for each decoded bus.
+ */
+#define VPCI_ECAM_SIZE		(((uint64_t)VPCI_ECAM_BUS_END + 1UL) << 20U)
+
+/**
+ * @brief Pre-defined number of virtual buses, bus 0 plus secondary buses, whose vBDFs are indexed for lookup.
+ */
+#define VPCI_BUS_NUM		4U
+
+/**
+ * @brief Pre-defined number of vBDFs indexed for lookup: 256 functions per virtual bus.
+ */
+#define VPCI_BDF_NUM		(VPCI_BUS_NUM << 8U)
+
 /**
  * @brief Data structure to present PCI BAR information
  *
  * For a PCI BAR, this structure includes its type (MMIO BAR and 32bits or 64bits), BAR size,
- * GPA/HPA of BAR base, BAR memory type (low 4bits of a BAR register) and BAR size mask.
+ * GPA/HPA of BAR base, the GPA where it is mapped in the EPT, BAR memory type (low 4bits of a BAR register) and BAR
+ * size mask.
  *
  * @consistency N/A
  * @alignment N/A
@@ -69,6 +97,7 @@ struct pci_bar {
 	uint64_t size; /**< The BAR size */
 	uint64_t base; /**< The guest physical address of BAR base */
 	uint64_t base_hpa; /**< The host physical address of BAR base */
+	uint64_t mapped_base; /**< The guest physical address where the BAR is mapped in the EPT, 0 if not mapped */
 	uint32_t fixed; /**< The BAR memory type encoding, the low 4bits of a BAR register */
 	uint32_t mask; /**< The BAR mask: BAR register value & ~0FH */
 };
@@ -90,6 +119,46 @@ struct pci_msi {
 	uint32_t caplen; /**< The length of the MSI capability */
 };
 
+/**
+ * @brief Data structure to present one entry of an emulated MSI-X table
+ *
+ * The layout matches the 16-byte MSI-X table entry defined by the PCI spec.
+ *
+ * @consistency N/A
+ * @alignment 8
+ *
+ * @remark N/A
+ */
+struct msix_table_entry {
+	uint64_t addr;           /**< The virtual message address */
+	uint32_t data;           /**< The virtual message data */
+	uint32_t vector_control; /**< The virtual vector control, bit 0 being the per-vector mask */
+};
+
+/**
+ * @brief Data structure to present PCI MSI-X capability information
+ *
+ * For a PCI MSI-X capability, this structure includes its offset and length, the location of the MSI-X table, the
+ * emulated table entries and the guest pages trapped to emulate them.
+ *
+ * @consistency table_count <= CONFIG_MAX_MSIX_TABLE_NUM
+ * @alignment 8
+ *
+ * @remark N/A
+ */
+struct pci_msix {
+	struct msix_table_entry tables[CONFIG_MAX_MSIX_TABLE_NUM]; /**< The emulated MSI-X table entries */
+	uint64_t mmio_gpa;     /**< The GPA of the first trapped page of the MSI-X table, 0 if none is trapped */
+	uint64_t mmio_hpa;     /**< The HPA of the first trapped page of the MSI-X table */
+	uint64_t mmio_size;    /**< The size in bytes of the trapped pages of the MSI-X table */
+	uint32_t capoff;       /**< The offset of the MSI-X capability in PCI configuration space */
+	uint32_t caplen;       /**< The length of the MSI-X capability */
+	uint32_t table_bar;    /**< The index of the BAR where the MSI-X table resides */
+	uint32_t table_offset; /**< The offset of the MSI-X table in its BAR */
+	uint32_t table_size;   /**< The size in bytes of the physical MSI-X table */
+	uint32_t table_count;  /**< The number of the emulated MSI-X table entries */
+};
+
 /**
  * @brief A union data structure to store all the data of a PCI configuration space
  *
@@ -155,6 +224,7 @@ struct pci_vdev {
 	struct pci_bar bar[PCI_BAR_COUNT]; /**< The BARs info of this vPCI device. */
 
 	struct pci_msi msi; /**< The MSI info of this vPCI device. */
+	struct pci_msix msix; /**< The MSI-X info of this vPCI device. */
 
 	struct acrn_vm_pci_dev_config *pci_dev_config; /**< Pointer to corresponding PCI device's vm_config */
 
@@ -196,11 +266,15 @@ struct acrn_vpci {
 	union pci_cfg_addr_reg addr; /**< The MMIO address to access a PCI configuration register */
 	uint32_t pci_vdev_cnt; /**< The total number of the devices included by this vPCI unit */
 	struct pci_vdev pci_vdevs[CONFIG_MAX_PCI_DEV_NUM]; /**< The vPCI devices list */
+	uint64_t vbdf_bitmap[VPCI_BDF_NUM >> 6U]; /**< Bitmap of the vBDFs populated by a vPCI device */
+	uint8_t vbdf_index[VPCI_BDF_NUM]; /**< Index in pci_vdevs of the vPCI device of each populated vBDF */
 };
 
 extern const struct pci_vdev_ops vhostbridge_ops;
+extern const struct pci_vdev_ops ivshmem_ops;
 void vpci_init(struct acrn_vm *vm);
 void vpci_cleanup(struct acrn_vm *vm);
+void vpci_reset(struct acrn_vm *vm);
 
 /**
  * @}
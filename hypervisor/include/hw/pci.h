@@ -55,6 +55,7 @@
 
 #define PCI_BAR_COUNT 0x6U /**< Pre-defined PCI devices BAR count. */
 #define PCI_REGMAX    0xFFU /**< Pre-defined the MAX offset of the PCI configuration space registers. */
+#define PCIE_REGMAX   0xFFFU /**< Pre-defined the MAX offset of the PCI Express extended configuration space registers. */
 #define PCI_HDRMAX    0x3FU /**< Pre-defined the MAX offset of the PCI configuration space header. */
 
 #define PCI_CONFIG_ADDR 0xCF8U /**< Pre-defined the I/O port of PCI configuration address. */
@@ -66,7 +67,11 @@
 #define PCIR_VENDOR          0x00U /**< Pre-defined the offset of vendor ID register in PCI configuration space. */
 #define PCIR_DEVICE          0x02U /**< Pre-defined the offset of device ID register in PCI configuration space. */
 #define PCIR_COMMAND         0x04U /**< Pre-defined the offset of command register in PCI configuration space. */
+#define PCIM_CMD_MEMEN       0x2U /**< Pre-defined the mask used to enable the memory space decoding of a PCI device. */
+#define PCIM_CMD_BUSMASTEN   0x4U /**< Pre-defined the mask used to enable a PCI device to initiate DMA. */
 #define PCIM_CMD_INTXDIS     0x400U /**< Pre-defined the mask used to set disable bit to PCI legacy interrupt. */
+#define PCIR_STATUS          0x06U /**< Pre-defined the offset of status register in PCI configuration space. */
+#define PCIM_STATUS_CAPPRESENT 0x10U /**< Pre-defined the mask used to indicate a capability list is present. */
 #define PCIR_REVID           0x08U /**< Pre-defined the offset of revision ID register in PCI configuration space. */
 #define PCIR_SUBCLASS        0x0AU /**< Pre-defined the offset of subclass ID register in PCI configuration space. */
 #define PCIR_CLASS           0x0BU /**< Pre-defined the offset of class ID register in PCI configuration space. */
@@ -78,6 +83,7 @@
 #define PCIM_BAR_MEM_TYPE    0x06U /**< Pre-defined the mask used to check the MMIO BAR is 32 or 64bits. */
 #define PCIM_BAR_MEM_32      0x00U /**< Pre-defined the mask used to indicate the MMIO BAR is 32bits. */
 #define PCIM_BAR_MEM_64      0x04U /**< Pre-defined the mask used to indicate the MMIO BAR is 64bits. */
+#define PCIM_BAR_MEM_PREFETCH 0x08U /**< Pre-defined the mask used to indicate the MMIO BAR is prefetchable. */
 #define PCIR_CAP_PTR         0x34U /**< Pre-defined the offset of capability register in PCI configuration space. */
 
 #define PCI_BASE_ADDRESS_MEM_MASK (~0x0fUL) /**< Pre-defined the mask used to calculate base address of a MMIO BAR */
@@ -88,6 +94,7 @@
 
 /* Capability Identification Numbers */
 #define PCIY_MSI 0x05U /**< Pre-defined the ID number of MSI capability. */
+#define PCIY_MSIX 0x11U /**< Pre-defined the ID number of MSI-X capability. */
 
 /* PCI Message Signalled Interrupts (MSI) */
 #define PCIR_MSI_CTRL           0x02U /**< Pre-defined the offset of MSI control register within MSI capability */
@@ -97,6 +104,21 @@
 #define PCIR_MSI_ADDR_HIGH      0x8U /**< Pre-defined the offset of high 32bits MSI address register. */
 #define PCIR_MSI_DATA           0x8U /**< Pre-defined the offset of MSI data register within MSI capability */
 #define PCIR_MSI_DATA_64BIT     0xCU /**< Pre-defined the offset of high 32bits MSI data register. */
+
+/* PCI MSI-X */
+#define PCIR_MSIX_CTRL          0x2U /**< Pre-defined the offset of MSI-X control register within MSI-X capability */
+#define PCIR_MSIX_TABLE         0x4U /**< Pre-defined the offset of MSI-X table offset/BIR register */
+#define PCIR_MSIX_PBA           0x8U /**< Pre-defined the offset of MSI-X PBA offset/BIR register */
+#define PCIM_MSIXCTRL_MSIX_ENABLE     0x8000U /**< Pre-defined the mask used to enable/disable MSI-X */
+#define PCIM_MSIXCTRL_FUNCTION_MASK   0x4000U /**< Pre-defined the mask used to mask all vectors of a function */
+#define PCIM_MSIXCTRL_TABLE_SIZE      0x07FFU /**< Pre-defined the mask of "table size - 1" in MSI-X control */
+#define PCIM_MSIX_BIR_MASK      0x7U /**< Pre-defined the mask of the BAR indicator in the table/PBA register */
+#define PCIM_MSIX_VCTRL_MASK    0x1U /**< Pre-defined the mask bit of the vector control of an MSI-X entry */
+#define MSIX_TABLE_ENTRY_SIZE   16U /**< Pre-defined the size in bytes of an MSI-X table entry */
+#define MSIX_ENTRY_ADDR         0x0U /**< Pre-defined the offset of the message address within an MSI-X entry */
+#define MSIX_ENTRY_DATA         0x8U /**< Pre-defined the offset of the message data within an MSI-X entry */
+#define MSIX_ENTRY_VCTRL        0xCU /**< Pre-defined the offset of the vector control within an MSI-X entry */
+
 #define PCIR_INTERRUPT_PIN      0x3DU /**< Pre-defined the offset of Interrupt Pin register. */
 #define PCIR_INTERRUPT_LINE     0x3CU /**< Pre-defined the offset of Interrupt Line register. */
 
@@ -47,6 +47,8 @@
 
 /* Generic VM flags from guest OS */
 #define GUEST_FLAG_HIGHEST_SEVERITY     (1UL << 6U) /**< Whether has the highest severity */
+#define GUEST_FLAG_EPT_AD               (1UL << 7U) /**< Whether EPT accessed and dirty flags are enabled */
+#define GUEST_FLAG_KERNEL_IN_PLACE      (1UL << 8U) /**< Whether the kernel module may be mapped in instead of copied */
 
 /**
  * @brief Representation of a port I/O register access
@@ -87,8 +89,45 @@ struct pio_request {
  *
  * @consistency N/A
  */
+/**
+ * @brief Representation of a MMIO register access
+ *
+ * @consistency N/A
+ *
+ * @alignment 8
+ */
+struct mmio_request {
+	/**
+	 * @brief Direction of the access
+	 *
+	 * Either \p REQUEST_READ or \p REQUEST_WRITE.
+	 */
+	uint32_t direction;
+
+	/**
+	 * @brief Reserved
+	 */
+	uint32_t reserved;
+
+	/**
+	 * @brief Guest physical address of the MMIO access
+	 */
+	uint64_t address;
+
+	/**
+	 * @brief Width of the MMIO access in byte
+	 */
+	uint64_t size;
+
+	/**
+	 * @brief The value read for MMIO reads or to be written for MMIO writes
+	 */
+	uint64_t value;
+} __aligned(8);
+
 union vhm_io_request {
 	struct pio_request pio;  /**< Representation of a port I/O register access */
+	struct mmio_request mmio;  /**< Representation of a MMIO register access */
 };
 
 /**
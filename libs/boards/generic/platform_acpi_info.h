@@ -35,4 +35,11 @@
 #define DRHD1_DEVSCOPE1_BUS  0x0U
 #define DRHD1_DEVSCOPE1_PATH 0xf8U
 
+/* MCFG of ACPI, base 0 means no ECAM region: port 0CF8H/0CFCH is used */
+
+#define MCFG_BASE            0x0UL
+#define MCFG_SEGMENT         0x0U
+#define MCFG_START_BUS       0x0U
+#define MCFG_END_BUS         0x0U
+
 #endif /* PLATFORM_ACPI_INFO_H */
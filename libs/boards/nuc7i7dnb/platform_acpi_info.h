@@ -158,6 +158,27 @@
  */
 #define DRHD1_DEVSCOPE1_PATH 0xf8U
 
+/* MCFG of ACPI */
+
+/**
+ * @brief Base address of the enhanced configuration access mechanism (ECAM) region in the MCFG.
+ *
+ * 0 indicates that the platform reports no MCFG, and PCI configuration space is accessed through port 0CF8H/0CFCH.
+ */
+#define MCFG_BASE            0xE0000000UL
+/**
+ * @brief The PCI Segment associated with the ECAM region.
+ */
+#define MCFG_SEGMENT         0x0U
+/**
+ * @brief The start bus number decoded by the ECAM region.
+ */
+#define MCFG_START_BUS       0x0U
+/**
+ * @brief The end bus number decoded by the ECAM region.
+ */
+#define MCFG_END_BUS         0xFFU
+
 /**
  * @}
  */
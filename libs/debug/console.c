@@ -113,6 +113,9 @@ void console_kick(void)
 	if (get_pcpu_id() == CONSOLE_CPU_ID) {
 		struct acrn_vuart *vu;
 
+		/* Sample the working sets tracked by the HV-Shell */
+		shell_sample_wss();
+
 		/* Kick HV-Shell and Uart-Console tasks */
 		vu = vuart_console_active();
 		if (vu != NULL) {
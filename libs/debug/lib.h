@@ -54,6 +54,7 @@ void console_putc(const char *ch);
 char console_getc(void);
 
 void shell_kick(void);
+void shell_sample_wss(void);
 
 static inline uint64_t vcpu_get_cr2(const struct acrn_vcpu *vcpu)
 {
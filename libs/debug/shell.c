@@ -15,6 +15,12 @@
 #include <cpuid.h>
 #include <ptdev.h>
 #include <vm.h>
+#include <vm_reset.h>
+#include <vm_snapshot.h>
+#include <bulk_mem.h>
+#include <ept.h>
+#include <vtd.h>
+#include <timer.h>
 #include <logmsg.h>
 #include <version.h>
 #include "vuart.h"
@@ -33,6 +39,26 @@ static char shell_log_buf[SHELL_LOG_BUF_SIZE];
 
 static uint64_t save_exception_entry;
 
+/* Working set samples of a VM, harvested from its EPT accessed/dirty flags */
+#define WSS_SAMPLE_NUM		16U
+
+struct wss_sample {
+	uint64_t time_ms;	/* since sampling started */
+	uint64_t interval_ms;	/* since the previous sample */
+	uint64_t accessed;	/* bytes accessed in the interval */
+	uint64_t dirty;		/* bytes written in the interval */
+};
+
+struct wss_tracker {
+	uint64_t period_ms;	/* 0 if not sampling */
+	uint64_t start_tsc;
+	uint64_t last_tsc;
+	uint32_t sample_count;
+	struct wss_sample samples[WSS_SAMPLE_NUM];
+};
+
+static struct wss_tracker wss_trackers[CONFIG_MAX_VM_NUM];
+
 /* Input Line Other - Switch to the "other" input line (there are only two
  * input lines total).
  */
@@ -41,8 +67,15 @@ static uint64_t save_exception_entry;
 static int32_t shell_cmd_help(__unused int32_t argc, __unused char **argv);
 static int32_t shell_version(__unused int32_t argc, __unused char **argv);
 static int32_t shell_list_vm(__unused int32_t argc, __unused char **argv);
+static int32_t shell_restart_vm(int32_t argc, char **argv);
+static int32_t shell_checkpoint_vm(int32_t argc, char **argv);
+static int32_t shell_vm_wss(int32_t argc, char **argv);
+static int32_t shell_bulk_bench(int32_t argc, char **argv);
+static int32_t shell_show_ept_stat(__unused int32_t argc, __unused char **argv);
+static int32_t shell_show_iommu_stat(__unused int32_t argc, __unused char **argv);
 static int32_t shell_list_vcpu(__unused int32_t argc, __unused char **argv);
 static int32_t shell_vcpu_dumpreg(int32_t argc, char **argv);
+static int32_t shell_show_pcpu_stack(__unused int32_t argc, __unused char **argv);
 static int32_t shell_dumpmem(int32_t argc, char **argv);
 static int32_t shell_to_vm_console(int32_t argc, char **argv);
 static int32_t shell_show_ptdev_info(__unused int32_t argc, __unused char **argv);
@@ -74,6 +107,42 @@ static struct shell_cmd shell_cmds[] = {
 		.help_str	= SHELL_CMD_VM_LIST_HELP,
 		.fcn		= shell_list_vm,
 	},
+	{
+		.str		= SHELL_CMD_VM_RESTART,
+		.cmd_param	= SHELL_CMD_VM_RESTART_PARAM,
+		.help_str	= SHELL_CMD_VM_RESTART_HELP,
+		.fcn		= shell_restart_vm,
+	},
+	{
+		.str		= SHELL_CMD_VM_CHECKPOINT,
+		.cmd_param	= SHELL_CMD_VM_CHECKPOINT_PARAM,
+		.help_str	= SHELL_CMD_VM_CHECKPOINT_HELP,
+		.fcn		= shell_checkpoint_vm,
+	},
+	{
+		.str		= SHELL_CMD_VM_WSS,
+		.cmd_param	= SHELL_CMD_VM_WSS_PARAM,
+		.help_str	= SHELL_CMD_VM_WSS_HELP,
+		.fcn		= shell_vm_wss,
+	},
+	{
+		.str		= SHELL_CMD_BULK_BENCH,
+		.cmd_param	= SHELL_CMD_BULK_BENCH_PARAM,
+		.help_str	= SHELL_CMD_BULK_BENCH_HELP,
+		.fcn		= shell_bulk_bench,
+	},
+	{
+		.str		= SHELL_CMD_EPT_STAT,
+		.cmd_param	= SHELL_CMD_EPT_STAT_PARAM,
+		.help_str	= SHELL_CMD_EPT_STAT_HELP,
+		.fcn		= shell_show_ept_stat,
+	},
+	{
+		.str		= SHELL_CMD_IOMMU_STAT,
+		.cmd_param	= SHELL_CMD_IOMMU_STAT_PARAM,
+		.help_str	= SHELL_CMD_IOMMU_STAT_HELP,
+		.fcn		= shell_show_iommu_stat,
+	},
 	{
 		.str		= SHELL_CMD_VCPU_LIST,
 		.cmd_param	= SHELL_CMD_VCPU_LIST_PARAM,
@@ -86,6 +155,12 @@ static struct shell_cmd shell_cmds[] = {
 		.help_str	= SHELL_CMD_VCPU_DUMPREG_HELP,
 		.fcn		= shell_vcpu_dumpreg,
 	},
+	{
+		.str		= SHELL_CMD_PCPU_STACK,
+		.cmd_param	= SHELL_CMD_PCPU_STACK_PARAM,
+		.help_str	= SHELL_CMD_PCPU_STACK_HELP,
+		.fcn		= shell_show_pcpu_stack,
+	},
 	{
 		.str		= SHELL_CMD_DUMPMEM,
 		.cmd_param	= SHELL_CMD_DUMPMEM_PARAM,
@@ -622,6 +697,272 @@ static int32_t shell_list_vm(__unused int32_t argc, __unused char **argv)
 	return 0;
 }
 
+static int32_t shell_restart_vm(int32_t argc, char **argv)
+{
+	int32_t status = 0;
+	uint16_t vm_id;
+	struct acrn_vm *vm;
+
+	/* User input invalidation */
+	if (argc != 2) {
+		shell_puts("Please enter cmd with <vm_id>\r\n");
+		status = -EINVAL;
+	} else {
+		status = strtol_deci(argv[1]);
+		if (status >= 0) {
+			vm_id = sanitize_vmid((uint16_t)status);
+			vm = get_vm_from_vmid(vm_id);
+			if (vm->state != VM_STARTED) {
+				shell_puts("VM is not running\r\n");
+				status = -EINVAL;
+			} else {
+				request_vm_restart(vm);
+				status = 0;
+			}
+		}
+	}
+
+	return status;
+}
+
+static int32_t shell_checkpoint_vm(int32_t argc, char **argv)
+{
+	int32_t status = 0;
+	uint16_t vm_id;
+	struct acrn_vm *vm;
+
+	/* User input invalidation */
+	if (argc != 2) {
+		shell_puts("Please enter cmd with <vm_id>\r\n");
+		status = -EINVAL;
+	} else {
+		status = strtol_deci(argv[1]);
+		if (status >= 0) {
+			vm_id = sanitize_vmid((uint16_t)status);
+			vm = get_vm_from_vmid(vm_id);
+			if (vm->state != VM_STARTED) {
+				shell_puts("VM is not running\r\n");
+				status = -EINVAL;
+			} else {
+				/* Completes before the vCPUs enter the guest again and logs the pages copied */
+				status = take_vm_checkpoint(vm);
+				if (status == -EINVAL) {
+					shell_puts("No valid snapshot memory is reserved for the VM\r\n");
+				} else if (status == -EBUSY) {
+					shell_puts("VM is busy, try again later\r\n");
+				} else {
+					/* Checkpoint started */
+				}
+			}
+		}
+	}
+
+	return status;
+}
+
+static void shell_show_wss(uint16_t vm_id)
+{
+	char temp_str[MAX_STR_SIZE];
+	struct wss_tracker *wss = &wss_trackers[vm_id];
+	const struct wss_sample *sample;
+	uint32_t i, first;
+
+	shell_puts("\r\nTIME(ms)     WSS(KB)      DIRTY(KB)    DIRTY_RATE(KB/s)");
+	shell_puts("\r\n==========   ==========   ==========   ================\r\n");
+
+	first = (wss->sample_count > WSS_SAMPLE_NUM) ? (wss->sample_count - WSS_SAMPLE_NUM) : 0U;
+	for (i = first; i < wss->sample_count; i++) {
+		sample = &wss->samples[i % WSS_SAMPLE_NUM];
+		snprintf(temp_str, MAX_STR_SIZE, "%-10llu   %-10llu   %-10llu   %-16llu\r\n", sample->time_ms,
+			sample->accessed / 1024UL, sample->dirty / 1024UL,
+			((sample->dirty / 1024UL) * 1000UL) / sample->interval_ms);
+		shell_puts(temp_str);
+	}
+}
+
+static int32_t shell_vm_wss(int32_t argc, char **argv)
+{
+	int32_t status = 0;
+	uint16_t vm_id;
+	struct acrn_vm *vm;
+	struct wss_tracker *wss;
+	uint64_t accessed, dirty;
+
+	/* User input invalidation */
+	if ((argc != 2) && (argc != 3)) {
+		shell_puts("Please enter cmd with <vm_id> [<period ms>]\r\n");
+		status = -EINVAL;
+	} else {
+		status = strtol_deci(argv[1]);
+		if (status >= 0) {
+			vm_id = sanitize_vmid((uint16_t)status);
+			vm = get_vm_from_vmid(vm_id);
+			wss = &wss_trackers[vm_id];
+			status = 0;
+			if (!vm->arch_vm.ept_ad) {
+				shell_puts("EPT accessed/dirty flags are not enabled for the VM\r\n");
+				status = -EINVAL;
+			} else if (argc == 2) {
+				shell_show_wss(vm_id);
+			} else {
+				status = strtol_deci(argv[2]);
+				if (status >= 0) {
+					wss->period_ms = (uint64_t)status;
+					wss->sample_count = 0U;
+					wss->start_tsc = rdtsc();
+					wss->last_tsc = wss->start_tsc;
+					/* Drop what was accessed before sampling starts */
+					if ((wss->period_ms != 0UL) && (vm->state == VM_STARTED)) {
+						ept_harvest_ad(vm, &accessed, &dirty);
+					}
+					status = 0;
+				}
+			}
+		}
+	}
+
+	return status;
+}
+
+void shell_sample_wss(void)
+{
+	uint16_t vm_id;
+	struct acrn_vm *vm;
+	struct wss_tracker *wss;
+	struct wss_sample *sample;
+	uint64_t now, interval_ms;
+
+	for (vm_id = 0U; vm_id < CONFIG_MAX_VM_NUM; vm_id++) {
+		wss = &wss_trackers[vm_id];
+		vm = get_vm_from_vmid(vm_id);
+		if ((wss->period_ms == 0UL) || (vm->state != VM_STARTED)) {
+			continue;
+		}
+
+		now = rdtsc();
+		interval_ms = (now - wss->last_tsc) / (uint64_t)get_tsc_khz();
+		if (interval_ms >= wss->period_ms) {
+			sample = &wss->samples[wss->sample_count % WSS_SAMPLE_NUM];
+			ept_harvest_ad(vm, &sample->accessed, &sample->dirty);
+			sample->time_ms = (now - wss->start_tsc) / (uint64_t)get_tsc_khz();
+			sample->interval_ms = interval_ms;
+			wss->sample_count++;
+			wss->last_tsc = now;
+		}
+	}
+}
+
+#define BULK_BENCH_MAX_SIZE	(64UL * 1024UL * 1024UL)
+
+/* Bandwidth in MB/s of an operation on len bytes that took the given TSC ticks */
+static uint64_t bulk_bench_mbps(uint64_t len, uint64_t ticks)
+{
+	uint64_t us = (ticks * 1000UL) / (uint64_t)get_tsc_khz();
+
+	return (us != 0UL) ? (len / us) : 0UL;
+}
+
+static void shell_run_bulk_bench(uint8_t *buf, uint64_t len)
+{
+	char temp_str[MAX_STR_SIZE];
+	uint8_t *src = buf, *dst = buf + len;
+	uint64_t ticks[4] = { 0UL, 0UL, 0UL, 0UL };
+	uint64_t start;
+	uint32_t round;
+
+	/* The first round warms up the TLB and the caches, the second one is reported */
+	for (round = 0U; round < 2U; round++) {
+		start = rdtsc();
+		(void)memcpy_s(dst, len, src, len);
+		ticks[0] = rdtsc() - start;
+
+		start = rdtsc();
+		bulk_copy(dst, src, len);
+		ticks[1] = rdtsc() - start;
+
+		start = rdtsc();
+		(void)memset(dst, 0U, len);
+		ticks[2] = rdtsc() - start;
+
+		start = rdtsc();
+		bulk_clear(dst, len);
+		ticks[3] = rdtsc() - start;
+	}
+
+	snprintf(temp_str, MAX_STR_SIZE, "\r\nSIZE: %llu KB, BULK KERNEL: %s\r\n", len / 1024UL, get_bulk_kernel());
+	shell_puts(temp_str);
+	shell_puts("\r\nOP      ERMS(MB/s)   BULK(MB/s)");
+	shell_puts("\r\n=====   ==========   ==========\r\n");
+	snprintf(temp_str, MAX_STR_SIZE, "copy    %-10llu   %-10llu\r\n",
+		bulk_bench_mbps(len, ticks[0]), bulk_bench_mbps(len, ticks[1]));
+	shell_puts(temp_str);
+	snprintf(temp_str, MAX_STR_SIZE, "clear   %-10llu   %-10llu\r\n",
+		bulk_bench_mbps(len, ticks[2]), bulk_bench_mbps(len, ticks[3]));
+	shell_puts(temp_str);
+}
+
+static int32_t shell_bulk_bench(int32_t argc, char **argv)
+{
+	int32_t status = 0;
+	struct acrn_vm *vm;
+	uint64_t size = 0UL, len;
+	void *buf;
+
+	/* User input invalidation */
+	if (argc != 2) {
+		shell_puts("Please enter cmd with <vm_id>\r\n");
+		status = -EINVAL;
+	} else {
+		status = strtol_deci(argv[1]);
+		if (status >= 0) {
+			vm = get_vm_from_vmid(sanitize_vmid((uint16_t)status));
+			buf = lend_vm_snapshot_memory(vm, &size);
+			if (buf == NULL) {
+				shell_puts("No snapshot memory of the VM can be used now, it may keep a snapshot\r\n");
+				status = -EINVAL;
+			} else {
+				/* Copy between the two halves of the scratch memory */
+				len = ((size / 2UL) < BULK_BENCH_MAX_SIZE) ? (size / 2UL) : BULK_BENCH_MAX_SIZE;
+				shell_run_bulk_bench((uint8_t *)buf, len & PAGE_MASK);
+				reclaim_vm_snapshot_memory(vm);
+				status = 0;
+			}
+		}
+	}
+
+	return status;
+}
+
+static int32_t shell_show_ept_stat(__unused int32_t argc, __unused char **argv)
+{
+	char temp_str[MAX_STR_SIZE];
+	struct acrn_vm *vm;
+	uint16_t vm_id;
+
+	shell_puts("\r\nVM_ID EXEC_EPT_VIOLATIONS");
+	shell_puts("\r\n===== ====================\r\n");
+
+	for (vm_id = 0U; vm_id < CONFIG_MAX_VM_NUM; vm_id++) {
+		vm = get_vm_from_vmid(vm_id);
+		if (vm->state != VM_POWERED_OFF) {
+			snprintf(temp_str, MAX_STR_SIZE, "   %-3d %-20llu\r\n", vm_id, vm->exe_ept_violations);
+			shell_puts(temp_str);
+		}
+	}
+
+	return 0;
+}
+
+static int32_t shell_show_iommu_stat(__unused int32_t argc, __unused char **argv)
+{
+	char temp_str[MAX_STR_SIZE];
+
+	snprintf(temp_str, MAX_STR_SIZE, "\r\nIOMMU cache flushes avoided: %llu\r\n", iommu_get_flushes_avoided());
+	shell_puts(temp_str);
+
+	return 0;
+}
+
 static int32_t shell_list_vcpu(__unused int32_t argc, __unused char **argv)
 {
 	char temp_str[MAX_STR_SIZE];
@@ -792,6 +1133,36 @@ out:
 	return status;
 }
 
+static int32_t shell_show_pcpu_stack(__unused int32_t argc, __unused char **argv)
+{
+	char temp_str[MAX_STR_SIZE];
+	const uint64_t *stack;
+	uint16_t pcpu_id;
+	uint32_t i;
+
+	shell_puts("\r\nPCPU_ID STACK_SIZE MAX_USED");
+	shell_puts("\r\n======= ========== ==========\r\n");
+
+	for (pcpu_id = 0U; pcpu_id < get_pcpu_nums(); pcpu_id++) {
+		/*
+		 * The stacks are cleared together with the BSS at boot and grow
+		 * downwards, so the lowest non-zero qword marks the deepest use.
+		 */
+		stack = (const uint64_t *)per_cpu(stack, pcpu_id);
+		for (i = 0U; i < (PCPU_STACK_SIZE / sizeof(uint64_t)); i++) {
+			if (stack[i] != 0UL) {
+				break;
+			}
+		}
+
+		snprintf(temp_str, MAX_STR_SIZE, "   %-4hu 0x%-8x 0x%-8x\r\n", pcpu_id, PCPU_STACK_SIZE,
+			PCPU_STACK_SIZE - (i * sizeof(uint64_t)));
+		shell_puts(temp_str);
+	}
+
+	return 0;
+}
+
 #define MAX_MEMDUMP_LEN		(32U * 8U)
 static int32_t shell_dumpmem(int32_t argc, char **argv)
 {
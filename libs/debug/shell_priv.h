@@ -48,6 +48,33 @@ struct shell {
 #define SHELL_CMD_VM_LIST_PARAM		NULL
 #define SHELL_CMD_VM_LIST_HELP		"List all VMs, displaying the VM ID, name and state"
 
+#define SHELL_CMD_VM_RESTART		"vm_restart"
+#define SHELL_CMD_VM_RESTART_PARAM	"<vm id>"
+#define SHELL_CMD_VM_RESTART_HELP	"Restart a VM in place, without taking its pCPUs offline"
+
+#define SHELL_CMD_VM_CHECKPOINT		"vm_checkpoint"
+#define SHELL_CMD_VM_CHECKPOINT_PARAM	"<vm id>"
+#define SHELL_CMD_VM_CHECKPOINT_HELP	"Checkpoint a VM into its reserved snapshot memory, copying only the pages "\
+	"dirty since the previous checkpoint if EPT accessed/dirty flags are enabled. vm_restart rolls back to it"
+
+#define SHELL_CMD_VM_WSS		"vm_wss"
+#define SHELL_CMD_VM_WSS_PARAM		"<vm id> [<period ms>]"
+#define SHELL_CMD_VM_WSS_HELP		"Sample the working set and dirty rate of a VM every <period ms> (0 to stop) "\
+	"with EPT accessed/dirty flags, or show the latest samples if no period is given"
+
+#define SHELL_CMD_BULK_BENCH		"bulk_bench"
+#define SHELL_CMD_BULK_BENCH_PARAM	"<vm id>"
+#define SHELL_CMD_BULK_BENCH_HELP	"Compare bulk copy/clear bandwidth against rep movsb/stosb, using the snapshot "\
+	"memory reserved for a VM as scratch memory while it keeps no snapshot. Stalls this pCPU for a while"
+
+#define SHELL_CMD_EPT_STAT		"ept_stat"
+#define SHELL_CMD_EPT_STAT_PARAM	NULL
+#define SHELL_CMD_EPT_STAT_HELP		"Show the number of EPT violations caused by instruction fetches in each VM"
+
+#define SHELL_CMD_IOMMU_STAT		"iommu_stat"
+#define SHELL_CMD_IOMMU_STAT_PARAM	NULL
+#define SHELL_CMD_IOMMU_STAT_HELP	"Show the number of IOMMU cache flushes skipped thanks to page-walk coherency"
+
 #define SHELL_CMD_VCPU_LIST		"vcpu_list"
 #define SHELL_CMD_VCPU_LIST_PARAM	NULL
 #define SHELL_CMD_VCPU_LIST_HELP	"List all vCPUs in all VMs"
@@ -56,6 +83,10 @@ struct shell {
 #define SHELL_CMD_VCPU_DUMPREG_PARAM	"<vm id, vcpu id>"
 #define SHELL_CMD_VCPU_DUMPREG_HELP	"Dump registers for a specific vCPU"
 
+#define SHELL_CMD_PCPU_STACK		"pcpu_stack"
+#define SHELL_CMD_PCPU_STACK_PARAM	NULL
+#define SHELL_CMD_PCPU_STACK_HELP	"Show the size and the high-water mark of the normal stack of each pCPU"
+
 #define SHELL_CMD_DUMPMEM		"dumpmem"
 #define SHELL_CMD_DUMPMEM_PARAM		"<addr, length>"
 #define SHELL_CMD_DUMPMEM_HELP		"Dump host memory, starting at a given address, and for a given length (in "\
@@ -49,6 +49,12 @@ struct acrn_vm_pci_dev_config vm0_pci_devs[VM0_CONFIG_PCI_DEV_NUM] = {
 		 **/
 		VM0_NETWORK_CONTROLLER
 	},
+	{
+		.emu_type = PCI_DEV_TYPE_HVEMUL, /**< Emulated by hypervisor */
+		.vbdf.bits = { .b = 0x00U, .d = 0x02U, .f = 0x00U }, /**< Virtual address of ivshmem device */
+		.vdev_ops = &ivshmem_ops, /**< Callback functions for ivshmem device */
+		IVSHMEM_DEVICE /**< Memory shared with VM1 */
+	},
 };
 
 /**
@@ -72,6 +78,12 @@ struct acrn_vm_pci_dev_config vm1_pci_devs[VM1_CONFIG_PCI_DEV_NUM] = {
 		 **/
 		VM1_STORAGE_CONTROLLER
 	},
+	{
+		.emu_type = PCI_DEV_TYPE_HVEMUL, /**< Emulated by hypervisor */
+		.vbdf.bits = { .b = 0x00U, .d = 0x02U, .f = 0x00U }, /**< Virtual address of ivshmem device */
+		.vdev_ops = &ivshmem_ops, /**< Callback functions for ivshmem device */
+		IVSHMEM_DEVICE /**< Memory shared with VM0 */
+	},
 };
 
 /**
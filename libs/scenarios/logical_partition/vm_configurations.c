@@ -49,6 +49,7 @@ struct acrn_vm_config vm_configs[CONFIG_MAX_VM_NUM] = {
 		.memory = { /**< Memory information of guest VM */
 			.start_hpa = VM0_CONFIG_MEM_START_HPA, /**< Start host physical address */
 			.size = VM0_CONFIG_MEM_SIZE, /**< Size of memory in bytes */
+			.snapshot_hpa = VM0_CONFIG_MEM_SNAPSHOT_HPA, /**< Start HPA of the golden snapshot */
 		},
 		.os_config = { /**< Configurations of guest kernel */
 			.name = "Zephyr", /**< Name of guest OS */
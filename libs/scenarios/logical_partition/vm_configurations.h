@@ -38,6 +38,7 @@
 
 #define VM0_CONFIG_MEM_START_HPA      0x100000000UL /**< Start host physical address of VM0 */
 #define VM0_CONFIG_MEM_SIZE           0x20000000UL /**< Memory size in bytes of VM0 */
+#define VM0_CONFIG_MEM_SNAPSHOT_HPA   0x160000000UL /**< Start host physical address of the golden snapshot of VM0 */
 
 
 #define VM1_CONFIG_VCPU_AFFINITY \
@@ -52,10 +53,21 @@
 #define VM1_CONFIG_OS_BOOTARG_CONSOLE "console=ttyS0 " /**< 'console' type in bootargs of VM1 */
 
 #define VM0_NETWORK_CONTROLLER ETHERNET_CONTROLLER /**< Network controller device of VM0 */
-#define VM0_CONFIG_PCI_DEV_NUM 2U /**< Number of PCI device for VM0 */
+#define VM0_CONFIG_PCI_DEV_NUM 3U /**< Number of PCI device for VM0 */
 
 #define VM1_STORAGE_CONTROLLER USB_CONTROLLER /**< Mass Storage controller device of VM1 */
-#define VM1_CONFIG_PCI_DEV_NUM 2U /**< Number of PCI device for VM1 */
+#define VM1_CONFIG_PCI_DEV_NUM 3U /**< Number of PCI device for VM1 */
+
+#define IVSHMEM_SHM_HPA       0x180000000UL /**< Start host physical address of the memory shared by VM0 and VM1 */
+#define IVSHMEM_SHM_SIZE      0x200000UL /**< Size in bytes of the memory shared by VM0 and VM1 */
+
+/**
+ * @brief Shared memory and virtual BAR configuration of the ivshmem device of VM0 and VM1.
+ *
+ * The registers are at port 1800H and the shared memory at GPA DF800000H in both VMs.
+ */
+#define IVSHMEM_DEVICE .shm_hpa = IVSHMEM_SHM_HPA, .shm_size = IVSHMEM_SHM_SIZE, \
+	.vbar_base[0] = 0x1800UL, .vbar_base[2] = 0xdf800000UL
 
 /**
  * @}
@@ -19,6 +19,35 @@ $(C_CODESCAN): %.c.codescan: %.c $(VERSION) $(HV_OBJDIR)/$(HV_CONFIG_H) $(TARGET
 	@echo "CODESCAN" $*.c
 	@clang-tidy $< -header-filter=.* --checks=-*,acrn-c-* -- $(patsubst %, -I%, $(INCLUDE_PATH)) -I. $(filter-out -m%,$(CFLAGS) $(ARCH_CFLAGS)) >> $(TMP_SCAN_OUT) 2>>$(TMP_SCAN_ERR) | true
 
+# Host-side property test and benchmark of arch/x86/pagetable.c, built with the host toolchain
+HOST_PT_DIR := ../libs/testing/pagetable
+HOST_PT_OBJDIR := $(HV_OBJDIR)/testing/pagetable
+HOST_PT_BIN := $(HOST_PT_OBJDIR)/pagetable_host
+PT_SEED ?= 0x5eed
+PT_OPS ?= 4096
+HOST_PT_CFLAGS := -O2 -g -Wall -W -Werror -fsigned-char -fno-common
+HOST_PT_HV_CFLAGS := $(HOST_PT_CFLAGS) -ffreestanding -fshort-wchar -nostdinc
+HOST_PT_HV_CFLAGS += $(patsubst %, -I%, $(INCLUDE_PATH)) -I. -include include/config.h -include bsp.h
+
+$(HOST_PT_OBJDIR)/pagetable.o: arch/x86/pagetable.c
+	@mkdir -p $(dir $@)
+	$(CC) $(HOST_PT_HV_CFLAGS) -c $< -o $@
+
+$(HOST_PT_OBJDIR)/host_pt_ops.o: $(HOST_PT_DIR)/host_pt_ops.c $(HOST_PT_DIR)/host_pt.h
+	@mkdir -p $(dir $@)
+	$(CC) $(HOST_PT_HV_CFLAGS) -c $< -o $@
+
+$(HOST_PT_OBJDIR)/host_pt_test.o: $(HOST_PT_DIR)/host_pt_test.c $(HOST_PT_DIR)/host_pt.h
+	@mkdir -p $(dir $@)
+	$(CC) $(HOST_PT_CFLAGS) -c $< -o $@
+
+$(HOST_PT_BIN): $(HOST_PT_OBJDIR)/pagetable.o $(HOST_PT_OBJDIR)/host_pt_ops.o $(HOST_PT_OBJDIR)/host_pt_test.o
+	$(CC) $^ -o $@
+
+.PHONY: pagetable-host
+pagetable-host: $(HOST_PT_BIN)
+	$(HOST_PT_BIN) $(PT_SEED) $(PT_OPS)
+
 ifdef QEMU
 
 ZEPHYR_DIR := ../../zephyrproject
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2019 Intel Corporation. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Interface between the host-side page table harness (built against libc) and
+ * the glue layer that drives the unmodified arch/x86/pagetable.c (built
+ * against the hypervisor headers). Only plain C types cross this boundary as
+ * the two sides do not agree on the definition of types like size_t.
+ */
+
+#ifndef HOST_PT_H
+#define HOST_PT_H
+
+/* Access rights and memory type in the abstract form used by the harness. */
+#define HOST_PT_R	(1UL << 0U)
+#define HOST_PT_W	(1UL << 1U)
+#define HOST_PT_X	(1UL << 2U)
+#define HOST_PT_UC	(1UL << 3U)	/* uncached; write-back if not set */
+
+/* Guest physical space covered by the page tables, which are statically indexed by address as in a VM's EPT. */
+#define HOST_PT_SPACE	(4UL << 30U)
+
+/* Provided by the harness: return num contiguous 4 KB aligned pages below 4 GB. */
+void *host_pt_alloc_pages(unsigned long num);
+
+/* Provided by the glue layer. */
+void host_pt_reset(int large_page_enabled, int tweak_exe_right);
+void host_pt_add(unsigned long hpa, unsigned long gpa, unsigned long size, unsigned long prot);
+void host_pt_modify(unsigned long gpa, unsigned long size, unsigned long prot_set, unsigned long prot_clr);
+void host_pt_del(unsigned long gpa, unsigned long size);
+int host_pt_lookup(unsigned long gpa, unsigned long *hpa, unsigned long *prot, unsigned long *pg_size);
+unsigned long host_pt_fatal_count(void);
+
+#endif /* HOST_PT_H */
@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2019 Intel Corporation. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Glue layer of the host-side page table harness. It provides an EPT flavored
+ * memory_ops whose paging structures are indexed by guest physical address,
+ * as ept_get_pt_page and friends do, and the few hypervisor symbols
+ * pagetable.c depends on, and wraps mmu_add/mmu_modify_or_del/lookup_address
+ * with plain types.
+ */
+
+#include <types.h>
+#include <rtl.h>
+#include <acrn_hv_defs.h>
+#include <page.h>
+#include <pgtable.h>
+#include <mmu.h>
+#include <logmsg.h>
+#include "host_pt.h"
+
+static union pgtable_pages_info host_pages_info;
+static struct memory_ops host_mem_ops;
+static uint64_t *host_pml4_page;
+static uint64_t fatal_count;
+
+static uint64_t host_get_default_access_right(void)
+{
+	return EPT_RWX;
+}
+
+static uint64_t host_pgentry_present(uint64_t pte)
+{
+	return pte & EPT_RWX;
+}
+
+static struct page *host_get_pml4_page(const union pgtable_pages_info *info)
+{
+	struct page *pml4_page = info->ept.nworld_pml4_base;
+
+	(void)memset(pml4_page, 0U, PAGE_SIZE);
+	return pml4_page;
+}
+
+static struct page *host_get_pdpt_page(const union pgtable_pages_info *info, uint64_t gpa)
+{
+	struct page *pdpt_page = info->ept.nworld_pdpt_base + (gpa >> PML4E_SHIFT);
+
+	(void)memset(pdpt_page, 0U, PAGE_SIZE);
+	return pdpt_page;
+}
+
+static struct page *host_get_pd_page(const union pgtable_pages_info *info, uint64_t gpa)
+{
+	struct page *pd_page = info->ept.nworld_pd_base + (gpa >> PDPTE_SHIFT);
+
+	(void)memset(pd_page, 0U, PAGE_SIZE);
+	return pd_page;
+}
+
+static struct page *host_get_pt_page(const union pgtable_pages_info *info, uint64_t gpa)
+{
+	struct page *pt_page = info->ept.nworld_pt_base + (gpa >> PDE_SHIFT);
+
+	(void)memset(pt_page, 0U, PAGE_SIZE);
+	return pt_page;
+}
+
+static void host_clflush_pagewalk(__unused const void *entry)
+{
+}
+
+static void host_tweak_exe_right(uint64_t *prot)
+{
+	*prot &= ~EPT_EXE;
+}
+
+static void host_recover_exe_right(uint64_t *prot)
+{
+	*prot |= EPT_EXE;
+}
+
+static void host_nop_exe_right(__unused uint64_t *prot)
+{
+}
+
+static void host_flush_merged(__unused const union pgtable_pages_info *info, __unused uint64_t vaddr,
+	__unused uint64_t size)
+{
+}
+
+static uint64_t to_ept_prot(unsigned long prot)
+{
+	uint64_t ept_prot = prot & EPT_RWX;
+
+	ept_prot |= ((prot & HOST_PT_UC) != 0UL) ? EPT_UNCACHED : EPT_WB;
+	return ept_prot;
+}
+
+void host_pt_reset(int large_page_enabled, int tweak_exe_right)
+{
+	if (host_pages_info.ept.nworld_pml4_base == NULL) {
+		host_pages_info.ept.nworld_pml4_base = (struct page *)host_pt_alloc_pages(PML4_PAGE_NUM);
+		host_pages_info.ept.nworld_pdpt_base = (struct page *)host_pt_alloc_pages(PDPT_PAGE_NUM(HOST_PT_SPACE));
+		host_pages_info.ept.nworld_pd_base = (struct page *)host_pt_alloc_pages(PD_PAGE_NUM(HOST_PT_SPACE));
+		host_pages_info.ept.nworld_pt_base = (struct page *)host_pt_alloc_pages(PT_PAGE_NUM(HOST_PT_SPACE));
+	}
+
+	host_mem_ops.info = &host_pages_info;
+	host_mem_ops.large_page_enabled = (large_page_enabled != 0);
+	host_mem_ops.get_default_access_right = host_get_default_access_right;
+	host_mem_ops.pgentry_present = host_pgentry_present;
+	host_mem_ops.get_pml4_page = host_get_pml4_page;
+	host_mem_ops.get_pdpt_page = host_get_pdpt_page;
+	host_mem_ops.get_pd_page = host_get_pd_page;
+	host_mem_ops.get_pt_page = host_get_pt_page;
+	host_mem_ops.clflush_pagewalk = host_clflush_pagewalk;
+	host_mem_ops.tweak_exe_right = (tweak_exe_right != 0) ? host_tweak_exe_right : host_nop_exe_right;
+	host_mem_ops.recover_exe_right = (tweak_exe_right != 0) ? host_recover_exe_right : host_nop_exe_right;
+	host_mem_ops.flush_merged = host_flush_merged;
+
+	host_pml4_page = (uint64_t *)host_mem_ops.get_pml4_page(host_mem_ops.info);
+	/*
+	 * mmu_modify_or_del expects the PML4E of the range to be present, as it
+	 * always is for a VM's EPT, so populate the first one up front.
+	 */
+	mmu_add(host_pml4_page, 0UL, 0UL, PAGE_SIZE, EPT_RD, &host_mem_ops);
+	mmu_modify_or_del(host_pml4_page, 0UL, PAGE_SIZE, 0UL, 0UL, &host_mem_ops, MR_DEL);
+	fatal_count = 0UL;
+}
+
+void host_pt_add(unsigned long hpa, unsigned long gpa, unsigned long size, unsigned long prot)
+{
+	mmu_add(host_pml4_page, hpa, gpa, size, to_ept_prot(prot), &host_mem_ops);
+}
+
+void host_pt_modify(unsigned long gpa, unsigned long size, unsigned long prot_set, unsigned long prot_clr)
+{
+	uint64_t set = prot_set & EPT_RWX;
+	uint64_t clr = prot_clr & EPT_RWX;
+
+	if (((prot_set | prot_clr) & HOST_PT_UC) != 0UL) {
+		set |= ((prot_set & HOST_PT_UC) != 0UL) ? EPT_UNCACHED : EPT_WB;
+		clr |= EPT_MT_MASK;
+	}
+	mmu_modify_or_del(host_pml4_page, gpa, size, set, clr, &host_mem_ops, MR_MODIFY);
+}
+
+void host_pt_del(unsigned long gpa, unsigned long size)
+{
+	mmu_modify_or_del(host_pml4_page, gpa, size, 0UL, 0UL, &host_mem_ops, MR_DEL);
+}
+
+int host_pt_lookup(unsigned long gpa, unsigned long *hpa, unsigned long *prot, unsigned long *pg_size)
+{
+	const uint64_t *pgentry;
+	uint64_t size = 0UL;
+	int ret = 0;
+
+	pgentry = lookup_address(host_pml4_page, gpa, &size, &host_mem_ops);
+	if (pgentry != NULL) {
+		*hpa = ((*pgentry) & MAXPHYADDR_MASK & ~(size - 1UL)) | (gpa & (size - 1UL));
+		*prot = (*pgentry) & EPT_RWX;
+		if (((*pgentry) & EPT_MT_MASK) == EPT_UNCACHED) {
+			*prot |= HOST_PT_UC;
+		}
+		*pg_size = size;
+		ret = 1;
+	}
+
+	return ret;
+}
+
+unsigned long host_pt_fatal_count(void)
+{
+	return fatal_count;
+}
+
+/* Hypervisor symbols referenced by pagetable.c */
+
+void sanitize_pte_entry(uint64_t *ptep, const struct memory_ops *mem_ops)
+{
+	set_pgentry(ptep, 0UL, mem_ops);
+}
+
+void sanitize_pte(uint64_t *pt_page, const struct memory_ops *mem_ops)
+{
+	uint64_t i;
+
+	for (i = 0UL; i < PTRS_PER_PTE; i++) {
+		sanitize_pte_entry(pt_page + i, mem_ops);
+	}
+}
+
+void do_logmsg(uint32_t severity, __unused const char *fmt, ...)
+{
+	if (severity == LOG_FATAL) {
+		fatal_count++;
+	}
+}
@@ -0,0 +1,326 @@
+/*
+ * Copyright (C) 2019 Intel Corporation. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * Host-side property test and benchmark for arch/x86/pagetable.c.
+ *
+ * The property test runs randomized add/modify/delete sequences on a 4 GB
+ * guest physical window and checks every translation against a flat
+ * reference map kept at 4 KB granularity, with and without large pages and
+ * with and without the execute permission of large pages tweaked. The
+ * benchmark measures the rate of
+ * a VM construction workload (map the RAM with large pages and punch a few
+ * holes) and of a BAR remap workload (delete, re-add and retype a small MMIO
+ * range).
+ *
+ * Usage: pagetable_host [seed] [ops]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include "host_pt.h"
+
+#define PAGE_SZ		0x1000UL
+#define SZ_2M		0x200000UL
+#define SZ_1G		0x40000000UL
+
+#define WIN_SIZE	HOST_PT_SPACE
+#define WIN_PAGES	(WIN_SIZE / PAGE_SZ)
+#define HPA_BASE	(8UL * SZ_1G)
+
+#define ARENA_PAGES	4096UL
+#define FULL_CHECK_INTERVAL	64UL
+
+static uint8_t *arena;
+static unsigned long arena_next;
+static int exe_tweaked;
+
+/* reference map: hpa per 4 KB page and abstract prot, 0 prot means not mapped */
+static uint64_t *ref_hpa;
+static uint8_t *ref_prot;
+
+static uint64_t rng_state;
+
+/* The paging structures are carved out once and reused, being indexed by address. */
+void *host_pt_alloc_pages(unsigned long num)
+{
+	void *pages;
+
+	if ((arena_next + num) > ARENA_PAGES) {
+		fprintf(stderr, "page arena exhausted\n");
+		exit(2);
+	}
+	pages = arena + (arena_next * PAGE_SZ);
+	arena_next += num;
+	return pages;
+}
+
+static void reset(int large_page_enabled, int tweak_exe_right)
+{
+	exe_tweaked = tweak_exe_right;
+	host_pt_reset(large_page_enabled, tweak_exe_right);
+	memset(ref_prot, 0, WIN_PAGES);
+}
+
+static uint64_t rnd(void)
+{
+	/* xorshift64* */
+	rng_state ^= rng_state >> 12U;
+	rng_state ^= rng_state << 25U;
+	rng_state ^= rng_state >> 27U;
+	return rng_state * 0x2545F4914F6CDD1DUL;
+}
+
+/* Pick a range inside the window, biased towards large page friendly ones. */
+static void rnd_range(uint64_t *gpa, uint64_t *size)
+{
+	uint64_t gran, units, r = rnd() % 10UL;
+
+	if (r < 2UL) {
+		gran = SZ_1G;
+		units = 1UL + (rnd() % 2UL);
+	} else if (r < 6UL) {
+		gran = SZ_2M;
+		units = 1UL + (rnd() % 8UL);
+	} else {
+		gran = PAGE_SZ;
+		units = 1UL + (rnd() % 1024UL);
+	}
+
+	*gpa = (rnd() % (WIN_SIZE / gran)) * gran;
+	*size = units * gran;
+	/* occasionally misalign an otherwise large range */
+	if ((gran != PAGE_SZ) && ((rnd() % 4UL) == 0UL)) {
+		*gpa += (1UL + (rnd() % 511UL)) * PAGE_SZ;
+	}
+	if ((*gpa + *size) > WIN_SIZE) {
+		*size = WIN_SIZE - *gpa;
+	}
+}
+
+static unsigned long rnd_rights(void)
+{
+	static const unsigned long rights[] = {
+		HOST_PT_R, HOST_PT_R | HOST_PT_W, HOST_PT_R | HOST_PT_X, HOST_PT_R | HOST_PT_W | HOST_PT_X,
+	};
+	unsigned long prot = rights[rnd() % 4UL];
+
+	if ((rnd() % 4UL) == 0UL) {
+		prot |= HOST_PT_UC;
+	}
+	/* splitting a tweaked large page recovers the execute permission, so it must have been granted */
+	if (exe_tweaked != 0) {
+		prot |= HOST_PT_X;
+	}
+	return prot;
+}
+
+static void op_add(void)
+{
+	uint64_t gpa, size, hpa, i;
+	unsigned long prot = rnd_rights();
+
+	rnd_range(&gpa, &size);
+	/* keep the large page alignment of gpa most of the time */
+	hpa = HPA_BASE + gpa + (((rnd() % 2UL) == 0UL) ? 0UL : ((rnd() % 512UL) * PAGE_SZ));
+
+	host_pt_del(gpa, size);
+	host_pt_add(hpa, gpa, size, prot);
+	for (i = 0UL; i < (size / PAGE_SZ); i++) {
+		ref_hpa[(gpa / PAGE_SZ) + i] = hpa + (i * PAGE_SZ);
+		ref_prot[(gpa / PAGE_SZ) + i] = (uint8_t)prot;
+	}
+}
+
+static void op_modify(void)
+{
+	uint64_t gpa, size, i;
+	unsigned long set, clr, idx;
+
+	rnd_range(&gpa, &size);
+	/* read permission is never cleared, an EPT entry without RWX is not present */
+	set = rnd() & (HOST_PT_W | HOST_PT_X | HOST_PT_UC);
+	clr = rnd() & (HOST_PT_W | HOST_PT_X | HOST_PT_UC) & ~set;
+	/* nor is the execute permission changed once it is tweaked on large pages */
+	if (exe_tweaked != 0) {
+		set &= ~HOST_PT_X;
+		clr &= ~HOST_PT_X;
+	}
+
+	host_pt_modify(gpa, size, set, clr);
+	for (i = 0UL; i < (size / PAGE_SZ); i++) {
+		idx = (gpa / PAGE_SZ) + i;
+		if (ref_prot[idx] != 0U) {
+			ref_prot[idx] = (uint8_t)((ref_prot[idx] & ~clr) | set);
+		}
+	}
+}
+
+static void op_del(void)
+{
+	uint64_t gpa, size;
+
+	rnd_range(&gpa, &size);
+	host_pt_del(gpa, size);
+	memset(ref_prot + (gpa / PAGE_SZ), 0, size / PAGE_SZ);
+}
+
+static int check_page(uint64_t idx)
+{
+	unsigned long hpa, prot, pg_size, expected;
+	int present = host_pt_lookup(idx * PAGE_SZ, &hpa, &prot, &pg_size);
+
+	if (present != (ref_prot[idx] != 0U)) {
+		printf("gpa 0x%lx: present %d, expected %d\n", idx * PAGE_SZ, present, ref_prot[idx] != 0U);
+		return -1;
+	}
+	/* large pages never keep the execute permission when it is tweaked */
+	expected = ref_prot[idx];
+	if ((exe_tweaked != 0) && (pg_size != PAGE_SZ)) {
+		expected &= ~HOST_PT_X;
+	}
+	if ((present != 0) && ((hpa != ref_hpa[idx]) || (prot != expected))) {
+		printf("gpa 0x%lx: hpa 0x%lx prot 0x%lx (%lx page), expected hpa 0x%lx prot 0x%lx\n",
+			idx * PAGE_SZ, hpa, prot, pg_size, ref_hpa[idx], expected);
+		return -1;
+	}
+	return 0;
+}
+
+static int check_all(void)
+{
+	uint64_t idx;
+
+	for (idx = 0UL; idx < WIN_PAGES; idx++) {
+		if (check_page(idx) != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int property_test(int large_page_enabled, int tweak_exe_right, unsigned long ops)
+{
+	unsigned long n, r;
+
+	reset(large_page_enabled, tweak_exe_right);
+	for (n = 1UL; n <= ops; n++) {
+		r = rnd() % 10UL;
+		if (r < 4UL) {
+			op_add();
+		} else if (r < 8UL) {
+			op_modify();
+		} else {
+			op_del();
+		}
+
+		if (host_pt_fatal_count() != 0UL) {
+			printf("op %lu: fatal error reported by pagetable.c\n", n);
+			return -1;
+		}
+		if (((n % FULL_CHECK_INTERVAL) == 0UL) || (n == ops)) {
+			if (check_all() != 0) {
+				printf("op %lu: mismatch (large pages %s, exe tweak %s)\n", n,
+					large_page_enabled ? "on" : "off", tweak_exe_right ? "on" : "off");
+				return -1;
+			}
+		}
+	}
+
+	printf("property: %lu ops, large pages %s, exe tweak %s: PASS\n", ops,
+		large_page_enabled ? "on" : "off", tweak_exe_right ? "on" : "off");
+	return 0;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+}
+
+/* Map 2 GB of RAM plus a 256 MB MMIO window, then punch low memory holes. */
+static void vm_construct(void)
+{
+	reset(1, 0);
+	host_pt_add(HPA_BASE, 0UL, 2UL * SZ_1G, HOST_PT_R | HOST_PT_W | HOST_PT_X);
+	host_pt_add(0xE0000000UL, 0xE0000000UL, 0x10000000UL, HOST_PT_R | HOST_PT_W | HOST_PT_UC);
+	host_pt_del(0xA0000UL, 0x60000UL);
+	host_pt_del(0x7F000000UL, 0x100000UL);
+	host_pt_modify(0xF0000UL, 0x10000UL, 0UL, HOST_PT_W);
+}
+
+static void bar_remap(uint64_t bar)
+{
+	host_pt_del(bar, 0x4000UL);
+	host_pt_add(0xE0000000UL + bar, bar, 0x4000UL, HOST_PT_R | HOST_PT_W | HOST_PT_UC);
+	host_pt_modify(bar, 0x4000UL, HOST_PT_W, 0UL);
+}
+
+static void benchmark(void)
+{
+	unsigned long n, iters = 2000UL;
+	double t;
+
+	t = now();
+	for (n = 0UL; n < iters; n++) {
+		vm_construct();
+	}
+	t = now() - t;
+	printf("bench: vm construction  %10.0f ops/s\n", (double)iters / t);
+
+	vm_construct();
+	iters = 200000UL;
+	t = now();
+	for (n = 0UL; n < iters; n++) {
+		bar_remap(0xE0000000UL + ((n % 64UL) * 0x100000UL));
+	}
+	t = now() - t;
+	printf("bench: bar remap        %10.0f ops/s\n", (double)iters / t);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long ops = 4096UL;
+	int large, tweak, ret = 0;
+
+	rng_state = (argc > 1) ? strtoull(argv[1], NULL, 0) : 0x5eedUL;
+	if (rng_state == 0UL) {
+		rng_state = 1UL;
+	}
+	if (argc > 2) {
+		ops = strtoul(argv[2], NULL, 0);
+	}
+
+	arena = mmap(NULL, ARENA_PAGES * PAGE_SZ, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT,
+		-1, 0);
+	ref_hpa = malloc(WIN_PAGES * sizeof(*ref_hpa));
+	ref_prot = malloc(WIN_PAGES);
+	if ((arena == MAP_FAILED) || (ref_hpa == NULL) || (ref_prot == NULL)) {
+		fprintf(stderr, "out of memory\n");
+		return 2;
+	}
+
+	printf("seed 0x%lx\n", rng_state);
+	for (large = 1; (large >= 0) && (ret == 0); large--) {
+		for (tweak = 0; (tweak <= 1) && (ret == 0); tweak++) {
+			if (property_test(large, tweak, ops) != 0) {
+				ret = 1;
+			}
+		}
+	}
+	if (ret == 0) {
+		benchmark();
+	}
+
+	return ret;
+}